@@ -37,6 +37,104 @@ std::string DataSegId::to_string(const bool withName) const
             ", offset=" + std::to_string(offset) + "}";
 }
 
+std::string BlockId::to_string(const bool withName) const
+{
+    String string;
+    if (withName)
+        string += "BlockId";
+    return string + "{prodIndex=" + prodIndex.to_string() +
+            ", offset=" + std::to_string(offset) + "}";
+}
+
+std::string McastReport::to_string(const bool withName) const
+{
+    String string;
+    if (withName)
+        string += "McastReport";
+    return string + "{lossPpm=" + std::to_string(lossPpm) +
+            ", rcvRate=" + std::to_string(rcvRate) +
+            ", numHops=" + std::to_string(numHops) + "}";
+}
+
+void Inventory::addComplete(const ProdIndex prodIndex)
+{
+    const ProdIndex::Type index = prodIndex;
+
+    if (!complete.empty() &&
+            complete.back().first + complete.back().count == index) {
+        ++complete.back().count;
+    }
+    else {
+        complete.push_back(ProdRange{index, 1});
+    }
+}
+
+/**
+ * Returns the incomplete product with a given index. Creates it if necessary.
+ * Recently added products are searched first.
+ */
+static Inventory::PartialProd& getPartial(
+        std::vector<Inventory::PartialProd>& partial,
+        const ProdIndex                      prodIndex)
+{
+    for (auto iter = partial.rbegin(); iter != partial.rend(); ++iter)
+        if (iter->prodIndex == prodIndex)
+            return *iter;
+
+    partial.push_back(Inventory::PartialProd{prodIndex, false, {}});
+    return partial.back();
+}
+
+void Inventory::add(const DataSegId& segId)
+{
+    auto&        segs = getPartial(partial, segId.prodIndex).segs;
+    const size_t index = segId.offset / DataSeg::CANON_DATASEG_SIZE;
+
+    if (index/64 >= segs.size())
+        segs.resize(index/64 + 1);
+    segs[index/64] |= uint64_t(1) << (index%64);
+}
+
+void Inventory::add(const ProdIndex prodIndex)
+{
+    getPartial(partial, prodIndex).info = true;
+}
+
+bool Inventory::isComplete(const ProdIndex prodIndex) const noexcept
+{
+    const ProdIndex::Type index = prodIndex;
+
+    for (const auto& range : complete)
+        if (index - range.first < range.count) // Unsigned arithmetic
+            return true;
+
+    return false;
+}
+
+bool Inventory::has(const DataSegId& segId) const noexcept
+{
+    if (isComplete(segId.prodIndex))
+        return true;
+
+    const size_t index = segId.offset / DataSeg::CANON_DATASEG_SIZE;
+
+    for (const auto& prod : partial)
+        if (prod.prodIndex == segId.prodIndex)
+            return index/64 < prod.segs.size() &&
+                    (prod.segs[index/64] & (uint64_t(1) << (index%64)));
+
+    return false;
+}
+
+std::string Inventory::to_string(const bool withName) const
+{
+    String string;
+    if (withName)
+        string += "Inventory";
+    return string + "{numRanges=" + std::to_string(complete.size()) +
+            ", numPartial=" + std::to_string(partial.size()) + "}";
+}
+
 String NoteReq::to_string() const {
     return (id == Id::PROD_INDEX)
             ? prodIndex.to_string()
@@ -32,6 +32,7 @@
 #include <string>
 #include <thread>
 #include <time.h>
+#include <vector>
 
 namespace hycast {
 
@@ -79,6 +80,45 @@ public:
     }
 };
 
+/**
+ * Notice-mode notice. A peer that's receiving the multicast well announces
+ * NACK-mode to its remote peers so that they don't notify it about individual
+ * data-segments: it'll request (i.e., negatively acknowledge) the few
+ * data-segments that it's missing from a remote peer that notified it about
+ * the product.
+ */
+class NackMode
+{
+    bool nackMode; // Remote peer should suppress data-segment notices
+
+public:
+    /**
+     * NB: Implicit construction.
+     * @param[in] nackMode  Whether NACK-mode is wanted
+     */
+    NackMode(const bool nackMode)
+        : nackMode(nackMode)
+    {}
+
+    NackMode()
+        : NackMode(false)
+    {}
+
+    NackMode(const NackMode& nackMode) =default;
+    ~NackMode() =default;
+    NackMode& operator=(const NackMode& rhs) =default;
+
+    operator bool() const {
+        return nackMode;
+    }
+
+    std::string to_string(const bool withName) const {
+        return withName
+                ? "NackMode{" + std::to_string(nackMode) + "}"
+                : std::to_string(nackMode);
+    }
+};
+
 class ProdIndex
 {
 public:
@@ -168,6 +208,58 @@ struct Timestamp
     std::string to_string(bool withName = false) const;
 };
 
+/**
+ * Summary of a subscriber's reception of the multicast over a reporting
+ * interval. Sent towards the publisher so that it can adapt its multicast
+ * rate.
+ */
+struct McastReport
+{
+    /// Denominator of the loss-rate
+    static const uint32_t PPM = 1000000;
+    /// Maximum number of times a report is forwarded
+    static const uint8_t  MAX_HOPS = 8;
+
+    uint32_t lossPpm; ///< Loss-rate of data-segments in parts per million
+    uint64_t rcvRate; ///< Receive-rate in bytes per second
+    uint8_t  numHops; ///< Number of times the report has been forwarded
+
+    McastReport()
+        : lossPpm{0}
+        , rcvRate{0}
+        , numHops{0}
+    {}
+
+    /**
+     * Constructs.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     */
+    McastReport(const double lossRate,
+                const double rcvRate)
+        : lossPpm{static_cast<uint32_t>(lossRate*PPM + 0.5)}
+        , rcvRate{static_cast<uint64_t>(rcvRate + 0.5)}
+        , numHops{0}
+    {}
+
+    /**
+     * Returns the loss-rate.
+     *
+     * @return Loss-rate of data-segments in [0, 1]
+     */
+    inline double lossRate() const noexcept {
+        return static_cast<double>(lossPpm)/PPM;
+    }
+
+    inline bool operator==(const McastReport& rhs) const {
+        return (lossPpm == rhs.lossPpm) && (rcvRate == rhs.rcvRate) &&
+                (numHops == rhs.numHops);
+    }
+
+    std::string to_string(const bool withName = false) const;
+};
+
 /// Product information
 struct ProdInfo
 {
@@ -245,6 +337,205 @@ public:
     String to_string(bool withName = false) const;
 };
 
+/**
+ * Identifier of a block of consecutive data-segments for random linear network
+ * coding. The offset is that of the block's first data-segment and is a
+ * multiple of `SIZE`. The last block of a product may be short.
+ */
+struct BlockId
+{
+    /// Maximum number of data-segments in a block
+    static const unsigned NUM_SEGS = 32;
+    /// Maximum number of bytes in a block
+    static const ProdSize SIZE = NUM_SEGS * DataSeg::CANON_DATASEG_SIZE;
+
+    ProdIndex prodIndex; ///< Product index
+    SegOffset offset;    ///< Offset of block's first data segment in bytes
+
+    BlockId()
+        : prodIndex{0}
+        , offset{0}
+    {}
+
+    BlockId(const ProdIndex prodIndex,
+            const SegOffset offset)
+        : prodIndex{prodIndex}
+        , offset{offset}
+    {}
+
+    /**
+     * Returns the number of data-segments in the block.
+     *
+     * @param[in] prodSize  Size of product in bytes
+     * @return              Number of data-segments in block
+     */
+    inline unsigned numSegs(const ProdSize prodSize) const noexcept {
+        const auto nbytes = (prodSize - offset > SIZE)
+                ? SIZE
+                : prodSize - offset;
+        return (nbytes + DataSeg::CANON_DATASEG_SIZE - 1) /
+                DataSeg::CANON_DATASEG_SIZE;
+    }
+
+    inline bool operator==(const BlockId& rhs) const {
+        return (prodIndex == rhs.prodIndex) && (offset == rhs.offset);
+    }
+
+    std::string to_string(const bool withName = false) const;
+
+    size_t hash() const noexcept {
+        static std::hash<SegOffset> offHash;
+        return prodIndex.hash() ^ offHash(offset);
+    }
+};
+
+/**
+ * Coded data-segment: a random linear combination, over GF(2^8), of the
+ * data-segments of a block. The data is always `DataSeg::CANON_DATASEG_SIZE`
+ * bytes; a short last segment is treated as if padded with zeros.
+ */
+class CodedSeg
+{
+public:
+    class Impl;
+
+private:
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    CodedSeg();
+
+    /**
+     * Constructs. Copies the coefficients and the data.
+     *
+     * @param[in] blockId   Block identifier
+     * @param[in] prodSize  Size of product in bytes
+     * @param[in] coefs     Coefficients. One per data-segment in the block.
+     * @param[in] data      Linear combination of the block's data-segments
+     */
+    CodedSeg(const BlockId& blockId,
+             const ProdSize prodSize,
+             const uint8_t* coefs,
+             const char*    data);
+
+    /**
+     * Constructs from a socket by reading the coefficients and data.
+     *
+     * @param[in] blockId   Block identifier
+     * @param[in] prodSize  Size of product in bytes
+     * @param[in] sock      Socket
+     * @throws    EofError  EOF encountered
+     */
+    CodedSeg(const BlockId& blockId,
+             const ProdSize prodSize,
+             TcpSock&       sock);
+
+    operator bool() const;
+
+    const BlockId& blockId() const noexcept;
+
+    ProdSize prodSize() const noexcept;
+
+    inline unsigned numSegs() const noexcept {
+        return blockId().numSegs(prodSize());
+    }
+
+    const uint8_t* coefs() const noexcept;
+
+    const char* data() const noexcept;
+
+    String to_string(bool withName = false) const;
+};
+
+/**
+ * Compact inventory of the products and data-segments that a node has. It's
+ * exchanged between peers so that each learns what the other has without
+ * being sent a notice for every data-segment. Complete products are
+ * described by ranges of product indexes and incomplete ones by a bitmap of
+ * their data-segments.
+ */
+struct Inventory
+{
+    /**
+     * Maximum total number of entries (i.e., product ranges, incomplete
+     * products, and bitmap words) in a received inventory. Bounds the memory
+     * that a remote peer can make the local peer allocate.
+     */
+    static const uint32_t MAX_ENTRIES = 1 << 20;
+
+    /// Range of consecutive, complete products
+    struct ProdRange {
+        ProdIndex::Type first; ///< Index of first product
+        uint32_t        count; ///< Number of products
+    };
+
+    /// Incomplete product
+    struct PartialProd {
+        ProdIndex::Type       prodIndex; ///< Index of product
+        bool                  info;      ///< Product information is had?
+        std::vector<uint64_t> segs;      ///< Bitmap of data-segments
+    };
+
+    std::vector<ProdRange>   complete; ///< Complete products in index order
+    std::vector<PartialProd> partial;  ///< Incomplete products
+
+    Inventory()
+        : complete()
+        , partial()
+    {}
+
+    /**
+     * Indicates if this instance is non-empty.
+     *
+     * @retval `true`   It is
+     * @retval `false`  It isn't
+     */
+    inline operator bool() const noexcept {
+        return !complete.empty() || !partial.empty();
+    }
+
+    /**
+     * Adds a complete product. Extends the last range if possible.
+     *
+     * @param[in] prodIndex  Index of product
+     */
+    void addComplete(const ProdIndex prodIndex);
+
+    /**
+     * Adds a data-segment of an incomplete product.
+     *
+     * @param[in] segId  Data-segment identifier
+     */
+    void add(const DataSegId& segId);
+
+    /**
+     * Adds the product information of an incomplete product.
+     *
+     * @param[in] prodIndex  Index of product
+     */
+    void add(const ProdIndex prodIndex);
+
+    /**
+     * Indicates if a product is complete.
+     *
+     * @param[in] prodIndex  Index of product
+     * @retval    `true`     It is
+     * @retval    `false`    It isn't
+     */
+    bool isComplete(const ProdIndex prodIndex) const noexcept;
+
+    /**
+     * Indicates if a data-segment is had.
+     *
+     * @param[in] segId      Data-segment identifier
+     * @retval    `true`     It is
+     * @retval    `false`    It isn't
+     */
+    bool has(const DataSegId& segId) const noexcept;
+
+    std::string to_string(const bool withName = false) const;
+};
+
 /******************************************************************************/
 // Protocol data units (PDU)
 
@@ -257,7 +548,13 @@ enum class PduId : PduType {
     PROD_INFO_REQUEST,
     DATA_SEG_REQUEST,
     PROD_INFO,
-    DATA_SEG
+    DATA_SEG,
+    CODED_SEG_REQUEST,
+    CODED_SEG,
+    NACK_MODE_NOTICE,
+    MCAST_REPORT,
+    INVENTORY,
+    DATA_SEG_UNAVAIL
 };
 
 /**
@@ -354,6 +651,30 @@ public:
 } // namespace
 
 namespace std {
+    template<>
+    class hash<hycast::ProdIndex> {
+    public:
+        size_t operator()(const hycast::ProdIndex& prodIndex) const noexcept {
+            return prodIndex.hash();
+        }
+    };
+
+    template<>
+    class hash<hycast::BlockId> {
+    public:
+        size_t operator()(const hycast::BlockId& blockId) const noexcept {
+            return blockId.hash();
+        }
+    };
+
+    template<>
+    class hash<hycast::DataSegId> {
+    public:
+        size_t operator()(const hycast::DataSegId& segId) const noexcept {
+            return segId.hash();
+        }
+    };
+
     template<>
     class hash<hycast::NoteReq> {
     public:
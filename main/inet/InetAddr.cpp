@@ -26,791 +26,855 @@
 
 #include <algorithm>
 #include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
-#include <functional>
+#include <deque>
+#include <ifaddrs.h>
+#include <mutex>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
-#include <sys/ioctl.h>
 #include <sys/socket.h>
-
-#if defined(__linux__)
-    #include <sys/types.h>
-    #include <ifaddrs.h>
-#endif
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace hycast {
 
-class Inet4Addr;
-class Inet6Addr;
-class NameAddr;
-
-class InetAddr::Impl
+/**
+ * Process-wide table of interned hostnames. Interning allows a hostname-based
+ * `InetAddr` to be a fixed-size value that's compared for equality and hashed
+ * by index. Entries are never removed; the number of distinct hostnames used
+ * by a process is small.
+ */
+class NameTable
 {
-protected:
-    /**
-     * Returns an appropriate socket.
-     *
-     * @param[in] family             Address family. One of `AF_INET` or
-     *                               `AF_INET6`.
-     * @param[in] type               Type of socket. One of `SOCK_STREAM`,
-     *                               `SOCK_DGRAM`, or `SOCK_SEQPACKET`.
-     * @param[in] protocol           Protocol. E.g., `IPPROTO_TCP` or `0` to
-     *                               obtain the default protocol.
-     * @return                       Appropriate socket
-     * @throws    std::system_error  `::socket()` failure
-     */
-    static int createSocket(
-            const int family,
-            const int type,
-            const int protocol) {
-        int sd = ::socket(family, type, protocol);
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
 
-        if (sd == -1)
-            throw SYSTEM_ERROR("::socket() failure: "
-                    "family=" + std::to_string(family) + ","
-                    "type=" + std::to_string(type) + ","
-                    "protocol=" + std::to_string(protocol));
-
-        return sd;
-    }
+    mutable Mutex                             mutex;
+    std::deque<std::string>                   names; ///< References are stable
+    std::unordered_map<std::string, uint32_t> ids;
 
 public:
-    virtual ~Impl() noexcept;
-
-    virtual int getFamily() const noexcept =0;
-
-    virtual std::string to_string() const =0;
-
-    virtual bool operator<(const Impl& rhs) const noexcept =0;
-
-    virtual bool operator<(const Inet4Addr& rhs) const noexcept =0;
-
-    virtual bool operator<(const Inet6Addr& rhs) const noexcept =0;
-
-    virtual bool operator<(const NameAddr& rhs) const noexcept =0;
-
-    virtual bool operator==(const Impl& rhs) const noexcept =0;
-
-    virtual bool operator==(const Inet4Addr& rhs) const noexcept =0;
-
-    virtual bool operator==(const Inet6Addr& rhs) const noexcept =0;
-
-    virtual bool operator==(const NameAddr& rhs) const noexcept =0;
-
-    virtual size_t hash() const noexcept =0;
-
-    virtual SockAddr getSockAddr(const in_port_t port) const =0;
-
     /**
-     * Returns a socket descriptor appropriate to this instance's address
-     * family.
+     * Returns the index of a hostname, adding it if necessary.
      *
-     * @param[in] type               Type of socket. One of `SOCK_STREAM`,
-     *                               `SOCK_DGRAM`, or `SOCK_SEQPACKET`.
-     * @param[in] protocol           Protocol. E.g., `IPPROTO_TCP` or `0` to
-     *                               obtain the default protocol.
-     * @return                       Appropriate socket
-     * @throws    std::system_error  `::socket()` failure
+     * @param[in] name  Hostname
+     * @return          Index of hostname
+     * @threadsafety    Safe
      */
-    virtual int socket(
-            const int type,
-            const int protocol) const =0;
+    uint32_t intern(const std::string& name)
+    {
+        Guard guard{mutex};
+        auto  iter = ids.find(name);
+
+        if (iter != ids.end())
+            return iter->second;
+
+        const uint32_t id = static_cast<uint32_t>(names.size());
+        names.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
 
     /**
-     * Sets a socket address structure and returns a pointer to it.
+     * Returns the hostname corresponding to an index.
      *
-     * @param[in] storage  Socket address structure
-     * @param[in] port     Port number in host byte-order
-     * @return             Pointer to given socket address structure
-     * @threadsafety       Safe
+     * @param[in] id  Index of hostname
+     * @return        Corresponding hostname. Valid for the lifetime of the
+     *                process.
+     * @threadsafety  Safe
      */
-    virtual struct sockaddr* get_sockaddr(
-            struct sockaddr_storage& storage,
-            const in_port_t          port) const =0;
-
-    virtual void setMcastIface(int sd) const =0;
-
-    virtual bool isSsm() const =0;
+    const std::string& get(const uint32_t id) const
+    {
+        Guard guard{mutex};
+        return names[id];
+    }
 
     /**
-     * Joins the source-specific multicast group identified by this instance
-     * and the address of the sending host.
+     * Returns the process-wide instance.
      *
-     * @param[in] sd       Socket identifier
-     * @param[in] srcAddr  Address of the sending host
-     * @threadsafety       Safe
-     * @exceptionsafety    Strong guarantee
-     * @cancellationpoint  Maybe (`::getaddrinfo()` may be one and will be
-     *                     called if either address is based on a name)
+     * @return Process-wide instance
      */
-    void join(
-            const int       sd,
-            const InetAddr& srcAddr) const
+    static NameTable& instance()
     {
-        LOG_DEBUG("Joining multicast group %s from source %s",
-                to_string().data(), srcAddr.to_string().data());
-
-        // NB: The following is independent of protocol (i.e., IPv4 or IPv6)
-        struct group_source_req mreq = {};
-
-        mreq.gsr_interface = 0; // => O/S chooses interface
-        getSockAddr(0).get_sockaddr(mreq.gsr_group);
-        srcAddr.getSockAddr(0).get_sockaddr(mreq.gsr_source);
-
-        if (::setsockopt(sd, IPPROTO_IP, MCAST_JOIN_SOURCE_GROUP, &mreq,
-                sizeof(mreq)))
-            throw SYSTEM_ERROR("Couldn't join multicast group " +
-                    to_string() + " from source " + srcAddr.to_string());
+        static NameTable nameTable;
+        return nameTable;
     }
 };
 
-InetAddr::Impl::~Impl() noexcept
-{}
-
-/******************************************************************************/
-
-class Inet4Addr final : public InetAddr::Impl
+/**
+ * Returns an appropriate socket.
+ *
+ * @param[in] family             Address family. One of `AF_INET` or
+ *                               `AF_INET6`.
+ * @param[in] type               Type of socket. One of `SOCK_STREAM`,
+ *                               `SOCK_DGRAM`, or `SOCK_SEQPACKET`.
+ * @param[in] protocol           Protocol. E.g., `IPPROTO_TCP` or `0` to
+ *                               obtain the default protocol.
+ * @return                       Appropriate socket
+ * @throws    std::system_error  `::socket()` failure
+ */
+static int createSocket(
+        const int family,
+        const int type,
+        const int protocol)
 {
-    struct in_addr       addr;
-    std::hash<in_addr_t> myHash;
+    int sd = ::socket(family, type, protocol);
 
-public:
-    Inet4Addr(const in_addr_t addr) noexcept
-        : addr{addr}
-    {}
+    if (sd == -1)
+        throw SYSTEM_ERROR("::socket() failure: "
+                "family=" + std::to_string(family) + ","
+                "type=" + std::to_string(type) + ","
+                "protocol=" + std::to_string(protocol));
 
-    int getFamily() const noexcept
-    {
-        return AF_INET;
-    }
-
-    std::string to_string() const
-    {
-        char buf[INET_ADDRSTRLEN];
-
-        if (inet_ntop(AF_INET, &addr.s_addr, buf, sizeof(buf)) == nullptr)
-            throw SYSTEM_ERROR("inet_ntop() failure");
-
-        return std::string(buf);
-    }
+    return sd;
+}
 
-    bool operator <(const InetAddr::Impl& rhs) const noexcept
-    {
-        return !(rhs < *this) && !(rhs == *this);
-    }
+/**
+ * Returns the index of the interface that has a given IPv6 address.
+ *
+ * @param[in] addr               IPv6 address
+ * @retval    0                  No such interface
+ * @return                       Index of interface
+ * @throws    std::system_error  Couldn't get information on interfaces
+ */
+static unsigned getIfaceIndex(const struct in6_addr& addr)
+{
+    unsigned        index = 0; // 0 => no interface index found
+    struct ifaddrs* ifaddrs;
 
-    bool operator <(const Inet4Addr& rhs) const noexcept
-    {
-        return ntohl(addr.s_addr) < ntohl(rhs.addr.s_addr);
-    }
+    if (::getifaddrs(&ifaddrs))
+        throw SYSTEM_ERROR("Couldn't get information on interfaces");
 
-    bool operator <(const Inet6Addr& rhs) const noexcept
-    {
-        return true;
-    }
+    const struct ifaddrs* entry;
 
-    bool operator <(const NameAddr& rhs) const noexcept
-    {
-        return true;
-    }
+    for (entry = ifaddrs; entry; entry = entry->ifa_next) {
+        const struct sockaddr* sockAddr = entry->ifa_addr;
 
-    bool operator ==(const InetAddr::Impl& rhs) const noexcept
-    {
-        return rhs == *this;
+        if (sockAddr && sockAddr->sa_family == AF_INET6) {
+            const struct in6_addr* in6Addr = &reinterpret_cast
+                    <const struct sockaddr_in6*>(sockAddr)->sin6_addr;
+            if (::memcmp(&addr, in6Addr, sizeof(addr)) == 0)
+                break;
+        }
     }
 
-    bool operator ==(const Inet4Addr& rhs) const noexcept
-    {
-        return addr.s_addr == rhs.addr.s_addr;
-    }
+    if (entry)
+        index = ::if_nametoindex(entry->ifa_name);
 
-    bool operator ==(const Inet6Addr& rhs) const noexcept
-    {
-        return false;
-    }
+    ::freeifaddrs(ifaddrs);
 
-    bool operator ==(const NameAddr& rhs) const noexcept
-    {
-        return false;
-    }
+    return index;
+}
 
-    size_t hash() const noexcept {
-        return myHash(addr.s_addr);
+/**
+ * Sets a socket address from the first IP-based Internet address of a host
+ * that matches the given information.
+ *
+ * @param[in]  name               Hostname
+ * @param[out] storage            Socket address
+ * @param[in]  family             Address family. One of `AF_INET` or
+ *                                `AF_INET6`.
+ * @param[in]  port               Port number in host byte-order
+ * @retval     `true`             Success. `sockaddr` is set.
+ * @retval     `false`            Failure. `sockaddr` is not set.
+ * @throws     std::system_error  `::getaddrinfo()` failure
+ * @exceptionsafety               Strong guarantee
+ * @threadsafety                  Safe
+ * @cancellationpoint             Maybe (`::getaddrinfo()` may be one)
+ */
+static bool resolve(
+        const std::string&       name,
+        struct sockaddr_storage& storage,
+        const int                family,
+        const in_port_t          port)
+{
+    bool             success = false;
+    struct addrinfo  hints = {};
+    struct addrinfo* list;
+
+    hints.ai_family = family;
+    hints.ai_socktype = 0;
+
+    if (::getaddrinfo(name.data(), nullptr, &hints, &list))
+        throw SYSTEM_ERROR(
+                std::string("::getaddrinfo() failure for host \"") +
+                name.data() + "\"");
+
+    for (struct addrinfo* entry = list; entry != NULL;
+            entry = entry->ai_next) {
+        if (entry->ai_family == AF_INET) {
+            auto*       dstaddr =
+                    reinterpret_cast<struct sockaddr_in*>(&storage);
+            const auto* srcaddr = reinterpret_cast
+                    <const struct sockaddr_in*>(entry->ai_addr);
+            *dstaddr = *srcaddr;
+            dstaddr->sin_port = htons(port);
+            success = true;
+            break;
+        }
+        else if (entry->ai_family == AF_INET6) {
+            auto*       dstaddr =
+                    reinterpret_cast<struct sockaddr_in6*>(&storage);
+            const auto* srcaddr = reinterpret_cast
+                    <const struct sockaddr_in6*>(entry->ai_addr);
+            *dstaddr = *srcaddr;
+            dstaddr->sin6_port = htons(port);
+            success = true;
+            break;
+        }
     }
 
-    int socket(
-            const int type,
-            const int protocol) const
-    {
-        return createSocket(AF_INET, type, protocol);
-    }
+    ::freeaddrinfo(list);
+    return success;
+}
 
-    SockAddr getSockAddr(const in_port_t port) const
-    {
-        return SockAddr(addr.s_addr, port);
-    }
+/**
+ * Process-wide cache of hostname resolutions. Resolutions are performed
+ * asynchronously by a small pool of threads so that a slow resolver only
+ * delays the threads that actually need an address that has never been
+ * resolved. Successful resolutions are retained for a positive time-to-live;
+ * failures, for a (shorter) negative time-to-live. An expired successful
+ * resolution continues to be used while it's refreshed in the background.
+ */
+class Resolver
+{
+    using Mutex     = std::mutex;
+    using Lock      = std::unique_lock<Mutex>;
+    using Cond      = std::condition_variable;
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /// Cached resolution of a hostname
+    struct Entry {
+        enum class State {
+            PENDING, ///< Initial resolution in progress
+            VALID,   ///< `storage` is set
+            FAILED   ///< `error` is set
+        }                               state;
+        struct sockaddr_storage         storage;    ///< Port number is zero
+        std::exception_ptr              error;      ///< Reason for failure
+        TimePoint                       expiry;     ///< When entry is stale
+        bool                            refreshing; ///< Queued?
+        std::vector<InetAddr::Resolved> waiters;    ///< Called when resolved
+
+        Entry()
+            : state(State::PENDING)
+            , storage()
+            , error()
+            , expiry()
+            , refreshing(false)
+            , waiters()
+        {}
+    };
+
+    static const int numThreads = 2; ///< Size of resolution pool
 
-    struct sockaddr* get_sockaddr(
+    /**
+     * Sets a socket address from a valid entry.
+     *
+     * @param[in]  entry    Valid entry
+     * @param[out] storage  Socket address
+     * @param[in]  port     Port number in host byte-order
+     */
+    static void copy(
+            const Entry&             entry,
             struct sockaddr_storage& storage,
-            const in_port_t          port) const
-    {
-        ::memset(&storage, 0, sizeof(storage));
-        struct sockaddr_in* const sockaddr =
-                reinterpret_cast<struct sockaddr_in*>(&storage);
-        sockaddr->sin_family = AF_INET;
-        sockaddr->sin_addr = addr;
-        sockaddr->sin_port = htons(port);
-        return reinterpret_cast<struct sockaddr*>(sockaddr);
-    }
-
-    void setMcastIface(int sd) const override
+            const in_port_t          port)
     {
-        LOG_DEBUG("Setting multicast interface for IPv4 UDP socket %d to %s",
-                sd, to_string().data());
-        if (setsockopt(sd, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof(addr)) <
-                0)
-            throw SYSTEM_ERROR("Couldn't set multicast interface for IPv4 UDP "
-                    "socket " + std::to_string(sd) + " to " + to_string());
-    }
-
-    bool isSsm() const override {
-        auto ip = ntohl(addr.s_addr);
-        return ip >= 0XE8000100 && ip <= 0XE8FFFFFF;
+        storage = entry.storage;
+        if (storage.ss_family == AF_INET) {
+            reinterpret_cast<struct sockaddr_in*>(&storage)->sin_port =
+                    htons(port);
+        }
+        else {
+            reinterpret_cast<struct sockaddr_in6*>(&storage)->sin6_port =
+                    htons(port);
+        }
     }
-};
-
-/******************************************************************************/
 
-class Inet6Addr final : public InetAddr::Impl
-{
-    struct in6_addr     addr;
-    std::hash<uint64_t> myHash;
+    mutable Mutex                       mutex;
+    Cond                                cond;
+    std::unordered_map<uint32_t, Entry> entries;  ///< Keyed by name index
+    std::deque<uint32_t>                queue;    ///< Names to be resolved
+    Clock::duration                     posTtl;   ///< Success time-to-live
+    Clock::duration                     negTtl;   ///< Failure time-to-live
+    bool                                started;  ///< Pool started?
+
+    Resolver()
+        : mutex()
+        , cond()
+        , entries()
+        , queue()
+        , posTtl(std::chrono::minutes(5))
+        , negTtl(std::chrono::seconds(30))
+        , started(false)
+    {}
 
-#if !defined(__linux__)
-    unsigned getIfaceIndex(
-            const char* buf,
-            const int   len)
+    /**
+     * Queues a hostname for resolution. Starts the pool if necessary.
+     *
+     * @pre             Mutex is locked
+     * @param[in] id    Index of hostname
+     * @param[in] entry Corresponding entry
+     */
+    void enqueue(
+            const uint32_t id,
+            Entry&         entry)
     {
-        unsigned index = 0;
-
-        for (const char* ptr = buf; ptr < buf + len; ) {
-            const struct ifreq* ifr = reinterpret_cast<const struct ifreq*>(ptr);
-
-            ptr += sizeof(ifr->ifr_name) + (
-                    (ifr->ifr_addr.sa_family == AF_INET6)
-                        ? sizeof(struct sockaddr_in6)
-                        : sizeof(struct sockaddr));
+        if (entry.refreshing)
+            return;
 
-            if (ifr->ifr_addr.sa_family == AF_LINK) {
-                const struct sockaddr_dl *sdl =
-                        static_cast<const struct sockaddr_dl*>(&ifr->ifr_addr);
-                index = sdl->sdl_index;
-            }
-
-            if (ifr->ifr_addr.sa_family != AF_INET6)
-                continue;
+        entry.refreshing = true;
+        queue.push_back(id);
 
-            if (memcmp(addr,
-                    static_cast<const struct sockaddr_in6*>(&ifr->ifr_addr)->sin6_addr,
-                    sizeof(addr)) == 0)
-                break;
+        if (!started) {
+            for (int i = 0; i < numThreads; ++i)
+                std::thread(&Resolver::run, this).detach();
+            started = true;
         }
 
-        return index;
+        cond.notify_all();
     }
-#endif
 
-    unsigned getIfaceIndex() const
+    /**
+     * Executes resolutions for the pool. Never returns.
+     */
+    void run()
     {
-        unsigned index = 0; // 0 => no interface index found
+        Lock lock{mutex};
 
-#if defined(__linux__)
-        struct ifaddrs* ifaddrs;
+        for (;;) {
+            cond.wait(lock, [&]{return !queue.empty();});
 
-        if (::getifaddrs(&ifaddrs))
-            throw SYSTEM_ERROR("Couldn't get information on interfaces");
+            const uint32_t id = queue.front();
+            queue.pop_front();
 
-        try {
-            const struct ifaddrs* entry;
+            const auto&             name = NameTable::instance().get(id);
+            struct sockaddr_storage storage = {};
+            std::exception_ptr      error;
 
-            for (entry = ifaddrs; entry; entry = entry->ifa_next) {
-                const struct sockaddr* sockAddr = entry->ifa_addr;
+            lock.unlock();
+            try {
+                if (!hycast::resolve(name, storage, AF_INET, 0) &&
+                        !hycast::resolve(name, storage, AF_INET6, 0))
+                    throw RUNTIME_ERROR("Couldn't get IP address for \"" +
+                            name + "\"");
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
 
-                if (sockAddr->sa_family == AF_INET6) {
-                    const struct in6_addr* in6Addr = &reinterpret_cast
-                            <const struct sockaddr_in6*>(sockAddr)->sin6_addr;
-                    if (::memcmp(&addr, in6Addr, sizeof(addr)) == 0)
-                        break;
-                }
+            auto& entry = entries[id];
+            entry.refreshing = false;
+
+            if (!error) {
+                entry.state = Entry::State::VALID;
+                entry.storage = storage;
+                entry.error = nullptr;
+                entry.expiry = Clock::now() + posTtl;
+            }
+            else if (entry.state != Entry::State::VALID) {
+                // A previous success is preferred to a new failure
+                LOG_DEBUG("Couldn't resolve \"%s\"", name.data());
+                entry.state = Entry::State::FAILED;
+                entry.error = error;
+                entry.expiry = Clock::now() + negTtl;
+            }
+            else {
+                entry.expiry = Clock::now() + negTtl; // Retry sooner
             }
 
-            if (entry)
-                index = ::if_nametoindex(entry->ifa_name);
+            cond.notify_all();
 
-            ::freeifaddrs(ifaddrs);
-        } // `ifaddrs` allocated
-        catch (...) {
-            ::freeifaddrs(ifaddrs);
-        }
-#else
-        int      sock = ::socket(AF_INET, SOCK_DGRAM, 0);
-
-        if (sock == -1)
-            throw SYSTEM_ERROR("Couldn't create socket for ioctl()");
-        try {
-            ;
-            int    lastlen = 0;
-
-            for (int len = 100*sizeof(struct ifreq); ; len *= 2) {
-                char buf[len];
-                struct ifconf ifc =
-                        {.ifc_ifcu={.ifcu_buf=buf}, .ifc_len=sizeof(buf)};
-
-                if (ioctl(sock, SIOCGIFCONF, &ifc) < 0) {
-                    if (errno != EINVAL || lastlen)
-                        throw SYSTEM_ERROR("ioctl() failure");
-                }
-                else {
-                    if (ifc.ifc_len == lastlen) {
-                        // Success, len has not changed
-                        index = getIfaceIndex(buf, sizeof(ifc.ifc_name),
-                                ifc.ifc_len);
-                        break;
+            if (!entry.waiters.empty()) {
+                std::vector<InetAddr::Resolved> waiters{};
+                waiters.swap(entry.waiters);
+                const auto result = (entry.state == Entry::State::VALID)
+                        ? std::exception_ptr{}
+                        : entry.error;
+
+                lock.unlock();
+                for (auto& waiter : waiters) {
+                    try {
+                        waiter(result);
+                    }
+                    catch (const std::exception& ex) {
+                        LOG_ERROR(ex, "Resolution callback threw an "
+                                "exception");
                     }
-                    lastlen = ifc.ifc_len;
                 }
+                lock.lock();
             }
-
-            close(sock);
         }
-        catch (...) {
-            ::close(sock);
-        }
-#endif
-
-        return index;
     }
 
 public:
-    Inet6Addr(const struct in6_addr& addr) noexcept
-        : addr(addr)
-    {}
-
-    int getFamily() const noexcept
-    {
-        return AF_INET6;
-    }
-
-    std::string to_string() const
-    {
-        char buf[INET6_ADDRSTRLEN];
-
-        if (inet_ntop(AF_INET6, &addr, buf, sizeof(buf)) == nullptr)
-            throw SYSTEM_ERROR("inet_ntop() failure");
-
-        return std::string(buf);
-    }
-
-    bool operator <(const InetAddr::Impl& rhs) const noexcept
-    {
-        return !(rhs < *this) && !(rhs == *this);
-    }
-
-    bool operator <(const Inet4Addr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    bool operator <(const Inet6Addr& rhs) const noexcept
-    {
-        return ::memcmp(&addr, &rhs.addr, sizeof(addr)) < 0;
-    }
-
-    bool operator <(const NameAddr& rhs) const noexcept
-    {
-        return true;
-    }
-
-    bool operator ==(const InetAddr::Impl& rhs) const noexcept
-    {
-        return rhs == *this;
-    }
-
-    bool operator ==(const Inet4Addr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    bool operator ==(const Inet6Addr& rhs) const noexcept
-    {
-        return ::memcmp(&addr, &rhs.addr, sizeof(addr)) == 0;
-    }
-
-    bool operator ==(const NameAddr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    size_t hash() const noexcept {
-        return myHash(((static_cast<uint64_t>(addr.s6_addr32[0]) ^
-                addr.s6_addr32[1]) << 32) |
-                (addr.s6_addr32[2] ^ addr.s6_addr32[3]));
-    }
-
-    int socket(
-            const int type,
-            const int protocol) const
+    /**
+     * Returns the process-wide instance.
+     *
+     * @return Process-wide instance
+     */
+    static Resolver& instance()
     {
-        return createSocket(AF_INET6, type, protocol);
+        // Never destroyed because detached pool threads reference it
+        static Resolver* resolver = new Resolver();
+        return *resolver;
     }
 
-    SockAddr getSockAddr(const in_port_t port) const
+    /**
+     * Sets the time-to-live of cached resolutions. Affects subsequent
+     * resolutions only.
+     *
+     * @param[in] positive  Time-to-live of successful resolutions
+     * @param[in] negative  Time-to-live of failed resolutions
+     * @threadsafety        Safe
+     */
+    void setTtl(
+            const Clock::duration positive,
+            const Clock::duration negative)
     {
-        return SockAddr(addr, port);
+        Lock lock{mutex};
+        posTtl = positive;
+        negTtl = negative;
     }
 
-    struct sockaddr* get_sockaddr(
-            struct sockaddr_storage& storage,
-            const in_port_t          port) const
+    /**
+     * Starts resolving a hostname if it hasn't been resolved or the
+     * resolution is stale. Doesn't block.
+     *
+     * @param[in] id  Index of hostname
+     * @threadsafety  Safe
+     */
+    void prefetch(const uint32_t id)
     {
-        ::memset(&storage, 0, sizeof(storage));
-        struct sockaddr_in6* const sockaddr =
-                reinterpret_cast<struct sockaddr_in6*>(&storage);
-        sockaddr->sin6_family = AF_INET;
-        sockaddr->sin6_addr = addr;
-        sockaddr->sin6_port = htons(port);
-        return reinterpret_cast<struct sockaddr*>(sockaddr);
-    }
+        Lock  lock{mutex};
+        auto& entry = entries[id];
 
-    void setMcastIface(int sd) const
-    {
-        unsigned ifaceIndex = getIfaceIndex();
-        LOG_DEBUG("Setting multicast interface for IPv6 UDP socket %d to %u",
-                sd, ifaceIndex);
-        if (setsockopt(sd, IPPROTO_IP, IPV6_MULTICAST_IF, &ifaceIndex,
-                       sizeof(ifaceIndex)) < 0)
-            throw SYSTEM_ERROR("Couldn't set multicast interface for IPv6 UDP "
-                    "socket " + std::to_string(sd) + " to " +
-                    std::to_string(ifaceIndex));
+        if (entry.state == Entry::State::PENDING || Clock::now() >= entry.expiry)
+            enqueue(id, entry);
     }
 
-    /*
-     * FF3X::0000 through FF3X::4000:0000 or FF3X::8000:0000 through
-     * FF3X::FFFF:FFFF (for IPv6).
+    /**
+     * Calls a function when a hostname has been resolved. Never blocks. The
+     * function is called immediately, on the current thread, if the
+     * resolution is cached; otherwise, it's called on a thread of the pool.
+     *
+     * @param[in] id        Index of hostname
+     * @param[in] resolved  Function to call
+     * @threadsafety        Safe
      */
-    bool isSsm() const override {
-        // Get address in host byte-order
-        uint8_t ip[16];
-        if (htons(1) == 1) {
-            ::memcpy(ip, addr.s6_addr, 16);
+    void whenResolved(
+            const uint32_t            id,
+            const InetAddr::Resolved& resolved)
+    {
+        Lock               lock{mutex};
+        auto&              entry = entries[id];
+        const bool         expired = Clock::now() >= entry.expiry;
+        std::exception_ptr error{};
+
+        if (entry.state == Entry::State::VALID) {
+            if (expired)
+                enqueue(id, entry); // Stale entry is used meanwhile
+        }
+        else if (entry.state == Entry::State::FAILED && !expired) {
+            error = entry.error;
         }
         else {
-            std::reverse_copy(addr.s6_addr, addr.s6_addr+16, ip);
+            entry.state = Entry::State::PENDING;
+            entry.waiters.push_back(resolved);
+            enqueue(id, entry);
+            return;
         }
-        ip[1] &= 0XF0; // Clear irrelevant bits
-
-        // Check first 12 bytes
-        static const uint8_t first12[12] = {0XFF, 0X30};
-        if (::memcmp(ip, first12, 12))
-            return false;
 
-        // Check last 4 bytes
-        const uint32_t last4 = (ip[12] << 24) | (ip[13] << 16) |
-                (ip[14] << 8) | ip[15];
-        return last4 <= 0X40000000 || last4 >= 0X80000000;
+        lock.unlock();
+        resolved(error);
     }
-};
-
-/******************************************************************************/
-
-class NameAddr final : public InetAddr::Impl
-{
-    std::string            name;
-    std::hash<std::string> myHash;
 
     /**
-     * Sets a socket address from the first IP-based Internet address that
-     * matches the given information.
+     * Sets a socket address from the resolution of a hostname. Only blocks if
+     * the hostname has never been resolved or its failed resolution has
+     * expired.
      *
+     * @param[in]  id                 Index of hostname
      * @param[out] storage            Socket address
-     * @param[in]  family             Address family. One of `AF_INET` or
-     *                                `AF_INET6`.
      * @param[in]  port               Port number in host byte-order
-     * @retval     `true`             Success. `sockaddr` is set.
-     * @retval     `false`            Failure. `sockaddr` is not set.
      * @throws     std::system_error  `::getaddrinfo()` failure
-     * @exceptionsafety               Strong guarantee
+     * @throws     RuntimeError       Hostname has no IP address
      * @threadsafety                  Safe
-     * @cancellationpoint             Maybe (`::getaddrinfo()` may be one)
+     * @cancellationpoint             Yes
      */
-    bool get_sockaddr(
+    void get(
+            const uint32_t           id,
             struct sockaddr_storage& storage,
-            const int                family,
-            const in_port_t          port) const
+            const in_port_t          port)
     {
-        bool             success = false;
-        struct addrinfo  hints = {};
-        struct addrinfo* list;
-
-        hints.ai_family = family;
-        hints.ai_socktype = 0;
-
-        if (::getaddrinfo(name.data(), nullptr, &hints, &list))
-            throw SYSTEM_ERROR(
-                    std::string("::getaddrinfo() failure for host \"") +
-                    name.data() + "\"");
-        try {
-            for (struct addrinfo* entry = list; entry != NULL;
-                    entry = entry->ai_next) {
-                if (entry->ai_family == AF_INET) {
-                    auto*       dstaddr =
-                            reinterpret_cast<struct sockaddr_in*>(&storage);
-                    const auto* srcaddr = reinterpret_cast
-                            <const struct sockaddr_in*>(entry->ai_addr);
-                    *dstaddr = *srcaddr;
-                    dstaddr->sin_port = htons(port);
-                    success = true;
-                    break;
-                }
-                else if (entry->ai_family == AF_INET6) {
-                    auto*       dstaddr =
-                            reinterpret_cast<struct sockaddr_in6*>(&storage);
-                    const auto* srcaddr = reinterpret_cast
-                            <const struct sockaddr_in6*>(entry->ai_addr);
-                    *dstaddr = *srcaddr;
-                    dstaddr->sin6_port = htons(port);
-                    success = true;
-                    break;
-                }
-            }
-
-            freeaddrinfo(list);
-            return success;
-        }
-        catch (...) {
-            freeaddrinfo(list);
-            throw;
-        }
-    }
+        Lock  lock{mutex};
+        auto& entry = entries[id];
 
-public:
-    NameAddr(const std::string& name)
-        : name{name}
-    {}
-
-    int getFamily() const noexcept
-    {
-        return AF_UNSPEC;
-    }
-
-    std::string to_string() const
-    {
-        return std::string(name);
-    }
-
-    bool operator <(const InetAddr::Impl& rhs) const noexcept
-    {
-        return !(rhs < *this) && !(rhs == *this);
-    }
-
-    bool operator <(const Inet4Addr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    bool operator <(const Inet6Addr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    bool operator <(const NameAddr& rhs) const noexcept
-    {
-        return name < rhs.name;
-    }
-
-    bool operator ==(const InetAddr::Impl& rhs) const noexcept
-    {
-        return rhs == *this;
-    }
-
-    bool operator ==(const Inet4Addr& rhs) const noexcept
-    {
-        return false;
-    }
-
-    bool operator ==(const Inet6Addr& rhs) const noexcept
-    {
-        return false;
-    }
+        for (;;) {
+            const bool expired = Clock::now() >= entry.expiry;
 
-    bool operator ==(const NameAddr& rhs) const noexcept
-    {
-        return name == rhs.name;
-    }
+            if (entry.state == Entry::State::VALID) {
+                if (expired)
+                    enqueue(id, entry); // Stale entry is used meanwhile
+                break;
+            }
 
-    size_t hash() const noexcept {
-        return myHash(name);
-    }
+            if (entry.state == Entry::State::FAILED) {
+                if (!expired)
+                    std::rethrow_exception(entry.error);
+                entry.state = Entry::State::PENDING;
+            }
 
-    int socket(
-            const int type,
-            const int protocol) const
-    {
-        struct sockaddr_storage storage;
-        return createSocket(get_sockaddr(storage, 0)->sa_family, type,
-                protocol);
-    }
+            enqueue(id, entry);
+            cond.wait(lock);
+        }
 
-    SockAddr getSockAddr(const in_port_t port) const
-    {
-        return SockAddr(name, port);
+        copy(entry, storage, port);
     }
 
-    struct sockaddr* get_sockaddr(
+    /**
+     * Sets a socket address from the cached resolution of a hostname. Never
+     * blocks: if the resolution isn't cached, then it's started.
+     *
+     * @param[in]  id                 Index of hostname
+     * @param[out] storage            Socket address. Set only on success.
+     * @param[in]  port               Port number in host byte-order
+     * @retval     `true`             Success. `storage` is set.
+     * @retval     `false`            The resolution isn't cached. `storage`
+     *                                isn't set.
+     * @throws     std::system_error  `::getaddrinfo()` failure
+     * @throws     RuntimeError       Hostname has no IP address
+     * @threadsafety                  Safe
+     */
+    bool peek(
+            const uint32_t           id,
             struct sockaddr_storage& storage,
-            const in_port_t          port) const
+            const in_port_t          port)
     {
-        if (!get_sockaddr(storage, AF_INET, port) &&
-            !get_sockaddr(storage, AF_INET6, port))
-                throw RUNTIME_ERROR(
-                        "Couldn't get IP address for \"" + name + "\"");
-        return reinterpret_cast<struct sockaddr*>(&storage);
-    }
+        Lock       lock{mutex};
+        auto&      entry = entries[id];
+        const bool expired = Clock::now() >= entry.expiry;
 
-    void setMcastIface(int sd) const
-    {
-        struct sockaddr_storage storage;
-        get_sockaddr(storage, 0);
+        if (entry.state == Entry::State::FAILED && !expired)
+            std::rethrow_exception(entry.error);
 
-        if (storage.ss_family == AF_INET) {
-            const auto* sockaddr =
-                    reinterpret_cast<struct sockaddr_in*>(&storage);
-            Inet4Addr(sockaddr->sin_addr.s_addr).setMcastIface(sd);
-        }
-        else if (storage.ss_family == AF_INET6) {
-            const auto* sockaddr =
-                    reinterpret_cast<struct sockaddr_in6*>(&storage);
-            Inet6Addr(sockaddr->sin6_addr).setMcastIface(sd);
-        }
-        else {
-            throw LOGIC_ERROR("Unsupported address family: " +
-                    std::to_string(storage.ss_family));
-        }
-    }
+        if (expired)
+            enqueue(id, entry); // A stale, valid entry is used meanwhile
 
-    bool isSsm() const override {
-        return false;
+        if (entry.state != Entry::State::VALID)
+            return false;
+
+        copy(entry, storage, port);
+        return true;
     }
 };
 
 /******************************************************************************/
 
 InetAddr::InetAddr() noexcept
-    : pImpl()
+    : addr()
+    , type(Type::UNSET)
 {}
 
 InetAddr::InetAddr(const in_addr_t addr) noexcept
-    : pImpl(new Inet4Addr(addr))
-{}
+    : addr()
+    , type(Type::INET4)
+{
+    this->addr.in4.s_addr = addr;
+}
 
 InetAddr::InetAddr(const struct in_addr& addr) noexcept
     : InetAddr(addr.s_addr)
 {}
 
 InetAddr::InetAddr(const struct in6_addr& addr) noexcept
-    : pImpl(new Inet6Addr(addr))
-{}
+    : addr()
+    , type(Type::INET6)
+{
+    this->addr.in6 = addr;
+}
 
 InetAddr::InetAddr(const std::string& addr)
-    : pImpl()
+    : addr()
+    , type(Type::UNSET)
 {
-    const char*     cstr = addr.data();
-    struct in_addr  in4addr;
-    struct in6_addr in6addr;
+    const char* cstr = addr.data();
 
-    if (::inet_pton(AF_INET, cstr, &in4addr) == 1) {
-        pImpl.reset(new Inet4Addr(in4addr.s_addr));
+    if (::inet_pton(AF_INET, cstr, &this->addr.in4) == 1) {
+        type = Type::INET4;
     }
-    else if (::inet_pton(AF_INET6, cstr, &in6addr) == 1) {
-        pImpl.reset(new Inet6Addr(in6addr));
+    else if (::inet_pton(AF_INET6, cstr, &this->addr.in6) == 1) {
+        type = Type::INET6;
     }
     else {
-        pImpl.reset(new NameAddr(addr));
+        ::memset(&this->addr, 0, sizeof(this->addr));
+        this->addr.nameId = NameTable::instance().intern(addr);
+        type = Type::NAME;
+        Resolver::instance().prefetch(this->addr.nameId);
     }
 }
 
-InetAddr::operator bool() const noexcept
-{
-    return static_cast<bool>(pImpl);
-}
-
 int InetAddr::getFamily() const noexcept
 {
-    return pImpl->getFamily();
+    return (type == Type::INET4)
+            ? AF_INET
+            : (type == Type::INET6)
+                  ? AF_INET6
+                  : AF_UNSPEC;
 }
 
 std::string InetAddr::to_string() const
 {
-    return pImpl ? pImpl->to_string() : "(unset)";
-}
+    switch (type) {
+    case Type::INET4: {
+        char buf[INET_ADDRSTRLEN];
 
-bool InetAddr::operator<(const InetAddr& rhs) const noexcept
-{
-    auto impl1 = pImpl.get();
-    auto impl2 = rhs.pImpl.get();
-    return (impl1 == impl2)
-            ? false
-            : (impl1 == nullptr || impl2 == nullptr)
-                  ? (impl1 == nullptr)
-                  : *impl1 < *impl2;
-}
+        if (inet_ntop(AF_INET, &addr.in4.s_addr, buf, sizeof(buf)) == nullptr)
+            throw SYSTEM_ERROR("inet_ntop() failure");
 
-bool InetAddr::operator==(const InetAddr& rhs) const noexcept
-{
-    return !(*pImpl < *rhs.pImpl || *rhs.pImpl < *pImpl);
+        return std::string(buf);
+    }
+    case Type::INET6: {
+        char buf[INET6_ADDRSTRLEN];
+
+        if (inet_ntop(AF_INET6, &addr.in6, buf, sizeof(buf)) == nullptr)
+            throw SYSTEM_ERROR("inet_ntop() failure");
+
+        return std::string(buf);
+    }
+    case Type::NAME:
+        return NameTable::instance().get(addr.nameId);
+    default:
+        return "(unset)";
+    }
 }
 
-size_t InetAddr::hash() const noexcept
+bool InetAddr::operator<(const InetAddr& rhs) const noexcept
 {
-    return pImpl ? pImpl->hash() : 0;
+    // Unset < IPv4 < IPv6 < hostname
+    if (type != rhs.type)
+        return type < rhs.type;
+
+    switch (type) {
+    case Type::INET4:
+        return ntohl(addr.in4.s_addr) < ntohl(rhs.addr.in4.s_addr);
+    case Type::INET6:
+        return ::memcmp(&addr.in6, &rhs.addr.in6, sizeof(addr.in6)) < 0;
+    case Type::NAME: {
+        if (addr.nameId == rhs.addr.nameId)
+            return false;
+        const auto& names = NameTable::instance();
+        return names.get(addr.nameId) < names.get(rhs.addr.nameId);
+    }
+    default:
+        return false;
+    }
 }
 
 SockAddr InetAddr::getSockAddr(const in_port_t port) const
 {
-    return pImpl->getSockAddr(port);
+    return SockAddr(*this, port);
 }
 
 int InetAddr::socket(
         const int type,
         const int protocol) const
 {
-    return pImpl->socket(type, protocol);
+    switch (this->type) {
+    case Type::INET4:
+        return createSocket(AF_INET, type, protocol);
+    case Type::INET6:
+        return createSocket(AF_INET6, type, protocol);
+    case Type::NAME: {
+        struct sockaddr_storage storage;
+        return createSocket(get_sockaddr(storage, 0)->sa_family, type,
+                protocol);
+    }
+    default:
+        throw LOGIC_ERROR("Address is unset");
+    }
 }
 
 void InetAddr::join(
         const int       sd,
         const InetAddr& srcAddr) const
 {
-    return pImpl->join(sd, srcAddr);
+    LOG_DEBUG("Joining multicast group %s from source %s",
+            to_string().data(), srcAddr.to_string().data());
+
+    // NB: The following is independent of protocol (i.e., IPv4 or IPv6)
+    struct group_source_req mreq = {};
+
+    mreq.gsr_interface = 0; // => O/S chooses interface
+    get_sockaddr(mreq.gsr_group, 0);
+    srcAddr.get_sockaddr(mreq.gsr_source, 0);
+
+    if (::setsockopt(sd, IPPROTO_IP, MCAST_JOIN_SOURCE_GROUP, &mreq,
+            sizeof(mreq)))
+        throw SYSTEM_ERROR("Couldn't join multicast group " +
+                to_string() + " from source " + srcAddr.to_string());
 }
 
 struct sockaddr* InetAddr::get_sockaddr(
         struct sockaddr_storage& storage,
         const in_port_t          port) const
 {
-    return pImpl->get_sockaddr(storage, port);
+    switch (type) {
+    case Type::INET4: {
+        ::memset(&storage, 0, sizeof(storage));
+        struct sockaddr_in* const sockaddr =
+                reinterpret_cast<struct sockaddr_in*>(&storage);
+        sockaddr->sin_family = AF_INET;
+        sockaddr->sin_addr = addr.in4;
+        sockaddr->sin_port = htons(port);
+        break;
+    }
+    case Type::INET6: {
+        ::memset(&storage, 0, sizeof(storage));
+        struct sockaddr_in6* const sockaddr =
+                reinterpret_cast<struct sockaddr_in6*>(&storage);
+        sockaddr->sin6_family = AF_INET6;
+        sockaddr->sin6_addr = addr.in6;
+        sockaddr->sin6_port = htons(port);
+        break;
+    }
+    case Type::NAME:
+        Resolver::instance().get(addr.nameId, storage, port);
+        break;
+    default:
+        throw LOGIC_ERROR("Address is unset");
+    }
+
+    return reinterpret_cast<struct sockaddr*>(&storage);
+}
+
+bool InetAddr::peek_sockaddr(
+        struct sockaddr_storage& storage,
+        const in_port_t          port) const
+{
+    if (type == Type::NAME)
+        return Resolver::instance().peek(addr.nameId, storage, port);
+
+    get_sockaddr(storage, port); // Doesn't block for an IP address
+    return true;
 }
 
 const InetAddr& InetAddr::setMcastIface(int sd) const
 {
-    pImpl->setMcastIface(sd);
+    switch (type) {
+    case Type::INET4: {
+        LOG_DEBUG("Setting multicast interface for IPv4 UDP socket %d to %s",
+                sd, to_string().data());
+        if (setsockopt(sd, IPPROTO_IP, IP_MULTICAST_IF, &addr.in4,
+                sizeof(addr.in4)) < 0)
+            throw SYSTEM_ERROR("Couldn't set multicast interface for IPv4 UDP "
+                    "socket " + std::to_string(sd) + " to " + to_string());
+        break;
+    }
+    case Type::INET6: {
+        unsigned ifaceIndex = getIfaceIndex(addr.in6);
+        LOG_DEBUG("Setting multicast interface for IPv6 UDP socket %d to %u",
+                sd, ifaceIndex);
+        if (setsockopt(sd, IPPROTO_IPV6, IPV6_MULTICAST_IF, &ifaceIndex,
+                       sizeof(ifaceIndex)) < 0)
+            throw SYSTEM_ERROR("Couldn't set multicast interface for IPv6 UDP "
+                    "socket " + std::to_string(sd) + " to " +
+                    std::to_string(ifaceIndex));
+        break;
+    }
+    case Type::NAME: {
+        struct sockaddr_storage storage;
+        get_sockaddr(storage, 0);
+
+        if (storage.ss_family == AF_INET) {
+            const auto* sockaddr =
+                    reinterpret_cast<struct sockaddr_in*>(&storage);
+            InetAddr(sockaddr->sin_addr).setMcastIface(sd);
+        }
+        else if (storage.ss_family == AF_INET6) {
+            const auto* sockaddr =
+                    reinterpret_cast<struct sockaddr_in6*>(&storage);
+            InetAddr(sockaddr->sin6_addr).setMcastIface(sd);
+        }
+        else {
+            throw LOGIC_ERROR("Unsupported address family: " +
+                    std::to_string(storage.ss_family));
+        }
+        break;
+    }
+    default:
+        throw LOGIC_ERROR("Address is unset");
+    }
+
     return *this;
 }
 
+void InetAddr::prefetch() const
+{
+    if (type == Type::NAME)
+        Resolver::instance().prefetch(addr.nameId);
+}
+
+void InetAddr::whenResolved(const Resolved& resolved) const
+{
+    if (type == Type::UNSET)
+        throw LOGIC_ERROR("Address is unset");
+
+    if (type == Type::NAME) {
+        Resolver::instance().whenResolved(addr.nameId, resolved);
+    }
+    else {
+        resolved(std::exception_ptr{});
+    }
+}
+
+void InetAddr::setResolverTtl(
+        const std::chrono::seconds positive,
+        const std::chrono::seconds negative)
+{
+    Resolver::instance().setTtl(positive, negative);
+}
+
 bool InetAddr::isSsm() const
 {
-    return pImpl->isSsm();
+    if (type == Type::INET4) {
+        auto ip = ntohl(addr.in4.s_addr);
+        return ip >= 0XE8000100 && ip <= 0XE8FFFFFF;
+    }
+
+    if (type == Type::INET6) {
+        /*
+         * FF3X::0000 through FF3X::4000:0000 or FF3X::8000:0000 through
+         * FF3X::FFFF:FFFF (for IPv6).
+         */
+        uint8_t ip[16];
+        if (htons(1) == 1) {
+            ::memcpy(ip, addr.in6.s6_addr, 16);
+        }
+        else {
+            std::reverse_copy(addr.in6.s6_addr, addr.in6.s6_addr+16, ip);
+        }
+        ip[1] &= 0XF0; // Clear irrelevant bits
+
+        // Check first 12 bytes
+        static const uint8_t first12[12] = {0XFF, 0X30};
+        if (::memcmp(ip, first12, 12))
+            return false;
+
+        // Check last 4 bytes
+        const uint32_t last4 = (ip[12] << 24) | (ip[13] << 16) |
+                (ip[14] << 8) | ip[15];
+        return last4 <= 0X40000000 || last4 >= 0X80000000;
+    }
+
+    return false;
 }
 
 } // namespace
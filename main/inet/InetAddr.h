@@ -23,24 +23,68 @@
 #ifndef MAIN_NET_IO_INADDR_H_
 #define MAIN_NET_IO_INADDR_H_
 
-#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <netinet/in.h>
+#include <string>
 
 namespace hycast {
 
 class SockAddr;
 
+/**
+ * Internet address. A small, fixed-size value type: IPv4 and IPv6 addresses
+ * are stored inline and a hostname is stored as the index of an interned
+ * string. Consequently, instances are trivially copyable and can be hashed and
+ * compared without indirection.
+ */
 class InetAddr
 {
 public:
-    class                 Impl;
+    /// Kind of address
+    enum class Type : uint8_t {
+        UNSET, ///< Default constructed
+        INET4, ///< IPv4 address
+        INET6, ///< IPv6 address
+        NAME   ///< Hostname
+    };
+
+private:
+    union {
+        struct in_addr  in4;    ///< IPv4 address in network byte-order
+        struct in6_addr in6;    ///< IPv6 address in network byte-order
+        uint32_t        nameId; ///< Index of interned hostname
+    }    addr;
+    Type type;
 
-protected:
-    std::shared_ptr<Impl> pImpl;
+    /**
+     * Mixes the bits of a value. Used for hashing.
+     *
+     * @param[in] value  Value to be mixed
+     * @return           Mixed value
+     */
+    static inline uint64_t mix(uint64_t value) noexcept {
+        value ^= value >> 33;
+        value *= UINT64_C(0xff51afd7ed558ccd);
+        value ^= value >> 33;
+        value *= UINT64_C(0xc4ceb9fe1a85ec53);
+        value ^= value >> 33;
+        return value;
+    }
 
-    InetAddr(Impl* impl);
+    friend class SockAddr;
 
 public:
+    /**
+     * Function that's called when the resolution of an instance is available.
+     *
+     * @param[in] error  Reason the resolution failed. Empty on success.
+     */
+    using Resolved = std::function<void(std::exception_ptr error)>;
+
     /**
      * Default constructs.
      */
@@ -68,14 +112,45 @@ public:
     InetAddr(const struct in6_addr& addr) noexcept;
 
     /**
-     * Constructs from a string representation of an Internet address.
+     * Constructs from a string representation of an Internet address. If the
+     * string is a hostname, then its asynchronous resolution is started.
      *
      * @param[in] addr  String representation of Internet address
      */
     InetAddr(const std::string& addr);
 
-    operator bool() const noexcept;
+    /**
+     * Sets the time-to-live of cached hostname resolutions. The defaults are 5
+     * minutes for successful resolutions and 30 seconds for failed ones.
+     *
+     * @param[in] positive  Time-to-live of successful resolutions
+     * @param[in] negative  Time-to-live of failed resolutions
+     * @threadsafety        Safe
+     */
+    static void setResolverTtl(
+            const std::chrono::seconds positive,
+            const std::chrono::seconds negative);
 
+    inline operator bool() const noexcept {
+        return type != Type::UNSET;
+    }
+
+    /**
+     * Returns the kind of this instance.
+     *
+     * @return Kind of this instance
+     */
+    inline Type getType() const noexcept {
+        return type;
+    }
+
+    /**
+     * Returns the address family of this instance.
+     *
+     * @retval `AF_INET`    IPv4 address
+     * @retval `AF_INET6`   IPv6 address
+     * @retval `AF_UNSPEC`  Hostname or unset
+     */
     int getFamily() const noexcept;
 
     /**
@@ -87,9 +162,36 @@ public:
 
     bool operator <(const InetAddr& rhs) const noexcept;
 
-    bool operator ==(const InetAddr& rhs) const noexcept;
+    inline bool operator ==(const InetAddr& rhs) const noexcept {
+        if (type != rhs.type)
+            return false;
+        switch (type) {
+        case Type::INET4:
+            return addr.in4.s_addr == rhs.addr.in4.s_addr;
+        case Type::INET6:
+            return ::memcmp(&addr.in6, &rhs.addr.in6, sizeof(addr.in6)) == 0;
+        case Type::NAME:
+            return addr.nameId == rhs.addr.nameId; // Names are interned
+        default:
+            return true;
+        }
+    }
 
-    size_t hash() const noexcept;
+    inline size_t hash() const noexcept {
+        switch (type) {
+        case Type::INET4:
+            return mix(addr.in4.s_addr);
+        case Type::INET6: {
+            uint64_t words[2];
+            ::memcpy(words, &addr.in6, sizeof(words));
+            return mix(words[0] ^ mix(words[1]));
+        }
+        case Type::NAME:
+            return mix((static_cast<uint64_t>(1) << 32) | addr.nameId);
+        default:
+            return 0;
+        }
+    }
 
     /**
      * Returns a socket address corresponding to this instance and a port
@@ -100,6 +202,27 @@ public:
      */
     SockAddr getSockAddr(const in_port_t port) const;
 
+    /**
+     * Starts the asynchronous resolution of this instance if it's based on a
+     * hostname whose resolution isn't cached or is stale. Doesn't block.
+     *
+     * @threadsafety  Safe
+     */
+    void prefetch() const;
+
+    /**
+     * Calls a function when this instance has been resolved, so that a caller
+     * that can't block needn't call `get_sockaddr()` until it won't block.
+     * Never blocks. The function is called immediately, on the current
+     * thread, if this instance is an IP address or its resolution is cached;
+     * otherwise, it's called on a resolver thread and so shouldn't block.
+     *
+     * @param[in] resolved    Function to call
+     * @throws    LogicError  This instance is unset
+     * @threadsafety          Safe
+     */
+    void whenResolved(const Resolved& resolved) const;
+
     /**
      * Returns a socket descriptor appropriate to this instance's address
      * family.
@@ -131,17 +254,45 @@ public:
             const InetAddr& srcAddr) const;
 
     /**
-     * Sets a socket address structure and returns a pointer to it.
+     * Sets a socket address structure and returns a pointer to it. If this
+     * instance is a hostname that has never been resolved (or whose failed
+     * resolution has expired), then this function blocks until the resolver
+     * pool has resolved it. Callers that mustn't block should first call
+     * `whenResolved()`.
      *
      * @param[in] storage  Socket address structure
      * @param[in] port     Port number in host byte-order
      * @return             Pointer to given socket address structure
      * @threadsafety       Safe
+     * @cancellationpoint  Maybe (will wait for a hostname to be resolved if
+     *                     its resolution isn't cached)
      */
     struct sockaddr* get_sockaddr(
             struct sockaddr_storage& storage,
             const in_port_t          port) const;
 
+    /**
+     * Sets a socket address structure if that can be done without blocking:
+     * i.e., if this instance is an IP address or a hostname whose resolution
+     * is cached. Otherwise, the resolution of the hostname is started.
+     *
+     * @param[out] storage            Socket address structure. Set only on
+     *                                success.
+     * @param[in]  port               Port number in host byte-order
+     * @retval     `true`             Success. `storage` is set.
+     * @retval     `false`            The hostname hasn't been resolved
+     * @throws     LogicError         This instance is unset
+     * @throws     std::system_error  The cached resolution of the hostname
+     *                                failed: `::getaddrinfo()` failure
+     * @throws     RuntimeError       The cached resolution of the hostname
+     *                                failed: it has no IP address
+     * @threadsafety                  Safe
+     * @see `whenResolved()`
+     */
+    bool peek_sockaddr(
+            struct sockaddr_storage& storage,
+            const in_port_t          port) const;
+
     /**
      * Set a UDP socket to use the interface associated with this instance.
      *
@@ -170,4 +321,13 @@ public:
 
 } // namespace
 
+namespace std {
+    template<>
+    struct hash<hycast::InetAddr> {
+        inline size_t operator()(const hycast::InetAddr& inetAddr) const {
+            return inetAddr.hash();
+        }
+    };
+}
+
 #endif /* MAIN_NET_IO_IPADDR_H_ */
@@ -0,0 +1,373 @@
+/**
+ * Memory-mapped, TPACKET_V3 receive ring for source-specific multicast UDP
+ * datagrams.
+ *
+ *        File: PacketRing.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "PacketRing.h"
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <mutex>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace hycast {
+
+class PacketRing::Impl
+{
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
+
+    mutable Mutex   mutex;       ///< Protects `stats`
+    int             sd;          ///< `AF_PACKET` socket
+    int             joinSd;      ///< UDP socket for group membership
+    int             haltFd;      ///< `eventfd` for `halt()`
+    unsigned        blockSize;   ///< Size of a block in bytes
+    unsigned        numBlocks;   ///< Number of blocks
+    uint8_t*        ring;        ///< Memory-mapped ring
+    unsigned        blockIndex;  ///< Index of current block
+    bool            inBlock;     ///< Current block is owned by user?
+    uint32_t        numPkts;     ///< Number of packets left in current block
+    tpacket3_hdr*   pkt;         ///< Current packet or `nullptr`
+    mutable Stats   stats;       ///< Cumulative statistics
+
+    /**
+     * Returns the descriptor of a block.
+     *
+     * @param[in] index  Index of the block
+     * @return           Descriptor of the block
+     */
+    inline tpacket_block_desc* block(const unsigned index) const noexcept {
+        return reinterpret_cast<tpacket_block_desc*>(ring + index*blockSize);
+    }
+
+    /**
+     * Attaches a BPF program that accepts only unfragmented IPv4 UDP datagrams
+     * from a given source to a given group and port.
+     *
+     * @param[in] grpAddr      Multicast group
+     * @param[in] srcAddr      Sending host
+     * @throws    SystemError  `::setsockopt()` failure
+     */
+    void attachFilter(
+            const struct sockaddr_in& grpAddr,
+            const struct sockaddr_in& srcAddr) {
+        // Offsets are relative to the IP header because the socket is
+        // `SOCK_DGRAM`
+        struct sock_filter code[] = {
+            BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 9),               // Protocol
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   IPPROTO_UDP, 0, 10),
+            BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, 12),              // Source
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                    ntohl(srcAddr.sin_addr.s_addr), 0, 8),
+            BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, 16),              // Dest.
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                    ntohl(grpAddr.sin_addr.s_addr), 0, 6),
+            BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 6),               // Frag.
+            BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K,  0x1fff, 4, 0),
+            BPF_STMT(BPF_LDX | BPF_B   | BPF_MSH, 0),               // IHL
+            BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, 2),               // Port
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                    ntohs(grpAddr.sin_port), 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF),                  // Accept
+            BPF_STMT(BPF_RET | BPF_K, 0),                           // Reject
+        };
+        struct sock_fprog prog = {
+                static_cast<unsigned short>(sizeof(code)/sizeof(code[0])),
+                code};
+
+        if (::setsockopt(sd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+                sizeof(prog)))
+            throw SYSTEM_ERROR("Couldn't attach BPF filter to packet socket " +
+                    std::to_string(sd));
+    }
+
+    /**
+     * Creates the memory-mapped ring.
+     *
+     * @throws SystemError  System failure
+     */
+    void createRing() {
+        const int version = TPACKET_V3;
+        if (::setsockopt(sd, SOL_PACKET, PACKET_VERSION, &version,
+                sizeof(version)))
+            throw SYSTEM_ERROR("Couldn't set TPACKET_V3 on packet socket " +
+                    std::to_string(sd));
+
+        struct tpacket_req3 req = {};
+        req.tp_block_size = blockSize;
+        req.tp_block_nr = numBlocks;
+        req.tp_frame_size = TPACKET_ALIGNMENT << 7; // Nominal for V3
+        req.tp_frame_nr = (blockSize/req.tp_frame_size) * numBlocks;
+        req.tp_retire_blk_tov = 10; // Milliseconds before partial block retired
+
+        if (::setsockopt(sd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)))
+            throw SYSTEM_ERROR("Couldn't create receive ring: blockSize=" +
+                    std::to_string(blockSize) + ", numBlocks=" +
+                    std::to_string(numBlocks));
+
+        void* addr = ::mmap(nullptr, static_cast<size_t>(blockSize)*numBlocks,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED | MAP_POPULATE,
+                sd, 0);
+        if (addr == MAP_FAILED) {
+            // Locking might exceed RLIMIT_MEMLOCK; try without
+            addr = ::mmap(nullptr, static_cast<size_t>(blockSize)*numBlocks,
+                    PROT_READ | PROT_WRITE, MAP_SHARED, sd, 0);
+            if (addr == MAP_FAILED)
+                throw SYSTEM_ERROR("Couldn't memory-map receive ring");
+        }
+        ring = static_cast<uint8_t*>(addr);
+    }
+
+    /**
+     * Releases the current block to the kernel and advances to the next one.
+     */
+    void releaseBlock() noexcept {
+        __sync_synchronize();
+        block(blockIndex)->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        blockIndex = (blockIndex + 1) % numBlocks;
+        inBlock = false;
+        numPkts = 0;
+        pkt = nullptr;
+    }
+
+    /**
+     * Updates the cumulative statistics from the kernel, which resets its
+     * statistics when they're read.
+     *
+     * @pre                 `mutex` is locked
+     * @throws SystemError  `::getsockopt()` failure
+     */
+    void updateStats() const {
+        struct tpacket_stats_v3 kStats = {};
+        socklen_t               len = sizeof(kStats);
+
+        if (::getsockopt(sd, SOL_PACKET, PACKET_STATISTICS, &kStats, &len))
+            throw SYSTEM_ERROR("Couldn't get statistics of packet socket " +
+                    std::to_string(sd));
+
+        stats.packets += kStats.tp_packets;
+        stats.drops += kStats.tp_drops;
+        stats.freezes += kStats.tp_freeze_q_cnt;
+    }
+
+    void close() noexcept {
+        if (ring)
+            ::munmap(ring, static_cast<size_t>(blockSize)*numBlocks);
+        if (sd >= 0)
+            ::close(sd);
+        if (joinSd >= 0)
+            ::close(joinSd);
+        if (haltFd >= 0)
+            ::close(haltFd);
+    }
+
+public:
+    Impl(   const SockAddr&    grpAddr,
+            const InetAddr&    srcAddr,
+            const std::string& ifaceName,
+            const unsigned     blockSize,
+            const unsigned     numBlocks)
+        : mutex()
+        , sd(-1)
+        , joinSd(-1)
+        , haltFd(-1)
+        , blockSize(blockSize)
+        , numBlocks(numBlocks)
+        , ring(nullptr)
+        , blockIndex(0)
+        , inBlock(false)
+        , numPkts(0)
+        , pkt(nullptr)
+        , stats()
+    {
+        struct sockaddr_storage grpStorage;
+        struct sockaddr_storage srcStorage;
+        grpAddr.get_sockaddr(grpStorage);
+        srcAddr.get_sockaddr(srcStorage, 0);
+        if (grpStorage.ss_family != AF_INET || srcStorage.ss_family != AF_INET)
+            throw INVALID_ARGUMENT("Only IPv4 is supported: group=" +
+                    grpAddr.to_string() + ", source=" + srcAddr.to_string());
+
+        const unsigned ifIndex = ::if_nametoindex(ifaceName.data());
+        if (ifIndex == 0)
+            throw SYSTEM_ERROR("Unknown interface: \"" + ifaceName + "\"");
+
+        try {
+            // Protocol 0 => nothing received until bound, after filter attached
+            sd = ::socket(AF_PACKET, SOCK_DGRAM, 0);
+            if (sd == -1)
+                throw SYSTEM_ERROR("Couldn't create packet socket");
+
+            attachFilter(*reinterpret_cast<struct sockaddr_in*>(&grpStorage),
+                    *reinterpret_cast<struct sockaddr_in*>(&srcStorage));
+            createRing();
+
+            struct sockaddr_ll sll = {};
+            sll.sll_family = AF_PACKET;
+            sll.sll_protocol = htons(ETH_P_IP);
+            sll.sll_ifindex = ifIndex;
+            if (::bind(sd, reinterpret_cast<struct sockaddr*>(&sll),
+                    sizeof(sll)))
+                throw SYSTEM_ERROR("Couldn't bind packet socket to interface "
+                        "\"" + ifaceName + "\"");
+
+            /*
+             * Group membership is per interface rather than per socket, so an
+             * unread UDP socket on a different port suffices to have the group
+             * delivered to the interface. The datagrams don't match the
+             * socket's port, so the kernel UDP path doesn't queue them.
+             */
+            joinSd = grpAddr.socket(SOCK_DGRAM, IPPROTO_UDP);
+            grpAddr.clone(0).bind(joinSd);
+            grpAddr.getInetAddr().join(joinSd, srcAddr);
+
+            haltFd = ::eventfd(0, 0);
+            if (haltFd == -1)
+                throw SYSTEM_ERROR("Couldn't create eventfd");
+        }
+        catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    ~Impl() noexcept {
+        close();
+    }
+
+    bool next(
+            const void*& data,
+            size_t&      nbytes) {
+        for (;;) {
+            if (numPkts) {
+                // Advance to the next packet in the current block
+                pkt = pkt
+                        ? reinterpret_cast<tpacket3_hdr*>(
+                                reinterpret_cast<uint8_t*>(pkt) +
+                                pkt->tp_next_offset)
+                        : reinterpret_cast<tpacket3_hdr*>(
+                                reinterpret_cast<uint8_t*>(block(blockIndex)) +
+                                block(blockIndex)->hdr.bh1.offset_to_first_pkt);
+                --numPkts;
+
+                const auto* sll = reinterpret_cast<const sockaddr_ll*>(
+                        reinterpret_cast<uint8_t*>(pkt) +
+                        TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+                if (sll->sll_pkttype == PACKET_OUTGOING)
+                    continue; // Looped-back copy is seen as incoming
+
+                const uint8_t* ip = reinterpret_cast<uint8_t*>(pkt) +
+                        pkt->tp_net;
+                const size_t   ipHdrLen = (ip[0] & 0xf) * 4;
+                const auto*    udp = reinterpret_cast<const struct udphdr*>(
+                        ip + ipHdrLen);
+                const size_t   udpLen = ntohs(udp->len);
+
+                if (udpLen < sizeof(*udp) ||
+                        ipHdrLen + udpLen > pkt->tp_snaplen)
+                    continue; // Truncated or corrupt
+
+                data = udp + 1;
+                nbytes = udpLen - sizeof(*udp);
+                return true;
+            }
+
+            if (inBlock)
+                releaseBlock(); // Current block was processed
+
+            auto* desc = block(blockIndex);
+            if (desc->hdr.bh1.block_status & TP_STATUS_USER) {
+                __sync_synchronize();
+                inBlock = true;
+                numPkts = desc->hdr.bh1.num_pkts;
+                pkt = nullptr;
+                continue;
+            }
+
+            // Wait for the kernel to retire a block or for `halt()`
+            struct pollfd pfds[2] = {
+                    {sd, POLLIN | POLLERR, 0},
+                    {haltFd, POLLIN, 0}};
+            if (::poll(pfds, 2, -1) == -1) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("poll() failure on packet socket " +
+                        std::to_string(sd));
+            }
+            if (pfds[1].revents)
+                return false;
+        }
+    }
+
+    void halt() const {
+        const uint64_t one = 1;
+        if (::write(haltFd, &one, sizeof(one)) != sizeof(one))
+            throw SYSTEM_ERROR("Couldn't write to eventfd");
+    }
+
+    Stats getStats() const {
+        Guard guard{mutex};
+        updateStats();
+        return stats;
+    }
+};
+
+/******************************************************************************/
+
+PacketRing::PacketRing(
+        const SockAddr&    grpAddr,
+        const InetAddr&    srcAddr,
+        const std::string& ifaceName,
+        const unsigned     blockSize,
+        const unsigned     numBlocks)
+    : pImpl{new Impl(grpAddr, srcAddr, ifaceName, blockSize, numBlocks)}
+{}
+
+bool PacketRing::next(
+        const void*& data,
+        size_t&      nbytes) const
+{
+    return pImpl->next(data, nbytes);
+}
+
+void PacketRing::halt() const
+{
+    pImpl->halt();
+}
+
+PacketRing::Stats PacketRing::getStats() const
+{
+    return pImpl->getStats();
+}
+
+} // namespace
@@ -0,0 +1,111 @@
+/**
+ * Memory-mapped, TPACKET_V3 receive ring for source-specific multicast UDP
+ * datagrams.
+ *
+ *        File: PacketRing.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_INET_PACKETRING_H_
+#define MAIN_INET_PACKETRING_H_
+
+#include "InetAddr.h"
+#include "SockAddr.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Receives the UDP datagrams of a source-specific multicast group from a
+ * memory-mapped TPACKET_V3 ring of an `AF_PACKET` socket. A classic BPF
+ * program restricts the ring to the group, port, and source. Datagram payloads
+ * are accessed in place in the ring, so there's no copying and no per-datagram
+ * system call. Requires the `CAP_NET_RAW` capability. IPv4 only.
+ */
+class PacketRing
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Ring statistics
+    struct Stats {
+        uint64_t packets; ///< Number of packets that passed the filter
+        uint64_t drops;   ///< Number of packets dropped because ring was full
+        uint64_t freezes; ///< Number of times the ring was full
+    };
+
+    /**
+     * Constructs. Joins the multicast group.
+     *
+     * @param[in] grpAddr          Socket address of the multicast group
+     * @param[in] srcAddr          Address of the sending host
+     * @param[in] ifaceName        Name of the receiving interface (e.g., "lo",
+     *                             "eth0")
+     * @param[in] blockSize        Size of a ring block in bytes. Must be a
+     *                             multiple of the page size.
+     * @param[in] numBlocks        Number of blocks in the ring
+     * @throws    InvalidArgument  An address isn't IPv4
+     * @throws    SystemError      System failure (e.g., lack of `CAP_NET_RAW`)
+     */
+    PacketRing(
+            const SockAddr&    grpAddr,
+            const InetAddr&    srcAddr,
+            const std::string& ifaceName,
+            const unsigned     blockSize = 1U << 20,
+            const unsigned     numBlocks = 64);
+
+    /**
+     * Returns the payload of the next datagram. The payload remains valid
+     * until the next call. Blocks until a datagram is available or `halt()`
+     * is called.
+     *
+     * @param[out] data         Start of payload in the ring
+     * @param[out] nbytes       Number of bytes in payload
+     * @retval     `true`       Success. `data` and `nbytes` are set.
+     * @retval     `false`      `halt()` was called
+     * @throws     SystemError  System failure
+     * @cancellationpoint       Yes
+     */
+    bool next(
+            const void*& data,
+            size_t&      nbytes) const;
+
+    /**
+     * Causes `next()` to return `false`. Idempotent.
+     *
+     * @throws SystemError  System failure
+     * @threadsafety        Safe
+     */
+    void halt() const;
+
+    /**
+     * Returns cumulative statistics on the ring since construction.
+     *
+     * @return              Ring statistics
+     * @throws SystemError  System failure
+     */
+    Stats getStats() const;
+};
+
+} // namespace
+
+#endif /* MAIN_INET_PACKETRING_H_ */
@@ -35,169 +35,16 @@
 
 namespace hycast {
 
-class SockAddr::Impl
-{
-protected:
-    InetAddr             inetAddr;
-    in_port_t            port;     // Port number in host byte-order
-    std::hash<in_port_t> portHash;
-
-public:
-    Impl()
-        : inetAddr{}
-        , port{0}
-    {}
-
-    Impl(   const InetAddr& inetAddr,
-            const in_port_t port)
-        : inetAddr{inetAddr}
-        , port{port}
-    {
-        if (port > 65535)
-            throw INVALID_ARGUMENT("Port number is too large: " +
-                    std::to_string(port));
-    }
-
-    const InetAddr& getInetAddr() const noexcept
-    {
-        return inetAddr;
-    }
-
-    in_port_t getPort() const noexcept
-    {
-        return port;
-    }
-
-    std::string to_string(const bool withName = false) const noexcept
-    {
-        return (withName ? "SockAddr{" : "") +
-                ((inetAddr.getFamily() == AF_INET6)
-                    ? "[" + inetAddr.to_string() + "]:" + std::to_string(port)
-                    : inetAddr.to_string() + ":" + std::to_string(port)) +
-               (withName ? "}" : "");
-    }
-
-    bool operator<(const Impl& rhs) const noexcept
-    {
-        return (inetAddr < rhs.inetAddr)
-                ? true
-                : (rhs.inetAddr < inetAddr)
-                  ? false
-                  : (port < rhs.port);
-    }
-
-    bool operator==(const Impl& rhs) const
-    {
-        return !((*this < rhs) || (rhs < *this));
-    }
-
-    /**
-     * Returns the hash value of this instance.
-     *
-     * @return The hash value of this instance
-     */
-    size_t hash() const noexcept {
-        return inetAddr.hash() ^ portHash(port);
-    }
-
-    void get_sockaddr(struct sockaddr_storage& storage) const
-    {
-        inetAddr.get_sockaddr(storage, port);
-    }
-
-    /**
-     * Returns a socket appropriate to this instance's address family.
-     *
-     * @param[in] type               Type of socket. One of `SOCK_STREAM`,
-     *                               `SOCK_DGRAM`, or `SOCK_SEQPACKET`.
-     * @param[in] protocol           Protocol. E.g., `IPPROTO_TCP` or `0` to
-     *                               obtain the default protocol.
-     * @return                       Appropriate socket
-     * @throws    std::system_error  `::socket()` failure
-     */
-    int socket(
-            const int type,
-            const int protocol) const
-    {
-        return inetAddr.socket(type, protocol);
-    }
-
-    /**
-     * Binds a socket to a local socket address.
-     *
-     * @param[in] sd                 Socket descriptor
-     * @throws    std::system_error  `::bind()` failure
-     * @threadsafety                 Safe
-     */
-    void bind(const int sd) const
-    {
-        struct sockaddr_storage storage;
-
-        if (::bind(sd, inetAddr.get_sockaddr(storage, port), sizeof(storage)))
-            throw SYSTEM_ERROR("Couldn't bind() socket " + std::to_string(sd) +
-                    " to " + to_string());
-    }
-
-    /**
-     * Connects a socket to a remote socket address.
-     *
-     * @param[in] sd                 Socket descriptor
-     * @throws    std::system_error  `::connect()` failure
-     * @threadsafety                 Safe
-     */
-    void connect(const int sd) const
-    {
-        LOG_DEBUG("Connecting to " + to_string());
-        struct sockaddr_storage storage;
-
-        if (::connect(sd, inetAddr.get_sockaddr(storage, port),
-                sizeof(storage)))
-            throw SYSTEM_ERROR("Couldn't connect() socket " +
-                    std::to_string(sd) + " to " + to_string());
-    }
-
-    /**
-     * Joins the source-specific multicast group identified by this instance
-     * and the address of the sending host.
-     *
-     * @param[in] sd       Socket identifier
-     * @param[in] srcAddr  Address of the sending host
-     * @threadsafety       Safe
-     * @exceptionsafety    Strong guarantee
-     * @cancellationpoint  Maybe (`::getaddrinfo()` may be one and will be
-     *                     called if either address is based on a name)
-     */
-    void join(
-            const int       sd,
-            const InetAddr& srcAddr) const
-    {
-        LOG_DEBUG("Joining multicast group %s from source %s",
-                to_string().data(), srcAddr.to_string().data());
-
-        // NB: The following is independent of protocol (i.e., IPv4 or IPv6)
-        struct group_source_req mreq = {};
-
-        mreq.gsr_interface = 0; // 0 => O/S chooses interface
-        inetAddr.get_sockaddr(mreq.gsr_group, port);
-        srcAddr.get_sockaddr(mreq.gsr_source, 0);
-
-        if (::setsockopt(sd, IPPROTO_IP, MCAST_JOIN_SOURCE_GROUP, &mreq,
-                sizeof(mreq)))
-            throw SYSTEM_ERROR("Couldn't join multicast group " +
-                    to_string() + " from source " + srcAddr.to_string());
-    }
-};
-
-/******************************************************************************/
-
 SockAddr::SockAddr() noexcept
-    : pImpl()
+    : inetAddr()
+    , port(0)
 {}
 
 SockAddr::SockAddr(
         const InetAddr& inetAddr,
         in_port_t       port)
-    : pImpl{new Impl(inetAddr, port)}
+    : inetAddr(inetAddr)
+    , port(port)
 {}
 
 SockAddr::SockAddr(
@@ -227,24 +74,24 @@ SockAddr::SockAddr(const struct sockaddr_in6& sockaddr)
 {}
 
 SockAddr::SockAddr(const struct sockaddr_storage& storage)
-    : pImpl()
+    : SockAddr()
 {
     if (storage.ss_family == AF_INET) {
         const struct sockaddr_in* addr =
                 reinterpret_cast<const struct sockaddr_in*>(&storage);
-        pImpl.reset(new Impl(InetAddr(addr->sin_addr), ntohs(addr->sin_port)));
+        inetAddr = InetAddr(addr->sin_addr);
+        port = ntohs(addr->sin_port);
     }
     else if (storage.ss_family == AF_INET6) {
         const struct sockaddr_in6* addr =
                 reinterpret_cast<const struct sockaddr_in6*>(&storage);
-        pImpl.reset(new Impl(InetAddr(addr->sin6_addr),
-                ntohs(addr->sin6_port)));
+        inetAddr = InetAddr(addr->sin6_addr);
+        port = ntohs(addr->sin6_port);
     }
     else {
         throw INVALID_ARGUMENT("Unsupported address family: " +
                 std::to_string(storage.ss_family));
     }
-    //LOG_DEBUG("%s", pImpl->to_string().c_str());
 }
 
 SockAddr::SockAddr(const struct sockaddr& sockaddr)
@@ -254,22 +101,8 @@ SockAddr::SockAddr(const struct sockaddr& sockaddr)
 SockAddr::SockAddr(
         const std::string& addr,
         const in_port_t    port)
-    : SockAddr{}
-{
-    const char*     cstr{addr.data()};
-    struct in_addr  inaddr;
-    struct in6_addr in6addr;
-
-    if (inet_pton(AF_INET, cstr, &inaddr) == 1) {
-        pImpl.reset(new Impl(InetAddr(inaddr), port));
-    }
-    else if (inet_pton(AF_INET6, cstr, &in6addr) == 1) {
-        pImpl.reset(new Impl(InetAddr(in6addr), port));
-    }
-    else {
-        pImpl.reset(new Impl(InetAddr(addr), port));
-    }
-}
+    : SockAddr(InetAddr(addr), port) // Handles IPv4, IPv6, and hostnames
+{}
 
 static bool parseSpec(
         const char* const  spec,
@@ -333,7 +166,8 @@ SockAddr::SockAddr(const std::string& spec)
                 throw INVALID_ARGUMENT(std::string(
                         "Invalid IPv4 specification: \"") + id + "\"");
 
-            pImpl.reset(new Impl(InetAddr(addr), port));
+            inetAddr = InetAddr(addr);
+            this->port = port;
         }
         else if (parseSpec(cstr, "[%m[0-9a-fA-F:]]:%5lu%n", id, port)) {
             struct in6_addr addr;
@@ -342,10 +176,12 @@ SockAddr::SockAddr(const std::string& spec)
                 throw INVALID_ARGUMENT(std::string(
                         "Invalid IPv6 specification: \"") + id + "\"");
 
-            pImpl.reset(new Impl(addr, port));
+            inetAddr = InetAddr(addr);
+            this->port = port;
         }
         else if (parseSpec(cstr, "%m[0-9a-zA-Z._-]:%5lu%n", id, port)) {
-            pImpl.reset(new Impl(InetAddr(id), port));
+            inetAddr = InetAddr(std::string(id));
+            this->port = port;
         }
         else {
             throw INVALID_ARGUMENT("Invalid socket address: \"" + spec + "\"");
@@ -361,81 +197,97 @@ SockAddr::SockAddr(const std::string& spec)
 
 SockAddr SockAddr::clone(const in_port_t port) const
 {
-    return SockAddr{getInetAddr(), port};
-}
-
-SockAddr::operator bool() const noexcept
-{
-    return static_cast<bool>(pImpl);
+    return SockAddr{inetAddr, port};
 }
 
 int SockAddr::socket(
             const int type,
             const int protocol) const
 {
-    return pImpl->socket(type, protocol);
+    return inetAddr.socket(type, protocol);
 }
 
 bool SockAddr::operator<(const SockAddr& rhs) const noexcept
 {
-    auto impl1 = pImpl.get();
-    auto impl2 = rhs.pImpl.get();
-    return (impl1 == impl2)
-            ? false
-            : (impl1 == nullptr || impl2 == nullptr)
-                ? (impl1 == nullptr)
-                : *impl1 < *impl2;
-}
-
-bool SockAddr::operator==(const SockAddr& rhs) const noexcept
-{
-    return *pImpl.get() == *rhs.pImpl.get();
-}
-
-size_t SockAddr::hash() const noexcept
-{
-    return pImpl ? pImpl->hash() : 0;
+    return (inetAddr < rhs.inetAddr)
+            ? true
+            : (rhs.inetAddr < inetAddr)
+              ? false
+              : (port < rhs.port);
 }
 
 std::string SockAddr::to_string(const bool withName) const noexcept
 {
-    return pImpl
-            ? pImpl->to_string(withName)
-            : withName
-                  ? "SockAddr{<unset>}"
-                  : "<unset>";
+    if (!inetAddr)
+        return withName
+              ? "SockAddr{<unset>}"
+              : "<unset>";
+
+    return (withName ? "SockAddr{" : "") +
+            ((inetAddr.getFamily() == AF_INET6)
+                ? "[" + inetAddr.to_string() + "]:" + std::to_string(port)
+                : inetAddr.to_string() + ":" + std::to_string(port)) +
+           (withName ? "}" : "");
 }
 
 void SockAddr::bind(const int sd) const
 {
-    pImpl->bind(sd);
+    struct sockaddr_storage storage;
+
+    if (::bind(sd, inetAddr.get_sockaddr(storage, port), sizeof(storage)))
+        throw SYSTEM_ERROR("Couldn't bind() socket " + std::to_string(sd) +
+                " to " + to_string());
 }
 
 void SockAddr::connect(const int sd) const
 {
-    pImpl->connect(sd);
+    LOG_DEBUG("Connecting to " + to_string());
+    struct sockaddr_storage storage;
+
+    if (::connect(sd, inetAddr.get_sockaddr(storage, port),
+            sizeof(storage)))
+        throw SYSTEM_ERROR("Couldn't connect() socket " +
+                std::to_string(sd) + " to " + to_string());
 }
 
 void SockAddr::join(
         const int       sd,
         const InetAddr& srcAddr) const
 {
-    pImpl->join(sd, srcAddr);
+    LOG_DEBUG("Joining multicast group %s from source %s",
+            to_string().data(), srcAddr.to_string().data());
+
+    // NB: The following is independent of protocol (i.e., IPv4 or IPv6)
+    struct group_source_req mreq = {};
+
+    mreq.gsr_interface = 0; // 0 => O/S chooses interface
+    inetAddr.get_sockaddr(mreq.gsr_group, port);
+    srcAddr.get_sockaddr(mreq.gsr_source, 0);
+
+    if (::setsockopt(sd, IPPROTO_IP, MCAST_JOIN_SOURCE_GROUP, &mreq,
+            sizeof(mreq)))
+        throw SYSTEM_ERROR("Couldn't join multicast group " +
+                to_string() + " from source " + srcAddr.to_string());
+}
+
+void SockAddr::get_sockaddr(struct sockaddr_storage& storage) const
+{
+    inetAddr.get_sockaddr(storage, port);
 }
 
-const InetAddr& SockAddr::getInetAddr() const noexcept
+bool SockAddr::peek_sockaddr(struct sockaddr_storage& storage) const
 {
-    return pImpl->getInetAddr();
+    return inetAddr.peek_sockaddr(storage, port);
 }
 
-in_port_t SockAddr::getPort() const noexcept
+void SockAddr::prefetch() const
 {
-    return pImpl->getPort();
+    inetAddr.prefetch();
 }
 
-void SockAddr::get_sockaddr(struct sockaddr_storage& storage) const
+void SockAddr::whenResolved(const InetAddr::Resolved& resolved) const
 {
-    return pImpl->get_sockaddr(storage);
+    inetAddr.whenResolved(resolved);
 }
 
 } // namespace
@@ -25,16 +25,19 @@
 
 #include "InetAddr.h"
 
-#include <memory>
 #include <netinet/in.h>
 #include <string>
 
 namespace hycast {
 
+/**
+ * Socket address. A small, fixed-size value type that can be copied, compared,
+ * and hashed without allocation or indirection.
+ */
 class SockAddr
 {
-    class                       Impl;
-    std::shared_ptr<const Impl> pImpl;
+    InetAddr  inetAddr; ///< Internet address
+    in_port_t port;     ///< Port number in host byte-order
 
 public:
     /**
@@ -138,14 +141,18 @@ public:
      */
     SockAddr clone(in_port_t port) const;
 
-    operator bool() const noexcept;
+    inline operator bool() const noexcept {
+        return static_cast<bool>(inetAddr);
+    }
 
     /**
      * Returns the Internet address of this socket address.
      *
      * @return Internet address of this socket address
      */
-    const InetAddr& getInetAddr() const noexcept;
+    inline const InetAddr& getInetAddr() const noexcept {
+        return inetAddr;
+    }
 
     /**
      * Returns the port number given to the constructor in host byte-order.
@@ -153,7 +160,9 @@ public:
      * @return            Constructor port number in host byte-order
      * @cancellationpoint No
      */
-    in_port_t getPort() const noexcept;
+    inline in_port_t getPort() const noexcept {
+        return port;
+    }
 
     /**
      * Returns the string representation of this instance.
@@ -167,17 +176,56 @@ public:
      *
      * @return The hash value of this instance
      */
-    size_t hash() const noexcept;
+    inline size_t hash() const noexcept {
+        return inetAddr.hash() ^ InetAddr::mix(port);
+    }
 
     /**
-     * Sets a socket address storage structure.
+     * Sets a socket address storage structure. Blocks if the Internet address
+     * is a hostname that has never been resolved (or whose failed resolution
+     * has expired) until it's resolved. Callers that mustn't block should
+     * first call `whenResolved()`.
      *
      * @param[out] storage  The structure to be set
-     * @cancellationpoint   Maybe (`::getaddrinfo()` may be one and will be
-     *                      called if the address is based on a name)
+     * @cancellationpoint   Maybe (will wait for a hostname to be resolved if
+     *                      its resolution isn't cached)
+     * @see `whenResolved()`
      */
     void get_sockaddr(struct sockaddr_storage& storage) const;
 
+    /**
+     * Sets a socket address storage structure if that can be done without
+     * blocking.
+     *
+     * @param[out] storage  The structure to be set. Set only on success.
+     * @retval     `true`   Success. `storage` is set.
+     * @retval     `false`  The Internet address is a hostname that hasn't been
+     *                      resolved. Its resolution has been started.
+     * @see `InetAddr::peek_sockaddr()`
+     */
+    bool peek_sockaddr(struct sockaddr_storage& storage) const;
+
+    /**
+     * Starts the asynchronous resolution of the Internet address of this
+     * instance if it's a hostname whose resolution isn't cached or is stale.
+     * Doesn't block.
+     *
+     * @threadsafety  Safe
+     * @see `InetAddr::prefetch()`
+     */
+    void prefetch() const;
+
+    /**
+     * Calls a function when the Internet address of this instance has been
+     * resolved. Never blocks.
+     *
+     * @param[in] resolved    Function to call
+     * @throws    LogicError  The Internet address is unset
+     * @threadsafety          Safe
+     * @see `InetAddr::whenResolved()`
+     */
+    void whenResolved(const InetAddr::Resolved& resolved) const;
+
     /**
      * Returns a socket appropriate for this instance's address family.
      *
@@ -208,7 +256,9 @@ public:
      * @retval    `true`   This instance is equal to `rhs`
      * @retval    `false`  This instance is not equal to `rhs`
      */
-    bool operator ==(const SockAddr& rhs) const noexcept;
+    inline bool operator ==(const SockAddr& rhs) const noexcept {
+        return port == rhs.port && inetAddr == rhs.inetAddr;
+    }
 
     /**
      * Binds a socket to a local socket address.
@@ -251,14 +301,14 @@ namespace std {
     struct less<hycast::SockAddr> {
         inline bool operator()(
                 const hycast::SockAddr& lhs,
-                const hycast::SockAddr& rhs) {
+                const hycast::SockAddr& rhs) const {
             return lhs < rhs;
         }
     };
 
     template<>
     struct hash<hycast::SockAddr> {
-        inline bool operator()(const hycast::SockAddr& sockAddr) const {
+        inline size_t operator()(const hycast::SockAddr& sockAddr) const {
             return sockAddr.hash();
         }
     };
@@ -27,17 +27,39 @@
 #include "error.h"
 #include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <linux/errqueue.h>
 #include <limits.h>
+#include <memory>
 #include <mutex>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <poll.h>
 #include <signal.h>
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104 // Since Linux 5.0
+#endif
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60 // Since Linux 4.14
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
 
 namespace hycast {
 
@@ -664,13 +686,16 @@ public:
      *
      * @param[in] sockAddr           Server's local socket address
      * @param[in] queueSize          Size of listening queue
+     * @param[in] reusePort          Whether or not to set SO_REUSEPORT
      * @throws    std::system_error  Couldn't set SO_REUSEADDR on socket
+     * @throws    std::system_error  Couldn't set SO_REUSEPORT on socket
      * @throws    std::system_error  Couldn't bind socket to `sockAddr`
      * @throws    std::system_error  Couldn't set SO_KEEPALIVE on socket
      * @throws    std::system_error  `::listen()` failure
      */
     Impl(   const SockAddr& sockAddr,
-            const int       queueSize)
+            const int       queueSize,
+            const bool      reusePort)
         : TcpSock::Impl{sockAddr.socket(SOCK_STREAM)}
     {
         const int enable = 1;
@@ -680,6 +705,11 @@ public:
             throw SYSTEM_ERROR("Couldn't set SO_REUSEADDR on socket " +
                     std::to_string(sd) + ", address " + sockAddr.to_string());
 
+        if (reusePort && ::setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &enable,
+                sizeof(enable)))
+            throw SYSTEM_ERROR("Couldn't set SO_REUSEPORT on socket " +
+                    std::to_string(sd) + ", address " + sockAddr.to_string());
+
         //LOG_DEBUG("Binding socket");
         sockAddr.bind(sd);
 
@@ -688,6 +718,13 @@ public:
             throw SYSTEM_ERROR("Couldn't set SO_KEEPALIVE on socket " +
                     std::to_string(sd) + ", address " + sockAddr.to_string());
 
+#ifdef TCP_FASTOPEN
+        // Accept TCP Fast Open connections. Harmless if clients don't use it.
+        const int qlen = queueSize ? queueSize : SOMAXCONN;
+        if (::setsockopt(sd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)))
+            LOG_DEBUG("Couldn't enable TCP Fast Open on socket %d", sd);
+#endif
+
         if (::listen(sd, queueSize))
             throw SYSTEM_ERROR("listen() failure: {sock: " + std::to_string(sd)
                     + ", queueSize: " + std::to_string(queueSize) + "}");
@@ -727,8 +764,9 @@ public:
 
 TcpSrvrSock::TcpSrvrSock(
         const SockAddr& sockAddr,
-        const int       queueSize)
-    : TcpSock{new Impl(sockAddr, queueSize)}
+        const int       queueSize,
+        const bool      reusePort)
+    : TcpSock{new Impl(sockAddr, queueSize, reusePort)}
 {}
 
 std::string TcpSrvrSock::to_string() const
@@ -745,9 +783,100 @@ TcpSock TcpSrvrSock::accept() const
 
 class TcpClntSock::Impl final : public TcpSock::Impl
 {
+    using Lock = std::unique_lock<Mutex>;
+    using Cond = std::condition_variable;
+
 public:
     /**
-     * Constructs.
+     * Returns the resolved address of a remote endpoint. If the address is a
+     * hostname whose resolution isn't cached, then this function waits for
+     * the resolver pool via `SockAddr::whenResolved()` rather than resolving
+     * the hostname on the current thread.
+     *
+     * @param[in] sockAddr     Address of remote endpoint
+     * @param[in] timeout      Timeout in milliseconds. -1 => indefinite.
+     * @return                 Resolved address of remote endpoint
+     * @throw     LogicError   Destination port number is zero
+     * @throw     SystemError  Timeout occurred (`errno` is `ETIMEDOUT`)
+     * @throw     RuntimeError The hostname couldn't be resolved
+     * @cancellationpoint      Yes
+     */
+    static struct sockaddr_storage resolve(
+            const SockAddr& sockAddr,
+            const int       timeout)
+    {
+        if (sockAddr.getPort() == 0)
+            throw LOGIC_ERROR("Port number of " + sockAddr.to_string() + " is "
+                    "zero");
+
+        struct sockaddr_storage storage;
+        if (sockAddr.peek_sockaddr(storage))
+            return storage;
+
+        /*
+         * The callback might be called after this function returns; so, the
+         * state it references is shared.
+         */
+        struct Waiter {
+            Mutex              mutex;
+            Cond               cond;
+            bool               done;
+            std::exception_ptr error;
+        };
+        auto waiter = std::make_shared<Waiter>();
+        waiter->done = false;
+
+        sockAddr.whenResolved([waiter](std::exception_ptr error) {
+            Guard guard{waiter->mutex};
+            waiter->done = true;
+            waiter->error = error;
+            waiter->cond.notify_all();
+        });
+
+        {
+            Lock lock{waiter->mutex};
+            auto isDone = [&waiter]{return waiter->done;};
+
+            if (timeout < 0) {
+                waiter->cond.wait(lock, isDone);
+            }
+            else if (!waiter->cond.wait_for(lock,
+                    std::chrono::milliseconds(timeout), isDone)) {
+                throw SYSTEM_ERROR("Couldn't resolve " + sockAddr.to_string(),
+                        ETIMEDOUT);
+            }
+
+            if (waiter->error)
+                std::rethrow_exception(waiter->error);
+        }
+
+        if (!sockAddr.peek_sockaddr(storage))
+            throw RUNTIME_ERROR("Resolution of " + sockAddr.to_string() +
+                    " isn't cached");
+
+        return storage;
+    }
+
+    /**
+     * Returns a TCP socket for a resolved address.
+     *
+     * @param[in] storage      Resolved address
+     * @return                 TCP socket
+     * @throw     SystemError  `::socket()` failure
+     */
+    static int createSocket(const struct sockaddr_storage& storage)
+    {
+        const int sd = ::socket(storage.ss_family, SOCK_STREAM, IPPROTO_TCP);
+
+        if (sd == -1)
+            throw SYSTEM_ERROR("::socket() failure: family=" +
+                    std::to_string(storage.ss_family));
+
+        return sd;
+    }
+
+    /**
+     * Constructs. Blocks while connecting.
      *
      * @param[in] sockAddr    Address of remote endpoint
      * @throw     SystemError Couldn't connect to `sockAddr`
@@ -756,13 +885,91 @@ public:
      * @cancellationpoint     Yes
      */
     Impl(const SockAddr& sockAddr)
-        : TcpSock::Impl(sockAddr.socket(SOCK_STREAM, IPPROTO_TCP))
+        : Impl(sockAddr, resolve(sockAddr, -1), false)
     {
-        if (sockAddr.getPort() == 0)
-            throw LOGIC_ERROR("Port number of " + sockAddr.to_string() + " is "
-                    "zero");
+        struct pollfd pfd = {};
+        pfd.fd = sd;
+        pfd.events = POLLOUT;
+
+        while (::poll(&pfd, 1, -1) == -1) {
+            if (errno != EINTR)
+                throw SYSTEM_ERROR("poll() failure while connecting to " +
+                        sockAddr.to_string());
+        }
+
+        finish();
+    }
+
+    /**
+     * Constructs. Doesn't block: the connection is only initiated.
+     *
+     * @param[in] sockAddr    Address of remote endpoint
+     * @param[in] storage     Resolved address of remote endpoint
+     * @param[in] fastOpen    Whether or not to use TCP Fast Open
+     * @throw     SystemError Couldn't initiate connection to `sockAddr`
+     * @see       `finish()`
+     */
+    Impl(   const SockAddr&                sockAddr,
+            const struct sockaddr_storage& storage,
+            const bool                     fastOpen)
+        : TcpSock::Impl(createSocket(storage))
+    {
+        const int flags = ::fcntl(sd, F_GETFL);
+
+        if (flags == -1 || ::fcntl(sd, F_SETFL, flags | O_NONBLOCK))
+            throw SYSTEM_ERROR("Couldn't make socket " + std::to_string(sd) +
+                    " non-blocking");
 
-        sockAddr.connect(sd);
+#ifdef TCP_FASTOPEN_CONNECT
+        if (fastOpen) {
+            const int enable = 1;
+            if (::setsockopt(sd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable,
+                    sizeof(enable)))
+                LOG_DEBUG("Couldn't enable TCP Fast Open on socket %d", sd);
+        }
+#endif
+
+        if (::connect(sd, reinterpret_cast<const struct sockaddr*>(&storage),
+                sizeof(storage)) && errno != EINPROGRESS)
+            throw SYSTEM_ERROR("Couldn't connect() socket " +
+                    std::to_string(sd) + " to " + sockAddr.to_string());
+
+        rmtSockAddr = sockAddr;
+    }
+
+    /**
+     * Returns the socket descriptor.
+     *
+     * @return Socket descriptor
+     */
+    int getSd() const noexcept
+    {
+        return sd;
+    }
+
+    /**
+     * Completes a connection initiated by the non-blocking constructor after
+     * the socket has become writable. Restores blocking I/O.
+     *
+     * @throw SystemError  The connection attempt failed
+     */
+    void finish()
+    {
+        int       error = 0;
+        socklen_t len = sizeof(error);
+
+        if (::getsockopt(sd, SOL_SOCKET, SO_ERROR, &error, &len))
+            throw SYSTEM_ERROR("getsockopt() failure on socket " +
+                    std::to_string(sd));
+        if (error)
+            throw SYSTEM_ERROR("Couldn't connect() socket " +
+                    std::to_string(sd) + " to " + rmtSockAddr.to_string(),
+                    error);
+
+        const int flags = ::fcntl(sd, F_GETFL);
+        if (flags == -1 || ::fcntl(sd, F_SETFL, flags & ~O_NONBLOCK))
+            throw SYSTEM_ERROR("Couldn't make socket " + std::to_string(sd) +
+                    " blocking");
     }
 };
 
@@ -770,6 +977,48 @@ TcpClntSock::TcpClntSock(const SockAddr& sockAddr)
     : TcpSock(new Impl(sockAddr))
 {}
 
+void TcpClntSock::connect(
+        const SockAddr& sockAddr,
+        TcpClntSock*    socks,
+        const int       numSocks,
+        const bool      fastOpen,
+        const int       timeout)
+{
+    // Resolve hostname once
+    const struct sockaddr_storage storage = Impl::resolve(sockAddr, timeout);
+
+    std::vector<struct pollfd> pfds(numSocks);
+    for (int i = 0; i < numSocks; ++i) {
+        Impl* impl = new Impl(sockAddr, storage, fastOpen);
+        socks[i] = TcpClntSock();
+        socks[i].pImpl.reset(impl);
+        pfds[i].fd = impl->getSd();
+        pfds[i].events = POLLOUT;
+    }
+
+    for (int numPending = numSocks; numPending; ) {
+        const int status = ::poll(pfds.data(), numSocks, timeout);
+
+        if (status == -1) {
+            if (errno == EINTR)
+                continue;
+            throw SYSTEM_ERROR("poll() failure while connecting to " +
+                    sockAddr.to_string());
+        }
+        if (status == 0)
+            throw SYSTEM_ERROR("Couldn't connect to " + sockAddr.to_string(),
+                    ETIMEDOUT);
+
+        for (int i = 0; i < numSocks; ++i) {
+            if (pfds[i].fd >= 0 && pfds[i].revents) {
+                static_cast<Impl*>(socks[i].pImpl.get())->finish();
+                pfds[i].fd = -1; // Ignored by `::poll()`
+                --numPending;
+            }
+        }
+    }
+}
+
 /******************************************************************************/
 
 class UdpSock::Impl final : public InetSock::Impl
@@ -795,6 +1044,23 @@ class UdpSock::Impl final : public InetSock::Impl
     size_t        numPeek;                ///< Current number of bytes to peek
     struct pollfd pollfd;                 ///< poll(2) structure
 
+    /// A zero-copy write whose bytes the kernel might still reference
+    struct ZcWrite {
+        uint32_t     id;       ///< Identifier in completion notifications
+        bool         done;     ///< Kernel is done with the bytes?
+        UdpSock::Pin pin;      ///< Keeps the caller's bytes valid
+        uint8_t      hdr[64];  ///< Copies of this instance's scalars
+    };
+    /// Maximum number of outstanding zero-copy writes
+    static const size_t   MAX_ZC_WRITES = 1024;
+    /// Number of zero-copy writes between processing of notifications
+    static const unsigned REAP_INTERVAL = 32;
+
+    bool                zeroCopy;    ///< Zero-copy writing is enabled?
+    uint32_t            nextZcId;    ///< Identifier of next zero-copy write
+    std::deque<ZcWrite> zcWrites;    ///< Outstanding zero-copy writes
+    unsigned            numUnreaped; ///< Zero-copy writes since processing
+
     /**
      * Vets adding an additional I/O vector element.
      *
@@ -928,6 +1194,10 @@ class UdpSock::Impl final : public InetSock::Impl
         , numWrite{0}
         , readIov{}
         , numPeek{0}
+        , zeroCopy{false}
+        , nextZcId{0}
+        , zcWrites()
+        , numUnreaped{0}
     {
         readIov[0].iov_base = skipBuf;
         msghdr.msg_name = msghdr.msg_control = nullptr;
@@ -1049,13 +1319,210 @@ public:
         addWrite(nxt64++, sizeof(value));
     }
 
+    /**
+     * Resets the write state for the next UDP packet.
+     */
+    void resetForNextWrite() noexcept
+    {
+        numWrite = 0;
+        writeIovCnt = 0;
+        nxt8 = uint8s;
+        nxt16 = uint16s;
+        nxt32 = uint32s;
+        nxt64 = uint64s;
+    }
+
+    /**
+     * Indicates if bytes reside in this instance (e.g., added scalars).
+     *
+     * @param[in] data  Bytes
+     * @retval `true`   Yes
+     * @retval `false`  No
+     */
+    bool isInternal(const void* data) const noexcept
+    {
+        const auto addr = reinterpret_cast<uintptr_t>(data);
+        return addr >= reinterpret_cast<uintptr_t>(this) &&
+                addr < reinterpret_cast<uintptr_t>(this + 1);
+    }
+
+    /**
+     * Processes pending zero-copy completion notifications and releases the
+     * pins of completed writes.
+     *
+     * @param[in] wait         Whether to block until the oldest outstanding
+     *                         write completes
+     * @throws    SystemError  I/O failure
+     */
+    void reap(const bool wait)
+    {
+        numUnreaped = 0;
+
+        while (!zcWrites.empty()) {
+            char          control[CMSG_SPACE(sizeof(struct sock_extended_err)
+                    + sizeof(struct sockaddr_in6))];
+            struct msghdr msg = {};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (::recvmsg(sd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    throw SYSTEM_ERROR("Couldn't read error queue of socket " +
+                            std::to_string(sd));
+                if (!wait || zcWrites.front().done)
+                    break;
+
+                // Error-queue readiness is reported as `POLLERR`
+                struct pollfd pfd = {sd, 0, 0};
+                if (::poll(&pfd, 1, -1) == -1 && errno != EINTR)
+                    throw SYSTEM_ERROR("::poll() failure on socket " +
+                            std::to_string(sd));
+                continue;
+            }
+
+            for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+                    cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (!((cmsg->cmsg_level == SOL_IP &&
+                            cmsg->cmsg_type == IP_RECVERR) ||
+                      (cmsg->cmsg_level == SOL_IPV6 &&
+                            cmsg->cmsg_type == IPV6_RECVERR)))
+                    continue;
+
+                struct sock_extended_err serr;
+                ::memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+                if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                    continue;
+
+                if ((serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && zeroCopy) {
+                    // E.g., loopback. Copying is cheaper without MSG_ZEROCOPY.
+                    LOG_NOTE("Kernel copied zero-copy write on socket %d. "
+                            "Disabling zero-copy writes.", sd);
+                    zeroCopy = false;
+                }
+
+                // Notifications cover an inclusive range of identifiers
+                const uint32_t first = zcWrites.front().id;
+                for (uint32_t id = serr.ee_info; ; ++id) {
+                    const uint32_t index = id - first;
+                    if (index < zcWrites.size())
+                        zcWrites[index].done = true;
+                    if (id == serr.ee_data)
+                        break;
+                }
+            }
+
+            while (!zcWrites.empty() && zcWrites.front().done)
+                zcWrites.pop_front();
+        }
+    }
+
     void write()
     {
         if (::writev(sd, writeIov, writeIovCnt) == -1)
             throw SYSTEM_ERROR("Couldn't write " + std::to_string(writeIovCnt) +
                     "-element I/O vector to host " + getRmtAddr().to_string());
-        numWrite = 0;
-        writeIovCnt = 0;
+        resetForNextWrite();
+    }
+
+    bool enableZeroCopy()
+    {
+        const int enable = 1;
+
+        if (::setsockopt(sd, SOL_SOCKET, SO_ZEROCOPY, &enable,
+                sizeof(enable))) {
+            if (errno == ENOPROTOOPT || errno == EINVAL ||
+                    errno == EOPNOTSUPP)
+                return false;
+            throw SYSTEM_ERROR("Couldn't enable zero-copy writes on socket " +
+                    std::to_string(sd));
+        }
+
+        zeroCopy = true;
+        return true;
+    }
+
+    void write(const UdpSock::Pin& pin)
+    {
+        if (!zeroCopy) {
+            write();
+            if (!zcWrites.empty())
+                reap(false);
+            return;
+        }
+
+        while (zcWrites.size() >= MAX_ZC_WRITES)
+            reap(true);
+
+        /*
+         * The kernel references every byte of a zero-copy write, so this
+         * instance's scalars, which are reused by the next packet, are copied
+         * into storage that lasts until the write completes. Element
+         * references in a deque survive insertion and removal at its ends.
+         */
+        zcWrites.emplace_back();
+        ZcWrite&     zcWrite = zcWrites.back();
+        struct iovec iov[IOV_MAX];
+        size_t       hdrLen = 0;
+
+        zcWrite.id = nextZcId;
+        zcWrite.done = false;
+        zcWrite.pin = pin;
+        for (int i = 0; i < writeIovCnt; ++i) {
+            iov[i] = writeIov[i];
+            if (isInternal(iov[i].iov_base)) {
+                if (hdrLen + iov[i].iov_len > sizeof(zcWrite.hdr)) {
+                    zcWrites.pop_back();
+                    write(); // Too many scalars to be worthwhile
+                    return;
+                }
+                ::memcpy(zcWrite.hdr + hdrLen, iov[i].iov_base,
+                        iov[i].iov_len);
+                iov[i].iov_base = zcWrite.hdr + hdrLen;
+                hdrLen += iov[i].iov_len;
+            }
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = writeIovCnt;
+        ssize_t status;
+        try {
+            status = ::sendmsg(sd, &msg, MSG_ZEROCOPY);
+        }
+        catch (...) {
+            zcWrites.pop_back(); // Thread cancellation
+            throw;
+        }
+        if (status == -1) {
+            zcWrites.pop_back();
+            if (errno != ENOBUFS)
+                throw SYSTEM_ERROR("Couldn't write " +
+                        std::to_string(writeIovCnt) + "-element I/O vector "
+                        "to host " + getRmtAddr().to_string());
+            // Out of memory for notifications
+            reap(false);
+            write();
+            return;
+        }
+
+        ++nextZcId;
+        resetForNextWrite();
+        if (++numUnreaped >= REAP_INTERVAL)
+            reap(false);
+    }
+
+    size_t getNumPinned()
+    {
+        reap(false);
+        return zcWrites.size();
+    }
+
+    void flush()
+    {
+        while (!zcWrites.empty())
+            reap(true);
     }
 
     /**
@@ -1157,6 +1624,69 @@ public:
 
         return true;
     }
+
+    bool enableGro() const
+    {
+        const int enable = 1;
+
+        if (::setsockopt(sd, SOL_UDP, UDP_GRO, &enable, sizeof(enable))) {
+            if (errno == ENOPROTOOPT || errno == EINVAL)
+                return false; // Kernel doesn't support UDP GRO
+            throw SYSTEM_ERROR("Couldn't enable UDP GRO on socket " +
+                    std::to_string(sd));
+        }
+
+        return true;
+    }
+
+    size_t read(
+            void* const  buf,
+            const size_t nbytes,
+            size_t&      segSize)
+    {
+        // poll(2) is used so `shutdown()` works
+        int status = ::poll(&pollfd, 1, -1); // -1 => indefinite wait
+
+        if (shutdownCalled || (pollfd.revents & POLLHUP))
+            return 0;
+
+        if (status == -1)
+            throw SYSTEM_ERROR("::poll() failure on socket" +
+                    std::to_string(sd));
+
+        if (pollfd.revents & (POLLERR | POLLNVAL))
+            return 0;
+
+        struct iovec  iov = {buf, nbytes};
+        char          control[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        const ssize_t nread = ::recvmsg(sd, &msg, 0);
+        if (nread < 0)
+            throw SYSTEM_ERROR("Couldn't read from socket" +
+                    std::to_string(sd));
+        if (msg.msg_flags & MSG_TRUNC)
+            throw RUNTIME_ERROR(std::to_string(nbytes) + "-byte buffer is too "
+                    "small for datagram from socket " + std::to_string(sd));
+
+        segSize = nread;
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+                cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int gsoSize;
+                ::memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof(gsoSize));
+                segSize = gsoSize;
+            }
+        }
+
+        resetForNextPeek(0);
+
+        return nread;
+    }
 };
 
 UdpSock::UdpSock(const SockAddr& grpAddr)
@@ -1217,6 +1747,26 @@ void UdpSock::write()
     static_cast<UdpSock::Impl*>(pImpl.get())->write();
 }
 
+bool UdpSock::enableZeroCopy() const
+{
+    return static_cast<UdpSock::Impl*>(pImpl.get())->enableZeroCopy();
+}
+
+void UdpSock::write(const Pin& pin)
+{
+    static_cast<UdpSock::Impl*>(pImpl.get())->write(pin);
+}
+
+size_t UdpSock::getNumPinned() const
+{
+    return static_cast<UdpSock::Impl*>(pImpl.get())->getNumPinned();
+}
+
+void UdpSock::flush() const
+{
+    static_cast<UdpSock::Impl*>(pImpl.get())->flush();
+}
+
 void UdpSock::addPeek(
         void* const  data,
         const size_t nbytes)
@@ -1249,6 +1799,20 @@ void UdpSock::discard()
     static_cast<UdpSock::Impl*>(pImpl.get())->discard();
 }
 
+bool UdpSock::enableGro() const
+{
+    return static_cast<UdpSock::Impl*>(pImpl.get())->enableGro();
+}
+
+size_t UdpSock::read(
+        void* const  buf,
+        const size_t nbytes,
+        size_t&      segSize) const
+{
+    return static_cast<UdpSock::Impl*>(pImpl.get())->read(buf, nbytes,
+            segSize);
+}
+
 bool UdpSock::peek() const
 {
     return static_cast<UdpSock::Impl*>(pImpl.get())->peek();
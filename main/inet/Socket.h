@@ -362,13 +362,19 @@ public:
      * @param[in] sockAddr           Socket address
      * @param[in] queueSize          Size of listening queue or `0` to obtain
      *                               the default.
+     * @param[in] reusePort          Whether or not to set SO_REUSEPORT so that
+     *                               multiple sockets can listen on the same
+     *                               address, with the kernel distributing
+     *                               incoming connections among them
      * @throws    std::system_error  Couldn't set SO_REUSEADDR on socket
+     * @throws    std::system_error  Couldn't set SO_REUSEPORT on socket
      * @throws    std::system_error  Couldn't bind socket to `sockAddr`
      * @throws    std::system_error  Couldn't set SO_KEEPALIVE on socket
      */
     TcpSrvrSock(
             const SockAddr& sockaddr,
-            const int       queueSize = 0);
+            const int       queueSize = 0,
+            const bool      reusePort = false);
 
     std::string to_string() const;
 
@@ -393,9 +399,43 @@ public:
     TcpClntSock() =default;
 
     /**
+     * Constructs. Blocks while connecting.
+     *
+     * @param[in] sockAddr    Address of remote endpoint
+     * @throw     SystemError Couldn't connect to `sockAddr`
+     * @throw     LogicError  Destination port number is zero
      * @cancellationpoint
      */
     TcpClntSock(const SockAddr& sockAddr);
+
+    /**
+     * Concurrently connects multiple sockets to the same remote endpoint. The
+     * hostname of the endpoint, if any, is resolved once -- by the resolver
+     * pool rather than on the current thread -- and all connections
+     * are initiated before any is waited upon; consequently, the total time is
+     * approximately that of a single connection.
+     *
+     * @param[in]  sockAddr     Address of remote endpoint
+     * @param[out] socks        Sockets to be connected
+     * @param[in]  numSocks     Number of sockets
+     * @param[in]  fastOpen     Whether or not to use TCP Fast Open. Ignored if
+     *                          unsupported. If used, then the SYN is sent
+     *                          with the first write.
+     * @param[in]  timeout      Timeout in milliseconds for resolving the
+     *                          hostname and, separately, for connecting.
+     *                          -1 => indefinite.
+     * @throw      SystemError  Couldn't connect to `sockAddr`
+     * @throw      SystemError  Timeout occurred (`errno` is `ETIMEDOUT`)
+     * @throw      LogicError   Destination port number is zero
+     * @exceptionsafety         Basic guarantee. `socks` might be modified.
+     * @cancellationpoint       Yes
+     */
+    static void connect(
+            const SockAddr& sockAddr,
+            TcpClntSock*    socks,
+            const int       numSocks,
+            const bool      fastOpen = false,
+            const int       timeout = -1);
 };
 
 /******************************************************************************/
@@ -487,6 +527,50 @@ public:
      */
     void write();
 
+    /// Keeps bytes given to `addWrite()` valid for a zero-copy write
+    using Pin = std::shared_ptr<const void>;
+
+    /**
+     * Enables zero-copy writing (`MSG_ZEROCOPY`) by `write(const Pin&)`.
+     *
+     * @retval    `true`       Success
+     * @retval    `false`      The kernel doesn't support zero-copy writing
+     * @throws    SystemError  System failure
+     */
+    bool enableZeroCopy() const;
+
+    /**
+     * Writes the UDP packet. If zero-copy writing is enabled, then the kernel
+     * references rather than copies the bytes given to `addWrite()`, and a
+     * copy of `pin` is kept until the kernel reports that it's done with
+     * them. Reports are processed in batches. If the kernel reports that it
+     * had to copy the bytes anyway (e.g., loopback), then zero-copy writing is
+     * disabled. Otherwise, this is the same as `write()`.
+     *
+     * @param[in] pin          Keeps the bytes given to `addWrite()` valid
+     * @throws    SystemError  I/O failure
+     * @cancellationpoint      Yes
+     */
+    void write(const Pin& pin);
+
+    /**
+     * Returns the number of zero-copy writes whose bytes the kernel might
+     * still reference.
+     *
+     * @return              Number of outstanding zero-copy writes
+     * @throws SystemError  I/O failure
+     */
+    size_t getNumPinned() const;
+
+    /**
+     * Blocks until the kernel no longer references the bytes of any zero-copy
+     * write.
+     *
+     * @throws SystemError  I/O failure
+     * @cancellationpoint   Yes
+     */
+    void flush() const;
+
     /**
      * Adds bytes to be peeked by the next call to `peek()` Previously peeked
      * bytes are skipped. No network-to-host translation is performed.
@@ -566,6 +650,36 @@ public:
      * Discards the current packet. Idempotent.
      */
     void discard();
+
+    /**
+     * Enables the kernel's coalescing of consecutive datagrams of a flow into
+     * a single buffer (UDP GRO). Afterwards, `read()` can return several
+     * datagrams at once.
+     *
+     * @retval    `true`       Success
+     * @retval    `false`      The kernel doesn't support UDP GRO
+     * @throws    SystemError  System failure
+     */
+    bool enableGro() const;
+
+    /**
+     * Reads the next datagram or, if UDP GRO is enabled, the next run of
+     * coalesced datagrams. Every datagram of a run has `segSize` bytes except
+     * the last, which might have fewer.
+     *
+     * @param[out] buf           Destination for the bytes. Should have room
+     *                           for 65535 bytes if UDP GRO is enabled.
+     * @param[in]  nbytes        Size of `buf` in bytes
+     * @param[out] segSize       Size of each datagram in bytes
+     * @return                   Number of bytes read. 0 on EOF or `halt()`.
+     * @throws     SystemError   I/O failure
+     * @throws     RuntimeError  `buf` is too small
+     * @cancellationpoint        Yes
+     */
+    size_t read(
+            void* const  buf,
+            const size_t nbytes,
+            size_t&      segSize) const;
 };
 
 } // namespace
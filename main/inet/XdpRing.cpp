@@ -0,0 +1,600 @@
+/**
+ * AF_XDP receive ring for source-specific multicast UDP datagrams.
+ *
+ *        File: XdpRing.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "XdpRing.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <dirent.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+namespace hycast {
+
+class XdpRing::Impl
+{
+    /// Size of a UMEM frame in bytes
+    static const unsigned FRAME_SIZE = 2048;
+    /// Size of Ethernet, IPv4 (without options), and UDP headers
+    static const unsigned HDRS_LEN = 14 + 20 + 8;
+
+    /// Mapping of a producer/consumer ring
+    struct Ring {
+        void*     map;      ///< Start of memory-mapping
+        size_t    mapLen;   ///< Length of memory-mapping in bytes
+        uint32_t* producer; ///< Producer index
+        uint32_t* consumer; ///< Consumer index
+        void*     descs;    ///< Descriptors
+        uint32_t  mask;     ///< Index mask
+
+        Ring()
+            : map(MAP_FAILED)
+            , mapLen(0)
+            , producer(nullptr)
+            , consumer(nullptr)
+            , descs(nullptr)
+            , mask(0)
+        {}
+    };
+
+    int                   sd;          ///< `AF_XDP` socket
+    int                   mapFd;       ///< XSKMAP
+    int                   progFd;      ///< XDP program
+    int                   linkFd;      ///< Attachment of program to interface
+    int                   joinSd;      ///< UDP socket for group membership
+    int                   haltFd;      ///< `eventfd` for `halt()`
+    unsigned              numFrames;   ///< Number of UMEM frames
+    uint8_t*              umem;        ///< UMEM
+    Ring                  rxRing;      ///< Receive ring
+    Ring                  fillRing;    ///< Fill ring
+    bool                  zeroCopy;    ///< Socket is in zero-copy mode?
+    bool                  held;        ///< Caller holds a frame?
+    uint64_t              heldAddr;    ///< UMEM address of held frame
+    std::atomic<uint64_t> numPackets;  ///< Number of returned packets
+
+    static int bpf(
+            const int       cmd,
+            union bpf_attr& attr) noexcept {
+        return ::syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+    }
+
+    static struct bpf_insn insn(
+            const uint8_t code,
+            const uint8_t dst,
+            const uint8_t src,
+            const int16_t off,
+            const int32_t imm) noexcept {
+        struct bpf_insn insn = {};
+        insn.code = code;
+        insn.dst_reg = dst;
+        insn.src_reg = src;
+        insn.off = off;
+        insn.imm = imm;
+        return insn;
+    }
+
+    /**
+     * Creates the XSKMAP that the XDP program uses to find the socket.
+     *
+     * @param[in] queueId      Index of receive queue
+     * @throws    SystemError  `bpf()` failure
+     */
+    void createMap(const unsigned queueId) {
+        union bpf_attr attr = {};
+        attr.map_type = BPF_MAP_TYPE_XSKMAP;
+        attr.key_size = sizeof(uint32_t);
+        attr.value_size = sizeof(uint32_t);
+        attr.max_entries = queueId + 1;
+
+        mapFd = bpf(BPF_MAP_CREATE, attr);
+        if (mapFd == -1)
+            throw SYSTEM_ERROR("Couldn't create XSKMAP");
+    }
+
+    /**
+     * Loads the XDP program, which redirects unfragmented IPv4 UDP datagrams
+     * without IP options from a given source to a given group and port into
+     * the XSKMAP and passes everything else to the network stack. Packet
+     * fields are compared in network byte order.
+     *
+     * @param[in] grpAddr      Multicast group
+     * @param[in] srcAddr      Sending host
+     * @throws    SystemError  `bpf()` failure
+     */
+    void loadProgram(
+            const struct sockaddr_in& grpAddr,
+            const struct sockaddr_in& srcAddr) {
+        std::vector<struct bpf_insn> code;
+        std::vector<size_t>          passJumps; // Jumps to pass instructions
+
+        auto jne = [&](const int32_t value) {
+            passJumps.push_back(code.size());
+            code.push_back(insn(BPF_JMP32 | BPF_JNE | BPF_K, 5, 0, 0, value));
+        };
+        auto load = [&](const uint8_t size, const int16_t off) {
+            code.push_back(insn(BPF_LDX | size | BPF_MEM, 5, 2, off, 0));
+        };
+
+        // r6 = context; r2 = packet start; r3 = packet end
+        code.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0));
+        code.push_back(insn(BPF_LDX | BPF_W | BPF_MEM, 2, 6,
+                offsetof(struct xdp_md, data), 0));
+        code.push_back(insn(BPF_LDX | BPF_W | BPF_MEM, 3, 6,
+                offsetof(struct xdp_md, data_end), 0));
+        // Bounds check for the verifier
+        code.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_X, 4, 2, 0, 0));
+        code.push_back(insn(BPF_ALU64 | BPF_ADD | BPF_K, 4, 0, 0, HDRS_LEN));
+        passJumps.push_back(code.size());
+        code.push_back(insn(BPF_JMP | BPF_JGT | BPF_X, 4, 3, 0, 0));
+
+        load(BPF_H, 12); jne(htons(ETH_P_IP));                 // Ether type
+        load(BPF_B, 14); jne(0x45);                            // IPv4, IHL=5
+        load(BPF_B, 23); jne(IPPROTO_UDP);                     // Protocol
+        load(BPF_W, 26); jne(srcAddr.sin_addr.s_addr);         // Source
+        load(BPF_W, 30); jne(grpAddr.sin_addr.s_addr);         // Destination
+        load(BPF_H, 20);                                       // Fragment
+        code.push_back(insn(BPF_ALU | BPF_AND | BPF_K, 5, 0, 0,
+                htons(0x3fff)));
+        jne(0);
+        load(BPF_H, 36); jne(grpAddr.sin_port);                // Port
+
+        // return bpf_redirect_map(map, ctx->rx_queue_index, XDP_PASS)
+        code.push_back(insn(BPF_LDX | BPF_W | BPF_MEM, 2, 6,
+                offsetof(struct xdp_md, rx_queue_index), 0));
+        code.push_back(insn(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0,
+                mapFd));
+        code.push_back(insn(0, 0, 0, 0, 0));
+        code.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS));
+        code.push_back(insn(BPF_JMP | BPF_CALL, 0, 0, 0,
+                BPF_FUNC_redirect_map));
+        code.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+        // return XDP_PASS
+        const size_t pass = code.size();
+        code.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS));
+        code.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+        for (auto i : passJumps)
+            code[i].off = pass - i - 1;
+
+        static const char license[] = "Apache-2.0";
+        union bpf_attr    attr = {};
+        attr.prog_type = BPF_PROG_TYPE_XDP;
+        attr.insns = reinterpret_cast<uint64_t>(code.data());
+        attr.insn_cnt = code.size();
+        attr.license = reinterpret_cast<uint64_t>(license);
+        attr.expected_attach_type = BPF_XDP;
+
+        progFd = bpf(BPF_PROG_LOAD, attr);
+        if (progFd == -1) {
+            const int errnum = errno;
+            // Reload to obtain the verifier's reason
+            char log[8192] = {};
+            attr.log_level = 1;
+            attr.log_buf = reinterpret_cast<uint64_t>(log);
+            attr.log_size = sizeof(log);
+            (void)bpf(BPF_PROG_LOAD, attr);
+            throw SYSTEM_ERROR(std::string("Couldn't load XDP program: ") + log,
+                    errnum);
+        }
+    }
+
+    /**
+     * Attaches the XDP program to an interface. The attachment is removed when
+     * `linkFd` is closed.
+     *
+     * @param[in] ifIndex      Index of the interface
+     * @param[in] genericMode  Use generic (SKB) mode?
+     * @throws    SystemError  `bpf()` failure
+     */
+    void attachProgram(
+            const unsigned ifIndex,
+            const bool     genericMode) {
+        union bpf_attr attr = {};
+        attr.link_create.prog_fd = progFd;
+        attr.link_create.target_ifindex = ifIndex;
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = genericMode ? XDP_FLAGS_SKB_MODE : 0;
+
+        linkFd = bpf(BPF_LINK_CREATE, attr);
+        if (linkFd == -1)
+            throw SYSTEM_ERROR("Couldn't attach XDP program to interface " +
+                    std::to_string(ifIndex));
+    }
+
+    /**
+     * Memory-maps a ring of the socket.
+     *
+     * @param[out] ring         Ring
+     * @param[in]  off          Offsets of the ring's members
+     * @param[in]  numDescs     Number of descriptors
+     * @param[in]  descSize     Size of a descriptor in bytes
+     * @param[in]  pgoff        Memory-mapping offset of the ring
+     * @throws     SystemError  `::mmap()` failure
+     */
+    void mapRing(
+            Ring&                         ring,
+            const struct xdp_ring_offset& off,
+            const unsigned                numDescs,
+            const size_t                  descSize,
+            const off_t                   pgoff) {
+        ring.mapLen = off.desc + numDescs*descSize;
+        ring.map = ::mmap(nullptr, ring.mapLen, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, sd, pgoff);
+        if (ring.map == MAP_FAILED)
+            throw SYSTEM_ERROR("Couldn't memory-map AF_XDP ring");
+
+        uint8_t* base = static_cast<uint8_t*>(ring.map);
+        ring.producer = reinterpret_cast<uint32_t*>(base + off.producer);
+        ring.consumer = reinterpret_cast<uint32_t*>(base + off.consumer);
+        ring.descs = base + off.desc;
+        ring.mask = numDescs - 1;
+    }
+
+    void setRingSize(
+            const int      name,
+            const unsigned size) {
+        if (::setsockopt(sd, SOL_XDP, name, &size, sizeof(size)))
+            throw SYSTEM_ERROR("Couldn't set size of AF_XDP ring " +
+                    std::to_string(name) + " to " + std::to_string(size));
+    }
+
+    /**
+     * Creates the socket, its UMEM, and its rings and gives every frame to the
+     * kernel.
+     *
+     * @throws SystemError  System failure
+     */
+    void createSocket() {
+        sd = ::socket(AF_XDP, SOCK_RAW, 0);
+        if (sd == -1)
+            throw SYSTEM_ERROR("Couldn't create AF_XDP socket");
+
+        const size_t umemLen = static_cast<size_t>(numFrames)*FRAME_SIZE;
+        void*        addr = ::mmap(nullptr, umemLen, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (addr == MAP_FAILED)
+            throw SYSTEM_ERROR("Couldn't allocate " + std::to_string(umemLen) +
+                    "-byte UMEM");
+        umem = static_cast<uint8_t*>(addr);
+
+        struct xdp_umem_reg reg = {};
+        reg.addr = reinterpret_cast<uint64_t>(umem);
+        reg.len = umemLen;
+        reg.chunk_size = FRAME_SIZE;
+        if (::setsockopt(sd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)))
+            throw SYSTEM_ERROR("Couldn't register UMEM");
+
+        setRingSize(XDP_UMEM_FILL_RING, numFrames);
+        setRingSize(XDP_UMEM_COMPLETION_RING, 1); // Required but unused
+        setRingSize(XDP_RX_RING, numFrames);
+
+        struct xdp_mmap_offsets offs = {};
+        socklen_t               len = sizeof(offs);
+        if (::getsockopt(sd, SOL_XDP, XDP_MMAP_OFFSETS, &offs, &len))
+            throw SYSTEM_ERROR("Couldn't get AF_XDP ring offsets");
+
+        mapRing(rxRing, offs.rx, numFrames, sizeof(struct xdp_desc),
+                XDP_PGOFF_RX_RING);
+        mapRing(fillRing, offs.fr, numFrames, sizeof(uint64_t),
+                XDP_UMEM_PGOFF_FILL_RING);
+
+        auto* fillAddrs = static_cast<uint64_t*>(fillRing.descs);
+        for (unsigned i = 0; i < numFrames; ++i)
+            fillAddrs[i] = static_cast<uint64_t>(i)*FRAME_SIZE;
+        __atomic_store_n(fillRing.producer, numFrames, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Binds the socket to a receive queue of an interface, preferring
+     * zero-copy mode, and adds it to the XSKMAP.
+     *
+     * @param[in] ifIndex      Index of the interface
+     * @param[in] queueId      Index of the receive queue
+     * @throws    SystemError  System failure
+     */
+    void bind(
+            const unsigned ifIndex,
+            const unsigned queueId) {
+        struct sockaddr_xdp sxdp = {};
+        sxdp.sxdp_family = AF_XDP;
+        sxdp.sxdp_ifindex = ifIndex;
+        sxdp.sxdp_queue_id = queueId;
+        sxdp.sxdp_flags = 0; // Zero-copy if supported; otherwise, copy
+        /*
+         * The kernel releases the queue of a closed AF_XDP socket
+         * asynchronously (typically within tens of milliseconds), so a queue
+         * that was just released by a previous instance can still be busy.
+         */
+        for (int ms = 0; ::bind(sd, reinterpret_cast<struct sockaddr*>(&sxdp),
+                sizeof(sxdp)); ms += 10) {
+            if (errno != EBUSY || ms >= 1000)
+                throw SYSTEM_ERROR("Couldn't bind AF_XDP socket to queue " +
+                        std::to_string(queueId) + " of interface " +
+                        std::to_string(ifIndex));
+            ::usleep(10000);
+        }
+
+        struct xdp_options opts = {};
+        socklen_t          len = sizeof(opts);
+        zeroCopy = ::getsockopt(sd, SOL_XDP, XDP_OPTIONS, &opts, &len) == 0 &&
+                (opts.flags & XDP_OPTIONS_ZEROCOPY);
+
+        const uint32_t key = queueId;
+        const uint32_t value = sd;
+        union bpf_attr attr = {};
+        attr.map_fd = mapFd;
+        attr.key = reinterpret_cast<uint64_t>(&key);
+        attr.value = reinterpret_cast<uint64_t>(&value);
+        if (bpf(BPF_MAP_UPDATE_ELEM, attr) == -1)
+            throw SYSTEM_ERROR("Couldn't add AF_XDP socket to XSKMAP");
+    }
+
+    /**
+     * Returns the held frame to the kernel via the fill ring. There's always
+     * room because the fill ring can hold every frame.
+     */
+    void releaseHeld() noexcept {
+        if (held) {
+            const uint32_t prod = *fillRing.producer;
+            static_cast<uint64_t*>(fillRing.descs)[prod & fillRing.mask] =
+                    heldAddr;
+            __atomic_store_n(fillRing.producer, prod + 1, __ATOMIC_RELEASE);
+            held = false;
+        }
+    }
+
+    void close() noexcept {
+        if (rxRing.map != MAP_FAILED)
+            ::munmap(rxRing.map, rxRing.mapLen);
+        if (fillRing.map != MAP_FAILED)
+            ::munmap(fillRing.map, fillRing.mapLen);
+        if (linkFd >= 0)
+            ::close(linkFd); // Detaches program
+        if (sd >= 0)
+            ::close(sd);
+        if (umem)
+            ::munmap(umem, static_cast<size_t>(numFrames)*FRAME_SIZE);
+        if (progFd >= 0)
+            ::close(progFd);
+        if (mapFd >= 0)
+            ::close(mapFd);
+        if (joinSd >= 0)
+            ::close(joinSd);
+        if (haltFd >= 0)
+            ::close(haltFd);
+    }
+
+public:
+    Impl(   const SockAddr&    grpAddr,
+            const InetAddr&    srcAddr,
+            const std::string& ifaceName,
+            const bool         genericMode,
+            const unsigned     queueId,
+            const unsigned     numFrames)
+        : sd(-1)
+        , mapFd(-1)
+        , progFd(-1)
+        , linkFd(-1)
+        , joinSd(-1)
+        , haltFd(-1)
+        , numFrames(numFrames)
+        , umem(nullptr)
+        , rxRing()
+        , fillRing()
+        , zeroCopy(false)
+        , held(false)
+        , heldAddr(0)
+        , numPackets(0)
+    {
+        if (numFrames == 0 || (numFrames & (numFrames - 1)))
+            throw INVALID_ARGUMENT("Number of frames isn't a power of 2: " +
+                    std::to_string(numFrames));
+
+        struct sockaddr_storage grpStorage;
+        struct sockaddr_storage srcStorage;
+        grpAddr.get_sockaddr(grpStorage);
+        srcAddr.get_sockaddr(srcStorage, 0);
+        if (grpStorage.ss_family != AF_INET || srcStorage.ss_family != AF_INET)
+            throw INVALID_ARGUMENT("Only IPv4 is supported: group=" +
+                    grpAddr.to_string() + ", source=" + srcAddr.to_string());
+
+        const unsigned ifIndex = ::if_nametoindex(ifaceName.data());
+        if (ifIndex == 0)
+            throw SYSTEM_ERROR("Unknown interface: \"" + ifaceName + "\"");
+
+        try {
+            createMap(queueId);
+            loadProgram(*reinterpret_cast<struct sockaddr_in*>(&grpStorage),
+                    *reinterpret_cast<struct sockaddr_in*>(&srcStorage));
+            createSocket();
+            bind(ifIndex, queueId);
+            // Attach last so that nothing is redirected to a missing socket
+            attachProgram(ifIndex, genericMode);
+
+            // See `PacketRing`
+            joinSd = grpAddr.socket(SOCK_DGRAM, IPPROTO_UDP);
+            grpAddr.clone(0).bind(joinSd);
+            grpAddr.getInetAddr().join(joinSd, srcAddr);
+
+            haltFd = ::eventfd(0, 0);
+            if (haltFd == -1)
+                throw SYSTEM_ERROR("Couldn't create eventfd");
+        }
+        catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    ~Impl() noexcept {
+        close();
+    }
+
+    bool isZeroCopy() const noexcept {
+        return zeroCopy;
+    }
+
+    bool next(
+            const void*& data,
+            size_t&      nbytes) {
+        releaseHeld();
+
+        for (;;) {
+            const uint32_t cons = *rxRing.consumer;
+            if (cons != __atomic_load_n(rxRing.producer, __ATOMIC_ACQUIRE)) {
+                const auto& desc = static_cast<struct xdp_desc*>(rxRing.descs)
+                        [cons & rxRing.mask];
+                heldAddr = desc.addr & ~static_cast<uint64_t>(FRAME_SIZE - 1);
+                held = true;
+                const uint8_t* frame = umem + desc.addr;
+                const uint32_t len = desc.len;
+                __atomic_store_n(rxRing.consumer, cons + 1, __ATOMIC_RELEASE);
+
+                if (len < HDRS_LEN) {
+                    releaseHeld();
+                    continue; // Can't happen given the XDP program
+                }
+
+                uint16_t udpLen;
+                ::memcpy(&udpLen, frame + HDRS_LEN - 4, sizeof(udpLen));
+                udpLen = ntohs(udpLen);
+                if (udpLen < 8 || HDRS_LEN - 8 + udpLen > len) {
+                    releaseHeld();
+                    continue; // Truncated or corrupt
+                }
+
+                ++numPackets;
+                data = frame + HDRS_LEN;
+                nbytes = udpLen - 8;
+                return true;
+            }
+
+            // Wait for a packet or for `halt()`
+            struct pollfd pfds[2] = {
+                    {sd, POLLIN, 0},
+                    {haltFd, POLLIN, 0}};
+            if (::poll(pfds, 2, -1) == -1) {
+                if (errno == EINTR)
+                    continue;
+                throw SYSTEM_ERROR("poll() failure on AF_XDP socket " +
+                        std::to_string(sd));
+            }
+            if (pfds[1].revents)
+                return false;
+        }
+    }
+
+    void halt() const {
+        const uint64_t one = 1;
+        if (::write(haltFd, &one, sizeof(one)) != sizeof(one))
+            throw SYSTEM_ERROR("Couldn't write to eventfd");
+    }
+
+    Stats getStats() const {
+        struct xdp_statistics xStats = {};
+        socklen_t             len = sizeof(xStats);
+
+        if (::getsockopt(sd, SOL_XDP, XDP_STATISTICS, &xStats, &len))
+            throw SYSTEM_ERROR("Couldn't get statistics of AF_XDP socket " +
+                    std::to_string(sd));
+
+        return Stats{numPackets.load(), xStats.rx_dropped +
+                xStats.rx_ring_full};
+    }
+};
+
+/******************************************************************************/
+
+XdpRing::XdpRing(
+        const SockAddr&    grpAddr,
+        const InetAddr&    srcAddr,
+        const std::string& ifaceName,
+        const bool         genericMode,
+        const unsigned     queueId,
+        const unsigned     numFrames)
+    : pImpl{new Impl(grpAddr, srcAddr, ifaceName, genericMode, queueId,
+            numFrames)}
+{}
+
+unsigned XdpRing::getNumRxQueues(const std::string& ifaceName)
+{
+    const std::string dirPath = "/sys/class/net/" + ifaceName + "/queues";
+    DIR* const        dir = ::opendir(dirPath.data());
+
+    if (dir == nullptr)
+        throw SYSTEM_ERROR("Couldn't open directory \"" + dirPath + "\"");
+
+    unsigned numQueues = 0;
+    for (const struct dirent* entry; (entry = ::readdir(dir)) != nullptr; )
+        if (::strncmp(entry->d_name, "rx-", 3) == 0)
+            ++numQueues;
+    ::closedir(dir);
+
+    return numQueues;
+}
+
+bool XdpRing::isZeroCopy() const noexcept
+{
+    return pImpl->isZeroCopy();
+}
+
+bool XdpRing::next(
+        const void*& data,
+        size_t&      nbytes) const
+{
+    return pImpl->next(data, nbytes);
+}
+
+void XdpRing::halt() const
+{
+    pImpl->halt();
+}
+
+XdpRing::Stats XdpRing::getStats() const
+{
+    return pImpl->getStats();
+}
+
+} // namespace
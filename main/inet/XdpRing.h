@@ -0,0 +1,142 @@
+/**
+ * AF_XDP receive ring for source-specific multicast UDP datagrams.
+ *
+ *        File: XdpRing.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_INET_XDPRING_H_
+#define MAIN_INET_XDPRING_H_
+
+#include "InetAddr.h"
+#include "SockAddr.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Receives the UDP datagrams of a source-specific multicast group from an
+ * `AF_XDP` socket. A small XDP program attached to the interface redirects the
+ * group's datagrams from the source into the socket's UMEM before they reach
+ * the kernel's network stack; all other packets pass through unaffected.
+ * Datagram payloads are accessed in place in the UMEM. Zero-copy mode is used
+ * if the driver supports it; otherwise, copy mode. Requires the `CAP_NET_ADMIN`
+ * and `CAP_NET_RAW` capabilities (or `CAP_BPF`). IPv4 only. Datagrams with IP
+ * options aren't redirected.
+ *
+ * Only one instance may exist per interface. Only datagrams that arrive on the
+ * given receive queue are redirected, so a multi-queue NIC should steer the
+ * feed to that queue (e.g., via `ethtool -N`).
+ */
+class XdpRing
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Ring statistics
+    struct Stats {
+        uint64_t packets; ///< Number of packets returned by `next()`
+        uint64_t drops;   ///< Number of packets dropped because ring was full
+    };
+
+    /**
+     * Constructs. Attaches the XDP program and joins the multicast group.
+     *
+     * @param[in] grpAddr          Socket address of the multicast group
+     * @param[in] srcAddr          Address of the sending host
+     * @param[in] ifaceName        Name of the receiving interface (e.g., "eth0")
+     * @param[in] genericMode      Attach the XDP program in generic (SKB) mode
+     *                             rather than letting the kernel prefer native
+     *                             mode. Generic mode works on any interface
+     *                             (e.g., a veth pair) but isn't zero-copy.
+     * @param[in] queueId          Index of the interface's receive queue
+     * @param[in] numFrames        Number of 2048-byte UMEM frames. Must be a
+     *                             power of 2.
+     * @throws    InvalidArgument  An address isn't IPv4 or `numFrames` isn't a
+     *                             power of 2
+     * @throws    SystemError      System failure (e.g., AF_XDP is unsupported
+     *                             or a capability is lacking)
+     */
+    XdpRing(const SockAddr&    grpAddr,
+            const InetAddr&    srcAddr,
+            const std::string& ifaceName,
+            const bool         genericMode = false,
+            const unsigned     queueId = 0,
+            const unsigned     numFrames = 4096);
+
+    /**
+     * Returns the number of receive queues of an interface. An instance only
+     * receives datagrams from one of them.
+     *
+     * @param[in] ifaceName    Name of the interface (e.g., "eth0")
+     * @return                 Number of receive queues
+     * @throws    SystemError  The interface's queues couldn't be read (e.g.,
+     *                         the interface doesn't exist)
+     * @threadsafety           Safe
+     */
+    static unsigned getNumRxQueues(const std::string& ifaceName);
+
+    /**
+     * Indicates if the socket is in zero-copy mode.
+     *
+     * @retval `true`   Zero-copy mode
+     * @retval `false`  Copy mode
+     */
+    bool isZeroCopy() const noexcept;
+
+    /**
+     * Returns the payload of the next datagram. The payload remains valid
+     * until the next call. Blocks until a datagram is available or `halt()`
+     * is called.
+     *
+     * @param[out] data         Start of payload in the UMEM
+     * @param[out] nbytes       Number of bytes in payload
+     * @retval     `true`       Success. `data` and `nbytes` are set.
+     * @retval     `false`      `halt()` was called
+     * @throws     SystemError  System failure
+     * @cancellationpoint       Yes
+     */
+    bool next(
+            const void*& data,
+            size_t&      nbytes) const;
+
+    /**
+     * Causes `next()` to return `false`. Idempotent.
+     *
+     * @throws SystemError  System failure
+     * @threadsafety        Safe
+     */
+    void halt() const;
+
+    /**
+     * Returns cumulative statistics on the ring since construction.
+     *
+     * @return              Ring statistics
+     * @throws SystemError  System failure
+     * @threadsafety        Safe
+     */
+    Stats getStats() const;
+};
+
+} // namespace
+
+#endif /* MAIN_INET_XDPRING_H_ */
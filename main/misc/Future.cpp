@@ -24,212 +24,429 @@
 #include "Future.h"
 #include "Thread.h"
 
+#include <atomic>
 #include <bitset>
 #include <cassert>
 #include <condition_variable>
 #include <errno.h>
 #include <exception>
 #include <iostream>
+#include <mutex>
 #include <system_error>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 namespace hycast {
 
+static thread_local bool freeListsGone = false; ///< `freeLists()` destroyed?
+
 /**
- * Abstract base class for the future of an asynchronous task.
+ * Free memory-blocks of one thread for the shared states of futures. Blocks
+ * are kept in singly-linked lists by size-class.
  */
-class BasicFuture::Impl
+class FreeLists
 {
-    typedef std::mutex              Mutex;
-    typedef std::lock_guard<Mutex>  LockGuard;
-    typedef std::unique_lock<Mutex> UniqueLock;
+    /// A free block
+    struct Block {
+        Block* next;
+    };
+    /// Free blocks of one size-class
+    struct List {
+        Block* head;
+        size_t size;
+    };
 
-    mutable Mutex                   mutex;
-    mutable std::condition_variable cond;
-    std::exception_ptr              exception;
-    bool                            haveResult;
-    bool                            canceled;
-    Stop                            stop;
+public:
+    /// Size-classes are multiples of this number of bytes
+    static const size_t GRANULE = 64;
+    /// Number of size-classes. Larger blocks come from the heap.
+    static const size_t NUM_CLASSES = 8;
+    /// Maximum number of free blocks of a given size-class
+    static const size_t MAX_FREE = 256;
+
+    FreeLists()
+        : lists()
+    {}
 
-    void cantStop(const bool mayInterrupt)
+    ~FreeLists() noexcept
     {
-        throw LOGIC_ERROR("No stop function specified");
+        for (auto& list : lists) {
+            while (list.head) {
+                Block* const block = list.head;
+                list.head = block->next;
+                ::operator delete(block);
+            }
+        }
+        freeListsGone = true;
     }
 
     /**
-     * Indicates whether or not the mutex is locked. Upon return, the state of
-     * the mutex is the same as upon entry.
-     * @retval `true`    Iff the mutex is locked
+     * Allocates memory.
+     *
+     * @param[in] index      Index of size-class
+     * @return               Allocated memory
+     * @throw std::bad_alloc Out of memory
      */
-    bool isLocked() const
+    void* alloc(const size_t index)
     {
-        if (!mutex.try_lock())
-            return true;
-        mutex.unlock();
-        return false;
-    }
-
-protected:
-    /**
-     * Default constructs.
-     */
-    Impl()
-        : mutex{}
-        , cond{}
-        , exception{}
-        , haveResult{false}
-        , canceled{false}
-        , stop{}
-    {}
+        auto& list = lists[index];
 
-    /**
-     * Constructs.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop& stop)
-        : mutex{}
-        , cond{}
-        , exception{}
-        , haveResult{false}
-        , canceled{false}
-        , stop{stop}
-    {}
+        if (list.head == nullptr)
+            return ::operator new((index+1)*GRANULE);
 
-    /**
-     * Constructs.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop&& stop)
-        : mutex{}
-        , cond{}
-        , exception{}
-        , haveResult{false}
-        , canceled{false}
-        , stop{stop}
-    {}
-
-    void markResult()
-    {
-        LockGuard lock{mutex};
-        haveResult = true;
-        cond.notify_all();
+        Block* const block = list.head;
+        list.head = block->next;
+        --list.size;
+        return block;
     }
 
     /**
-     * @pre `mutex` is locked
-     * @retval `true`  Iff the associated task is done
+     * Frees memory.
+     *
+     * @param[in] ptr    Memory to be freed
+     * @param[in] index  Index of size-class
      */
-    bool isDone() const
+    void free(
+            void* const  ptr,
+            const size_t index) noexcept
     {
-        assert(isLocked());
-        return haveResult || exception || canceled;
-    }
+        auto& list = lists[index];
 
-    /**
-     * Waits for the task to complete or for cancel() to be called, whichever
-     * occurs first. Idempotent.
-     * @param[in] lock   Condition variable lock
-     * @pre              `lock` is locked
-     * @exceptionsafety  Basic guarantee
-     * @threadsafety     Safe
-     */
-    void wait(UniqueLock& lock)
-    {
-        assert(lock.owns_lock());
-        while (!isDone()) {
-            Canceler canceler{};
-            cond.wait(lock);
+        if (list.size >= MAX_FREE) {
+            ::operator delete(ptr);
+        }
+        else {
+            Block* const block = static_cast<Block*>(ptr);
+            block->next = list.head;
+            list.head = block;
+            ++list.size;
         }
-        //::fprintf(stderr, "haveResult=%d, exception=%d, canceled=%d\n",
-                //haveResult, exception ? 1 : 0, canceled);
     }
 
-    void checkResult()
-    {
-        UniqueLock lock{mutex};
-        wait(lock);
-        if (exception)
-            std::rethrow_exception(exception);
-        if (canceled)
-            throw LOGIC_ERROR("checkResult() called on canceled future");
-        return; // `haveResult` must be true
-    }
+private:
+    List lists[NUM_CLASSES];
+};
 
-public:
-    virtual ~Impl() noexcept
-    {}
+/**
+ * Returns the free lists of the current thread.
+ *
+ * @return  Free lists of the current thread
+ */
+static FreeLists& freeLists()
+{
+    static thread_local FreeLists lists;
+    return lists;
+}
 
-    /**
-     * Cancels the task iff the task hasn't already completed. Idempotent.
-     * @param[in] mayInterrupt  Whether or not the thread on which the task is
-     *                          executing may be canceled. If false and the task
-     *                          has already started, then it will complete
-     *                          normally or throw an exception: it's thread will
-     *                          not be canceled.
-     * @exceptionsafety         Strong guarantee
-     * @threadsafety            Safe
-     */
-    void cancel(const bool mayInterrupt)
-    {
-        if (!hasCompleted())
-            stop(mayInterrupt);
-    }
+void* StatePool::alloc(const size_t size)
+{
+    const size_t index = (size - 1) / FreeLists::GRANULE;
 
-    void setException(const std::exception_ptr ptr)
-    {
-        LockGuard lock{mutex};
-        exception = ptr;
-        cond.notify_all();
+    // The free lists are gone if this thread is destroying its thread-locals
+    return (index >= FreeLists::NUM_CLASSES || freeListsGone)
+            ? ::operator new(size)
+            : freeLists().alloc(index);
+}
+
+void StatePool::free(
+        void* const  ptr,
+        const size_t size) noexcept
+{
+    const size_t index = (size - 1) / FreeLists::GRANULE;
+
+    if (index >= FreeLists::NUM_CLASSES || freeListsGone) {
+        ::operator delete(ptr);
+    }
+    else {
+        freeLists().free(ptr, index);
     }
+}
 
-    /**
-     * Sets the exception to be thrown by `getResult()` to the current
-     * exception.
-     */
-    void setException()
-    {
-        setException(std::current_exception());
+/**
+ * Indicates whether or not the mutex is locked. Upon return, the state of the
+ * mutex is the same as upon entry.
+ * @retval `true`    Iff the mutex is locked
+ */
+bool BasicFuture::Impl::isLocked() const
+{
+    if (!mutex.try_lock())
+        return true;
+    mutex.unlock();
+    return false;
+}
+
+/**
+ * Default constructs.
+ */
+BasicFuture::Impl::Impl()
+    : mutex{}
+    , cond{}
+    , exception{}
+    , haveResult{false}
+    , canceled{false}
+    , stop{}
+    , next{}
+    , callback{}
+    , callbacks{}
+{}
+
+/**
+ * Constructs.
+ * @param[in] stop  Function to call to cancel execution
+ */
+BasicFuture::Impl::Impl(Stop& stop)
+    : mutex{}
+    , cond{}
+    , exception{}
+    , haveResult{false}
+    , canceled{false}
+    , stop{stop}
+    , next{}
+    , callback{}
+    , callbacks{}
+{}
+
+/**
+ * Constructs.
+ * @param[in] stop  Function to call to cancel execution
+ */
+BasicFuture::Impl::Impl(Stop&& stop)
+    : mutex{}
+    , cond{}
+    , exception{}
+    , haveResult{false}
+    , canceled{false}
+    , stop{stop}
+    , next{}
+    , callback{}
+    , callbacks{}
+{}
+
+BasicFuture::Impl::~Impl() noexcept
+{}
+
+void BasicFuture::Impl::stopTask(const bool mayInterrupt)
+{
+    stop(mayInterrupt);
+}
+
+void BasicFuture::Impl::prevDone(const std::shared_ptr<Impl>&)
+{}
+
+/**
+ * Notifies waiting threads that the task is done and calls the callbacks if
+ * the task just completed. The callbacks are called without the mutex being
+ * locked so that they may access this instance.
+ *
+ * @param[in] lock     Locked mutex
+ * @param[in] wasDone  Was the task done before the latest change?
+ * @pre                `lock` is locked
+ * @post               `lock` is unlocked
+ */
+void BasicFuture::Impl::notify(UniqueLock& lock, const bool wasDone)
+{
+    assert(lock.owns_lock());
+    cond.notify_all();
+
+    if (wasDone) {
+        lock.unlock();
     }
+    else {
+        std::shared_ptr<Impl> doneNext{};
+        Callback              doneCallback{};
+        std::vector<Callback> doneCallbacks{};
+        doneNext.swap(next);
+        doneCallback.swap(callback);
+        doneCallbacks.swap(callbacks);
+        lock.unlock();
+
+        if (doneNext)
+            doneNext->prevDone(doneNext);
+        if (doneCallback)
+            doneCallback();
+        for (auto& callback : doneCallbacks)
+            callback();
+    }
+}
+
+void BasicFuture::Impl::markResult()
+{
+    UniqueLock lock{mutex};
+    const bool wasDone = isDone();
+    haveResult = true;
+    notify(lock, wasDone);
+}
+
+/**
+ * @pre `mutex` is locked
+ * @retval `true`  Iff the associated task is done
+ */
+bool BasicFuture::Impl::isDone() const
+{
+    assert(isLocked());
+    return haveResult || exception || canceled;
+}
+
+/**
+ * Waits for the task to complete or for cancel() to be called, whichever
+ * occurs first. Idempotent.
+ * @param[in] lock   Condition variable lock
+ * @pre              `lock` is locked
+ * @exceptionsafety  Basic guarantee
+ * @threadsafety     Safe
+ */
+void BasicFuture::Impl::wait(UniqueLock& lock)
+{
+    assert(lock.owns_lock());
+    while (!isDone())
+        cond.wait(lock);
+}
+
+void BasicFuture::Impl::checkResult()
+{
+    UniqueLock lock{mutex};
+    wait(lock);
+    if (exception)
+        std::rethrow_exception(exception);
+    if (canceled)
+        throw LOGIC_ERROR("checkResult() called on canceled future");
+    return; // `haveResult` must be true
+}
+
+/**
+ * Cancels the task iff the task hasn't already completed. Idempotent.
+ * @param[in] mayInterrupt  Whether or not the thread on which the task is
+ *                          executing may be canceled. If false and the task
+ *                          has already started, then it will complete
+ *                          normally or throw an exception: it's thread will
+ *                          not be canceled.
+ * @exceptionsafety         Strong guarantee
+ * @threadsafety            Safe
+ */
+void BasicFuture::Impl::cancel(const bool mayInterrupt)
+{
+    if (!hasCompleted())
+        stopTask(mayInterrupt);
+}
+
+void BasicFuture::Impl::setException(const std::exception_ptr ptr)
+{
+    UniqueLock lock{mutex};
+    const bool wasDone = isDone();
+    exception = ptr;
+    notify(lock, wasDone);
+}
+
+/**
+ * Sets the exception to be thrown by `getResult()` to the current exception.
+ */
+void BasicFuture::Impl::setException()
+{
+    setException(std::current_exception());
+}
 
-    void setCanceled()
+void BasicFuture::Impl::setCanceled()
+{
+    UniqueLock lock{mutex};
+    const bool wasDone = isDone();
+    canceled = true;
+    notify(lock, wasDone);
+}
+
+/**
+ * Arranges for a function to be called when the task is done. The function is
+ * called immediately, on the current thread, if the task is already done;
+ * otherwise, it's called on the thread that completes the task. The first
+ * such function is stored inline because a future usually has at most one
+ * continuation.
+ *
+ * @param[in] callback  Function to be called
+ * @threadsafety        Safe
+ */
+void BasicFuture::Impl::whenDone(Callback& callback)
+{
     {
         LockGuard lock{mutex};
-        canceled = true;
-        cond.notify_all();
+        if (!isDone()) {
+            if (this->callback) {
+                callbacks.push_back(callback);
+            }
+            else {
+                this->callback = callback;
+            }
+            return;
+        }
     }
+    callback();
+}
 
-    /**
-     * @retval `true`  Iff the associated task is done
-     */
-    bool hasCompleted() const
+/**
+ * Arranges for the shared state of a continuation to be completed when the
+ * task is done. Like `whenDone(Callback&)` but doesn't allocate a
+ * `std::function` for the first continuation.
+ *
+ * @param[in] next  Shared state of the continuation
+ * @threadsafety    Safe
+ */
+void BasicFuture::Impl::whenDone(const std::shared_ptr<Impl>& next)
+{
     {
-        UniqueLock lock{mutex};
-        return isDone();
+        LockGuard lock{mutex};
+        if (!isDone()) {
+            if (this->next) {
+                callbacks.push_back([next] {next->prevDone(next);});
+            }
+            else {
+                this->next = next;
+            }
+            return;
+        }
     }
+    next->prevDone(next);
+}
 
-    void wait()
-    {
-        UniqueLock lock{mutex};
-        wait(lock);
-    }
+/**
+ * Returns the exception thrown by the task. Doesn't block.
+ *
+ * @return  Exception thrown by the task. Will be empty if none.
+ */
+std::exception_ptr BasicFuture::Impl::getException() const
+{
+    LockGuard lock{mutex};
+    return exception;
+}
 
-    /**
-     * Indicates if the task completed by being canceled. Blocks until the task
-     * completes. Should be called before getResult() if having that function
-     * throw an exception is undesirable.
-     * @return `true`   Iff the task completed by being canceled
-     * @exceptionsafety Strong guarantee
-     * @threadsafety    Safe
-     * @see             getResult()
-     */
-    bool wasCanceled()
-    {
-        UniqueLock lock{mutex};
-        wait(lock);
-        return canceled && !exception;
-    }
-};
+/**
+ * @retval `true`  Iff the associated task is done
+ */
+bool BasicFuture::Impl::hasCompleted() const
+{
+    UniqueLock lock{mutex};
+    return isDone();
+}
+
+void BasicFuture::Impl::wait()
+{
+    UniqueLock lock{mutex};
+    wait(lock);
+}
+
+/**
+ * Indicates if the task completed by being canceled. Blocks until the task
+ * completes. Should be called before getResult() if having that function throw
+ * an exception is undesirable.
+ * @return `true`   Iff the task completed by being canceled
+ * @exceptionsafety Strong guarantee
+ * @threadsafety    Safe
+ * @see             getResult()
+ */
+bool BasicFuture::Impl::wasCanceled()
+{
+    UniqueLock lock{mutex};
+    wait(lock);
+    return canceled && !exception;
+}
 
 /******************************************************************************/
 
@@ -237,8 +454,8 @@ BasicFuture::BasicFuture()
     : pImpl{}
 {}
 
-BasicFuture::BasicFuture(Impl* ptr)
-    : pImpl{ptr}
+BasicFuture::BasicFuture(std::shared_ptr<Impl> pImpl)
+    : pImpl{pImpl}
 {}
 
 BasicFuture::~BasicFuture()
@@ -321,151 +538,115 @@ void BasicFuture::setException(const std::exception_ptr& ptr) const
     pImpl->setException(ptr);
 }
 
-/******************************************************************************/
-
-template<class Ret>
-class Future<Ret>::Impl : public BasicFuture::Impl
+void BasicFuture::whenDone(Callback callback) const
 {
-    Ret result;
-
-public:
-    /**
-     * Default constructs.
-     */
-    Impl()
-        : BasicFuture::Impl{}
-        , result{}
-    {}
-
-    /**
-     * Constructs from the function to call to cancel execution.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop& stop)
-        : BasicFuture::Impl{stop}
-        , result{}
-    {}
-
-    /**
-     * Constructs from the function to call to cancel execution.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop&& stop)
-        : BasicFuture::Impl{std::forward<Stop>(stop)}
-        , result{}
-    {}
+    if (!pImpl)
+        throw LOGIC_ERROR("Future is empty");
+    pImpl->whenDone(callback);
+}
 
-    void setResult(Ret result)
-    {
-        this->result = result;
-        markResult();
+Future<void> whenAll(const std::vector<BasicFuture>& futures)
+{
+    for (const auto& future : futures)
+        if (!future)
+            throw INVALID_ARGUMENT("Future is empty");
+
+    Future<void> all{[futures](const bool mayInterrupt) {
+        for (const auto& future : futures)
+            future.cancel(mayInterrupt);
+    }};
+
+    if (futures.empty()) {
+        all.setResult();
+        return all;
     }
 
-    /**
-     * Returns the result of the asynchronous task. Blocks until the task is
-     * done. If the task threw an exception, then it is re-thrown by this
-     * function.
-     * @return             Result of the asynchronous task
-     * @throws LogicError  The task's thread was canceled
-     * @exceptionsafety    Strong guarantee
-     * @threadsafety       Safe
-     * @see                wasCanceled()
-     */
-    Ret getResult() {
-        checkResult();
-        return result;
+    /// State shared by the callbacks
+    struct State {
+        std::mutex         mutex;
+        size_t             remaining;
+        std::exception_ptr exception;
+        bool               canceled;
+
+        State(const size_t count)
+            : mutex{}
+            , remaining{count}
+            , exception{}
+            , canceled{false}
+        {}
+    };
+    auto state = std::make_shared<State>(futures.size());
+
+    for (const auto& future : futures) {
+        auto impl = future.pImpl;
+        future.whenDone([state, all, impl] {
+            std::unique_lock<std::mutex> lock{state->mutex};
+
+            if (!state->exception)
+                state->exception = impl->getException();
+            if (!state->exception && impl->wasCanceled())
+                state->canceled = true;
+
+            if (--state->remaining == 0) {
+                lock.unlock();
+                if (state->exception) {
+                    all.setException(state->exception);
+                }
+                else if (state->canceled) {
+                    all.setCanceled();
+                }
+                else {
+                    all.setResult();
+                }
+            }
+        });
     }
-};
 
-template<class Ret>
-Future<Ret>::Future()
-    : BasicFuture{}
-{}
-
-template<class Ret>
-Future<Ret>::Future(Stop& stop)
-    : BasicFuture{new Impl(stop)}
-{}
-
-template<class Ret>
-Future<Ret>::Future(Stop&& stop)
-    : BasicFuture{new Impl(std::forward<Stop>(stop))}
-{}
-
-template<class Ret>
-void Future<Ret>::setResult(Ret result) const
-{
-    if (!pImpl)
-        throw LOGIC_ERROR("Empty future");
-    return reinterpret_cast<Impl*>(pImpl.get())->setResult(result);
+    return all;
 }
 
-template<class Ret>
-Ret Future<Ret>::getResult() const
+Future<size_t> whenAny(const std::vector<BasicFuture>& futures)
 {
-    if (!pImpl)
-        throw LOGIC_ERROR("Empty future");
-    return reinterpret_cast<Impl*>(pImpl.get())->getResult();
-}
+    if (futures.empty())
+        throw INVALID_ARGUMENT("No futures");
+    for (const auto& future : futures)
+        if (!future)
+            throw INVALID_ARGUMENT("Future is empty");
+
+    Future<size_t> any{[futures](const bool mayInterrupt) {
+        for (const auto& future : futures)
+            future.cancel(mayInterrupt);
+    }};
+    auto done = std::make_shared<std::atomic_flag>();
+    done->clear();
+
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].whenDone([any, done, i] {
+            if (!done->test_and_set())
+                any.setResult(i);
+        });
+    }
 
-template class Future<int>;
+    return any;
+}
 
 /******************************************************************************/
 
-class Future<void>::Impl : public BasicFuture::Impl
-{
-public:
-    /**
-     * Default constructs.
-     */
-    Impl()
-        : BasicFuture::Impl{}
-    {}
-
-    /**
-     * Constructs from the function to call to cancel execution.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop& stop)
-        : BasicFuture::Impl{stop}
-    {}
-
-    /**
-     * Constructs from the function to call to cancel execution.
-     * @param[in] stop  Function to call to cancel execution
-     */
-    Impl(Stop&& stop)
-        : BasicFuture::Impl{std::forward<Stop>(stop)}
-    {}
-
-    void setResult()
-    {
-        markResult();
-    }
-
-    /**
-     * Returns when the task is done. If the task threw an exception, then it is
-     * re-thrown by this function.
-     * @throws LogicError  The task was canceled
-     * @exceptionsafety    Strong guarantee
-     * @threadsafety       Safe
-     * @see                wasCanceled()
-     */
-    void getResult() {
-        checkResult();
-    }
-};
-
 Future<void>::Future()
     : BasicFuture{}
 {}
 
 Future<void>::Future(Stop& stop)
-    : BasicFuture{new Impl(stop)}
+    : BasicFuture{std::allocate_shared<Impl>(StateAllocator<Impl>{}, stop)}
 {}
 
 Future<void>::Future(Stop&& stop)
-    : BasicFuture{new Impl(std::forward<Stop>(stop))}
+    : BasicFuture{std::allocate_shared<Impl>(StateAllocator<Impl>{},
+            std::forward<Stop>(stop))}
+{}
+
+Future<void>::Future(std::shared_ptr<BasicFuture::Impl> pImpl)
+    : BasicFuture{pImpl}
 {}
 
 void Future<void>::setResult() const
@@ -482,6 +663,4 @@ void Future<void>::getResult() const
     reinterpret_cast<Impl*>(pImpl.get())->getResult();
 }
 
-template class Future<void>;
-
 } // namespace
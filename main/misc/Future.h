@@ -22,16 +22,32 @@
 #ifndef MAIN_MISC_FUTURE_H_
 #define MAIN_MISC_FUTURE_H_
 
+#include "error.h"
+
+#include <condition_variable>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace hycast {
 
+template<class Ret> class Future;
+template<class Next> struct Continuation;
+
+/**
+ * Base class of the future of an asynchronous task. The shared state of a
+ * future and its control block are allocated together from a pool.
+ */
 class BasicFuture
 {
 private:
     friend class std::hash<BasicFuture>;
+    friend Future<void>   whenAll(const std::vector<BasicFuture>& futures);
+    friend Future<size_t> whenAny(const std::vector<BasicFuture>& futures);
+    template<class Next> friend struct Continuation;
 
 protected:
     typedef std::function<void(const bool mayInterrupt)> Stop;
@@ -43,12 +59,21 @@ protected:
     static Stop cantStop;
 
     /**
-     * Constructs from a pointer to the template subclass implementation.
-     * @param[in] ptr   Pointer to template subclass implementation
+     * Constructs from the template subclass implementation.
+     * @param[in] pImpl  Template subclass implementation
      */
-    BasicFuture(Impl* ptr);
+    BasicFuture(std::shared_ptr<Impl> pImpl);
 
 public:
+    /// Function to be called when the associated task is done
+    typedef std::function<void()>         Callback;
+    /**
+     * Function that calls a callback. Determines where a continuation
+     * executes (e.g., on the thread of an executor). If empty, then the
+     * continuation executes on the thread that completes the task.
+     */
+    typedef std::function<void(Callback)> Dispatch;
+
     /**
      * Default constructs.
      */
@@ -116,17 +141,36 @@ public:
      * @threadsafety    Safe
      */
     bool wasCanceled() const;
+
+    /**
+     * Arranges for a function to be called when the associated task is done.
+     * The function is called immediately, on the current thread, if the task
+     * is already done; otherwise, it's called on the thread that completes
+     * the task. The function shouldn't block.
+     * @param[in] callback  Function to be called
+     * @throw LogicError    Future is empty
+     * @threadsafety        Safe
+     */
+    void whenDone(Callback callback) const;
 };
 
 /**
  * Future of an asynchronous task with a non-void result.
- * @tparam Ret  Task's result
+ * @tparam Ret  Task's result. Must be default constructible and copyable.
  */
 template<class Ret>
 class Future final : public BasicFuture
 {
+    template<class Next> friend struct Continuation;
+
     class Impl;
 
+    /**
+     * Constructs from a shared state.
+     * @param[in] pImpl  Shared state
+     */
+    explicit Future(std::shared_ptr<BasicFuture::Impl> pImpl);
+
 public:
     typedef BasicFuture::Stop Stop;
 
@@ -161,6 +205,25 @@ public:
      * @see                   wasCanceled()
      */
     Ret getResult() const;
+
+    /**
+     * Returns the future of a continuation of this instance. When the task is
+     * done, the continuation is called with its result. The returned future
+     * is canceled if the task is canceled, fails if the task or the
+     * continuation throws an exception, and otherwise has the result of the
+     * continuation. Canceling the returned future cancels the task.
+     * @tparam    Func      Type of continuation: `Next(Ret)`
+     * @param[in] func      Continuation
+     * @param[in] dispatch  Function that calls the continuation. If empty,
+     *                      then the continuation is called on the thread that
+     *                      completes the task.
+     * @return              Future of the continuation
+     * @throw LogicError    Future is empty
+     * @threadsafety        Safe
+     */
+    template<class Func>
+    auto then(Func func, const Dispatch& dispatch = Dispatch{}) const
+            -> Future<decltype(func(std::declval<Ret>()))>;
 };
 
 /**
@@ -169,8 +232,16 @@ public:
 template<>
 class Future<void> final : public BasicFuture
 {
+    template<class Next> friend struct Continuation;
+
     class Impl;
 
+    /**
+     * Constructs from a shared state.
+     * @param[in] pImpl  Shared state
+     */
+    explicit Future(std::shared_ptr<BasicFuture::Impl> pImpl);
+
 public:
     typedef BasicFuture::Stop Stop;
 
@@ -203,8 +274,499 @@ public:
      * @see                   wasCanceled()
      */
     void getResult() const;
+
+    /**
+     * Returns the future of a continuation of this instance. When the task is
+     * done, the continuation is called. The returned future is canceled if
+     * the task is canceled, fails if the task or the continuation throws an
+     * exception, and otherwise has the result of the continuation. Canceling
+     * the returned future cancels the task.
+     * @tparam    Func      Type of continuation: `Next()`
+     * @param[in] func      Continuation
+     * @param[in] dispatch  Function that calls the continuation. If empty,
+     *                      then the continuation is called on the thread that
+     *                      completes the task.
+     * @return              Future of the continuation
+     * @throw LogicError    Future is empty
+     * @threadsafety        Safe
+     */
+    template<class Func>
+    auto then(Func func, const Dispatch& dispatch = Dispatch{}) const
+            -> Future<decltype(func())>;
+};
+
+/**
+ * Returns a future that's done when all given futures are done. It fails
+ * with the first exception of the given futures, is canceled if any of them
+ * was canceled, and otherwise has a result. Canceling it cancels the given
+ * futures.
+ * @param[in] futures          Futures
+ * @return                     Future of all the given futures. Is done if
+ *                             `futures` is empty.
+ * @throw     InvalidArgument  A given future is empty
+ * @threadsafety               Safe
+ */
+Future<void> whenAll(const std::vector<BasicFuture>& futures);
+
+/**
+ * Returns a future that's done when any given future is done. Its result is
+ * the origin-0 index of the first given future to be done. Canceling it
+ * cancels the given futures.
+ * @param[in] futures          Futures
+ * @return                     Future of any of the given futures
+ * @throw     InvalidArgument  `futures` is empty or a given future is empty
+ * @threadsafety               Safe
+ */
+Future<size_t> whenAny(const std::vector<BasicFuture>& futures);
+
+/******************************************************************************/
+
+/**
+ * Pool of memory for the shared states of futures. Futures are created and
+ * destroyed at a high rate, so freed memory is kept for reuse rather than
+ * being returned to the heap. Each thread has its own free lists, so neither
+ * function locks.
+ */
+class StatePool
+{
+public:
+    /**
+     * Allocates memory.
+     * @param[in] size        Number of bytes
+     * @return                Allocated memory
+     * @throw std::bad_alloc  Out of memory
+     * @threadsafety          Safe
+     */
+    static void* alloc(const size_t size);
+
+    /**
+     * Frees memory. The memory may have been allocated on another thread.
+     * @param[in] ptr   Memory to be freed
+     * @param[in] size  Number of bytes given to `alloc()`
+     * @threadsafety    Safe
+     */
+    static void free(void* const ptr, const size_t size) noexcept;
+};
+
+/**
+ * Allocator of the shared states of futures. Given to `std::allocate_shared()`
+ * so that a shared state and its control block are one block from
+ * `StatePool`.
+ * @tparam T  Type to allocate
+ */
+template<class T>
+class StateAllocator
+{
+public:
+    typedef T value_type;
+
+    StateAllocator() noexcept =default;
+
+    template<class U>
+    StateAllocator(const StateAllocator<U>& that) noexcept
+    {}
+
+    T* allocate(const size_t n)
+    {
+        return static_cast<T*>(StatePool::alloc(n*sizeof(T)));
+    }
+
+    void deallocate(
+            T* const     ptr,
+            const size_t n) noexcept
+    {
+        StatePool::free(ptr, n*sizeof(T));
+    }
+};
+
+template<class T, class U>
+inline bool operator==(const StateAllocator<T>&, const StateAllocator<U>&)
+{
+    return true;
+}
+
+template<class T, class U>
+inline bool operator!=(const StateAllocator<T>&, const StateAllocator<U>&)
+{
+    return false;
+}
+
+/**
+ * Shared state of the future of an asynchronous task. It's declared here so
+ * that `Future<Ret>` can be instantiated for any result type. Its members are
+ * defined in `Future.cpp`.
+ */
+class BasicFuture::Impl
+{
+    typedef std::mutex              Mutex;
+    typedef std::lock_guard<Mutex>  LockGuard;
+    typedef std::unique_lock<Mutex> UniqueLock;
+
+    mutable Mutex                   mutex;
+    mutable std::condition_variable cond;
+    std::exception_ptr              exception;
+    bool                            haveResult;
+    bool                            canceled;
+    Stop                            stop;
+    std::shared_ptr<Impl>           next;      ///< First continuation.
+                                               ///< Usually the only one.
+    Callback                        callback;  ///< First function to call
+                                               ///< when done
+    std::vector<Callback>           callbacks; ///< Subsequent functions
+
+    bool isLocked() const;
+
+    void notify(UniqueLock& lock, const bool wasDone);
+
+    bool isDone() const;
+
+    void wait(UniqueLock& lock);
+
+protected:
+    Impl();
+
+    Impl(Stop& stop);
+
+    Impl(Stop&& stop);
+
+    void markResult();
+
+    void checkResult();
+
+    /**
+     * Cancels the task. Called by `cancel()` if the task hasn't completed.
+     * This default calls the function given to the constructor.
+     * @param[in] mayInterrupt  Whether the task may be interrupted if it's
+     *                          being executed
+     */
+    virtual void stopTask(const bool mayInterrupt);
+
+    /**
+     * Called when the task of the future of which this instance is a
+     * continuation is done. This default does nothing.
+     * @param[in] self  This instance
+     */
+    virtual void prevDone(const std::shared_ptr<Impl>& self);
+
+public:
+    virtual ~Impl() noexcept;
+
+    void cancel(const bool mayInterrupt);
+
+    void setException(const std::exception_ptr ptr);
+
+    void setException();
+
+    void setCanceled();
+
+    void whenDone(Callback& callback);
+
+    void whenDone(const std::shared_ptr<Impl>& next);
+
+    std::exception_ptr getException() const;
+
+    bool hasCompleted() const;
+
+    void wait();
+
+    bool wasCanceled();
 };
 
+template<class Ret>
+class Future<Ret>::Impl : public BasicFuture::Impl
+{
+    Ret result;
+
+public:
+    /**
+     * Default constructs. For a continuation, which cancels its predecessor
+     * rather than calling a function.
+     */
+    Impl()
+        : BasicFuture::Impl{}
+        , result{}
+    {}
+
+    /**
+     * Constructs from the function to call to cancel execution.
+     * @param[in] stop  Function to call to cancel execution
+     */
+    Impl(Stop& stop)
+        : BasicFuture::Impl{stop}
+        , result{}
+    {}
+
+    /**
+     * Constructs from the function to call to cancel execution.
+     * @param[in] stop  Function to call to cancel execution
+     */
+    Impl(Stop&& stop)
+        : BasicFuture::Impl{std::forward<Stop>(stop)}
+        , result{}
+    {}
+
+    void setResult(Ret result)
+    {
+        this->result = result;
+        markResult();
+    }
+
+    /**
+     * Returns the result of the asynchronous task. Blocks until the task is
+     * done. If the task threw an exception, then it is re-thrown by this
+     * function.
+     * @return             Result of the asynchronous task
+     * @throws LogicError  The task's thread was canceled
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     * @see                wasCanceled()
+     */
+    Ret getResult() {
+        checkResult();
+        return result;
+    }
+};
+
+template<class Ret>
+Future<Ret>::Future()
+    : BasicFuture{}
+{}
+
+template<class Ret>
+Future<Ret>::Future(Stop& stop)
+    : BasicFuture{std::allocate_shared<Impl>(StateAllocator<Impl>{}, stop)}
+{}
+
+template<class Ret>
+Future<Ret>::Future(Stop&& stop)
+    : BasicFuture{std::allocate_shared<Impl>(StateAllocator<Impl>{},
+            std::forward<Stop>(stop))}
+{}
+
+template<class Ret>
+Future<Ret>::Future(std::shared_ptr<BasicFuture::Impl> pImpl)
+    : BasicFuture{pImpl}
+{}
+
+template<class Ret>
+void Future<Ret>::setResult(Ret result) const
+{
+    if (!pImpl)
+        throw LOGIC_ERROR("Empty future");
+    return static_cast<Impl*>(pImpl.get())->setResult(result);
+}
+
+template<class Ret>
+Ret Future<Ret>::getResult() const
+{
+    if (!pImpl)
+        throw LOGIC_ERROR("Empty future");
+    return static_cast<Impl*>(pImpl.get())->getResult();
+}
+
+class Future<void>::Impl : public BasicFuture::Impl
+{
+public:
+    /**
+     * Default constructs.
+     */
+    Impl()
+        : BasicFuture::Impl{}
+    {}
+
+    /**
+     * Constructs from the function to call to cancel execution.
+     * @param[in] stop  Function to call to cancel execution
+     */
+    Impl(Stop& stop)
+        : BasicFuture::Impl{stop}
+    {}
+
+    /**
+     * Constructs from the function to call to cancel execution.
+     * @param[in] stop  Function to call to cancel execution
+     */
+    Impl(Stop&& stop)
+        : BasicFuture::Impl{std::forward<Stop>(stop)}
+    {}
+
+    void setResult()
+    {
+        markResult();
+    }
+
+    /**
+     * Returns when the task is done. If the task threw an exception, then it is
+     * re-thrown by this function.
+     * @throws LogicError  The task was canceled
+     * @exceptionsafety    Strong guarantee
+     * @threadsafety       Safe
+     * @see                wasCanceled()
+     */
+    void getResult() {
+        checkResult();
+    }
+};
+
+/******************************************************************************/
+
+/**
+ * Completes the future of a continuation.
+ * @tparam Next  Result of the continuation
+ */
+template<class Next>
+struct Continuation
+{
+    /**
+     * Sets the result of the shared state of a future to that of a
+     * continuation.
+     * @param[in] next  Shared state of the future of the continuation
+     * @param[in] call  Calls the continuation
+     */
+    template<class Call>
+    static void setResult(typename Future<Next>::Impl& next, Call& call)
+    {
+        next.setResult(call());
+    }
+
+    /**
+     * Shared state of the future of a continuation. The continuation is
+     * stored in it, rather than in a `std::function`, so that the future of a
+     * continuation is a single allocation from `StatePool`.
+     * @tparam Prev  Future of the task
+     * @tparam Call  Calls the continuation with the result of the task
+     */
+    template<class Prev, class Call>
+    class State final : public Future<Next>::Impl
+    {
+        Prev                  prev;     ///< Future of the task
+        Call                  call;     ///< Calls the continuation
+        BasicFuture::Dispatch dispatch; ///< Calls `complete()`. May be empty.
+
+        /**
+         * Completes this instance.
+         */
+        void complete()
+        {
+            if (prev.wasCanceled()) {
+                this->setCanceled();
+            }
+            else {
+                try {
+                    Continuation<Next>::setResult(*this, call);
+                }
+                catch (...) {
+                    this->setException(std::current_exception());
+                }
+            }
+        }
+
+    protected:
+        /**
+         * Cancels the task.
+         * @param[in] mayInterrupt  Whether the task may be interrupted if
+         *                          it's being executed
+         */
+        void stopTask(const bool mayInterrupt) override
+        {
+            prev.cancel(mayInterrupt);
+        }
+
+        /**
+         * Completes this instance -- via the dispatch function, if any.
+         * @param[in] self  This instance
+         */
+        void prevDone(const std::shared_ptr<BasicFuture::Impl>& self) override
+        {
+            if (dispatch) {
+                auto state = std::static_pointer_cast<State>(self);
+                dispatch([state] {state->complete();});
+            }
+            else {
+                complete();
+            }
+        }
+
+    public:
+        /**
+         * Constructs.
+         * @param[in] prev      Future of the task
+         * @param[in] call      Calls the continuation with the result of the
+         *                      task
+         * @param[in] dispatch  Function that calls the continuation. May be
+         *                      empty.
+         */
+        State(  const Prev&                  prev,
+                Call&                        call,
+                const BasicFuture::Dispatch& dispatch)
+            : Future<Next>::Impl{}
+            , prev(prev)
+            , call(call)
+            , dispatch(dispatch)
+        {}
+    };
+
+    /**
+     * Returns the future of a continuation of a task.
+     * @param[in] prev      Future of the task
+     * @param[in] call      Calls the continuation with the result of the task
+     * @param[in] dispatch  Function that calls the continuation. May be
+     *                      empty.
+     * @return              Future of the continuation
+     */
+    template<class Prev, class Call>
+    static Future<Next> make(
+            const Prev&                  prev,
+            Call                         call,
+            const BasicFuture::Dispatch& dispatch)
+    {
+        typedef State<Prev, Call> NextState;
+
+        if (!prev.pImpl)
+            throw LOGIC_ERROR("Future is empty");
+
+        auto next = std::allocate_shared<NextState>(
+                StateAllocator<NextState>{}, prev, call, dispatch);
+        prev.pImpl->whenDone(next);
+
+        return Future<Next>{next};
+    }
+};
+
+template<>
+template<class Call>
+void Continuation<void>::setResult(Future<void>::Impl& next, Call& call)
+{
+    call();
+    next.setResult();
+}
+
+template<class Ret>
+template<class Func>
+auto Future<Ret>::then(Func func, const Dispatch& dispatch) const
+        -> Future<decltype(func(std::declval<Ret>()))>
+{
+    typedef decltype(func(std::declval<Ret>())) Next;
+    const Future<Ret>                           prev{*this};
+
+    return Continuation<Next>::make(prev, [prev, func]() mutable {
+        return func(prev.getResult());
+    }, dispatch);
+}
+
+template<class Func>
+auto Future<void>::then(Func func, const Dispatch& dispatch) const
+        -> Future<decltype(func())>
+{
+    typedef decltype(func()) Next;
+    const Future<void>       prev{*this};
+
+    return Continuation<Next>::make(prev, [prev, func]() mutable {
+        prev.getResult();
+        return func();
+    }, dispatch);
+}
+
 } // namespace
 
 namespace std {
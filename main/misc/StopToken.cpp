@@ -0,0 +1,190 @@
+/**
+ * This file implements cooperative cancellation of threads.
+ *
+ *        File: StopToken.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "StopToken.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace hycast {
+
+/**
+ * State shared by a stop-source, its tokens and their callbacks.
+ */
+class StopToken::State
+{
+    using Mutex     = std::mutex;
+    using Guard     = std::lock_guard<Mutex>;
+    using Lock      = std::unique_lock<Mutex>;
+    using Callbacks = std::map<uint64_t, std::function<void()>>;
+
+    std::atomic<bool>       stopped;  ///< Has a stop been requested?
+    Mutex                   mutex;
+    std::condition_variable cond;
+    Callbacks               callbacks;
+    uint64_t                nextId;   ///< ID of next callback. 0 => none.
+    uint64_t                runningId;///< ID of executing callback
+    std::thread::id         stopper;  ///< Thread that's calling callbacks
+
+public:
+    State()
+        : stopped(false)
+        , mutex()
+        , cond()
+        , callbacks()
+        , nextId(1)
+        , runningId(0)
+        , stopper()
+    {}
+
+    bool stopRequested() const noexcept {
+        return stopped.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Requests a stop. The callbacks are called without the mutex being
+     * locked so that they may lock other mutexes.
+     *
+     * @retval `true`   This call requested the stop
+     * @retval `false`  A stop was already requested
+     */
+    bool requestStop() {
+        if (stopped.exchange(true, std::memory_order_acq_rel))
+            return false;
+
+        Lock lock{mutex};
+        stopper = std::this_thread::get_id();
+
+        while (!callbacks.empty()) {
+            auto iter = callbacks.begin();
+            auto callback = iter->second;
+
+            runningId = iter->first;
+            callbacks.erase(iter);
+            lock.unlock();
+
+            try {
+                callback();
+            }
+            catch (const std::exception& ex) {
+                LOG_ERROR(ex, "Stop callback threw an exception");
+            }
+
+            lock.lock();
+            runningId = 0;
+            cond.notify_all();
+        }
+
+        return true;
+    }
+
+    /**
+     * Registers a callback.
+     *
+     * @param[in] callback  Callback
+     * @return              ID of the callback. 0 => the callback was called
+     *                      because a stop was already requested.
+     */
+    uint64_t add(std::function<void()>& callback) {
+        {
+            Guard guard{mutex};
+            if (!stopRequested()) {
+                const auto id = nextId++;
+                callbacks.emplace(id, callback);
+                return id;
+            }
+        }
+
+        callback();
+        return 0;
+    }
+
+    /**
+     * Deregisters a callback. Blocks while the callback is executing on
+     * another thread.
+     *
+     * @param[in] id  ID of the callback
+     */
+    void erase(const uint64_t id) {
+        Lock lock{mutex};
+
+        callbacks.erase(id);
+        while (runningId == id && stopper != std::this_thread::get_id())
+            cond.wait(lock);
+    }
+};
+
+/******************************************************************************/
+
+StopToken::StopToken(std::shared_ptr<State> state)
+    : state(state)
+{}
+
+bool StopToken::stopRequested() const noexcept {
+    return state && state->stopRequested();
+}
+
+/******************************************************************************/
+
+StopSource::StopSource()
+    : state(std::make_shared<StopToken::State>())
+{}
+
+StopToken StopSource::getToken() const {
+    return StopToken(state);
+}
+
+bool StopSource::requestStop() const {
+    return state->requestStop();
+}
+
+bool StopSource::stopRequested() const noexcept {
+    return state->stopRequested();
+}
+
+/******************************************************************************/
+
+StopCallback::StopCallback(
+        const StopToken&      token,
+        std::function<void()> callback)
+    : token(token)
+    , id(token.state ? token.state->add(callback) : 0)
+{}
+
+StopCallback::~StopCallback() noexcept {
+    if (id) {
+        try {
+            token.state->erase(id);
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex, "Couldn't deregister stop callback");
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,141 @@
+/**
+ * This file declares cooperative cancellation of threads.
+ *
+ *        File: StopToken.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_MISC_STOPTOKEN_H_
+#define MAIN_MISC_STOPTOKEN_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Token that indicates if a stop was requested of a thread. Unlike thread
+ * cancellation, stopping is cooperative: the thread polls the token at
+ * convenient points and arranges, via a `StopCallback`, to be woken if it's
+ * blocked. Consequently, critical regions don't need to be shielded from
+ * cancellation.
+ */
+class StopToken
+{
+    friend class StopSource;
+    friend class StopCallback;
+
+    class                  State;
+    std::shared_ptr<State> state;
+
+    explicit StopToken(std::shared_ptr<State> state);
+
+public:
+    /**
+     * Default constructs. A stop will never be requested of the resulting
+     * instance.
+     */
+    StopToken() =default;
+
+    /**
+     * Indicates if a stop has been requested. Doesn't block.
+     *
+     * @retval `true`    A stop has been requested
+     * @retval `false`   A stop has not been requested
+     * @threadsafety     Safe
+     */
+    bool stopRequested() const noexcept;
+};
+
+/**
+ * Source of stop requests.
+ */
+class StopSource
+{
+    std::shared_ptr<StopToken::State> state;
+
+public:
+    /**
+     * Default constructs.
+     */
+    StopSource();
+
+    /**
+     * Returns a token associated with this instance.
+     *
+     * @return  Associated token
+     */
+    StopToken getToken() const;
+
+    /**
+     * Requests a stop. Calls the registered callbacks on the current thread.
+     * Idempotent.
+     *
+     * @retval `true`    This call requested the stop
+     * @retval `false`   A stop was already requested
+     * @threadsafety     Safe
+     */
+    bool requestStop() const;
+
+    /**
+     * Indicates if a stop has been requested.
+     *
+     * @retval `true`    A stop has been requested
+     * @retval `false`   A stop has not been requested
+     * @threadsafety     Safe
+     */
+    bool stopRequested() const noexcept;
+};
+
+/**
+ * RAII class that arranges for a function to be called when a stop is
+ * requested. The function is typically used to wake a thread that's blocked
+ * (e.g., by notifying a condition variable or shutting down a socket). It's
+ * called immediately, on the current thread, if a stop has already been
+ * requested. On destruction, it's deregistered; if it's executing on another
+ * thread, then destruction blocks until it returns.
+ */
+class StopCallback final
+{
+    StopToken token;
+    uint64_t  id;
+
+public:
+    /**
+     * Constructs.
+     *
+     * @param[in] token     Stop token
+     * @param[in] callback  Function to be called when a stop is requested
+     */
+    StopCallback(
+            const StopToken&      token,
+            std::function<void()> callback);
+
+    StopCallback(const StopCallback& that) =delete;
+    StopCallback& operator=(const StopCallback& rhs) =delete;
+
+    /**
+     * Destroys. Deregisters the function.
+     */
+    ~StopCallback() noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_STOPTOKEN_H_ */
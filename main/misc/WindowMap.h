@@ -0,0 +1,232 @@
+/**
+ * This file declares a map whose keys are indexes that increase
+ * monotonically.
+ *
+ *        File: WindowMap.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_MISC_WINDOWMAP_H_
+#define MAIN_MISC_WINDOWMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * A map whose keys are unsigned indexes that are assigned sequentially (e.g.,
+ * product-indexes). Recent entries are kept in a ring that's indexed by the
+ * key modulo its capacity, so finding them is a single array access. The
+ * full key stored in a slot serves as its generation: a slot holds at most
+ * one key. When two live keys contend for a slot, the older one -- a
+ * straggler -- is moved to an overflow map, so no entry is ever lost.
+ * Comparison of keys is modular, so the keys may wrap around. Not
+ * thread-safe.
+ *
+ * @tparam Value  Type of mapped value. Must be default-constructible.
+ * @tparam Key    Type of key. Must be an unsigned integral type.
+ */
+template<class Value, class Key = uint32_t>
+class WindowMap final
+{
+    static_assert(std::is_unsigned<Key>::value, "Key must be unsigned");
+
+    /// Slot in the ring
+    struct Slot {
+        Key   key;   ///< Key of entry. Identifies the generation of the slot.
+        bool  used;  ///< Does the slot contain an entry?
+        Value value; ///< Mapped value
+
+        Slot()
+            : key(0)
+            , used(false)
+            , value()
+        {}
+    };
+
+    using Overflow = std::unordered_map<Key, Value>;
+
+    std::vector<Slot> ring;     ///< Recent entries
+    size_t            mask;     ///< Capacity of ring minus one
+    Overflow          overflow; ///< Stragglers
+    size_t            count;    ///< Number of entries in the ring
+
+    /**
+     * Returns the capacity of the ring: the power of two that's not less
+     * than the requested capacity.
+     *
+     * @param[in] capacity  Requested capacity
+     * @return              Capacity of the ring
+     */
+    static size_t ringSize(const size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        return size;
+    }
+
+    /**
+     * Indicates if one key is older than another.
+     *
+     * @param[in] lhs     First key
+     * @param[in] rhs     Second key
+     * @retval    `true`  `lhs` is older than `rhs`
+     * @retval    `false` `lhs` isn't older than `rhs`
+     */
+    static bool isOlder(const Key lhs, const Key rhs) noexcept {
+        using Signed = typename std::make_signed<Key>::type;
+        return static_cast<Signed>(lhs - rhs) < 0;
+    }
+
+    inline Slot& slotOf(const Key key) noexcept {
+        return ring[key & mask];
+    }
+
+    inline const Slot& slotOf(const Key key) const noexcept {
+        return ring[key & mask];
+    }
+
+public:
+    /// Default capacity of the ring
+    static const size_t DEFAULT_CAPACITY = 4096;
+
+    /**
+     * Constructs.
+     *
+     * @param[in] capacity  Minimum number of entries in the ring. Increased,
+     *                      if necessary, to the next power of two.
+     */
+    explicit WindowMap(const size_t capacity = DEFAULT_CAPACITY)
+        : ring(ringSize(capacity))
+        , mask(ring.size() - 1)
+        , overflow()
+        , count(0)
+    {}
+
+    /**
+     * Returns the number of entries.
+     *
+     * @return  Number of entries
+     */
+    size_t size() const noexcept {
+        return count + overflow.size();
+    }
+
+    /**
+     * Returns the number of stragglers.
+     *
+     * @return  Number of entries in the overflow map
+     */
+    size_t overflowSize() const noexcept {
+        return overflow.size();
+    }
+
+    /**
+     * Returns the mapped value of a key.
+     *
+     * @param[in] key  Key
+     * @return         Pointer to the mapped value. Will be `nullptr` if the
+     *                 key doesn't exist. Valid until the map is modified.
+     */
+    Value* find(const Key key) {
+        auto& slot = slotOf(key);
+        if (slot.used && slot.key == key)
+            return &slot.value;
+
+        if (overflow.empty())
+            return nullptr;
+
+        auto iter = overflow.find(key);
+        return iter == overflow.end() ? nullptr : &iter->second;
+    }
+
+    /**
+     * Returns the mapped value of a key.
+     *
+     * @param[in] key  Key
+     * @return         Pointer to the mapped value. Will be `nullptr` if the
+     *                 key doesn't exist. Valid until the map is modified.
+     */
+    const Value* find(const Key key) const {
+        return const_cast<WindowMap*>(this)->find(key);
+    }
+
+    /**
+     * Inserts an entry if its key doesn't exist.
+     *
+     * @param[in] key    Key
+     * @param[in] value  Value to be mapped
+     * @return           Pointer to the mapped value of the key and whether the
+     *                   entry was inserted. The pointer is valid until the
+     *                   map is modified.
+     */
+    std::pair<Value*, bool> insert(const Key key, const Value& value) {
+        auto existing = find(key);
+        if (existing)
+            return {existing, false};
+
+        auto& slot = slotOf(key);
+
+        if (slot.used) {
+            if (isOlder(key, slot.key)) {
+                // The new entry is the straggler
+                auto pair = overflow.emplace(key, value);
+                return {&pair.first->second, true};
+            }
+            // The existing entry is the straggler
+            overflow.emplace(slot.key, std::move(slot.value));
+            --count;
+        }
+
+        slot.key = key;
+        slot.value = value;
+        slot.used = true;
+        ++count;
+
+        return {&slot.value, true};
+    }
+
+    /**
+     * Erases an entry.
+     *
+     * @param[in] key      Key of entry
+     * @retval    `true`   The entry existed and was erased
+     * @retval    `false`  The entry didn't exist
+     */
+    bool erase(const Key key) {
+        auto& slot = slotOf(key);
+
+        if (slot.used && slot.key == key) {
+            slot.used = false;
+            slot.value = Value{};
+            --count;
+            return true;
+        }
+
+        return overflow.erase(key) > 0;
+    }
+};
+
+} // namespace
+
+#endif /* MAIN_MISC_WINDOWMAP_H_ */
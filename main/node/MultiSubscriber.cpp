@@ -0,0 +1,286 @@
+/**
+ * A subscriber to several feeds in one process.
+ *
+ *        File: MultiSubscriber.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "MultiSubscriber.h"
+
+#include "error.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <semaphore.h>
+#include <thread>
+#include <vector>
+
+namespace hycast {
+
+class MultiSubscriber::Impl
+{
+    using Mutex  = std::mutex;
+    using Guard  = std::lock_guard<Mutex>;
+    using Thread = std::thread;
+
+    /// A feed that's being subscribed to
+    struct Entry
+    {
+        Feed        feed;       ///< Feed
+        SubRepo     repo;       ///< Repository of feed
+        Subscriber  subscriber; ///< Subscriber to feed. References above.
+        Thread      thread;     ///< Thread on which subscriber executes
+
+        Entry(  const Feed&        feed,
+                const std::string& repoRoot,
+                const SegSize      segSize,
+                const size_t       maxOpenFiles,
+                const WriteBehind& stage)
+            : feed(feed)
+            , repo(repoRoot + "/" + feed.name, segSize, maxOpenFiles)
+            , subscriber(this->feed.srcMcastAddrs, this->feed.p2pInfo,
+                    this->feed.p2pSrvrPool, repo, stage)
+            , thread()
+        {}
+    };
+
+    mutable Mutex      mutex;
+    sem_t              sem;          ///< Halt semaphore
+    const std::string  repoRoot;     ///< Root-directory of repository
+    const SegSize      segSize;      ///< Size of canonical data-segment
+    const size_t       maxOpenFiles; ///< Maximum number of open files
+    std::vector<Feed>  feeds;        ///< Feeds to subscribe to
+    WriteBehind        stage;        ///< Write-behind stage of all feeds
+    std::list<Entry>   entries;      ///< Stable because subscribers reference
+    std::exception_ptr exPtr;        ///< Exception of first failed subscriber
+    bool               started;      ///< `operator()()` has been called?
+
+    /**
+     * Saves the current exception if it's the first.
+     */
+    void setException()
+    {
+        Guard guard{mutex};
+        if (!exPtr)
+            exPtr = std::current_exception();
+    }
+
+    /**
+     * Executes the subscriber of a feed. Halts this instance when the
+     * subscriber returns. Executes on a thread of its own, so it doesn't throw.
+     *
+     * @param[in] entry  Feed entry
+     */
+    void run(Entry& entry) noexcept
+    {
+        try {
+            entry.subscriber();
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex);
+            setException();
+        }
+
+        try {
+            halt();
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex, "Couldn't halt multiple-feed subscriber");
+            setException();
+        }
+    }
+
+    /**
+     * Halts the subscribers and joins their threads.
+     */
+    void stopAll()
+    {
+        for (auto& entry : entries)
+            entry.subscriber.halt();
+
+        for (auto& entry : entries)
+            if (entry.thread.joinable())
+                entry.thread.join();
+    }
+
+    /**
+     * Waits until this instance should stop.
+     *
+     * @throws SystemError  `sem_wait()` failure
+     */
+    void waitUntilDone()
+    {
+        int status;
+        while ((status = ::sem_wait(&sem)) && errno == EINTR)
+            continue;
+
+        if (status)
+            throw SYSTEM_ERROR("sem_wait() failure");
+    }
+
+public:
+    Impl(   const std::string&         repoRoot,
+            const SegSize              segSize,
+            const size_t               maxOpenFiles,
+            const WriteBehind::Policy& policy)
+        : mutex()
+        , sem()
+        , repoRoot(repoRoot)
+        , segSize(segSize)
+        , maxOpenFiles(maxOpenFiles)
+        , feeds()
+        , stage()
+        , entries()
+        , exPtr()
+        , started(false)
+    {
+        if (repoRoot.empty())
+            throw INVALID_ARGUMENT("Pathname of repository is empty");
+        if (maxOpenFiles == 0)
+            throw INVALID_ARGUMENT("Maximum number of open files is zero");
+
+        stage = WriteBehind(segSize, policy);
+
+        if (::sem_init(&sem, 0, 0) == -1)
+            throw SYSTEM_ERROR("sem_init() failure");
+    }
+
+    ~Impl() noexcept
+    {
+        try {
+            stopAll();
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex, "Couldn't stop subscribers");
+        }
+        ::sem_destroy(&sem);
+    }
+
+    void add(const Feed& feed)
+    {
+        const auto& name = feed.name;
+
+        if (name.empty() || name == "." || name == ".." ||
+                name.find('/') != std::string::npos)
+            throw INVALID_ARGUMENT("Invalid feed name: \"" + name + "\"");
+
+        Guard guard{mutex};
+
+        if (started)
+            throw LOGIC_ERROR("Subscriber is executing");
+
+        for (const auto& extant : feeds)
+            if (extant.name == name)
+                throw INVALID_ARGUMENT("Feed \"" + name + "\" already exists");
+
+        feeds.push_back(feed);
+    }
+
+    size_t size() const
+    {
+        Guard guard{mutex};
+        return feeds.size();
+    }
+
+    void operator()()
+    {
+        {
+            Guard guard{mutex};
+            if (started)
+                throw LOGIC_ERROR("Subscriber is already executing");
+            if (feeds.empty())
+                throw LOGIC_ERROR("No feeds were added");
+            started = true;
+        }
+
+        // The feeds share the budget of open files
+        const auto feedOpenFiles = std::max<size_t>(1,
+                maxOpenFiles/feeds.size());
+
+        try {
+            for (const auto& feed : feeds) {
+                entries.emplace_back(feed, repoRoot, segSize, feedOpenFiles,
+                        stage);
+                auto& entry = entries.back();
+                entry.thread = Thread(&Impl::run, this, std::ref(entry));
+                LOG_NOTE("Subscribing to feed \"%s\"", feed.name.data());
+            }
+
+            waitUntilDone();
+        }
+        catch (const std::exception& ex) {
+            stopAll();
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't execute "
+                    "multiple-feed subscriber"));
+        }
+
+        stopAll();
+
+        const auto metrics = stage.getMetrics();
+        LOG_NOTE("{feeds: %lu, write-behind: {max depth: %lu, dropped: %lu, "
+                "overflows: %lu, blocked: %g s}}",
+                static_cast<unsigned long>(entries.size()),
+                static_cast<unsigned long>(metrics.maxDepth),
+                static_cast<unsigned long>(metrics.numDropped),
+                static_cast<unsigned long>(metrics.numOverflows),
+                metrics.blockedSecs);
+
+        if (exPtr)
+            std::rethrow_exception(exPtr);
+    }
+
+    void halt()
+    {
+        if (::sem_post(&sem))
+            throw SYSTEM_ERROR("sem_post() failure");
+    }
+};
+
+/******************************************************************************/
+
+MultiSubscriber::MultiSubscriber(
+        const std::string&         repoRoot,
+        const SegSize              segSize,
+        const size_t               maxOpenFiles,
+        const WriteBehind::Policy& policy)
+    : pImpl{std::make_shared<Impl>(repoRoot, segSize, maxOpenFiles, policy)}
+{}
+
+const MultiSubscriber& MultiSubscriber::add(const Feed& feed) const {
+    pImpl->add(feed);
+    return *this;
+}
+
+size_t MultiSubscriber::size() const {
+    return pImpl->size();
+}
+
+void MultiSubscriber::operator()() const {
+    pImpl->operator()();
+}
+
+void MultiSubscriber::halt() const {
+    pImpl->halt();
+}
+
+} // namespace
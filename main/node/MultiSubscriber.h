@@ -0,0 +1,122 @@
+/**
+ * A subscriber to several feeds in one process.
+ *
+ *        File: MultiSubscriber.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_NODE_MULTISUBSCRIBER_H_
+#define MAIN_NODE_MULTISUBSCRIBER_H_
+
+#include "Node.h"
+
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+namespace hycast {
+
+/**
+ * Subscriber to several feeds in one process. Each feed has its own
+ * source-specific multicast, P2P server, pool of remote P2P servers and
+ * product-index space. The feeds share
+ *   - One repository root-directory: a feed's products are in the
+ *     subdirectory that has the name of the feed;
+ *   - One budget of open product-files, which is divided equally among the
+ *     feeds;
+ *   - One write-behind stage, i.e., one writer thread and one pool of slots
+ *     between the multicast receivers and the repositories; and
+ *   - One lifetime: halting the instance, or the failure of any feed, halts
+ *     every feed.
+ */
+class MultiSubscriber final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// A feed
+    struct Feed
+    {
+        std::string   name;          ///< Name of feed. Can't contain '/'.
+        SrcMcastAddrs srcMcastAddrs; ///< Source-specific multicast addresses
+        P2pInfo       p2pInfo;       ///< Information on local P2P server
+        ServerPool    p2pSrvrPool;   ///< Pool of remote P2P servers
+    };
+
+    /**
+     * Constructs.
+     *
+     * @param[in] repoRoot         Pathname of root-directory of repository
+     * @param[in] segSize          Size of canonical data-segment in bytes
+     * @param[in] maxOpenFiles     Maximum number of open product-files for
+     *                             all feeds
+     * @param[in] policy           Policy of the write-behind stage for all
+     *                             feeds
+     * @throws    InvalidArgument  `repoRoot` is empty, `maxOpenFiles == 0`, or
+     *                             `policy` is invalid
+     * @throws    RuntimeError     Couldn't create writer thread
+     */
+    MultiSubscriber(
+            const std::string&         repoRoot,
+            const SegSize              segSize,
+            const size_t               maxOpenFiles = ::sysconf(_SC_OPEN_MAX)/2,
+            const WriteBehind::Policy& policy = WriteBehind::Policy{});
+
+    /**
+     * Adds a feed. Must be called before `operator()()`.
+     *
+     * @param[in] feed             Feed to be added
+     * @return                     This instance
+     * @throws    InvalidArgument  The name of the feed is invalid or it
+     *                             already exists
+     * @throws    LogicError       `operator()()` has been called
+     */
+    const MultiSubscriber& add(const Feed& feed) const;
+
+    /**
+     * Returns the number of feeds.
+     *
+     * @return  Number of feeds
+     */
+    size_t size() const;
+
+    /**
+     * Executes this instance. Creates a repository and a subscriber for every
+     * feed and executes the subscribers on separate threads. The multicast
+     * receivers and P2P managers remain per-feed because each blocks on its
+     * own sockets. Doesn't return
+     * until `halt()` is called or a subscriber fails, in which case the other
+     * subscribers are halted.
+     *
+     * @throws LogicError  No feeds were added or already called
+     * @throws            Exception of the first subscriber to fail
+     */
+    void operator()() const;
+
+    /**
+     * Halts execution of this instance. Causes `operator()()` to return.
+     *
+     * @asyncsignalsafety  Safe
+     */
+    void halt() const;
+};
+
+} // namespace
+
+#endif /* MAIN_NODE_MULTISUBSCRIBER_H_ */
@@ -0,0 +1,271 @@
+/**
+ * Aggregation of requests for missing data-segments (i.e., negative
+ * acknowledgements) by the publisher.
+ *
+ *        File: NackAggregator.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "NackAggregator.h"
+
+#include "error.h"
+#include "logging.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace hycast {
+
+class NackAggregator::Impl
+{
+    using Clock  = std::chrono::steady_clock;
+    using Mutex  = std::mutex;
+    using Guard  = std::lock_guard<Mutex>;
+    using Lock   = std::unique_lock<Mutex>;
+    using Cond   = std::condition_variable;
+    using Thread = std::thread;
+
+    /// Requests for a data-segment
+    struct Entry {
+        Clock::time_point start;    ///< Time of first request
+        unsigned          numNacks; ///< Number of requests within window
+        bool              remcast;  ///< Has the segment been re-multicast?
+        bool              deferred; ///< Was a request collected?
+    };
+
+    struct SegIdHash {
+        size_t operator()(const SegId& segId) const noexcept {
+            return segId.hash();
+        }
+    };
+
+    using Entries = std::unordered_map<SegId, Entry, SegIdHash>;
+    using Starts  = std::deque<SegId>; ///< Segments in order of first request
+
+    mutable Mutex         mutex;
+    Cond                  cond;
+    const double          minShare;
+    const Clock::duration window;
+    const Clock::duration retention;
+    Entries               entries;
+    Starts                starts;
+    Starts                open;     ///< Segments with collected requests
+    unsigned long         numRemcast;
+    unsigned long         numDeferred;
+    const Closed          closed;
+    bool                  done;     ///< Should the thread exit?
+    Thread                thread;
+
+    /**
+     * Forgets about data-segments whose retention time has expired.
+     *
+     * @pre             Mutex is locked
+     * @param[in] now   Current time
+     */
+    void purge(const Clock::time_point& now) {
+        while (!starts.empty()) {
+            auto iter = entries.find(starts.front());
+            if (now - iter->second.start < retention)
+                break;
+            entries.erase(iter);
+            starts.pop_front();
+        }
+    }
+
+    /**
+     * Calls `closed` for each data-segment with collected requests when its
+     * window closes. Executes on its own thread until `done` is set. Because
+     * every window has the same duration, the windows close in the order
+     * in which they opened.
+     */
+    void run() {
+        Lock lock{mutex};
+
+        while (!done) {
+            if (open.empty()) {
+                cond.wait(lock);
+                continue;
+            }
+
+            const auto iter = entries.find(open.front());
+            if (iter != entries.end()) { // Might have been purged
+                const auto deadline = iter->second.start + window;
+                if (Clock::now() < deadline) {
+                    cond.wait_until(lock, deadline);
+                    continue;
+                }
+            }
+
+            const auto segId = open.front();
+            open.pop_front();
+            if (iter == entries.end())
+                continue;
+
+            lock.unlock();
+            try {
+                closed(segId);
+            }
+            catch (const std::exception& ex) {
+                LOG_ERROR(ex, "Couldn't process closed window of %s",
+                        segId.to_string().data());
+            }
+            lock.lock();
+        }
+    }
+
+    static Clock::duration toDuration(const double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(seconds));
+    }
+
+public:
+    Impl(   const double  minShare,
+            const double  window,
+            const double  retention,
+            const Closed& closed)
+        : mutex()
+        , cond()
+        , minShare(minShare)
+        , window(toDuration(window))
+        , retention(toDuration(retention))
+        , entries()
+        , starts()
+        , open()
+        , numRemcast(0)
+        , numDeferred(0)
+        , closed(closed)
+        , done(false)
+        , thread()
+    {
+        if (minShare <= 0 || minShare > 1)
+            throw INVALID_ARGUMENT("Invalid share of peers: " +
+                    std::to_string(minShare));
+        if (window <= 0)
+            throw INVALID_ARGUMENT("Invalid window: " + std::to_string(window));
+        if (retention <= window)
+            throw INVALID_ARGUMENT("Invalid retention: " +
+                    std::to_string(retention));
+
+        if (closed) {
+            try {
+                thread = Thread(&Impl::run, this);
+            }
+            catch (const std::exception& ex) {
+                std::throw_with_nested(
+                        RUNTIME_ERROR("Couldn't create window thread"));
+            }
+        }
+    }
+
+    ~Impl() noexcept {
+        {
+            Guard guard{mutex};
+            done = true;
+            cond.notify_all();
+        }
+        if (thread.joinable())
+            thread.join();
+    }
+
+    Action add(
+            const SegId& segId,
+            size_t       numPeers) {
+        const auto now = Clock::now();
+        Guard      guard{mutex};
+
+        purge(now);
+
+        auto iter = entries.find(segId);
+        if (iter == entries.end()) {
+            iter = entries.emplace(segId, Entry{now, 0, false, false}).first;
+            starts.push_back(segId);
+        }
+        auto& entry = iter->second;
+
+        /*
+         * A request after the window is a re-request: either the segment
+         * wasn't re-multicast or the re-multicast didn't reach the requester.
+         */
+        if (now - entry.start >= window)
+            return Action::UNICAST;
+
+        if (!entry.remcast) {
+            if (numPeers == 0)
+                numPeers = 1;
+            if (++entry.numNacks > minShare*numPeers) {
+                entry.remcast = true;
+                ++numRemcast;
+                return Action::REMULTICAST;
+            }
+        }
+
+        if (!entry.deferred) {
+            entry.deferred = true;
+            if (closed) {
+                open.push_back(segId);
+                cond.notify_all();
+            }
+        }
+        ++numDeferred;
+        return Action::DEFER;
+    }
+
+    unsigned long getNumRemcast() const noexcept {
+        Guard guard{mutex};
+        return numRemcast;
+    }
+
+    unsigned long getNumDeferred() const noexcept {
+        Guard guard{mutex};
+        return numDeferred;
+    }
+};
+
+/******************************************************************************/
+
+constexpr double NackAggregator::RETENTION;
+
+NackAggregator::NackAggregator(
+        const double  minShare,
+        const double  window,
+        const double  retention,
+        const Closed& closed)
+    : pImpl{std::make_shared<Impl>(minShare, window, retention, closed)}
+{}
+
+NackAggregator::Action NackAggregator::add(
+        const SegId& segId,
+        const size_t numPeers) const {
+    return pImpl->add(segId, numPeers);
+}
+
+unsigned long NackAggregator::getNumRemcast() const noexcept {
+    return pImpl->getNumRemcast();
+}
+
+unsigned long NackAggregator::getNumDeferred() const noexcept {
+    return pImpl->getNumDeferred();
+}
+
+} // namespace
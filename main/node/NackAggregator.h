@@ -0,0 +1,145 @@
+/**
+ * Aggregation of requests for missing data-segments (i.e., negative
+ * acknowledgements) by the publisher in order to decide which segments should
+ * be re-multicast rather than repaired over the P2P network.
+ *
+ *        File: NackAggregator.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_NODE_NACKAGGREGATOR_H_
+#define MAIN_NODE_NACKAGGREGATOR_H_
+
+#include "hycast.h"
+
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe aggregator of the requests for data-segments that the publisher
+ * receives from its peers. A correlated loss (e.g., a burst loss upstream of a
+ * whole site) causes many subscribers to request the same data-segments.
+ *
+ * The first request for a data-segment opens a time-window for it. Requests
+ * for the segment within the window are collected rather than answered. If
+ * their number exceeds a given share of the publisher's peers, then the
+ * segment is re-multicast once. When the window of a segment with collected
+ * requests closes, a given function is called so that the segment can be
+ * announced again; subscribers that still lack it then request it at once
+ * rather than after their request timeout. A request that arrives after the
+ * segment's window has closed is answered over the P2P network.
+ */
+class NackAggregator
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// What to do about a request for a data-segment
+    enum class Action {
+        UNICAST,     ///< Send the segment to the requesting peer
+        REMULTICAST, ///< Re-multicast the segment
+        DEFER        ///< Do nothing now: answered when the window closes
+    };
+
+    /**
+     * Function called on a separate thread when the window of a data-segment
+     * with collected requests closes.
+     */
+    using Closed = std::function<void(const SegId& segId)>;
+
+    /// Default duration, in seconds, that a data-segment is remembered
+    static constexpr double RETENTION = 10;
+
+    /**
+     * Default constructs. The resulting instance will test false and must not
+     * be used.
+     */
+    NackAggregator() =default;
+
+    /**
+     * Constructs.
+     *
+     * @param[in] minShare         Share of peers whose requests for a
+     *                             data-segment cause it to be re-multicast.
+     *                             Must be in (0, 1].
+     * @param[in] window           Duration, in seconds, over which requests
+     *                             are aggregated
+     * @param[in] retention        Duration, in seconds, that a data-segment is
+     *                             remembered after its first request so that
+     *                             re-requests are answered over the P2P
+     *                             network. Must be greater than `window`.
+     * @param[in] closed           Function to call when the window of a
+     *                             data-segment with collected requests closes.
+     *                             If empty, then no thread is created and the
+     *                             requesters must re-request after their
+     *                             timeout.
+     * @throws    InvalidArgument  `minShare`, `window`, or `retention` is
+     *                             invalid
+     * @throws    RuntimeError     Couldn't create thread
+     */
+    NackAggregator(
+            const double  minShare,
+            const double  window = 0.1,
+            const double  retention = RETENTION,
+            const Closed& closed = Closed{});
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept {
+        return static_cast<bool>(pImpl);
+    }
+
+    /**
+     * Adds a request for a data-segment and returns what should be done
+     * about it.
+     *
+     * @param[in] segId     Identifier of requested data-segment
+     * @param[in] numPeers  Number of peers that could have made the request
+     * @return              What to do about the request
+     * @threadsafety        Safe
+     */
+    Action add(
+            const SegId& segId,
+            size_t       numPeers) const;
+
+    /**
+     * Returns the number of data-segments that have been re-multicast.
+     *
+     * @return  Number of re-multicast data-segments
+     */
+    unsigned long getNumRemcast() const noexcept;
+
+    /**
+     * Returns the number of requests that weren't answered because they were
+     * collected in a window.
+     *
+     * @return  Number of deferred requests
+     */
+    unsigned long getNumDeferred() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_NODE_NACKAGGREGATOR_H_ */
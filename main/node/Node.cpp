@@ -25,7 +25,11 @@
 #include "Node.h"
 
 #include "error.h"
+#include "McastRateCtl.h"
+#include "NackAggregator.h"
+#include "StopToken.h"
 
+#include <mutex>
 #include <semaphore.h>
 #include <thread>
 
@@ -209,10 +213,18 @@ void Node::halt() const {
  */
 class Publisher::Impl final : public Node::Impl
 {
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
+
+    Mutex              mcastMutex; ///< Serializes multicasting
     McastSndr          mcastSndr;
     PubRepo            repo;
     SegSize            segSize;
     Thread             sendThread;
+    StopSource         stopSource; ///< Stops the sending thread
+    bool               zeroCopy;   ///< Multicast data-segments zero-copy?
+    NackAggregator     nackAggregator; ///< Decides on re-multicasting
+    McastRateCtl       rateCtl;        ///< Controls the multicast rate
 
     /**
      * Sends product-information.
@@ -223,7 +235,10 @@ class Publisher::Impl final : public Node::Impl
     void send(const ProdInfo& prodInfo)
     {
         try {
-            mcastSndr.multicast(prodInfo);
+            {
+                Guard guard{mcastMutex};
+                mcastSndr.multicast(prodInfo);
+            }
             p2pMgr.notify(prodInfo.getProdIndex());
         }
         catch (const std::exception& ex) {
@@ -237,12 +252,19 @@ class Publisher::Impl final : public Node::Impl
      * Sends a data-segment
      *
      * @param[in] memSeg        Data-segment to be sent
+     * @param[in] pin           Keeps the segment's data valid for zero-copy
+     *                          multicasting. May be empty.
      * @throws    RuntimeError  Couldn't send
      */
-    void send(const MemSeg& memSeg)
+    void send(
+            const MemSeg&       memSeg,
+            const UdpSock::Pin& pin)
     {
         try {
-            mcastSndr.multicast(memSeg);
+            {
+                Guard guard{mcastMutex};
+                mcastSndr.multicast(memSeg, pin);
+            }
             p2pMgr.notify(memSeg.getSegId());
         }
         catch (const std::exception& ex) {
@@ -253,13 +275,18 @@ class Publisher::Impl final : public Node::Impl
     }
 
     /**
-     * Executes the sender of new data-products in the repository.
+     * Executes the sender of new data-products in the repository. Returns
+     * when a stop is requested.
      */
     void runSender()
     {
+        const auto stopToken = stopSource.getToken();
+
         try {
             for (;;) {
-                auto prodInfo = repo.getNextProd();
+                auto prodInfo = repo.getNextProd(stopToken);
+                if (!prodInfo)
+                    break; // Stop requested
 
                 // Send product-information
                 send(prodInfo);
@@ -267,18 +294,22 @@ class Publisher::Impl final : public Node::Impl
                 // Send data-segments
                 auto prodIndex = prodInfo.getProdIndex();
                 auto prodSize = prodInfo.getProdSize();
-                for (ProdSize offset = 0; offset < prodSize; offset += segSize)
+                /*
+                 * The product's mapping stays valid until the kernel is done
+                 * with the last zero-copy datagram that references it
+                 */
+                const auto pin = zeroCopy
+                        ? repo.pin(prodIndex)
+                        : UdpSock::Pin{};
+                for (ProdSize offset = 0; offset < prodSize &&
+                        !stopToken.stopRequested(); offset += segSize)
                     // TODO: Test for valid segment
-                    send(repo.getMemSeg(SegId(prodIndex, offset)));
+                    send(repo.getMemSeg(SegId(prodIndex, offset)), pin);
             }
         }
         catch (const std::exception& ex) {
             setException(ex);
         }
-        catch (...) {
-            LOG_DEBUG("Thread cancelled");
-            throw;
-        }
     }
 
     void startSender() {
@@ -293,7 +324,7 @@ class Publisher::Impl final : public Node::Impl
 
     void stopSender() {
         if (sendThread.joinable()) {
-            ::pthread_cancel(sendThread.native_handle());
+            stopSource.requestStop();
             sendThread.join();
         }
     }
@@ -302,20 +333,32 @@ public:
     /**
      * Constructs.
      *
-     * @param[in] p2pInfo  Information about the local P2P server
-     * @param[in] grpAddr  Destination address for multicast products
-     * @param[in] repo     Publisher's repository
+     * @param[in] p2pInfo   Information about the local P2P server
+     * @param[in] grpAddr   Destination address for multicast products
+     * @param[in] repo      Publisher's repository
+     * @param[in] zeroCopy  Whether to try zero-copy multicasting
      */
     Impl(   P2pInfo&        p2pInfo,
             const SockAddr& grpAddr,
-            PubRepo&        repo)
+            PubRepo&        repo,
+            const bool      zeroCopy)
         : Node::Impl(P2pMgr(p2pInfo, *this), repo)
         , mcastSndr{UdpSock(grpAddr)}
         , repo(repo)
         , segSize{repo.getSegSize()}
         , sendThread()
+        , stopSource()
+        , zeroCopy{false}
+        , nackAggregator()
+        , rateCtl()
     {
         mcastSndr.setMcastIface(p2pInfo.sockAddr.getInetAddr());
+
+        if (zeroCopy) {
+            this->zeroCopy = mcastSndr.enableZeroCopy();
+            if (!this->zeroCopy)
+                LOG_NOTE("Zero-copy multicasting is unsupported. Copying.");
+        }
     }
 
     /**
@@ -323,10 +366,7 @@ public:
      */
     ~Impl()
     {
-        if (sendThread.joinable()) {
-            ::pthread_cancel(sendThread.native_handle());
-            sendThread.join();
-        }
+        stopSender();
         if (::sem_destroy(&sem))
             LOG_ERROR("sem_destroy() failure");
     }
@@ -380,6 +420,111 @@ public:
             const std::string& prodName) {
         repo.link(pathname, prodName);
     }
+
+    /**
+     * Enables the re-multicasting of widely requested data-segments.
+     *
+     * @param[in] minShare         Share of peers whose requests for a
+     *                             data-segment cause it to be re-multicast
+     * @param[in] window           Duration, in seconds, over which requests
+     *                             are aggregated
+     * @throws    InvalidArgument  `minShare` or `window` is invalid
+     */
+    void setRemcast(
+            const double minShare,
+            const double window) {
+        // Subscribers whose requests were collected request again at once
+        nackAggregator = NackAggregator(minShare, window,
+                NackAggregator::RETENTION, [this](const SegId& segId) {
+                    p2pMgr.notify(segId);
+                });
+    }
+
+    /**
+     * Enables control of the multicast rate by the reception reports of
+     * subscribers.
+     *
+     * @param[in] minRate          Minimum rate in bytes per second
+     * @param[in] maxRate          Maximum rate in bytes per second
+     * @param[in] maxLoss          Maximum acceptable loss-rate
+     * @throws    InvalidArgument  An argument is invalid
+     */
+    void setRateCtl(
+            const double minRate,
+            const double maxRate,
+            const double maxLoss) {
+        rateCtl = McastRateCtl(minRate, maxRate, maxLoss);
+        mcastSndr.setRate(rateCtl.getRate());
+    }
+
+    /**
+     * Processes a subscriber's reception report.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     */
+    void report(
+            const double lossRate,
+            const double rcvRate) {
+        if (rateCtl && rateCtl.report(lossRate, rcvRate))
+            mcastSndr.setRate(rateCtl.getRate());
+    }
+
+    /**
+     * Receives a subscriber's reception report from the P2P manager.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     */
+    void recvReport(
+            const double lossRate,
+            const double rcvRate) override {
+        report(lossRate, rcvRate);
+    }
+
+    /**
+     * Returns the multicast rate.
+     *
+     * @return  Maximum multicast rate in bytes per second. 0 means no maximum.
+     */
+    double getRate() const noexcept {
+        return mcastSndr.getRate();
+    }
+
+    /**
+     * Returns a data-segment for a remote peer. If enabled, requests for a
+     * data-segment are aggregated and a segment that too many peers have
+     * requested is re-multicast instead.
+     *
+     * @param[in] segId  Identifier of the data-segment
+     * @return           The segment. Will test false if it doesn't exist or
+     *                   shouldn't be sent to the remote peer now.
+     * @see              `NackAggregator`
+     */
+    MemSeg getMemSeg(const SegId& segId) override
+    {
+        auto memSeg = repo.getMemSeg(segId);
+
+        if (memSeg && nackAggregator) {
+            switch (nackAggregator.add(segId, p2pMgr.size())) {
+            case NackAggregator::Action::REMULTICAST: {
+                LOG_DEBUG("Re-multicasting data-segment %s",
+                        segId.to_string().data());
+                Guard guard{mcastMutex};
+                mcastSndr.multicast(memSeg);
+                memSeg = MemSeg{};
+                break;
+            }
+            case NackAggregator::Action::DEFER:
+                memSeg = MemSeg{};
+                break;
+            default:
+                break;
+            }
+        }
+
+        return memSeg;
+    }
 };
 
 Publisher::Publisher()
@@ -389,8 +534,34 @@ Publisher::Publisher()
 Publisher::Publisher(
         P2pInfo&        p2pInfo,
         const SockAddr& grpAddr,
-        PubRepo&        repo)
-    : Node(new Impl{p2pInfo,  grpAddr, repo}) {
+        PubRepo&        repo,
+        const bool      zeroCopy)
+    : Node(new Impl{p2pInfo,  grpAddr, repo, zeroCopy}) {
+}
+
+Publisher& Publisher::setRemcast(
+        const double minShare,
+        const double window) {
+    static_cast<Impl*>(pImpl.get())->setRemcast(minShare, window);
+    return *this;
+}
+
+Publisher& Publisher::setRateCtl(
+        const double minRate,
+        const double maxRate,
+        const double maxLoss) {
+    static_cast<Impl*>(pImpl.get())->setRateCtl(minRate, maxRate, maxLoss);
+    return *this;
+}
+
+void Publisher::report(
+        const double lossRate,
+        const double rcvRate) const {
+    static_cast<Impl*>(pImpl.get())->report(lossRate, rcvRate);
+}
+
+double Publisher::getRate() const noexcept {
+    return static_cast<Impl*>(pImpl.get())->getRate();
 }
 
 void Publisher::link(
@@ -419,6 +590,7 @@ class Subscriber::Impl final : public Node::Impl, public P2pSub, public McastSub
     std::atomic<unsigned long> numTcpOrig;      ///< Number of original TCP chunks
     std::atomic<unsigned long> numUdpDup;       ///< Number of duplicate UDP chunks
     std::atomic<unsigned long> numTcpDup;       ///< Number of duplicate TCP chunks
+    WriteBehind                writeBehind;     ///< Multicast write-behind stage
 
     void runMcast()
     {
@@ -450,6 +622,25 @@ class Subscriber::Impl final : public Node::Impl, public P2pSub, public McastSub
         }
     }
 
+    /**
+     * Processes a multicast data-segment that the write-behind stage has
+     * processed. Called by the stage's writer thread.
+     *
+     * @param[in] segId  Identifier of data-segment
+     * @param[in] saved  Whether the data-segment is new
+     */
+    void wasWritten(
+            const SegId& segId,
+            const bool   saved) {
+        if (saved) {
+            ++numUdpOrig;
+            p2pMgr.notify(segId);
+        }
+        else {
+            ++numUdpDup;
+        }
+    }
+
 public:
     /**
      * Constructs.
@@ -458,12 +649,14 @@ public:
      * @param[in,out] p2pInfo        Information about the local P2P server
      * @param[in,out] p2pSrvrPool    Pool of remote P2P-servers
      * @param[in,out] repo           Data-product repository
-     * @param[in]     rcvrObs        Observer of this instance
+     * @param[in]     stage          Write-behind stage. May be shared with
+     *                               other subscribers.
      */
     Impl(   const SrcMcastAddrs& srcMcastAddrs,
             const P2pInfo&       p2pInfo,
             ServerPool&          p2pSrvrPool,
-            SubRepo&             repo)
+            SubRepo&             repo,
+            const WriteBehind&   stage)
         : Node::Impl(P2pMgr(p2pInfo, p2pSrvrPool, *this), repo)
         , mcastRcvr{srcMcastAddrs, *this}
         , repo(repo)
@@ -472,8 +665,25 @@ public:
         , numTcpOrig{0}
         , numUdpDup{0}
         , numTcpDup{0}
+        , writeBehind(stage.attach(this->repo,
+                [this](const SegId& segId, bool saved) {
+                    wasWritten(segId, saved);}))
     {}
 
+    /**
+     * Destroys. Doesn't return until the write-behind stage has processed this
+     * instance's data-segments because the stage might outlive it.
+     */
+    ~Impl() noexcept
+    {
+        try {
+            writeBehind.flush();
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex, "Couldn't flush write-behind stage");
+        }
+    }
+
     /**
      * Executes this instance. Doesn't return until either `halt()` is called
      * or an exception is thrown.
@@ -490,10 +700,17 @@ public:
             try {
                 waitUntilDone();
 
+                const auto metrics = writeBehind.getMetrics();
                 LOG_NOTE("{original chunks: {UDP: %lu, TCP: %lu}, "
-                        "duplicate chunks: {UDP: %lu, TCP: %lu}}",
+                        "duplicate chunks: {UDP: %lu, TCP: %lu}, "
+                        "write-behind: {max depth: %lu, dropped: %lu, "
+                        "overflows: %lu, blocked: %g s}}",
                         numUdpOrig.load(), numTcpOrig.load(),
-                        numUdpDup.load(), numTcpDup.load());
+                        numUdpDup.load(), numTcpDup.load(),
+                        static_cast<unsigned long>(metrics.maxDepth),
+                        static_cast<unsigned long>(metrics.numDropped),
+                        static_cast<unsigned long>(metrics.numOverflows),
+                        metrics.blockedSecs);
 
                 stopP2pMgr(); // Idempotent
             } // P2P manager started
@@ -604,24 +821,18 @@ public:
     }
 
     /**
-     * Processes receipt of a data-segment from the multicast.
+     * Processes receipt of a data-segment from the multicast. The segment is
+     * queued for the write-behind stage so that a storage stall doesn't stall
+     * the multicast receiver. Peers are notified after the segment is saved.
      *
-     * @param[in] udpSeg   Multicast data-segment
-     * @retval    `false`  Data-segment is old
-     * @retval    `true`   Data-segment is new
+     * @param[in] mcastSeg  Multicast data-segment
+     * @retval    `false`   Data-segment was dropped by the write-behind stage
+     * @retval    `true`    Data-segment was queued
      */
-    bool hereIsMcast(UdpSeg& udpSeg)
+    bool hereIsMcast(DataSeg& mcastSeg)
     {
-        LOG_DEBUG("Saving data-segment " + udpSeg.getSegId().to_string());
-        const bool saved = repo.save(udpSeg);
-        if (saved) {
-            ++numUdpOrig;
-            p2pMgr.notify(udpSeg.getSegId());
-        }
-        else {
-            ++numUdpDup;
-        }
-        return saved;
+        LOG_DEBUG("Queuing data-segment " + mcastSeg.getSegId().to_string());
+        return writeBehind.save(mcastSeg);
     }
 
     /**
@@ -653,12 +864,23 @@ public:
 
 /******************************************************************************/
 
+Subscriber::Subscriber(
+        const SrcMcastAddrs&       srcMcastAddrs,
+        P2pInfo&                   p2pInfo,
+        ServerPool&                p2pSrvrPool,
+        SubRepo&                   repo,
+        const WriteBehind::Policy& policy)
+    : Node{new Impl{srcMcastAddrs, p2pInfo, p2pSrvrPool, repo,
+            WriteBehind(repo.getSegSize(), policy)}} {
+}
+
 Subscriber::Subscriber(
         const SrcMcastAddrs& srcMcastAddrs,
         P2pInfo&             p2pInfo,
         ServerPool&          p2pSrvrPool,
-        SubRepo&             repo)
-    : Node{new Impl{srcMcastAddrs, p2pInfo, p2pSrvrPool, repo}} {
+        SubRepo&             repo,
+        const WriteBehind&   stage)
+    : Node{new Impl{srcMcastAddrs, p2pInfo, p2pSrvrPool, repo, stage}} {
 }
 
 #if 0
@@ -26,6 +26,7 @@
 #include "McastProto.h"
 #include "P2pMgr.h"
 #include "Repository.h"
+#include "WriteBehind.h"
 
 #include <memory>
 
@@ -76,14 +77,82 @@ public:
     /**
      * Constructs.
      *
-     * @param[in] p2pInfo  Information about the local P2P server
-     * @param[in] grpAddr  Address to which products will be multicast
-     * @param[in] repo     Publisher's repository
+     * @param[in] p2pInfo   Information about the local P2P server
+     * @param[in] grpAddr   Address to which products will be multicast
+     * @param[in] repo      Publisher's repository
+     * @param[in] zeroCopy  Whether to multicast data-segments without the
+     *                      kernel copying them (`MSG_ZEROCOPY`). Falls back to
+     *                      copying if unsupported. Only worthwhile for large
+     *                      datagrams on a NIC that supports scatter-gather.
      */
     Publisher(
             P2pInfo&        p2pInfo,
             const SockAddr& grpAddr,
-            PubRepo&        repo);
+            PubRepo&        repo,
+            bool            zeroCopy = false);
+
+    /**
+     * Enables the re-multicasting of data-segments that many subscribers
+     * missed. Requests for a data-segment from the publisher's peers are
+     * collected, unanswered, over a time-window that starts with the first
+     * request. A data-segment that's requested by more than a given share of
+     * the peers within its window is re-multicast once. When the window closes,
+     * the data-segment is announced to the peers again so that subscribers
+     * that still lack it request it at once, and such requests are answered
+     * over the P2P network. Must be called before `operator()()`.
+     *
+     * @param[in] minShare         Share of peers whose requests for a
+     *                             data-segment cause it to be re-multicast.
+     *                             Must be in (0, 1].
+     * @param[in] window           Duration, in seconds, over which requests
+     *                             are aggregated
+     * @return                     This instance
+     * @throws    InvalidArgument  `minShare` or `window` is invalid
+     */
+    Publisher& setRemcast(
+            double minShare,
+            double window = 0.1);
+
+    /**
+     * Enables receiver-driven control of the multicast rate. The rate starts
+     * at the maximum and is adapted to the reception reports of subscribers.
+     * Must be called before `operator()()`.
+     *
+     * @param[in] minRate          Minimum rate in bytes per second
+     * @param[in] maxRate          Maximum rate in bytes per second
+     * @param[in] maxLoss          Maximum acceptable loss-rate in [0, 1). Above
+     *                             it, the P2P repair load is deemed to cost
+     *                             more than a lower multicast rate.
+     * @return                     This instance
+     * @throws    InvalidArgument  An argument is invalid
+     * @see `McastRateCtl`
+     */
+    Publisher& setRateCtl(
+            double minRate,
+            double maxRate,
+            double maxLoss = 0.01);
+
+    /**
+     * Processes a subscriber's reception report. The P2P manager calls this
+     * for every report that a remote subscriber sends. Does nothing if rate
+     * control isn't enabled.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     * @threadsafety        Safe
+     */
+    void report(
+            double lossRate,
+            double rcvRate) const;
+
+    /**
+     * Returns the rate to which multicasting is paced.
+     *
+     * @return        Maximum multicast rate in bytes per second. 0 means no
+     *                maximum (i.e., rate control isn't enabled).
+     * @threadsafety  Safe
+     */
+    double getRate() const noexcept;
 
     /**
      * Links to a file (which could be a directory) that's outside the
@@ -121,12 +190,35 @@ public:
      * @param[in] p2pInfo        Information about the local P2P server
      * @param[in] ServerPool     Pool of remote P2P servers
      * @param[in] repo           Subscriber's product repository
+     * @param[in] policy         Policy of the write-behind stage between the
+     *                           multicast receiver and the repository
+     */
+    Subscriber(
+            const SrcMcastAddrs&       srcMcastAddrs,
+            P2pInfo&                   p2pInfo,
+            ServerPool&                p2pSrvrPool,
+            SubRepo&                   repo,
+            const WriteBehind::Policy& policy = WriteBehind::Policy{});
+
+    /**
+     * Constructs. The subscriber's multicast data-segments are saved by a
+     * write-behind stage that it shares with other subscribers (e.g., those of
+     * other feeds) so that they share its writer thread and pool of slots.
+     *
+     * @param[in] srcMcastAddrs  Source-specific multicast addresses
+     * @param[in] p2pInfo        Information about the local P2P server
+     * @param[in] ServerPool     Pool of remote P2P servers
+     * @param[in] repo           Subscriber's product repository
+     * @param[in] stage          Shared write-behind stage. Data-segments
+     *                           larger than its slots are saved directly.
+     * @see `WriteBehind::WriteBehind(SegSize, const Policy&)`
      */
     Subscriber(
             const SrcMcastAddrs& srcMcastAddrs,
             P2pInfo&             p2pInfo,
             ServerPool&          p2pSrvrPool,
-            SubRepo&             repo);
+            SubRepo&             repo,
+            const WriteBehind&   stage);
 
 #if 0
     /**
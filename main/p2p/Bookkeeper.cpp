@@ -0,0 +1,748 @@
+/**
+ * Tracks the status of peers in a thread-safe manner.
+ *
+ *        File: Bookkeeper.cpp
+ *  Created on: Oct 17, 2019
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "Bookkeeper.h"
+#include "HycastProto.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * Implementation interface for status monitoring of peers.
+ */
+class Bookkeeper::Impl
+{
+protected:
+    mutable Mutex mutex;
+
+    /**
+     * Constructs.
+     *
+     * @throws std::system_error  Out of memory
+     * @cancellationpoint         No
+     */
+    Impl()
+        : mutex()
+    {}
+
+public:
+    virtual ~Impl() noexcept =default;
+
+    virtual void add(const Peer peer) =0;
+
+    virtual void reset() noexcept =0;
+
+    virtual bool remove(const Peer peer) =0;
+};
+
+Bookkeeper::Bookkeeper(Impl* impl)
+    : pImpl(impl) {
+}
+
+/******************************************************************************/
+
+/**
+ * Bookkeeper implementation for a publisher
+ */
+class PubBookkeeper::Impl final : public Bookkeeper::Impl
+{
+    /// Map of peer -> number of requests by remote peer
+    std::unordered_map<Peer, uint_fast32_t> numRequests;
+
+public:
+    Impl(const int maxPeers)
+        : Bookkeeper::Impl()
+        , numRequests()
+    {}
+
+    void add(const Peer peer) override {
+        Guard guard(mutex);
+        numRequests[peer] = 0;
+    }
+
+    void requested(const Peer peer) {
+        Guard guard(mutex);
+        ++numRequests[peer];
+    }
+
+    Peer getWorstPeer() const {
+        Peer          peer{};
+        unsigned long minCount{ULONG_MAX};
+        Guard         guard(mutex);
+
+        for (auto& elt : numRequests) {
+            auto count = elt.second;
+
+            if (count < minCount) {
+                minCount = count;
+                peer = elt.first;
+            }
+        }
+
+        return peer;
+    }
+
+    void reset() noexcept override {
+        Guard guard(mutex);
+
+        for (auto& elt : numRequests)
+            elt.second = 0;
+    }
+
+    bool remove(const Peer peer) override {
+        Guard guard(mutex);
+        return numRequests.erase(peer) == 1;
+    }
+};
+
+PubBookkeeper::PubBookkeeper(const int maxPeers)
+    : Bookkeeper(new Impl(maxPeers)) {
+}
+
+void PubBookkeeper::add(const Peer peer) const {
+    static_cast<Impl*>(pImpl.get())->add(peer);
+}
+
+void PubBookkeeper::requested(const Peer peer) const {
+    static_cast<Impl*>(pImpl.get())->requested(peer);
+}
+
+Peer PubBookkeeper::getWorstPeer() const {
+    return static_cast<Impl*>(pImpl.get())->getWorstPeer();
+}
+
+bool PubBookkeeper::remove(const Peer peer) const {
+    return static_cast<Impl*>(pImpl.get())->remove(peer);
+}
+
+/******************************************************************************/
+
+/**
+ * Bookkeeper implementation for a subscriber
+ */
+class SubBookkeeper::Impl final : public Bookkeeper::Impl
+{
+    using Ratings    = std::unordered_map<Peer, uint_fast32_t>;
+    using PeerQueue  = std::queue<Peer, std::list<Peer>>;
+    using PeerQueues = std::unordered_map<NoteReq, PeerQueue>;
+    using Clock      = std::chrono::steady_clock;
+    using Peers      = std::vector<Peer>;
+
+    /// Swarming state of a peer
+    struct Swarmer {
+        double                rate;     ///< Smoothed segments per second
+        Clock::time_point     since;    ///< Start of current interval
+        unsigned              numOut;   ///< Number of outstanding requests
+        std::deque<DataSegId> backlog;  ///< Segments peer has. Might be stale.
+        Swarmer()
+            : rate{0}
+            , since()
+            , numOut{0}
+            , backlog()
+        {}
+    };
+    /// Swarming state of a data-segment that hasn't been received
+    struct SegState {
+        Peers holders;    ///< Peers that have the segment
+        Peers requesters; ///< Peers that requested it. >1 if stolen.
+    };
+    using Swarmers  = std::unordered_map<Peer, Swarmer>;
+    using SegStates = std::unordered_map<DataSegId, SegState>;
+
+    /// Weight of a new sample of a peer's throughput
+    static constexpr double   ALPHA = 0.25;
+    /// Duration, in seconds, of the requests in a peer's pipeline
+    static constexpr double   PIPELINE_DURATION = 0.05;
+    /// Minimum number of outstanding requests per peer
+    static constexpr unsigned MIN_WINDOW = 4;
+    /// Maximum number of outstanding requests per peer
+    static constexpr unsigned MAX_WINDOW = 256;
+
+    /// Map of peer -> peer rating
+    Ratings    ratings;
+    /**
+     * Map of request -> alternative peers that could make the request in the
+     * order in which their notifications arrived.
+     */
+    PeerQueues altPeers;
+    /// Stripe data-segment requests across peers?
+    const bool swarm;
+    /// Map of peer -> swarming state
+    Swarmers   swarmers;
+    /// Map of data-segment -> swarming state
+    SegStates  segStates;
+    /// Data-segments with outstanding requests
+    std::unordered_set<DataSegId> inFlight;
+
+    /**
+     * Returns the throughput of a peer. A peer that hasn't been measured is
+     * assumed to have the mean throughput of those that have.
+     *
+     * @pre                State is locked
+     * @param[in] swarmer  Peer's swarming state
+     * @return             Peer's throughput in segments per second
+     */
+    double rateOf(const Swarmer& swarmer) const
+    {
+        if (swarmer.rate > 0)
+            return swarmer.rate;
+
+        double   sum = 0;
+        unsigned num = 0;
+        for (auto& pair : swarmers) {
+            if (pair.second.rate > 0) {
+                sum += pair.second.rate;
+                ++num;
+            }
+        }
+        return num ? sum/num : 1;
+    }
+
+    /**
+     * Indicates if a peer may make another request.
+     *
+     * @pre                State is locked
+     * @param[in] swarmer  Peer's swarming state
+     * @retval    `true`   Yes
+     * @retval    `false`  No
+     */
+    bool hasRoom(const Swarmer& swarmer) const
+    {
+        const auto window = static_cast<unsigned>(rateOf(swarmer) *
+                PIPELINE_DURATION);
+        return swarmer.numOut < std::max(MIN_WINDOW,
+                std::min(MAX_WINDOW, window));
+    }
+
+    /**
+     * Assigns a data-segment request to a peer.
+     *
+     * @pre                  State is locked
+     * @param[in] peer       Peer
+     * @param[in] swarmer    Peer's swarming state
+     * @param[in] segState   Segment's swarming state
+     * @param[in] dataSegId  Segment identifier
+     */
+    void assign(
+            Peer             peer,
+            Swarmer&         swarmer,
+            SegState&        segState,
+            const DataSegId& dataSegId)
+    {
+        if (swarmer.numOut++ == 0)
+            swarmer.since = Clock::now();
+        segState.requesters.push_back(peer);
+        inFlight.insert(dataSegId);
+    }
+
+    /**
+     * Returns the swarming state of a peer.
+     *
+     * @pre                   State is locked
+     * @param[in] peer        Peer
+     * @return                Peer's swarming state
+     * @throws    LogicError  Peer is unknown
+     */
+    Swarmer& getSwarmer(Peer peer)
+    {
+        auto iter = swarmers.find(peer);
+        if (iter == swarmers.end())
+            throw LOGIC_ERROR("Peer " + peer.to_string() + " is unknown");
+        return iter->second;
+    }
+
+    /**
+     * Swarming version of `shouldRequest()` for a data-segment.
+     *
+     * @param[in] peer        Peer
+     * @param[in] dataSegId   Data segment identifier
+     * @return    `true`      Request should be made
+     * @return    `false`     Request shouldn't be made now
+     * @throws    LogicError  Peer is unknown or already has the segment
+     */
+    bool shouldSwarm(
+            Peer             peer,
+            const DataSegId& dataSegId)
+    {
+        Guard guard(mutex);
+        auto& swarmer = getSwarmer(peer);
+        auto& segState = segStates[dataSegId];
+        auto& holders = segState.holders;
+
+        if (std::find(holders.begin(), holders.end(), peer) != holders.end())
+            throw LOGIC_ERROR("Peer " + peer.to_string() + " already has " +
+                    dataSegId.to_string());
+
+        holders.push_back(peer);
+
+        if (segState.requesters.empty() && hasRoom(swarmer)) {
+            assign(peer, swarmer, segState, dataSegId);
+            return true;
+        }
+
+        swarmer.backlog.push_back(dataSegId); // For `getRequest()`
+        return false;
+    }
+
+    /**
+     * Swarming version of `received()` for a data-segment. Nothing happens if
+     * the peer didn't request the segment (e.g., another peer satisfied a
+     * stolen request first).
+     *
+     * @param[in] peer        Peer
+     * @param[in] dataSegId   Data segment identifier
+     * @throws    LogicError  Peer is unknown
+     */
+    void swarmReceived(
+            Peer             peer,
+            const DataSegId& dataSegId)
+    {
+        Guard guard(mutex);
+        auto& swarmer = getSwarmer(peer);
+        auto  iter = segStates.find(dataSegId);
+
+        if (iter == segStates.end())
+            return;
+        auto& requesters = iter->second.requesters;
+        if (std::find(requesters.begin(), requesters.end(), peer) ==
+                requesters.end())
+            return;
+
+        // Measure the peer's throughput while it's busy
+        const auto now = Clock::now();
+        const auto secs = std::chrono::duration<double>(now - swarmer.since)
+                .count();
+        const auto sample = 1 / std::max(secs, 1e-6);
+        swarmer.rate = (swarmer.rate > 0)
+                ? swarmer.rate + ALPHA*(sample - swarmer.rate)
+                : sample;
+        swarmer.since = now;
+        ++ratings.at(peer);
+
+        for (auto& requester : requesters) {
+            auto swarmerIter = swarmers.find(requester);
+            if (swarmerIter != swarmers.end())
+                --swarmerIter->second.numOut;
+        }
+        inFlight.erase(dataSegId);
+        segStates.erase(iter);
+    }
+
+    /**
+     * Returns an outstanding request of a slower peer that a peer could steal.
+     *
+     * @pre                    State is locked
+     * @param[in]  peer        Idle peer
+     * @param[in]  swarmer     Idle peer's swarming state
+     * @param[out] dataSegId   Segment to request
+     * @retval     `true`      `dataSegId` is set
+     * @retval     `false`     There's nothing worth stealing
+     */
+    bool steal(
+            Peer           peer,
+            const Swarmer& swarmer,
+            DataSegId&     dataSegId)
+    {
+        bool   found = false;
+        double bestTime = (swarmer.numOut + 1) / rateOf(swarmer);
+
+        for (auto& segId : inFlight) {
+            auto& segState = segStates.at(segId);
+            auto& holders = segState.holders;
+
+            if (segState.requesters.size() != 1 ||
+                    std::find(holders.begin(), holders.end(), peer) ==
+                    holders.end())
+                continue;
+
+            const auto& victim = swarmers.at(segState.requesters.front());
+            const auto  victimTime = victim.numOut / rateOf(victim);
+            if (victimTime >= bestTime) {
+                found = true;
+                bestTime = victimTime;
+                dataSegId = segId;
+            }
+        }
+
+        return found;
+    }
+
+    /**
+     * Indicates if a request should be made by a peer. if not, then the peer is
+     * added to the queue of alternative peers for the request.
+     *
+     * @param[in] peer        Peer
+     * @param[in] request     Request
+     * @return    `true`      Request should be made
+     * @return    `false`     Request shouldn't be made
+     * @throws    LogicError  Peer is unknown
+     * @threadsafety          Safe
+     * @cancellationpoint     No
+     */
+    bool shouldRequest(
+            Peer           peer,
+            const NoteReq& request)
+    {
+        Guard guard(mutex);
+
+        if (ratings.count(peer) == 0)
+            throw LOGIC_ERROR("Peer " + peer.to_string() + " is unknown");
+
+        const bool should = altPeers.count(request) == 0;
+
+        if (should) {
+            altPeers[request] = PeerQueue{}; // NB: `peer` not in empty queue
+        }
+        else {
+            altPeers[request].push(peer); // Add alternative peer. Might throw.
+        }
+
+        return should;
+    }
+
+    /**
+     * Process a satisfied request. The rating of the associated peer is
+     * increased and the set of alternative peers that could make the request is
+     * cleared.
+     *
+     * @param[in] peer        Peer
+     * @param[in] request     Request
+     * @throws    LogicError  Peer is unknown
+     * @throws    LogicError  Request is unknown
+     * @threadsafety          Safe
+     * @exceptionsafety       Basic guarantee
+     * @cancellationpoint     No
+     */
+    void received(Peer           peer,
+                  const NoteReq& request)
+    {
+        Guard  guard(mutex);
+
+        if (ratings.count(peer) == 0)
+            throw LOGIC_ERROR("Peer " + peer.to_string() + " is unknown");
+        if (altPeers.count(request) == 0)
+            throw LOGIC_ERROR("Request " + request.to_string() + " is unknown");
+
+        ++ratings.at(peer);
+        altPeers.erase(request); // No longer relevant
+    }
+
+public:
+    /**
+     * Constructs.
+     *
+     * @param[in] maxPeers        Maximum number of peers
+     * @throws std::system_error  Out of memory
+     * @cancellationpoint         No
+     */
+    Impl(   const int  maxPeers,
+            const bool swarm)
+        : Bookkeeper::Impl()
+        , ratings(maxPeers)
+        , altPeers(8)
+        , swarm(swarm)
+        , swarmers(maxPeers)
+        , segStates()
+        , inFlight()
+    {}
+
+    /**
+     * Adds a peer.
+     *
+     * @param[in] peer            Peer
+     * @throws std::system_error  Out of memory
+     * @threadsafety              Safe
+     * @exceptionsafety           Basic guarantee
+     * @cancellationpoint         No
+     */
+    void add(Peer peer) override
+    {
+        Guard guard(mutex);
+        ratings.insert({peer, 0});
+        if (swarm)
+            swarmers.insert({peer, Swarmer{}});
+    }
+
+    bool shouldRequest(Peer peer, const ProdIndex prodIndex) {
+        return shouldRequest(peer, NoteReq(prodIndex));
+    }
+
+    bool shouldRequest(Peer peer, const DataSegId& dataSegId) {
+        return swarm
+                ? shouldSwarm(peer, dataSegId)
+                : shouldRequest(peer, NoteReq(dataSegId));
+    }
+
+    void received(Peer            peer,
+                  const ProdIndex prodIndex) {
+        received(peer, NoteReq{prodIndex});
+    }
+
+    void received(Peer             peer,
+                  const DataSegId& dataSegId) {
+        if (swarm) {
+            swarmReceived(peer, dataSegId);
+        }
+        else {
+            received(peer, NoteReq{dataSegId});
+        }
+    }
+
+    /**
+     * Returns the next data-segment that a peer should request in swarming
+     * mode.
+     *
+     * @param[in]  peer        Peer
+     * @param[out] dataSegId   Segment to request
+     * @retval     `true`      `dataSegId` is set
+     * @retval     `false`     Peer should make no further request now
+     * @throws     LogicError  Peer is unknown
+     */
+    bool getRequest(
+            Peer       peer,
+            DataSegId& dataSegId)
+    {
+        if (!swarm)
+            return false;
+
+        Guard guard(mutex);
+        auto& swarmer = getSwarmer(peer);
+
+        if (!hasRoom(swarmer))
+            return false;
+
+        auto& backlog = swarmer.backlog;
+        while (!backlog.empty()) {
+            const auto segId = backlog.front();
+            backlog.pop_front();
+
+            auto iter = segStates.find(segId);
+            if (iter != segStates.end() && iter->second.requesters.empty()) {
+                assign(peer, swarmer, iter->second, segId);
+                dataSegId = segId;
+                return true;
+            }
+        }
+
+        if (swarmer.numOut == 0 && steal(peer, swarmer, dataSegId)) {
+            assign(peer, swarmer, segStates.at(dataSegId), dataSegId);
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Returns the number of remote peers that are a path to the publisher and
+     * the number that aren't.
+     *
+     * @param[out] numPath    Number of remote peers that are path to publisher
+     * @param[out] numNoPath  Number of remote peers that aren't path to
+     *                        publisher
+     */
+    void getPubPathCounts(
+            unsigned& numPath,
+            unsigned& numNoPath) const
+    {
+        Guard guard(mutex);
+
+        numPath = numNoPath = 0;
+
+        for (auto& pair : ratings) {
+            if (pair.first.rmtIsPubPath()) {
+                ++numPath;
+            }
+            else {
+                ++numNoPath;
+            }
+        }
+    }
+
+    /**
+     * Returns a worst performing peer.
+     *
+     * @param[in] pubPath         Attribute that peer must have
+     * @return                    A worst performing peer -- whose
+     *                            `rmtPubPath()` return value equals `pubPath`
+     *                            -- since construction or `reset()` was called.
+     *                            Will test false if the set is empty.
+     * @throws std::system_error  Out of memory
+     * @threadsafety              Safe
+     * @exceptionsafety           Strong guarantee
+     * @cancellationpoint         No
+     */
+    Peer getWorstPeer(const bool pubPath) const
+    {
+        Peer  peer{};
+        Guard guard(mutex);
+
+        if (ratings.size() > 1) {
+            unsigned long minCount{ULONG_MAX};
+
+            for (auto elt : ratings) {
+                if (elt.first.rmtIsPubPath() == pubPath) {
+                    const auto count = elt.second;
+
+                    if (count < minCount) {
+                        minCount = count;
+                        peer = elt.first;
+                    }
+                }
+            }
+        }
+
+        return peer;
+    }
+
+    /**
+     * Resets the count of satisfied requests for every peer.
+     *
+     * @threadsafety       Safe
+     * @exceptionsafety    No throw
+     * @cancellationpoint  No
+     */
+    void reset() noexcept override
+    {
+        Guard guard(mutex);
+
+        for (auto& elt : ratings)
+            elt.second = 0;
+    }
+
+    /**
+     * Removes a peer.
+     *
+     * @param[in] peer        The peer to be removed
+     * @retval    `true`      Success
+     * @retval    `false`     Peer is unknown
+     * @threadsafety          Safe
+     * @exceptionsafety       Basic guarantee
+     * @cancellationpoint     No
+     */
+    bool remove(const Peer peer) override
+    {
+        Guard guard{mutex};
+
+        if (swarm && swarmers.erase(peer)) {
+            for (auto iter = segStates.begin(); iter != segStates.end(); ) {
+                auto& holders = iter->second.holders;
+                auto& requesters = iter->second.requesters;
+
+                const auto end = std::remove(requesters.begin(),
+                        requesters.end(), peer);
+                const bool wasRequester = end != requesters.end();
+
+                requesters.erase(end, requesters.end());
+                holders.erase(std::remove(holders.begin(), holders.end(),
+                        peer), holders.end());
+
+                if (holders.empty() && requesters.empty()) {
+                    inFlight.erase(iter->first);
+                    iter = segStates.erase(iter); // Nobody else has it
+                    continue;
+                }
+                if (wasRequester && requesters.empty()) {
+                    inFlight.erase(iter->first);
+                    for (auto& holder : holders) // Make it claimable again
+                        swarmers.at(holder).backlog.push_back(iter->first);
+                }
+                ++iter;
+            }
+        }
+
+        return ratings.erase(peer) == 1;
+    }
+};
+
+constexpr double   SubBookkeeper::Impl::ALPHA;
+constexpr double   SubBookkeeper::Impl::PIPELINE_DURATION;
+constexpr unsigned SubBookkeeper::Impl::MIN_WINDOW;
+constexpr unsigned SubBookkeeper::Impl::MAX_WINDOW;
+
+SubBookkeeper::SubBookkeeper(
+        const int  maxPeers,
+        const bool swarm)
+    : Bookkeeper(new Impl(maxPeers, swarm)) {
+}
+
+void SubBookkeeper::add(const Peer peer) const {
+    static_cast<Impl*>(pImpl.get())->add(peer);
+}
+
+void SubBookkeeper::getPubPathCounts(
+        unsigned& numPath,
+        unsigned& numNoPath) const {
+    static_cast<Impl*>(pImpl.get())->getPubPathCounts(numPath, numNoPath);
+}
+
+bool SubBookkeeper::shouldRequest(
+        Peer            peer,
+        const ProdIndex prodIndex) const {
+    return static_cast<Impl*>(pImpl.get())->shouldRequest(peer, prodIndex);
+}
+
+bool SubBookkeeper::shouldRequest(
+        Peer             peer,
+        const DataSegId& dataSegId) const {
+    return static_cast<Impl*>(pImpl.get())->shouldRequest(peer, dataSegId);
+}
+
+void SubBookkeeper::received(
+        Peer            peer,
+        const ProdIndex prodIndex) const {
+    static_cast<Impl*>(pImpl.get())->received(peer, prodIndex);
+}
+
+void SubBookkeeper::received(
+        Peer             peer,
+        const DataSegId& dataSegId) const {
+    static_cast<Impl*>(pImpl.get())->received(peer, dataSegId);
+}
+
+bool SubBookkeeper::getRequest(
+        Peer       peer,
+        DataSegId& dataSegId) const {
+    return static_cast<Impl*>(pImpl.get())->getRequest(peer, dataSegId);
+}
+
+Peer SubBookkeeper::getWorstPeer(const bool pubPath) const {
+    return static_cast<Impl*>(pImpl.get())->getWorstPeer(pubPath);
+}
+
+bool SubBookkeeper::remove(const Peer peer) const {
+    return static_cast<Impl*>(pImpl.get())->remove(peer);
+}
+
+} // namespace
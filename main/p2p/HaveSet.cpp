@@ -0,0 +1,203 @@
+/**
+ * Set of products and data-segments that a remote peer is known to have.
+ *
+ *        File: HaveSet.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "HaveSet.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace hycast {
+
+class HaveSet::Impl
+{
+    /// What's had of a product
+    struct Entry {
+        bool                  info;     ///< Product information?
+        bool                  complete; ///< Every data-segment?
+        std::vector<uint64_t> segs;     ///< Bitmap of data-segments
+    };
+
+    using Entries = std::unordered_map<ProdIndex, Entry>;
+    using Order   = std::deque<ProdIndex>;
+
+    mutable Mutex  mutex;
+    const unsigned maxProds;
+    const size_t   maxWords; ///< Maximum number of words in a bitmap
+    Entries        entries;
+    Order          order;   ///< Products in order of addition
+
+    static inline size_t segIndex(const DataSegId& segId) {
+        return segId.offset / DataSeg::CANON_DATASEG_SIZE;
+    }
+
+    /**
+     * Returns the entry of a product. Creates it if necessary and evicts the
+     * oldest product if there are too many.
+     *
+     * @pre   Mutex is locked
+     * @post  Mutex is locked
+     */
+    Entry& getEntry(const ProdIndex prodIndex) {
+        auto iter = entries.find(prodIndex);
+
+        if (iter == entries.end()) {
+            if (order.size() >= maxProds) {
+                entries.erase(order.front());
+                order.pop_front();
+            }
+            iter = entries.emplace(prodIndex, Entry{false, false, {}}).first;
+            order.push_back(prodIndex);
+        }
+
+        return iter->second;
+    }
+
+public:
+    Impl(   const unsigned maxProds,
+            const unsigned maxSegs)
+        : mutex()
+        , maxProds(maxProds)
+        , maxWords((static_cast<size_t>(maxSegs) + 63)/64)
+        , entries()
+        , order()
+    {
+        if (maxProds == 0)
+            throw INVALID_ARGUMENT("Maximum number of products is zero");
+        if (maxSegs == 0)
+            throw INVALID_ARGUMENT("Maximum number of data-segments is zero");
+    }
+
+    void add(const ProdIndex prodIndex) {
+        Guard guard{mutex};
+        getEntry(prodIndex).info = true;
+    }
+
+    void add(const DataSegId& segId) {
+        const auto index = segIndex(segId);
+        if (index/64 >= maxWords)
+            return; // Bogus or beyond what's tracked
+
+        Guard guard{mutex};
+        auto& entry = getEntry(segId.prodIndex);
+        if (entry.complete)
+            return;
+
+        auto& segs = entry.segs;
+        if (index/64 >= segs.size())
+            segs.resize(index/64 + 1);
+        segs[index/64] |= uint64_t(1) << (index%64);
+    }
+
+    void add(const Inventory& inventory) {
+        Guard    guard{mutex};
+        unsigned numAdded = 0;
+
+        // Only the most recent complete products can be kept
+        for (auto range = inventory.complete.rbegin();
+                range != inventory.complete.rend() && numAdded < maxProds;
+                ++range) {
+            for (auto i = range->count; i > 0 && numAdded < maxProds;
+                    --i, ++numAdded) {
+                auto& entry = getEntry(ProdIndex(range->first + i - 1));
+                entry.info = entry.complete = true;
+                entry.segs.clear();
+            }
+        }
+
+        for (const auto& prod : inventory.partial) {
+            auto& entry = getEntry(prod.prodIndex);
+            if (entry.complete)
+                continue;
+            entry.info = entry.info || prod.info;
+            const auto numWords = std::min(prod.segs.size(), maxWords);
+            if (entry.segs.size() < numWords)
+                entry.segs.resize(numWords);
+            for (size_t i = 0; i < numWords; ++i)
+                entry.segs[i] |= prod.segs[i];
+        }
+    }
+
+    bool has(const ProdIndex prodIndex) const {
+        Guard      guard{mutex};
+        const auto iter = entries.find(prodIndex);
+        return iter != entries.end() && iter->second.info;
+    }
+
+    bool has(const DataSegId& segId) const {
+        Guard      guard{mutex};
+        const auto iter = entries.find(segId.prodIndex);
+
+        if (iter == entries.end())
+            return false;
+        if (iter->second.complete)
+            return true;
+
+        const auto& segs = iter->second.segs;
+        const auto  index = segIndex(segId);
+        return index/64 < segs.size() &&
+                (segs[index/64] & (uint64_t(1) << (index%64)));
+    }
+
+    size_t size() const {
+        Guard guard{mutex};
+        return entries.size();
+    }
+};
+
+/******************************************************************************/
+
+HaveSet::HaveSet(
+        const unsigned maxProds,
+        const unsigned maxSegs)
+    : pImpl{std::make_shared<Impl>(maxProds, maxSegs)}
+{}
+
+void HaveSet::add(const ProdIndex prodIndex) const {
+    pImpl->add(prodIndex);
+}
+
+void HaveSet::add(const DataSegId& segId) const {
+    pImpl->add(segId);
+}
+
+void HaveSet::add(const Inventory& inventory) const {
+    pImpl->add(inventory);
+}
+
+bool HaveSet::has(const ProdIndex prodIndex) const {
+    return pImpl->has(prodIndex);
+}
+
+bool HaveSet::has(const DataSegId& segId) const {
+    return pImpl->has(segId);
+}
+
+size_t HaveSet::size() const {
+    return pImpl->size();
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+/**
+ * Set of products and data-segments that a remote peer is known to have.
+ *
+ *        File: HaveSet.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_P2P_HAVESET_H_
+#define MAIN_P2P_HAVESET_H_
+
+#include "HycastProto.h"
+
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe set of the products and data-segments that a remote peer is
+ * known to have because it announced them or because they were exchanged
+ * with it. Every product has a bitmap of its data-segments. Only the most
+ * recently added products are kept, so a product that's been evicted isn't
+ * known to be had.
+ */
+class HaveSet
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Default maximum number of products
+    static const unsigned MAX_PRODS = 1024;
+    /// Default maximum number of data-segments per product
+    static const unsigned MAX_SEGS = 1 << 18;
+
+    /**
+     * Constructs. A data-segment notice doesn't contain the size of its
+     * product, so the size of a product's bitmap is bounded by the maximum
+     * number of data-segments per product. The memory used is thus at most
+     * about `maxProds*maxSegs/8` bytes regardless of what remote peers send.
+     *
+     * @param[in] maxProds         Maximum number of products
+     * @param[in] maxSegs          Maximum number of data-segments per product
+     * @throws    InvalidArgument  `maxProds == 0 || maxSegs == 0`
+     */
+    explicit HaveSet(
+            const unsigned maxProds = MAX_PRODS,
+            const unsigned maxSegs = MAX_SEGS);
+
+    /**
+     * Adds a product (i.e., its product information).
+     *
+     * @param[in] prodIndex  Index of product
+     */
+    void add(const ProdIndex prodIndex) const;
+
+    /**
+     * Adds a data-segment. Does nothing if the data-segment's index in its
+     * product isn't less than the maximum number of data-segments per product.
+     *
+     * @param[in] segId  Data-segment identifier
+     */
+    void add(const DataSegId& segId) const;
+
+    /**
+     * Adds the contents of an inventory. Only the most recent complete
+     * products are added if there are too many. The bitmap of an incomplete
+     * product is truncated to the maximum number of data-segments per product.
+     *
+     * @param[in] inventory  Inventory of a remote peer
+     */
+    void add(const Inventory& inventory) const;
+
+    /**
+     * Indicates if a product's information is had.
+     *
+     * @param[in] prodIndex  Index of product
+     * @retval    `true`     It is
+     * @retval    `false`    It isn't known to be
+     */
+    bool has(const ProdIndex prodIndex) const;
+
+    /**
+     * Indicates if a data-segment is had.
+     *
+     * @param[in] segId      Data-segment identifier
+     * @retval    `true`     It is
+     * @retval    `false`    It isn't known to be
+     */
+    bool has(const DataSegId& segId) const;
+
+    /**
+     * Returns the number of products.
+     *
+     * @return  Number of products
+     */
+    size_t size() const;
+};
+
+} // namespace
+
+#endif /* MAIN_P2P_HAVESET_H_ */
@@ -0,0 +1,212 @@
+/**
+ * Monitor of a subscriber's reception of the multicast.
+ *
+ *        File: McastMonitor.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "McastMonitor.h"
+
+#include "error.h"
+
+#include <chrono>
+#include <mutex>
+
+namespace hycast {
+
+class McastMonitor::Impl
+{
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
+    using Clock = std::chrono::steady_clock;
+
+    /// Reception during the current reporting interval
+    struct Interval {
+        Clock::time_point start;
+        uint64_t          numRcvd;
+        uint64_t          numLost;
+        uint64_t          numBytes; ///< Number of bytes received
+    };
+
+    mutable Mutex         mutex;
+    McastRcvr&            rcvr;
+    PeerSet               peerSet;
+    const Clock::duration reportInterval;
+    bool                  active;     ///< A product is being received?
+    ProdIndex             prodIndex;  ///< Product being received
+    ProdSize              prodSize;   ///< Size of product being received
+    SegOffset             nextOffset; ///< Offset of next expected data-segment
+    uint64_t              numRcvd;
+    uint64_t              numLost;
+    uint64_t              numReports;
+    Interval              current;    ///< Current reporting interval
+
+    /**
+     * Accounts for the data-segments of the current product from the next
+     * expected one up to, but not including, a given offset as lost.
+     *
+     * @pre                Mutex is locked
+     * @param[in] offset   Offset of first data-segment that wasn't lost
+     * @post               Mutex is locked
+     */
+    void lostTo(const SegOffset offset) {
+        for (; nextOffset < offset; nextOffset += DataSeg::CANON_DATASEG_SIZE) {
+            ++numLost;
+            ++current.numLost;
+            peerSet.mcastOutcome(false);
+        }
+    }
+
+    /**
+     * Ends the current reporting interval if it has elapsed.
+     *
+     * @pre                   Mutex is locked
+     * @param[out] report     Reception report of the interval. Set only if
+     *                        `true` is returned.
+     * @retval     `true`     Interval ended. `report` is set.
+     * @retval     `false`    Interval hasn't elapsed
+     * @post                  Mutex is locked
+     */
+    bool endInterval(McastReport& report) {
+        const auto now = Clock::now();
+        if (now - current.start < reportInterval)
+            return false;
+
+        const auto numSegs = current.numRcvd + current.numLost;
+        const auto secs = std::chrono::duration<double>(now - current.start)
+                .count();
+        report = McastReport(static_cast<double>(current.numLost)/numSegs,
+                current.numBytes/secs);
+        current = Interval{now, 0, 0, 0};
+        return true;
+    }
+
+public:
+    Impl(   McastRcvr&   rcvr,
+            PeerSet      peerSet,
+            const double interval)
+        : mutex()
+        , rcvr(rcvr)
+        , peerSet(peerSet)
+        , reportInterval(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(interval)))
+        , active(false)
+        , prodIndex()
+        , prodSize(0)
+        , nextOffset(0)
+        , numRcvd(0)
+        , numLost(0)
+        , numReports(0)
+        , current{Clock::now(), 0, 0, 0}
+    {
+        if (interval <= 0)
+            throw INVALID_ARGUMENT("Invalid reporting interval: " +
+                    std::to_string(interval));
+    }
+
+    void recvMcast(const ProdInfo prodInfo) {
+        rcvr.recvMcast(prodInfo);
+    }
+
+    void recvMcast(const DataSeg dataSeg) {
+        const auto& segId = dataSeg.segId();
+        McastReport report{};
+        bool        haveReport = false;
+        {
+            Guard guard{mutex};
+
+            if (!active || segId.prodIndex > prodIndex) {
+                if (active)
+                    lostTo(prodSize); // Rest of current product
+                active = true;
+                prodIndex = segId.prodIndex;
+                prodSize = dataSeg.prodSize();
+                nextOffset = 0;
+            }
+
+            if (segId.prodIndex == prodIndex && segId.offset >= nextOffset) {
+                lostTo(segId.offset);
+                ++numRcvd;
+                ++current.numRcvd;
+                current.numBytes += dataSeg.size();
+                peerSet.mcastOutcome(true);
+                nextOffset = segId.offset + DataSeg::CANON_DATASEG_SIZE;
+                haveReport = endInterval(report);
+            }
+        }
+        rcvr.recvMcast(dataSeg);
+
+        // Sending can block, so the mutex isn't locked
+        if (haveReport && peerSet.notify(report)) {
+            Guard guard{mutex};
+            ++numReports;
+        }
+    }
+
+    uint64_t getNumRcvd() const {
+        Guard guard{mutex};
+        return numRcvd;
+    }
+
+    uint64_t getNumLost() const {
+        Guard guard{mutex};
+        return numLost;
+    }
+
+    uint64_t getNumReports() const {
+        Guard guard{mutex};
+        return numReports;
+    }
+};
+
+/******************************************************************************/
+
+McastMonitor::McastMonitor(
+        McastRcvr&   rcvr,
+        PeerSet      peerSet,
+        const double interval)
+    : pImpl{std::make_shared<Impl>(rcvr, peerSet, interval)}
+{}
+
+McastMonitor::operator bool() const noexcept {
+    return static_cast<bool>(pImpl);
+}
+
+void McastMonitor::recvMcast(const ProdInfo prodInfo) {
+    pImpl->recvMcast(prodInfo);
+}
+
+void McastMonitor::recvMcast(const DataSeg dataSeg) {
+    pImpl->recvMcast(dataSeg);
+}
+
+uint64_t McastMonitor::getNumRcvd() const {
+    return pImpl->getNumRcvd();
+}
+
+uint64_t McastMonitor::getNumLost() const {
+    return pImpl->getNumLost();
+}
+
+uint64_t McastMonitor::getNumReports() const {
+    return pImpl->getNumReports();
+}
+
+} // namespace
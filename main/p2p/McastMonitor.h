@@ -0,0 +1,117 @@
+/**
+ * Monitor of a subscriber's reception of the multicast.
+ *
+ *        File: McastMonitor.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_P2P_MCASTMONITOR_H_
+#define MAIN_P2P_MCASTMONITOR_H_
+
+#include "HycastProto.h"
+#include "PeerSet.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe multicast receiver that sits between a subscriber's multicast
+ * socket and its actual multicast receiver. It forwards everything to the
+ * latter and tells the subscriber's peer-set whether each data-segment was
+ * received so that the peer-set can switch NACK-mode on and off. At the end
+ * of every reporting interval, it also sends the interval's loss-rate and
+ * receive-rate towards the publisher so that the publisher can adapt its
+ * multicast rate.
+ *
+ * The multicast is sent in order, so a data-segment whose offset is beyond
+ * the next expected one means the ones in between were lost, and a later
+ * product means the rest of the current product was lost. A data-segment
+ * that arrives after a later one is forwarded but not counted.
+ *
+ * @see `PeerSet::mcastOutcome()`
+ * @see `McastRateCtl`
+ */
+class McastMonitor final : public McastRcvr
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. The resulting instance will test false and must not
+     * be used.
+     */
+    McastMonitor() =default;
+
+    /**
+     * Constructs.
+     *
+     * @param[in] rcvr             Actual multicast receiver. Must exist for
+     *                             the lifetime of this instance.
+     * @param[in] peerSet          Subscriber's peer-set
+     * @param[in] interval         Reporting interval in seconds. An interval
+     *                             ends with the first data-segment received
+     *                             after it has elapsed.
+     * @throws    InvalidArgument  `interval <= 0`
+     * @see `PeerSet::notify(const McastReport&, Peer)`
+     */
+    McastMonitor(
+            McastRcvr&   rcvr,
+            PeerSet      peerSet,
+            const double interval = 1);
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept;
+
+    void recvMcast(const ProdInfo prodInfo) override;
+
+    void recvMcast(const DataSeg dataSeg) override;
+
+    /**
+     * Returns the number of data-segments that were received by multicast.
+     *
+     * @return  Number of received data-segments
+     */
+    uint64_t getNumRcvd() const;
+
+    /**
+     * Returns the number of data-segments that were lost by the multicast.
+     *
+     * @return  Number of lost data-segments
+     */
+    uint64_t getNumLost() const;
+
+    /**
+     * Returns the number of reception reports that were sent towards the
+     * publisher.
+     *
+     * @return  Number of sent reports
+     */
+    uint64_t getNumReports() const;
+};
+
+} // namespace
+
+#endif /* MAIN_P2P_MCASTMONITOR_H_ */
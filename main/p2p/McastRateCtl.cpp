@@ -0,0 +1,172 @@
+/**
+ * Receiver-driven control of the publisher's multicast rate.
+ *
+ *        File: McastRateCtl.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "McastRateCtl.h"
+
+#include "error.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+
+namespace hycast {
+
+constexpr double McastRateCtl::DECREASE;
+constexpr double McastRateCtl::INCREASE;
+
+class McastRateCtl::Impl
+{
+    using Clock = std::chrono::steady_clock;
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
+
+    mutable Mutex         mutex;
+    const double          minRate;
+    const double          maxRate;
+    const double          maxLoss;
+    const Clock::duration interval;
+    Clock::time_point     start;      ///< Start of current interval
+    std::atomic<double>   rate;       ///< Current rate. Read without mutex.
+    double                worstLoss;  ///< Highest loss-rate in interval
+    double                worstRate;  ///< Lowest receive-rate in interval
+    unsigned              numReports; ///< Number of reports in interval
+
+    /**
+     * @pre   Mutex is locked
+     * @post  Mutex is locked
+     */
+    bool endInterval(const Clock::time_point& now) {
+        bool changed = false;
+
+        if (numReports) {
+            const double prevRate = rate;
+
+            /*
+             * A decrease is at most by half because a receive-rate is low if
+             * little was multicast during the interval
+             */
+            double newRate = (worstLoss > maxLoss)
+                    ? std::max(prevRate/2, std::min(prevRate*DECREASE,
+                            worstRate))
+                    : prevRate + INCREASE*maxRate;
+            newRate = std::max(minRate, std::min(maxRate, newRate));
+            rate = newRate;
+
+            changed = newRate != prevRate;
+            if (changed)
+                LOG_DEBUG("Multicast rate changed from %g to %g bytes/s. "
+                        "Worst loss-rate was %g.", prevRate, newRate,
+                        worstLoss);
+        }
+
+        start = now;
+        worstLoss = 0;
+        worstRate = std::numeric_limits<double>::max();
+        numReports = 0;
+
+        return changed;
+    }
+
+public:
+    Impl(   const double minRate,
+            const double maxRate,
+            const double maxLoss,
+            const double interval)
+        : mutex()
+        , minRate(minRate)
+        , maxRate(maxRate)
+        , maxLoss(maxLoss)
+        , interval(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(interval)))
+        , start(Clock::now())
+        , rate(maxRate)
+        , worstLoss(0)
+        , worstRate(std::numeric_limits<double>::max())
+        , numReports(0)
+    {
+        if (minRate <= 0 || maxRate < minRate)
+            throw INVALID_ARGUMENT("Invalid rate limits: min=" +
+                    std::to_string(minRate) + ", max=" +
+                    std::to_string(maxRate));
+        if (maxLoss < 0 || maxLoss >= 1)
+            throw INVALID_ARGUMENT("Invalid maximum loss-rate: " +
+                    std::to_string(maxLoss));
+        if (interval <= 0)
+            throw INVALID_ARGUMENT("Invalid interval: " +
+                    std::to_string(interval));
+    }
+
+    bool report(
+            const double lossRate,
+            const double rcvRate) {
+        const auto now = Clock::now();
+        Guard      guard{mutex};
+
+        worstLoss = std::max(worstLoss, lossRate);
+        worstRate = std::min(worstRate, rcvRate);
+        ++numReports;
+
+        return (now - start >= interval)
+                ? endInterval(now)
+                : false;
+    }
+
+    bool endInterval() {
+        Guard guard{mutex};
+        return endInterval(Clock::now());
+    }
+
+    double getRate() const noexcept {
+        return rate;
+    }
+};
+
+/******************************************************************************/
+
+McastRateCtl::McastRateCtl(
+        const double minRate,
+        const double maxRate,
+        const double maxLoss,
+        const double interval)
+    : pImpl{std::make_shared<Impl>(minRate, maxRate, maxLoss, interval)}
+{}
+
+bool McastRateCtl::report(
+        const double lossRate,
+        const double rcvRate) const {
+    return pImpl->report(lossRate, rcvRate);
+}
+
+bool McastRateCtl::endInterval() const {
+    return pImpl->endInterval();
+}
+
+double McastRateCtl::getRate() const noexcept {
+    return pImpl->getRate();
+}
+
+} // namespace
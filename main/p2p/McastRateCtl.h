@@ -0,0 +1,119 @@
+/**
+ * Receiver-driven control of the publisher's multicast rate.
+ *
+ *        File: McastRateCtl.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_PROTOCOL_MCASTRATECTL_H_
+#define MAIN_PROTOCOL_MCASTRATECTL_H_
+
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe controller of the multicast rate based on the reception reports
+ * of subscribers. In the manner of TFMCC, the rate tracks the worst receiver:
+ * at the end of every reporting interval, if the highest reported loss-rate
+ * exceeds the maximum acceptable loss-rate, then the rate is decreased to no
+ * more than the lowest reported receive-rate (but by no more than half);
+ * otherwise, it's increased. The rate is always within configured limits.
+ *
+ * The maximum acceptable loss-rate is the cost model: every lost data-segment
+ * must be repaired over the P2P network, so it's the loss-rate above which
+ * the repair load costs more than a slightly lower multicast rate.
+ */
+class McastRateCtl
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Multiplier of the rate on a decrease
+    static constexpr double DECREASE = 0.875;
+    /// Increment of the rate on an increase as a fraction of the maximum rate
+    static constexpr double INCREASE = 0.02;
+
+    /**
+     * Default constructs. The resulting instance will test false and must not
+     * be used.
+     */
+    McastRateCtl() =default;
+
+    /**
+     * Constructs. The initial rate is the maximum rate.
+     *
+     * @param[in] minRate          Minimum rate in bytes per second
+     * @param[in] maxRate          Maximum rate in bytes per second
+     * @param[in] maxLoss          Maximum acceptable loss-rate in [0, 1)
+     * @param[in] interval         Reporting interval in seconds
+     * @throws    InvalidArgument  An argument is invalid
+     */
+    McastRateCtl(
+            const double minRate,
+            const double maxRate,
+            const double maxLoss = 0.01,
+            const double interval = 1);
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept {
+        return static_cast<bool>(pImpl);
+    }
+
+    /**
+     * Adds a subscriber's reception report.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     * @retval    `true`    The rate was changed
+     * @retval    `false`   The rate wasn't changed
+     * @threadsafety        Safe
+     */
+    bool report(
+            const double lossRate,
+            const double rcvRate) const;
+
+    /**
+     * Ends the current reporting interval. Called by `report()` when the
+     * interval has elapsed; public for testing.
+     *
+     * @retval    `true`    The rate was changed
+     * @retval    `false`   The rate wasn't changed
+     * @threadsafety        Safe
+     */
+    bool endInterval() const;
+
+    /**
+     * Returns the current rate.
+     *
+     * @return        Current rate in bytes per second
+     * @threadsafety  Safe. Doesn't block, so it can be called for every
+     *                datagram.
+     */
+    double getRate() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_PROTOCOL_MCASTRATECTL_H_ */
@@ -0,0 +1,637 @@
+/**
+ * This file implements a queue of notices.
+ *
+ *   @file: NoticeQueue.cpp
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "NoticeArray.h"
+#include "WindowMap.h"
+
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * Thread-unsafe queue of notice PDU ID-s.
+ */
+class PduIdQueue
+{
+private:
+    using Map   = std::map<ArrayIndex, PduId>;
+
+    Map           pduIds;
+
+public:
+    PduIdQueue()
+        : pduIds()
+    {}
+
+    PduIdQueue(const PduIdQueue& queue) =delete;
+    PduIdQueue& operator=(const PduIdQueue& queue) =delete;
+
+    ~PduIdQueue() noexcept =default;
+
+    size_t size() const {
+        return pduIds.size();
+    }
+
+    inline void put(const ArrayIndex& index, const PduId id) {
+        pduIds[index] = id;
+    }
+
+    /**
+     * Indicates if the PDU ID at a given index doesn't exist.
+     *
+     * @param[in] index    Index of desired PDU ID
+     * @retval    `true`   PDU ID does not exist
+     * @retval    `false`  PDU ID does exist
+     */
+    inline bool empty(const ArrayIndex& index) const {
+        auto count = pduIds.count(index);
+        return count == 0;
+    }
+
+    /**
+     * Returns a reference to the PDU ID at a given index.
+     *
+     * @param[in] index   Index of desired PDU ID
+     * @return            Reference to PDU ID
+     * @throw OutOfRange  Given position is empty
+     */
+    inline const PduId& at(const ArrayIndex& index) const {
+        return pduIds.at(index);
+    }
+
+    /**
+     * Deletes all entries up to (but excluding) a given index.
+     *
+     * @param[in] from   Index from which to start erasing
+     * @param[in] to     Index of entry at which to stop
+     */
+    void erase(ArrayIndex from, const ArrayIndex& to) {
+        while (from < to)
+            pduIds.erase(from++);
+    }
+};
+
+/******************************************************************************/
+
+/**
+ * Thread-unsafe queue of notice PDU-s.
+ *
+ * @tparam PDU  Notice product data unit
+ */
+template<typename PDU>
+class PduQueue
+{
+    using Map   = std::map<ArrayIndex, PDU>;
+
+    Map           map;
+    P2pNode&      p2pNode;
+    const String  desc;
+
+public:
+    PduQueue(P2pNode& p2pNode, const String& desc)
+        : map()
+        , p2pNode(p2pNode)
+        , desc(desc)
+    {}
+
+    /**
+     * Adds an entry at a given index.
+     *
+     * @param[in] index   Index for entry
+     * @throw LogicError  Entry already exists at index
+     */
+    void put(const ArrayIndex& index,
+             const PDU&        pdu) {
+        if (map.count(index))
+            throw LOGIC_ERROR("Entry already exists at index " +
+                    index.to_string());
+        map[index] = pdu;
+    }
+
+    void erase(ArrayIndex from, const ArrayIndex& to) {
+        while (from < to)
+            map.erase(from++);
+    }
+
+    /**
+     * Returns the notice at a given index.
+     *
+     * @param[in] index   Index of notice
+     * @return            Notice
+     * @throw OutOfRange  Given position is empty
+     */
+    inline const PDU& at(const ArrayIndex& index) const {
+        return map.at(index);
+    }
+
+    /**
+     * Sends a notice to a peer. Blocks while sending. The notice is passed by
+     * value so that it may be sent without holding a lock.
+     *
+     * @param[in] notice        Notice to be sent
+     * @param[in] index         Index of notice
+     * @param[in] peer          Peer to be sent notice
+     * @retval    `false`       Connection lost
+     * @retval    `true`        Success
+     * @throws    RuntimeError  Failure
+     */
+    bool send(const PDU notice, const ArrayIndex& index, Peer& peer) const {
+        bool success;
+
+        try {
+            success = peer.notify(notice);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(RUNTIME_ERROR("Couldn't send " + desc +
+                    " notice #" + std::to_string(index) + " to peer "+
+                    peer.to_string()));
+        }
+
+        return success;
+    }
+};
+
+/******************************************************************************/
+
+class NoticeArray::Impl
+{
+    /// Summary of products: index of last notice -> product index
+    using Summary = std::map<ArrayIndex, ProdIndex>;
+    /// Index of last notice of a product. Direct-indexed by product-index.
+    using LastIndexes = WindowMap<ArrayIndex, ProdIndex::Type>;
+
+    /// Maximum number of products in the summary
+    static const size_t MAX_PRODS = 4096;
+
+    mutable Mutex       mutex;
+    mutable Cond        cond;
+    PduIdQueue          pduIdQueue;
+    PduQueue<PubPath>   pubPaths;
+    PduQueue<NackMode>  nackModes;
+    PduQueue<Inventory> inventories;
+    PduQueue<ProdIndex> prodIndexes;
+    PduQueue<DataSegId> dataSegIds;
+    ArrayIndex          writeIndex;
+    ArrayIndex          oldestIndex;
+    const ArrayIndex::Type maxNotices;
+    Summary             summary;
+    LastIndexes         lastIndexes;
+    mutable std::atomic<unsigned long> numSuppressed;
+    mutable std::atomic<unsigned long> numRedundant;
+    mutable std::atomic<unsigned long> numSent;
+    mutable std::atomic<unsigned long> numResyncs;
+
+    /**
+     * Sends a notice to a peer.
+     *
+     * @pre                     Mutex is locked
+     * @param[in] lock          Lock of mutex
+     * @retval    `false`       Connection lost
+     * @retval    `true`        Success
+     * @throws    RuntimeError  Failure
+     * @post                    Mutex is unlocked
+     */
+    template<typename PDU>
+    bool send(
+            const PduQueue<PDU>& queue,
+            const ArrayIndex&    index,
+            Peer&                peer,
+            Lock&                lock) const {
+        const auto notice = queue.at(index);
+        lock.unlock();
+        return queue.send(notice, index, peer);
+    }
+
+    /**
+     * Sends a product or data-segment notice to a peer unless the remote peer
+     * is known to have the product or data-segment.
+     *
+     * @pre                     Mutex is locked
+     * @param[in] lock          Lock of mutex
+     * @retval    `false`       Connection lost
+     * @retval    `true`        Success
+     * @throws    RuntimeError  Failure
+     * @post                    Mutex is unlocked
+     */
+    template<typename PDU>
+    bool sendIfNeeded(
+            const PduQueue<PDU>& queue,
+            const ArrayIndex&    index,
+            Peer&                peer,
+            Lock&                lock) const {
+        const auto notice = queue.at(index);
+        lock.unlock();
+        if (peer.rmtHas(notice)) {
+            ++numRedundant;
+            return true;
+        }
+        ++numSent;
+        return queue.send(notice, index, peer);
+    }
+
+    /**
+     * Resynchronizes a peer that fell so far behind that its next notice was
+     * erased. The peer is sent a notice for every product whose last notice
+     * is at or after its index -- regardless of whether the remote peer is
+     * known to have the product -- and its index is advanced to the oldest
+     * notice. The remote peer can then request whatever it's missing.
+     *
+     * @pre                         Mutex is locked
+     * @param[in,out] index         Index of the peer's next notice
+     * @param[in]     peer          Peer to be resynchronized
+     * @param[in]     lock          Lock of mutex
+     * @retval        `false`       Connection lost
+     * @retval        `true`        Success
+     * @throws        RuntimeError  Failure
+     * @post                        Mutex is unlocked
+     */
+    bool resync(
+            ArrayIndex& index,
+            Peer&       peer,
+            Lock&       lock) const {
+        std::vector<ProdIndex> prods;
+        for (auto iter = summary.lower_bound(index); iter != summary.end();
+                ++iter)
+            prods.push_back(iter->second);
+
+        LOG_NOTE("Peer %s fell %s notices behind. Resynchronizing it with "
+                "%zu product notices.", peer.to_string().data(),
+                std::to_string(oldestIndex - index).data(),
+                prods.size());
+
+        const auto from = index;
+        index = oldestIndex;
+        lock.unlock();
+        ++numResyncs;
+
+        for (const auto prodIndex : prods) {
+            ++numSent;
+            if (!prodIndexes.send(prodIndex, from, peer))
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Adds a product notice to the summary of products. Only the most
+     * recently noticed products are kept.
+     *
+     * @pre                  Mutex is locked
+     * @param[in] prodIndex  Index of product
+     * @param[in] index      Index of notice
+     * @post                 Mutex is locked
+     */
+    void addToSummary(
+            const ProdIndex   prodIndex,
+            const ArrayIndex& index) {
+        const auto pair = lastIndexes.insert(prodIndex, index);
+
+        if (!pair.second) {
+            summary.erase(*pair.first);
+            *pair.first = index;
+        }
+        summary[index] = prodIndex;
+
+        if (summary.size() > MAX_PRODS) {
+            const auto oldest = summary.begin();
+            lastIndexes.erase(oldest->second);
+            summary.erase(oldest);
+        }
+    }
+
+    /**
+     * Erases all notices before a given index.
+     *
+     * @pre           Mutex is locked
+     * @param[in] to  Index of the first notice not to erase
+     * @post          Mutex is locked
+     */
+    void erase(const ArrayIndex& to) {
+        if (to <= oldestIndex)
+            return;
+
+        pduIdQueue .erase(oldestIndex, to);
+        pubPaths   .erase(oldestIndex, to);
+        nackModes  .erase(oldestIndex, to);
+        inventories.erase(oldestIndex, to);
+        prodIndexes.erase(oldestIndex, to);
+        dataSegIds .erase(oldestIndex, to);
+        oldestIndex = to;
+    }
+
+    /**
+     * Adds a PDU ID at the write index in the PDU ID queue. Increments the
+     * write index. Erases the oldest notice if the array is full.
+     *
+     * @pre                      Mutex is locked
+     * @param[in] pduId          PDU ID to be added
+     * @return                   PDU ID's corresponding index
+     * @post                     Mutex is locked
+     */
+    ArrayIndex put(const PduId pduId) {
+        LOG_ASSERT(!mutex.try_lock());
+
+        if (writeIndex - oldestIndex >= maxNotices)
+            erase(writeIndex - maxNotices + 1);
+
+        const auto index = writeIndex;
+        pduIdQueue.put(writeIndex++, pduId);
+        cond.notify_all();
+
+        return index;
+    }
+
+public:
+    Impl(   P2pNode&               p2pNode,
+            const ArrayIndex::Type maxNotices)
+        : mutex()
+        , cond()
+        , pduIdQueue()
+        , pubPaths(p2pNode, "path-to-publisher")
+        , nackModes(p2pNode, "NACK-mode")
+        , inventories(p2pNode, "inventory")
+        , prodIndexes(p2pNode, "product-index")
+        , dataSegIds(p2pNode, "data-segment ID")
+        , writeIndex(0)
+        , oldestIndex(0)
+        , maxNotices(maxNotices)
+        , summary()
+        , lastIndexes(2*MAX_PRODS)
+        , numSuppressed(0)
+        , numRedundant(0)
+        , numSent(0)
+        , numResyncs(0)
+    {
+        if (maxNotices == 0)
+            throw INVALID_ARGUMENT("Maximum number of notices is zero");
+    }
+
+    /**
+     * Returns the index of the next notice to be added to the queue.
+     *
+     * @return  Index of the next notice
+     */
+    ArrayIndex getWriteIndex() const {
+        Guard guard(mutex);
+        return writeIndex;
+    }
+
+    /**
+     * Returns the index of the oldest notice in the queue.
+     *
+     * @return Index of oldest notice
+     */
+    ArrayIndex getOldestIndex() const {
+        Guard guard(mutex);
+        return oldestIndex;
+    }
+
+    ArrayIndex put(const PubPath pubPath) {
+        Guard      guard{mutex};
+        const auto index = put(PduId::PUB_PATH_NOTICE);
+        pubPaths.put(index, pubPath);
+        return index;
+    }
+
+    ArrayIndex put(const NackMode nackMode) {
+        Guard      guard{mutex};
+        const auto index = put(PduId::NACK_MODE_NOTICE);
+        nackModes.put(index, nackMode);
+        return index;
+    }
+
+    ArrayIndex put(const Inventory& inventory) {
+        Guard      guard{mutex};
+        const auto index = put(PduId::INVENTORY);
+        inventories.put(index, inventory);
+        return index;
+    }
+
+    ArrayIndex put(const ProdIndex prodIndex) {
+        Guard      guard{mutex};
+        const auto index = put(PduId::PROD_INFO_NOTICE);
+        prodIndexes.put(index, prodIndex);
+        addToSummary(prodIndex, index);
+        return index;
+    }
+
+    ArrayIndex put(const DataSegId& dataSegId) {
+        Guard      guard{mutex};
+        const auto index = put(PduId::DATA_SEG_NOTICE);
+        dataSegIds.put(index, dataSegId);
+        addToSummary(dataSegId.prodIndex, index);
+        return index;
+    }
+
+    /**
+     * Indicates if a peer must wait for a notice.
+     *
+     * @pre               Mutex is locked
+     * @param[in] index   Index of notice
+     * @retval    `true`  The notice doesn't exist yet
+     * @retval    `false` The notice exists or was erased
+     * @post              Mutex is locked
+     */
+    bool mustWait(const ArrayIndex index) const {
+        return index >= oldestIndex && pduIdQueue.empty(index);
+    }
+
+    /**
+     * Waits until a notice exists or was erased or a stop is requested. The
+     * stop-callback locks the mutex; consequently, the mutex is unlocked
+     * while the callback is registered and deregistered. Because that's only
+     * done when waiting, sending pending notices only costs a check of the
+     * stop token.
+     *
+     * @pre                   `lock` is locked
+     * @param[in] index       Index of notice
+     * @param[in] lock        Lock on the mutex
+     * @param[in] stopToken   Stop token
+     * @retval    `true`      The notice exists or was erased
+     * @retval    `false`     A stop was requested
+     * @post                  `lock` is locked
+     */
+    bool waitForNotice(
+            const ArrayIndex index,
+            Lock&            lock,
+            const StopToken& stopToken) const {
+        if (stopToken.stopRequested())
+            return false;
+
+        if (mustWait(index)) {
+            lock.unlock();
+            {
+                StopCallback callback{stopToken, [this] {
+                    Guard guard{mutex};
+                    cond.notify_all();
+                }};
+                lock.lock();
+                while (!stopToken.stopRequested() && mustWait(index))
+                    cond.wait(lock);
+                lock.unlock();
+            }
+            lock.lock();
+        }
+
+        return !stopToken.stopRequested();
+    }
+
+    /**
+     * Sends a given notice to a peer and sets the index to that of the next
+     * notice. Blocks until that notice exists and while sending it. A
+     * data-segment notice isn't sent if the remote peer is in NACK-mode. A
+     * product or data-segment notice isn't sent if the remote peer is known
+     * to have the product or data-segment. If the notice was erased, then the
+     * peer is resynchronized instead.
+     *
+     * @param[in,out] index         Index of notice
+     * @param[in]     peer          Peer to be sent notice
+     * @param[in]     stopToken     Stop token
+     * @retval        `false`       Connection lost or stop requested
+     * @retval        `true`        Success
+     * @throws        LogicError    Invalid PDU ID in queue
+     * @throws        RuntimeError  Failure
+     */
+    bool send(ArrayIndex& index, Peer& peer, const StopToken& stopToken)
+            const {
+        LOG_TRACE;
+        Lock lock{mutex};
+
+        if (!waitForNotice(index, lock, stopToken))
+            return false;
+
+        if (index < oldestIndex)
+            return resync(index, peer, lock);
+
+        const auto i = index++;
+
+        switch (pduIdQueue.at(i)) {
+        case PduId::PUB_PATH_NOTICE:
+            return send(pubPaths, i, peer, lock);
+        case PduId::NACK_MODE_NOTICE:
+            return send(nackModes, i, peer, lock);
+        case PduId::INVENTORY:
+            return send(inventories, i, peer, lock);
+        case PduId::PROD_INFO_NOTICE:
+            return sendIfNeeded(prodIndexes, i, peer, lock);
+        case PduId::DATA_SEG_NOTICE:
+            if (peer.rmtWantsNacks()) {
+                ++numSuppressed;
+                return true;
+            }
+            return sendIfNeeded(dataSegIds, i, peer, lock);
+        default:
+            throw LOGIC_ERROR("Invalid PDU ID");
+        }
+    }
+
+    // Purge queue of old notices
+    void eraseTo(const ArrayIndex& to) {
+        Guard guard{mutex};
+        erase(to);
+    }
+
+    unsigned long getNumSuppressed() const noexcept {
+        return numSuppressed;
+    }
+
+    unsigned long getNumRedundant() const noexcept {
+        return numRedundant;
+    }
+
+    unsigned long getNumSent() const noexcept {
+        return numSent;
+    }
+
+    unsigned long getNumResyncs() const noexcept {
+        return numResyncs;
+    }
+};
+
+NoticeArray::NoticeArray(
+        P2pNode&               p2pNode,
+        const ArrayIndex::Type maxNotices)
+    : pImpl(std::make_shared<Impl>(p2pNode, maxNotices))
+{}
+
+ArrayIndex NoticeArray::getWriteIndex() const {
+    return pImpl->getWriteIndex();
+}
+
+ArrayIndex NoticeArray::getOldestIndex() const {
+    return pImpl->getOldestIndex();
+}
+
+ArrayIndex NoticeArray::putPubPath(const PubPath pubPath) const {
+    return pImpl->put(pubPath);
+}
+
+ArrayIndex NoticeArray::putNackMode(const NackMode nackMode) const {
+    return pImpl->put(nackMode);
+}
+
+ArrayIndex NoticeArray::putInventory(const Inventory& inventory) const {
+    return pImpl->put(inventory);
+}
+
+ArrayIndex NoticeArray::putProdIndex(const ProdIndex prodIndex) const {
+    return pImpl->put(prodIndex);
+}
+
+ArrayIndex NoticeArray::put(const DataSegId& dataSegId) const {
+    return pImpl->put(dataSegId);
+}
+
+void NoticeArray::eraseTo(const ArrayIndex index) const {
+    pImpl->eraseTo(index);
+}
+
+bool NoticeArray::send(
+        ArrayIndex&      index,
+        Peer&            peer,
+        const StopToken& stopToken) const {
+    return pImpl->send(index, peer, stopToken);
+}
+
+unsigned long NoticeArray::getNumSuppressed() const noexcept {
+    return pImpl->getNumSuppressed();
+}
+
+unsigned long NoticeArray::getNumRedundant() const noexcept {
+    return pImpl->getNumRedundant();
+}
+
+unsigned long NoticeArray::getNumSent() const noexcept {
+    return pImpl->getNumSent();
+}
+
+unsigned long NoticeArray::getNumResyncs() const noexcept {
+    return pImpl->getNumResyncs();
+}
+
+} // namespace
@@ -0,0 +1,200 @@
+/**
+ * This file declares a thread-safe array of notices to be sent to remote
+ * peers.
+ *
+ *  @file:  NoticeArray.h
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_P2P_NOTICEARRAY_H_
+#define MAIN_P2P_NOTICEARRAY_H_
+
+#include "HycastProto.h"
+#include "P2pNode.h"
+#include "Peer.h"
+#include "StopToken.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Index of a notice in a `NoticeArray`.
+ */
+class ArrayIndex
+{
+public:
+    using Type = uint64_t;
+
+private:
+    Type index;
+
+public:
+    /**
+     * NB: Implicit construction.
+     * @param[in] index  Index value
+     */
+    ArrayIndex(const Type index = 0)
+        : index(index)
+    {}
+
+    operator Type() const noexcept {
+        return index;
+    }
+
+    ArrayIndex& operator++() noexcept {
+        ++index;
+        return *this;
+    }
+
+    ArrayIndex operator++(int) noexcept {
+        const auto prev = *this;
+        ++index;
+        return prev;
+    }
+
+    ArrayIndex& operator--() noexcept {
+        --index;
+        return *this;
+    }
+
+    std::string to_string() const {
+        return std::to_string(index);
+    }
+};
+
+/**
+ * Thread-safe array of notices that are sent to remote peers. Every peer
+ * reads the array independently via its own index. The array is bounded: when
+ * it's full, the oldest notices are erased. A peer whose index refers to an
+ * erased notice is resynchronized by being sent a notice for every recent
+ * product and having its index advanced to the oldest notice.
+ */
+class NoticeArray
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Default maximum number of notices
+    static const ArrayIndex::Type MAX_NOTICES = 100000;
+
+    /**
+     * Constructs.
+     *
+     * @param[in] node             Associated P2P node
+     * @param[in] maxNotices       Maximum number of notices
+     * @throws    InvalidArgument  `maxNotices == 0`
+     */
+    NoticeArray(
+            P2pNode&               node,
+            const ArrayIndex::Type maxNotices = MAX_NOTICES);
+
+    /**
+     * Returns the index of the next notice to be added.
+     *
+     * @return  Index of the next notice
+     */
+    ArrayIndex getWriteIndex() const;
+
+    /**
+     * Returns the index of the oldest notice.
+     *
+     * @return  Index of the oldest notice
+     */
+    ArrayIndex getOldestIndex() const;
+
+    ArrayIndex putPubPath(const PubPath pubPath) const;
+
+    ArrayIndex putNackMode(const NackMode nackMode) const;
+
+    ArrayIndex putInventory(const Inventory& inventory) const;
+
+    ArrayIndex putProdIndex(const ProdIndex prodIndex) const;
+
+    ArrayIndex put(const DataSegId& dataSegId) const;
+
+    /**
+     * Erases all notices before a given index. Does nothing if the index
+     * isn't greater than the oldest index.
+     *
+     * @param[in] index  Index of the first notice not to erase
+     */
+    void eraseTo(const ArrayIndex index) const;
+
+    /**
+     * Sends a given notice to a peer and sets the index to that of the next
+     * notice. Blocks until that notice exists and while sending it. A
+     * data-segment notice isn't sent if the remote peer is in NACK-mode. A
+     * product or data-segment notice isn't sent if the remote peer is known
+     * to have the product or data-segment. If the notice was erased because
+     * the array was full, then the peer is instead sent a notice for every
+     * recent product at or after the index and the index is set to that of
+     * the oldest notice. Returns without sending if a stop is requested.
+     *
+     * @param[in,out] index         Index of notice
+     * @param[in]     peer          Peer to be sent notice
+     * @param[in]     stopToken     Stop token. By default, a stop will never
+     *                              be requested.
+     * @retval        `false`       Connection lost or stop requested
+     * @retval        `true`        Success
+     * @throws        RuntimeError  Failure
+     */
+    bool send(
+            ArrayIndex&      index,
+            Peer&            peer,
+            const StopToken& stopToken = StopToken{}) const;
+
+    /**
+     * Returns the number of data-segment notices that weren't sent because the
+     * remote peer was in NACK-mode.
+     *
+     * @return  Number of suppressed data-segment notices
+     */
+    unsigned long getNumSuppressed() const noexcept;
+
+    /**
+     * Returns the number of product and data-segment notices that weren't
+     * sent because the remote peer was known to have the product or
+     * data-segment.
+     *
+     * @return  Number of redundant notices
+     * @see `Peer::rmtHas()`
+     */
+    unsigned long getNumRedundant() const noexcept;
+
+    /**
+     * Returns the number of product and data-segment notices that were sent.
+     *
+     * @return  Number of sent product and data-segment notices
+     */
+    unsigned long getNumSent() const noexcept;
+
+    /**
+     * Returns the number of times that a peer was resynchronized because it
+     * fell too far behind.
+     *
+     * @return  Number of resynchronizations
+     */
+    unsigned long getNumResyncs() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_P2P_NOTICEARRAY_H_ */
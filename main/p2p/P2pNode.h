@@ -0,0 +1,183 @@
+/**
+ * This file declares the interface for a peer-to-peer node. Such a node
+ * is called by peers to handle received PDU-s.
+ * 
+ * @file:   P2pNode.h
+ * @author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_PROTO_P2PNODE_H_
+#define MAIN_PROTO_P2PNODE_H_
+
+#include "error.h"
+#include "HycastProto.h"
+
+#include <cstdint>
+#include <string>
+
+namespace hycast {
+
+class Peer; // Forward declaration
+
+/// Interface
+class P2pNode : public RequestRcvr
+              , public NoticeRcvr
+              , public DataRcvr
+{
+public:
+    virtual ~P2pNode() {}
+
+    virtual bool isPublisher() const {
+        return false;
+    }
+
+    virtual bool isPathToPub() const {
+        return false;
+    }
+
+    virtual void recvNotice(const PubPath    notice,
+                            Peer             peer) =0;
+    /**
+     * Receives a notice of the notice-mode of a remote peer. If the notice is
+     * true, then the local peer will no longer send it notices of individual
+     * data-segments. This default does nothing.
+     *
+     * @param[in] notice       Whether the remote peer is in NACK-mode
+     * @param[in] peer         Associated local peer
+     */
+    virtual void recvNotice(const NackMode   notice,
+                            Peer             peer);
+    /**
+     * Receives a summary of a subscriber's reception of the multicast from a
+     * remote peer. The publisher uses it to adapt its multicast rate. A
+     * subscriber should forward it towards the publisher by calling
+     * `PeerSet::notify(notice, peer)`. This default does nothing.
+     *
+     * @param[in] notice       Summary of multicast reception
+     * @param[in] peer         Associated local peer
+     * @see `McastMonitor`
+     * @see `McastRateCtl`
+     */
+    virtual void recvNotice(const McastReport notice,
+                            Peer              peer);
+    /**
+     * Returns the inventory of this node (i.e., what products and
+     * data-segments it has) for a newly-connected remote peer. If it's
+     * non-empty, then it's sent instead of replaying every pending notice.
+     * This default returns an empty inventory.
+     *
+     * @return  Inventory of this node
+     * @see `PeerSet`
+     */
+    virtual Inventory getInventory() const;
+    /**
+     * Receives the inventory of a remote peer, which is sent when the peers
+     * connect and periodically thereafter. The local peer won't notify the
+     * remote peer about what's in it. A node may request what it lacks. This
+     * default does nothing.
+     *
+     * @param[in] notice       Inventory of the remote peer
+     * @param[in] peer         Associated local peer
+     */
+    virtual void recvNotice(const Inventory& notice,
+                            Peer             peer);
+    /**
+     * Receives a notice of available product information from a remote peer.
+     *
+     * @param[in] notice       Which product
+     * @param[in] peer         Associated local peer
+     * @retval    `false`      Local peer shouldn't request from remote peer
+     * @retval    `true`       Local peer should request from remote peer
+     */
+    virtual bool recvNotice(const ProdIndex  notice,
+                            Peer             peer) =0;
+    /**
+     * Receives a notice of an available data-segment from a remote peer.
+     *
+     * @param[in] notice       Which data-segment
+     * @param[in] peer         Associated local peer
+     * @retval    `false`      Local peer shouldn't request from remote peer
+     * @retval    `true`       Local peer should request from remote peer
+     */
+    virtual bool recvNotice(const DataSegId notice,
+                            Peer            peer) =0;
+
+    /**
+     * Receives a request for product information from a remote peer.
+     *
+     * @param[in] request      Which product
+     * @param[in] peer         Associated local peer
+     * @return                 Product information. Will test false if it
+     *                         shouldn't be sent to remote peer.
+     */
+    virtual ProdInfo recvRequest(const ProdIndex  request,
+                                 Peer             peer) =0;
+    /**
+     * Receives a request for a data-segment from a remote peer.
+     *
+     * @param[in] request      Which data-segment
+     * @param[in] peer         Associated local peer
+     * @return                 Product information. Will test false if it
+     *                         shouldn't be sent to remote peer.
+     */
+    virtual DataSeg  recvRequest(const DataSegId request,
+                                 Peer            peer) =0;
+    /**
+     * Receives a reply from a remote peer that a data-segment that the local
+     * peer requested is unavailable. This happens in NACK-mode, where requests
+     * aren't preceded by notices. The node should request the data-segment
+     * from another peer. This default does nothing.
+     *
+     * @param[in] segId        Which data-segment
+     * @param[in] peer         Associated local peer
+     */
+    virtual void recvUnavail(const DataSegId segId,
+                             Peer            peer);
+
+    virtual void recvData(const ProdInfo prodInfo,
+                          Peer           peer) =0;
+    virtual void recvData(const DataSeg  dataSeg,
+                          Peer           peer) =0;
+
+    /**
+     * Receives a request for a coded data-segment of a block from a remote
+     * peer. Coded repair is optional: this default doesn't support it.
+     *
+     * @param[in] request      Which block
+     * @param[in] peer         Associated local peer
+     * @return                 Coded data-segment. Will test false if it
+     *                         shouldn't be sent to remote peer.
+     * @see `RlncEncoder`
+     */
+    virtual CodedSeg recvRequest(const BlockId request,
+                                 Peer          peer);
+
+    /**
+     * Receives a coded data-segment from a remote peer. This default ignores
+     * it.
+     *
+     * @param[in] codedSeg     Coded data-segment
+     * @param[in] peer         Associated local peer
+     * @see `RlncDecoder`
+     */
+    virtual void recvData(const CodedSeg codedSeg,
+                          Peer           peer);
+};
+
+} // namespace
+
+#endif /* MAIN_PROTO_P2PNODE_H_ */
@@ -0,0 +1,1376 @@
+/**
+ * This file defines the Peer class. The Peer class handles low-level,
+ * bidirectional messaging with its remote counterpart.
+ *
+ *  @file:  Peer.cpp
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "HaveSet.h"
+#include "logging.h"
+#include "Peer.h"
+#include "ThreadException.h"
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hycast {
+
+class Peer::Impl
+{
+    /**
+     * Bounds the number of simultaneous outbound connection attempts.
+     */
+    class ConnectGate
+    {
+        static Mutex    mutex;
+        static Cond     cond;
+        static unsigned numConnecting;
+        static unsigned maxConnecting;
+
+    public:
+        /**
+         * Sets the maximum number of simultaneous connection attempts.
+         *
+         * @param[in] max  Maximum number of simultaneous connection attempts
+         */
+        static void setMax(const unsigned max) {
+            Guard guard{mutex};
+            maxConnecting = max;
+            cond.notify_all();
+        }
+
+        /**
+         * Constructs. Blocks until a connection attempt is allowed.
+         *
+         * @cancellationpoint  Yes
+         */
+        ConnectGate() {
+            Lock lock{mutex};
+            while (numConnecting >= maxConnecting)
+                cond.wait(lock);
+            ++numConnecting;
+        }
+
+        ~ConnectGate() noexcept {
+            Guard guard{mutex};
+            --numConnecting;
+            cond.notify_one();
+        }
+    };
+
+    mutable Mutex      sockMutex;
+    mutable Mutex      noticeMutex; ///< Serializes writes to notice socket
+    mutable Mutex      rmtSockAddrMutex;
+    mutable Mutex      exceptMutex;
+    P2pNode&           node;
+    /*
+     * If a single socket is used for asynchronous communication and reading and
+     * writing occur on the same thread, then deadlock will occur if both
+     * receive buffers are full and each end is trying to write. To prevent
+     * this, three sockets are used and a thread that reads from one socket will
+     * write to another. The pipeline might block for a while as messages are
+     * processed, but it won't deadlock.
+     */
+    TcpSock            noticeSock;
+    TcpSock            requestSock;
+    TcpSock            dataSock;
+    Thread             noticeReader;
+    Thread             requestReader;
+    Thread             dataReader;
+    Thread             requestWriter;
+    SockAddr           rmtSockAddr;
+    std::atomic<bool>  rmtPubPath;
+    std::atomic<bool>  rmtNackMode;
+    HaveSet            rmtHaves;   ///< What the remote peer has
+    enum class State {
+        INITED,
+        STARTING,
+        STARTED,
+        STOPPING
+    };
+    using AtomicState = std::atomic<State>;
+    AtomicState        state;
+    const bool         clientSide;
+    std::exception_ptr exPtr;
+
+    /**
+     * Orders the sockets so that the notice socket has the lowest client-side
+     * port number, then the request socket, and then the data socket.
+     *
+     * @param[in] notSock  Notice socket
+     * @param[in] reqSock  Request socket
+     * @param[in] datSock  Data socket
+     */
+    void orderSocks(TcpSock& notSock,
+                    TcpSock& reqSock,
+                    TcpSock& datSock) {
+        if (clientSide) {
+            if (reqSock.getLclPort() < notSock.getLclPort())
+                reqSock.swap(notSock);
+
+            if (datSock.getLclPort() < reqSock.getLclPort()) {
+                datSock.swap(reqSock);
+                if (reqSock.getLclPort() < notSock.getLclPort())
+                    reqSock.swap(notSock);
+            }
+        }
+        else {
+            if (reqSock.getRmtPort() < notSock.getRmtPort())
+                reqSock.swap(notSock);
+
+            if (datSock.getRmtPort() < reqSock.getRmtPort()) {
+                datSock.swap(reqSock);
+                if (reqSock.getRmtPort() < notSock.getRmtPort())
+                    reqSock.swap(notSock);
+            }
+        }
+    }
+
+    /**
+     * Connects a client-side peer to a remote peer. Blocks while connecting.
+     * The individual connections are established concurrently.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool connectClient() {
+        bool     success = false;
+        SockAddr srvrAddr;
+
+        {
+            Guard guard{rmtSockAddrMutex};
+            srvrAddr = rmtSockAddr;
+        }
+
+        // Connect to Peer server.
+        // Keep consonant with `PeerSrvr::accept()`
+        TcpClntSock socks[3];
+        {
+            ConnectGate gate{};
+            TcpClntSock::connect(srvrAddr, socks, 3, fastOpen);
+        }
+
+        // Use of local RAII sockets => sockets close on error
+        orderSocks(socks[0], socks[1], socks[2]); // Might throw
+
+        // Identifies the connection to the server
+        const in_port_t noticePort = socks[0].getLclPort();
+
+        if (socks[0].write(noticePort) && socks[1].write(noticePort) &&
+                socks[2].write(noticePort)) {
+            noticeSock  = socks[0];
+            requestSock = socks[1];
+            dataSock    = socks[2];
+            success = true;
+        }
+
+        return success;
+    }
+
+    void startThreads(Peer peer) {
+        noticeReader = Thread(&Impl::runReader, this, noticeSock, peer);
+
+        try {
+            requestReader = Thread(&Impl::runReader, this, requestSock, peer);
+
+            try {
+                dataReader = Thread(&Impl::runReader, this, dataSock, peer);
+            } // `requestReader` created
+            catch (const std::exception& ex) {
+                requestSock.shutdown(SHUT_RD); // Stops the reader
+                requestReader.join();
+                throw;
+            }
+        } // `noticeReader` created
+        catch (const std::exception& ex) {
+            noticeSock.shutdown(SHUT_RD); // Stops the reader
+            noticeReader.join();
+            throw;
+        }
+    }
+
+    /**
+     * Stops the reading threads by shutting down the connection. Because
+     * writing is also shut down, a thread that's blocked writing to the
+     * remote peer returns `false` rather than having to be canceled.
+     * Idempotent.
+     */
+    void stopThreads() {
+        LOG_TRACE;
+        if (dataSock)
+            dataSock.shutdown(SHUT_RDWR);
+        if (requestSock)
+            requestSock.shutdown(SHUT_RDWR);
+        if (noticeSock)
+            noticeSock.shutdown(SHUT_RDWR);
+        LOG_TRACE;
+    }
+
+    void joinThreads() {
+        LOG_TRACE;
+        if (dataReader.joinable())
+            dataReader.join();
+        LOG_TRACE;
+        if (requestReader.joinable())
+            requestReader.join();
+        LOG_TRACE;
+        if (noticeReader.joinable())
+            noticeReader.join();
+        LOG_TRACE;
+    }
+
+    static inline bool write(TcpSock& sock, const PduId id) {
+        LOG_TRACE;
+        return sock.write(static_cast<PduType>(id));
+    }
+
+    static inline bool read(TcpSock& sock, PduId& pduId) {
+        PduType id;
+        auto    success = sock.read(id);
+        pduId = static_cast<PduId>(id);
+        return success;
+    }
+
+    static inline bool write(TcpSock& sock, const ProdIndex index) {
+        LOG_TRACE;
+        return sock.write((ProdIndex::Type)index);
+    }
+
+    static inline bool read(TcpSock& sock, ProdIndex& index) {
+        ProdIndex::Type i;
+        if (sock.read(i)) {
+            index = ProdIndex(i);
+            return true;
+        }
+        return false;
+    }
+
+    static inline bool write(TcpSock& sock, const Timestamp& timestamp) {
+        LOG_TRACE;
+        return sock.write(timestamp.sec) && sock.write(timestamp.nsec);
+    }
+
+    static inline bool read(TcpSock& sock, Timestamp& timestamp) {
+        LOG_TRACE;
+        return sock.read(timestamp.sec) && sock.read(timestamp.nsec);
+    }
+
+    static inline bool write(TcpSock& sock, const DataSegId& id) {
+        return write(sock, id.prodIndex) && sock.write(id.offset);
+    }
+
+    static inline bool write(TcpSock& sock, const ProdInfo& prodInfo) {
+        return write(sock, prodInfo.getProdIndex()) &&
+                sock.write(prodInfo.getName()) &&
+                sock.write(prodInfo.getProdSize()) &&
+                write(sock, prodInfo.getTimestamp());
+    }
+
+    static bool read(TcpSock& sock, ProdInfo& prodInfo) {
+        ProdIndex index;
+        String    name;
+        ProdSize  size;
+        Timestamp timestamp;
+
+        if (!read(sock, index) ||
+               !sock.read(name) ||
+               !sock.read(size) ||
+               !read(sock, timestamp))
+            return false;
+
+        prodInfo = ProdInfo(index, name, size, timestamp);
+        return true;
+    }
+
+    static inline bool write(TcpSock& sock, const DataSeg& dataSeg) {
+        return write(sock, dataSeg.segId()) &&
+                sock.write(dataSeg.prodSize()) &&
+                sock.write(dataSeg.data(), dataSeg.size());
+    }
+
+    static inline bool read(TcpSock& sock, DataSegId& id) {
+        return read(sock, id.prodIndex) && sock.read(id.offset);
+    }
+
+    static inline bool write(TcpSock& sock, const BlockId& id) {
+        return write(sock, id.prodIndex) && sock.write(id.offset);
+    }
+
+    static inline bool read(TcpSock& sock, BlockId& id) {
+        return read(sock, id.prodIndex) && sock.read(id.offset);
+    }
+
+    static inline bool write(TcpSock& sock, const CodedSeg& codedSeg) {
+        return write(sock, codedSeg.blockId()) &&
+                sock.write(codedSeg.prodSize()) &&
+                sock.write(codedSeg.coefs(), codedSeg.numSegs()) &&
+                sock.write(codedSeg.data(), DataSeg::CANON_DATASEG_SIZE);
+    }
+
+    static bool read(TcpSock& sock, CodedSeg& codedSeg) {
+        bool     success = false;
+        BlockId  id;
+        ProdSize size;
+        if (read(sock, id) && sock.read(size)) {
+            codedSeg = CodedSeg(id, size, sock);
+            success = true;
+        }
+        return success;
+    }
+
+    static inline bool write(TcpSock& sock, const McastReport& report) {
+        return sock.write(report.lossPpm) && sock.write(report.rcvRate) &&
+                sock.write(report.numHops);
+    }
+
+    static inline bool read(TcpSock& sock, McastReport& report) {
+        return sock.read(report.lossPpm) && sock.read(report.rcvRate) &&
+                sock.read(report.numHops);
+    }
+
+    static bool write(TcpSock& sock, const Inventory& inventory) {
+        if (!sock.write(static_cast<uint32_t>(inventory.complete.size())))
+            return false;
+        for (const auto& range : inventory.complete)
+            if (!sock.write(range.first) || !sock.write(range.count))
+                return false;
+
+        if (!sock.write(static_cast<uint32_t>(inventory.partial.size())))
+            return false;
+        for (const auto& prod : inventory.partial) {
+            if (!sock.write(prod.prodIndex) || !sock.write(prod.info) ||
+                    !sock.write(static_cast<uint32_t>(prod.segs.size())))
+                return false;
+            for (const auto word : prod.segs)
+                if (!sock.write(word))
+                    return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @throws RuntimeError  Inventory is too large
+     */
+    static bool read(TcpSock& sock, Inventory& inventory) {
+        uint32_t count;
+        uint32_t numLeft = Inventory::MAX_ENTRIES; // Entries left to decode
+
+        if (!sock.read(count))
+            return false;
+        if (count > numLeft)
+            throw RUNTIME_ERROR("Too many product ranges in inventory: " +
+                    std::to_string(count));
+        numLeft -= count;
+        inventory.complete.resize(count);
+        for (auto& range : inventory.complete)
+            if (!sock.read(range.first) || !sock.read(range.count))
+                return false;
+
+        if (!sock.read(count))
+            return false;
+        if (count > numLeft)
+            throw RUNTIME_ERROR("Too many partial products in inventory: " +
+                    std::to_string(count));
+        numLeft -= count;
+        inventory.partial.resize(count);
+        for (auto& prod : inventory.partial) {
+            if (!sock.read(prod.prodIndex) || !sock.read(prod.info) ||
+                    !sock.read(count))
+                return false;
+            if (count > numLeft)
+                throw RUNTIME_ERROR("Bitmaps in inventory are too large: " +
+                        std::to_string(Inventory::MAX_ENTRIES - numLeft +
+                        count) + " entries");
+            numLeft -= count;
+            prod.segs.resize(count);
+            for (auto& word : prod.segs)
+                if (!sock.read(word))
+                    return false;
+        }
+
+        return true;
+    }
+
+    static inline bool read(TcpSock& sock, bool& value) {
+        return sock.read(value);
+    }
+
+    static bool read(TcpSock& sock, DataSeg& dataSeg) {
+        bool success = false;
+        DataSegId id;
+        ProdSize  size;
+        if (read(sock, id) && sock.read(size)) {
+            dataSeg = DataSeg(id, size, sock);
+            success = true;;
+        }
+        return success;
+    }
+
+    /**
+     * Dispatch function for processing an incoming message from the remote
+     * peer.
+     *
+     * @param[in] id            Message type
+     * @param[in] peer          Associated local peer
+     * @retval    `false`       End-of-file encountered.
+     * @retval    `true`        Success
+     * @throw std::logic_error  `id` is unknown
+     */
+    bool processPdu(const PduId id, Peer peer) {
+        bool success = false;
+        int  cancelState;
+
+        switch (id) {
+        case PduId::PUB_PATH_NOTICE: {
+            LOG_TRACE;
+            bool notice;
+            if (read(noticeSock, notice)) {
+                node.recvNotice(PubPath(notice), peer);
+                rmtPubPath = notice;
+                success = true;
+            }
+            break;
+        }
+        case PduId::PROD_INFO_NOTICE: {
+            LOG_TRACE;
+            ProdIndex notice;
+            if (read(noticeSock, notice)) {
+                rmtHaves.add(notice);
+                success = !node.recvNotice(notice, peer) || request(notice);
+            }
+            break;
+        }
+        case PduId::DATA_SEG_NOTICE: {
+            LOG_TRACE;
+            DataSegId notice;
+            if (read(noticeSock, notice)) {
+                rmtHaves.add(notice);
+                success = !node.recvNotice(notice, peer) || request(notice);
+            }
+            break;
+        }
+        case PduId::PROD_INFO_REQUEST: {
+            LOG_TRACE;
+            ProdIndex request;
+            if (read(requestSock, request)) {
+                auto prodInfo = node.recvRequest(request, peer);
+                success = prodInfo && send(prodInfo);
+            }
+            break;
+        }
+        case PduId::DATA_SEG_REQUEST: {
+            LOG_TRACE;
+            DataSegId request;
+            if (read(requestSock, request)) {
+                auto dataSeg = node.recvRequest(request, peer);
+                // A NACK-mode request might be for an unavailable segment
+                success = dataSeg ? send(dataSeg) : sendUnavail(request);
+            }
+            break;
+        }
+        case PduId::DATA_SEG_UNAVAIL: {
+            LOG_TRACE;
+            DataSegId segId;
+            if (read(dataSock, segId)) {
+                node.recvUnavail(segId, peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::PROD_INFO: {
+            LOG_TRACE;
+            ProdInfo data;
+            if (read(dataSock, data)) {
+                rmtHaves.add(data.getProdIndex());
+                node.recvData(data, peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::DATA_SEG: {
+            LOG_TRACE;
+            DataSeg dataSeg;
+            if (read(dataSock, dataSeg)) {
+                rmtHaves.add(dataSeg.segId());
+                node.recvData(dataSeg, peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::CODED_SEG_REQUEST: {
+            LOG_TRACE;
+            BlockId request;
+            if (read(requestSock, request)) {
+                auto codedSeg = node.recvRequest(request, peer);
+                success = !codedSeg || send(codedSeg);
+            }
+            break;
+        }
+        case PduId::CODED_SEG: {
+            LOG_TRACE;
+            CodedSeg codedSeg;
+            if (read(dataSock, codedSeg)) {
+                node.recvData(codedSeg, peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::NACK_MODE_NOTICE: {
+            LOG_TRACE;
+            bool notice;
+            if (read(noticeSock, notice)) {
+                rmtNackMode = notice;
+                node.recvNotice(NackMode(notice), peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::MCAST_REPORT: {
+            LOG_TRACE;
+            McastReport report;
+            if (read(noticeSock, report)) {
+                node.recvNotice(report, peer);
+                success = true;
+            }
+            break;
+        }
+        case PduId::INVENTORY: {
+            LOG_TRACE;
+            Inventory inventory;
+            if (read(noticeSock, inventory)) {
+                rmtHaves.add(inventory);
+                node.recvNotice(inventory, peer);
+                success = true;
+            }
+            break;
+        }
+        default:
+            throw std::logic_error("Invalid PDU type: " +
+                    std::to_string(static_cast<PduType>(id)));
+        }
+
+        return success;
+    }
+
+    void setExPtr() {
+        Guard guard{exceptMutex};
+        if (!exPtr)
+            exPtr = std::current_exception();
+    }
+
+    void throwIfExPtr() {
+        bool throwEx = false;
+        {
+            Guard guard{exceptMutex};
+            throwEx = static_cast<bool>(exPtr);
+        }
+        if (throwEx)
+            std::rethrow_exception(exPtr);
+    }
+
+    /**
+     * Reads one socket from the remote peer and processes incoming messages.
+     * Doesn't return until either EOF is encountered or an error occurs.
+     *
+     * @param[in] sock    Socket with remote peer
+     * @param[in] peer    Associated local peer
+     * @throw LogicError  Message type is unknown
+     */
+    void runReader(TcpSock sock, Peer peer) {
+        try {
+            for (;;) {
+                PduId id;
+                if (!read(sock, id) || !processPdu(id, peer))
+                    break; // EOF
+            }
+        }
+        catch (const std::exception& ex) {
+            setExPtr();
+        }
+    }
+
+public:
+    static std::atomic<bool> fastOpen; ///< Use TCP Fast Open?
+
+    /**
+     * Sets the maximum number of simultaneous outbound connection attempts.
+     *
+     * @param[in] max  Maximum number of simultaneous connection attempts
+     */
+    static void setMaxConnecting(const unsigned max) {
+        ConnectGate::setMax(max);
+    }
+
+    /**
+     * Constructs.
+     *
+     * @param[in] node      P2P node
+     * @param[in] srvrAddr  Socket address of remote P2P server. Must be
+     *                      invalid if server-side constructed.
+     */
+    Impl(P2pNode& node, const SockAddr& srvrAddr)
+        : sockMutex()
+        , noticeMutex()
+        , rmtSockAddrMutex()
+        , exceptMutex()
+        , node(node)
+        , noticeSock()
+        , requestSock()
+        , dataSock()
+        , noticeReader()
+        , requestReader()
+        , dataReader()
+        , requestWriter()
+        , rmtSockAddr(srvrAddr)
+        , rmtPubPath(false)
+        , rmtNackMode(false)
+        , rmtHaves()
+        , state(State::INITED)
+        , clientSide(static_cast<bool>(srvrAddr))
+        , exPtr()
+    {}
+
+    /**
+     * Server-side construction.
+     *
+     * @param[in] node  P2P node
+     */
+    explicit Impl(P2pNode& node)
+        : Impl(node, SockAddr{})
+    {}
+
+    Impl(const Impl& impl) =delete; // Rule of three
+
+    ~Impl() noexcept {
+        LOG_TRACE;
+        try {
+            stop(); // Idempotent
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex);
+        }
+    }
+
+    Impl& operator=(const Impl& rhs) noexcept =delete; // Rule of three
+
+    /**
+     * Sets the next, individual socket. Server-side only.
+     *
+     * @param[in] sock        Relevant socket
+     * @throw     LogicError  Connection is already complete
+     */
+    void set(TcpSock& sock) {
+        if (clientSide)
+            throw LOGIC_ERROR("Can't set client-side socket");
+
+        Guard guard{sockMutex};
+
+        // NB: Keep function consonant with `Impl(SockAddr)`
+
+        if (!noticeSock) {
+            noticeSock = sock;
+            Guard guard{rmtSockAddrMutex};
+            rmtSockAddr = noticeSock.getRmtAddr();
+        }
+        else if (!requestSock) {
+            requestSock = sock;
+        }
+        else if (!dataSock) {
+            dataSock = sock;
+            orderSocks(noticeSock, requestSock, dataSock);
+            // The sockets might have been accepted in any order
+            Guard guard{rmtSockAddrMutex};
+            rmtSockAddr = noticeSock.getRmtAddr();
+        }
+        else {
+            throw LOGIC_ERROR("Server-side P2P connection is complete");
+        }
+    }
+
+    /**
+     * Indicates if instance is complete (i.e., has all individual sockets).
+     *
+     * @retval `false`  Instance is not complete
+     * @retval `true`   Instance is complete
+     */
+    bool isComplete() const noexcept {
+        Guard guard{sockMutex};
+        return noticeSock && requestSock && dataSock;
+    }
+
+    /**
+     * Starts this instance. Does the following:
+     *   - If client-side constructed, blocks while connecting to the remote
+     *     peer
+     *   - Creates threads on which
+     *       - The sockets are read; and
+     *       - The P2P node is called.
+     *
+     * @param[in] peer     Associated local peer
+     * @retval    `false`  Peer is client-side and couldn't connect with remote
+     *                     peer
+     * @retval    `false`  `stop()` was called
+     * @retval    `true`   Success
+     * @throw LogicError   Already called
+     * @throw SystemError  Thread couldn't be created
+     * @see   `stop()`
+     */
+    bool start(Peer peer) {
+        LOG_TRACE;
+        bool  success;
+        State lclState{State::INITED};
+
+        if (!state.compare_exchange_strong(lclState, State::STARTING)) {
+            if (lclState == State::STARTING || lclState == State::STARTED)
+                throw LOGIC_ERROR("start() already called");
+        }
+        else {
+            success = clientSide
+                    ? connectClient()
+                    : true;
+
+            if (success) {
+                startThreads(peer);
+                lclState = State::STARTING;
+                if (!state.compare_exchange_strong(lclState, State::STARTED)) {
+                    stopThreads();
+                    joinThreads();
+                    success = false;
+                }
+                // `stop()` is now effective
+            }
+        }
+
+        return success;
+    }
+
+    /**
+     * Returns the socket address of the remote peer.
+     *
+     * @return Socket address of remote peer
+     */
+    SockAddr getRmtAddr() const noexcept {
+        Guard guard{rmtSockAddrMutex};
+        return rmtSockAddr;
+    }
+
+    /**
+     * Stops this instance from serving its remote counterpart. Causes the
+     * threads serving the remote peer to terminate. If called before `start()`,
+     * then the remote peer will not be served.
+     *
+     * Idempotent.
+     *
+     * @see   `start()`
+     */
+    void stop() {
+        LOG_TRACE;
+        State expected = State::INITED;
+
+        if (!state.compare_exchange_strong(expected, State::STOPPING)) {
+            expected = State::STARTING;
+
+            if (!state.compare_exchange_strong(expected, State::STOPPING)) {
+                expected = State::STARTED;
+
+                if (state.compare_exchange_strong(expected, State::STOPPING)) {
+                    stopThreads();
+                    joinThreads();
+                }
+            }
+        }
+    }
+
+    String to_string(const bool withName) const {
+        Guard guard{rmtSockAddrMutex};
+        return rmtSockAddr.to_string(withName);
+    }
+
+    /**
+     * Notifies the remote peer.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool notify(const PubPath notice) {
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::PUB_PATH_NOTICE) &&
+                noticeSock.write(notice.operator bool());
+    }
+    bool notify(const NackMode notice) {
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::NACK_MODE_NOTICE) &&
+                noticeSock.write(notice.operator bool());
+    }
+    bool notify(const McastReport& notice) {
+        LOG_TRACE;
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::MCAST_REPORT) &&
+            write(noticeSock, notice);
+    }
+    bool notify(const Inventory& notice) {
+        LOG_TRACE;
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::INVENTORY) &&
+            write(noticeSock, notice);
+    }
+    bool notify(const ProdIndex notice) {
+        LOG_TRACE;
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::PROD_INFO_NOTICE) &&
+            write(noticeSock, notice);
+    }
+    bool notify(const DataSegId& notice) {
+        LOG_TRACE;
+        throwIfExPtr();
+        Guard guard{noticeMutex}; // To support internal & external threads
+        return write(noticeSock, PduId::DATA_SEG_NOTICE) &&
+            write(noticeSock, notice);
+    }
+
+    /**
+     * Requests product information from the remote peer. Blocks while writing.
+     *
+     * @param[in] prodIndex   Index of product
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool request(const ProdIndex prodIndex) {
+        throwIfExPtr();
+        Guard guard{sockMutex}; // To support internal & external threads
+        return write(requestSock, PduId::PROD_INFO_REQUEST) &&
+                write(requestSock, prodIndex);
+    }
+
+    /**
+     * Requests a data-segment from the remote peer. Blocks while writing.
+     *
+     * @param[in] segId       ID of data-segment
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool request(const DataSegId& segId) {
+        throwIfExPtr();
+        Guard guard{sockMutex}; // To support internal & external threads
+        return write(requestSock, PduId::DATA_SEG_REQUEST) &&
+            write(requestSock, segId);
+    }
+
+    /**
+     * Requests a coded data-segment of a block from the remote peer. Blocks
+     * while writing.
+     *
+     * @param[in] blockId     ID of block
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool request(const BlockId& blockId) {
+        throwIfExPtr();
+        Guard guard{sockMutex}; // To support internal & external threads
+        return write(requestSock, PduId::CODED_SEG_REQUEST) &&
+            write(requestSock, blockId);
+    }
+
+    /**
+     * Sends data to the remote peer.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool send(const ProdInfo& data) {
+        throwIfExPtr();
+        rmtHaves.add(data.getProdIndex()); // Irrelevant if the write fails
+        return write(dataSock, PduId::PROD_INFO) &&
+                write(dataSock, data);
+    }
+    bool send(const DataSeg& data) {
+        throwIfExPtr();
+        rmtHaves.add(data.segId()); // Irrelevant if the write fails
+        return write(dataSock, PduId::DATA_SEG) &&
+                write(dataSock, data);
+    }
+    bool send(const CodedSeg& data) {
+        throwIfExPtr();
+        return write(dataSock, PduId::CODED_SEG) &&
+                write(dataSock, data);
+    }
+
+    /**
+     * Tells the remote peer that a data-segment it requested is unavailable so
+     * that it can request it elsewhere.
+     *
+     * @param[in] segId       ID of the unavailable data-segment
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool sendUnavail(const DataSegId& segId) {
+        throwIfExPtr();
+        return write(dataSock, PduId::DATA_SEG_UNAVAIL) &&
+                write(dataSock, segId);
+    }
+
+    bool rmtIsPubPath() const noexcept {
+        return rmtPubPath;
+    }
+
+    bool rmtWantsNacks() const noexcept {
+        return rmtNackMode;
+    }
+
+    bool rmtHas(const ProdIndex prodIndex) const {
+        return rmtHaves.has(prodIndex);
+    }
+
+    bool rmtHas(const DataSegId& segId) const {
+        return rmtHaves.has(segId);
+    }
+};
+
+/******************************************************************************/
+
+CodedSeg P2pNode::recvRequest(
+        const BlockId,
+        Peer) {
+    return CodedSeg{}; // Coded repair isn't supported
+}
+
+void P2pNode::recvData(
+        const CodedSeg,
+        Peer) {
+}
+
+void P2pNode::recvNotice(
+        const NackMode,
+        Peer) {
+}
+
+void P2pNode::recvNotice(
+        const McastReport,
+        Peer) {
+}
+
+Inventory P2pNode::getInventory() const {
+    return Inventory{};
+}
+
+void P2pNode::recvNotice(
+        const Inventory&,
+        Peer) {
+}
+
+void P2pNode::recvUnavail(
+        const DataSegId,
+        Peer) {
+}
+
+/******************************************************************************/
+
+Mutex    Peer::Impl::ConnectGate::mutex;
+Cond     Peer::Impl::ConnectGate::cond;
+unsigned Peer::Impl::ConnectGate::numConnecting = 0;
+unsigned Peer::Impl::ConnectGate::maxConnecting = 8;
+
+std::atomic<bool> Peer::Impl::fastOpen(false);
+
+void Peer::setMaxConnecting(const unsigned maxConnecting)
+{
+    if (maxConnecting == 0)
+        throw INVALID_ARGUMENT("Maximum number of connection attempts is zero");
+
+    Impl::setMaxConnecting(maxConnecting);
+}
+
+void Peer::setFastOpen(const bool enable) noexcept
+{
+    Impl::fastOpen = enable;
+}
+
+Peer::Peer(SharedPtr& pImpl)
+    : pImpl(pImpl)
+{}
+
+Peer::Peer(P2pNode& node)
+    /*
+     * Passing `this` or `*this` to the `Impl` ctor doesn't make changes to
+     * `pImpl` visible: `pImpl` isn't visible while `Impl` is being constructed.
+     */
+    : pImpl(std::make_shared<Impl>(node))
+{
+    LOG_TRACE;
+}
+
+Peer::Peer(P2pNode& node, const SockAddr& srvrAddr)
+    : pImpl(std::make_shared<Impl>(node, srvrAddr))
+{
+    LOG_TRACE;
+}
+
+Peer& Peer::set(TcpSock& sock) {
+    pImpl->set(sock);
+    return *this;
+}
+
+bool Peer::isComplete() const noexcept {
+    return pImpl->isComplete();
+}
+
+bool Peer::start() {
+    return pImpl->start(*this);
+}
+
+SockAddr Peer::getRmtAddr() noexcept {
+    return pImpl->getRmtAddr();
+}
+
+void Peer::stop() {
+    pImpl->stop();
+}
+
+Peer::operator bool() const {
+    return static_cast<bool>(pImpl);
+}
+
+size_t Peer::hash() const noexcept {
+    /*
+     * The underlying pointer is used instead of `pImpl->hash()` because
+     * hashing a client-side socket in the implementation won't work until
+     * `connect()` returns -- which could be a while -- and `PeerSet`, at least,
+     * requires a hash before it calls `Peer::start()`.
+     *
+     * This means, however, that it's possible to have multiple client-side
+     * peers connected to the same remote host within the same process.
+     */
+    return std::hash<Impl*>()(pImpl.get());
+}
+
+bool Peer::operator<(const Peer& rhs) const noexcept {
+    // Must be consistent with `hash()`
+    return pImpl.get() < rhs.pImpl.get();
+}
+
+bool Peer::operator==(const Peer& rhs) const noexcept {
+    return !(*this < rhs) && !(rhs < *this);
+}
+
+bool Peer::operator!=(const Peer& rhs) const noexcept {
+    return (*this < rhs) || (rhs < *this);
+}
+
+String Peer::to_string(const bool withName) const {
+    return pImpl->to_string(withName);
+}
+
+bool Peer::notify(const PubPath notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::notify(const NackMode notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::notify(const McastReport& notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::notify(const Inventory& notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::notify(const ProdIndex notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::notify(const DataSegId& notice) const {
+    return pImpl->notify(notice);
+}
+
+bool Peer::request(const ProdIndex request) const {
+    return pImpl->request(request);
+}
+
+bool Peer::request(const DataSegId& request) const {
+    return pImpl->request(request);
+}
+
+bool Peer::request(const BlockId& request) const {
+    return pImpl->request(request);
+}
+
+bool Peer::send(const ProdInfo& data) const {
+    return pImpl->send(data);
+}
+
+bool Peer::send(const DataSeg& data) const {
+    return pImpl->send(data);
+}
+
+bool Peer::send(const CodedSeg& data) const {
+    return pImpl->send(data);
+}
+
+bool Peer::rmtIsPubPath() const noexcept {
+    return pImpl->rmtIsPubPath();
+}
+
+bool Peer::rmtWantsNacks() const noexcept {
+    return pImpl->rmtWantsNacks();
+}
+
+bool Peer::rmtHas(const ProdIndex prodIndex) const {
+    return pImpl->rmtHas(prodIndex);
+}
+
+bool Peer::rmtHas(const DataSegId& segId) const {
+    return pImpl->rmtHas(segId);
+}
+
+/******************************************************************************/
+
+/**
+ * Peer server implementation.
+ */
+class PeerSrvr::Impl
+{
+    class PeerFactory
+    {
+        using Map = std::unordered_map<SockAddr, Peer>;
+
+        P2pNode& node;
+        Map      peers;
+
+    public:
+        PeerFactory(P2pNode& node)
+            : node(node)
+            , peers()
+        {}
+
+        /**
+         * Adds an individual socket to a peer. If the addition completes the
+         * peer, then it is removed from this instance.
+         *
+         * @param[in] sock  Individual socket
+         * @return          Corresponding peer. `Peer::isComplete()` is true,
+         *                  then the peer has been removed from this instance.
+         */
+        Peer add(TcpSock& sock, in_port_t noticePort) {
+            // TODO: Limit number of outstanding connections
+            // TODO: Purge old entries
+            auto key = sock.getRmtAddr().clone(noticePort);
+            auto peer = peers[key];
+
+            if (!peer)
+                peers[key] = peer = Peer{node}; // Entry was default constructed
+
+            if (peer.set(sock).isComplete())
+                peers.erase(key);
+
+            return peer;
+        }
+    };
+
+    using PeerQ = std::queue<Peer, std::list<Peer>>;
+
+    mutable Mutex            mutex;
+    mutable Cond             cond;
+    PeerFactory              peerFactory;
+    const SockAddr           srvrAddr;
+    std::vector<TcpSrvrSock> srvrSocks;
+    std::vector<Thread>      acceptors; ///< Empty => caller of `accept()`
+    PeerQ                    acceptQ;
+    PeerQ::size_type         maxAccept;
+
+    /**
+     * Executes on separate thread.
+     *
+     * @param[in] sock  Newly-accepted socket
+     */
+    void acceptSock(TcpSock sock) {
+        in_port_t noticePort;
+
+        if (sock.read(noticePort)) { // Might take a while
+            // The rest is fast
+            Guard guard{mutex};
+
+            if (acceptQ.size() < maxAccept) {
+                // A peer's sockets might have been accepted by different
+                // acceptors; `peerFactory` assembles them regardless.
+                auto peer = peerFactory.add(sock, noticePort);
+
+                if (peer.isComplete())
+                    acceptQ.push(peer);
+
+                cond.notify_one();
+            }
+        }
+    }
+
+    /**
+     * Accepts sockets from one of several listening sockets. Executes on its
+     * own thread until the listening socket is shut down.
+     *
+     * @param[in] srvrSock  Listening socket
+     * @param[in] cpu       Index of the CPU on which to execute
+     */
+    void runAcceptor(
+            TcpSrvrSock    srvrSock,
+            const unsigned cpu) {
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet))
+            LOG_DEBUG("Couldn't bind acceptor thread to CPU %u", cpu);
+#endif
+
+        try {
+            // The socket is scoped to the iteration so that a blocked
+            // `accept()` doesn't keep the previous one open
+            for (;;) {
+                auto sock = srvrSock.accept();
+                if (!sock)
+                    break;
+                Thread(&Impl::acceptSock, this, sock).detach();
+            }
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex);
+        }
+    }
+
+public:
+    /**
+     * Constructs from the local address of the server.
+     *
+     * @param[in] node          P2P node
+     * @param[in] srvrAddr      Local Address of P2P server
+     * @param[in] maxAccept     Maximum number of outstanding P2P connections
+     * @param[in] numAcceptors  Number of listening sockets, each with its own
+     *                          accepting thread. If greater than one, then the
+     *                          sockets share `srvrAddr` via SO_REUSEPORT;
+     *                          otherwise, the caller of `accept()` accepts.
+     */
+    Impl(   P2pNode&        node,
+            const SockAddr& srvrAddr,
+            const unsigned  maxAccept,
+            const unsigned  numAcceptors)
+        : mutex()
+        , cond()
+        , peerFactory(node)
+        , srvrAddr(srvrAddr)
+        , srvrSocks()
+        , acceptors()
+        , acceptQ()
+        , maxAccept(maxAccept)
+    {
+        if (numAcceptors <= 1) {
+            srvrSocks.push_back(TcpSrvrSock(srvrAddr, 3*maxAccept));
+        }
+        else {
+            srvrSocks.push_back(TcpSrvrSock(srvrAddr, 3*maxAccept, true));
+            // Use the actual address in case the port number was zero
+            const auto lclAddr = srvrSocks[0].getLclAddr();
+            for (unsigned i = 1; i < numAcceptors; ++i)
+                srvrSocks.push_back(TcpSrvrSock(lclAddr, 3*maxAccept, true));
+
+            const unsigned numCpus =
+                    std::max(1U, std::thread::hardware_concurrency());
+            try {
+                for (unsigned i = 0; i < numAcceptors; ++i)
+                    acceptors.push_back(Thread(&Impl::runAcceptor, this,
+                            srvrSocks[i], i % numCpus));
+            }
+            catch (...) {
+                stopAcceptors();
+                throw;
+            }
+        }
+    }
+
+    Impl(const Impl& impl) =delete; // Rule of three
+
+    ~Impl() noexcept {
+        try {
+            stopAcceptors();
+        }
+        catch (const std::exception& ex) {
+            LOG_ERROR(ex);
+        }
+    }
+
+    Impl& operator=(const Impl& rhs) noexcept =delete; // Rule of three
+
+    /**
+     * Stops and joins the accepting threads. Idempotent.
+     */
+    void stopAcceptors() {
+        for (auto& srvrSock : srvrSocks)
+            srvrSock.shutdown(SHUT_RD); // Causes `accept()` to return
+        for (auto& acceptor : acceptors)
+            if (acceptor.joinable())
+                acceptor.join();
+    }
+
+    /**
+     * Returns the next, accepted, peer-to-peer connection.
+     *
+     * @return Next P2P connection
+     */
+    Peer accept() {
+        Lock lock{mutex};
+
+        while (acceptQ.empty()) {
+            if (acceptors.empty()) {
+                // TODO: Limit number of threads
+                // TODO: Lower priority of thread to favor data transmission
+                auto sock = srvrSocks[0].accept();
+                if (sock)
+                    Thread(&Impl::acceptSock, this, sock).detach();
+            }
+            cond.wait(lock);
+        }
+
+        auto peer = acceptQ.front();
+        acceptQ.pop();
+
+        return peer;
+    }
+};
+
+PeerSrvr::PeerSrvr(P2pNode&        node,
+                   const SockAddr& srvrAddr,
+                   const unsigned  maxAccept,
+                   const unsigned  numAcceptors)
+    : pImpl(std::make_shared<Impl>(node, srvrAddr, maxAccept, numAcceptors))
+{}
+Peer PeerSrvr::accept() {
+    return pImpl->accept();
+}
+
+} // namespace
@@ -0,0 +1,263 @@
+/**
+ * This file declares the Peer class. The Peer class handles low-level,
+ * bidirectional messaging with its remote counterpart.
+ *
+ *  @file:  Peer.h
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_PROTO_PEER_H_
+#define MAIN_PROTO_PEER_H_
+
+#include "HycastProto.h"
+#include "P2pNode.h"
+#include "Socket.h"
+
+#include <memory>
+
+namespace hycast {
+
+/// Handles low-level, asynchronous, bidirectional messaging with a remote peer.
+class Peer final
+{
+private:
+    class     Impl;
+    using     SharedPtr = std::shared_ptr<Impl>;
+    SharedPtr pImpl;
+
+    Peer(SharedPtr& pImpl);
+
+    /**
+     * Indicates if instance is complete (i.e., has all individual connections).
+     *
+     * @retval `false`  Instance is not complete
+     * @retval `true`   Instance is complete
+     */
+    bool isComplete() const noexcept;
+
+public:
+    friend class Impl;
+    friend class PeerSrvr;
+
+    /**
+     * Default constructs.
+     */
+    Peer() =default;
+
+    /**
+     * Server-side construction.
+     *
+     * @param[in] node  Associated P2P node
+     */
+    explicit Peer(P2pNode& node);
+
+    /**
+     * Constructs a client-side instance.
+     *
+     * @param[in] node      P2P node to call about received PDU-s
+     * @param[in] srvrAddr  Address of server to which to connect
+     */
+    Peer(P2pNode& node, const SockAddr& srvrAddr);
+
+    /**
+     * Sets the maximum number of client-side instances that may be connecting
+     * to their remote peers at the same time. Additional instances will block
+     * in `start()` until an attempt completes. The default is 8.
+     *
+     * @param[in] maxConnecting    Maximum number of simultaneous outbound
+     *                             connection attempts
+     * @throw     InvalidArgument  `maxConnecting == 0`
+     * @threadsafety               Safe
+     */
+    static void setMaxConnecting(const unsigned maxConnecting);
+
+    /**
+     * Sets whether or not client-side instances use TCP Fast Open when
+     * connecting to their remote peers. The default is not to.
+     *
+     * @param[in] enable  Whether or not to use TCP Fast Open
+     * @threadsafety      Safe
+     */
+    static void setFastOpen(const bool enable) noexcept;
+
+    /**
+     * Sets the next, individual socket. Server-side only.
+     *
+     * @param[in] sock        Relevant socket
+     * @return                This instance
+     * @throw     LogicError  Connection is already complete
+     */
+    Peer& set(TcpSock& sock);
+
+    /**
+     * Starts this instance. Does the following:
+     *   - If client-side constructed, blocks while connecting to the remote
+     *     peer
+     *   - Creates threads that serve the remote peer
+     * Upon return, this instance *must* be stopped before it can be destroyed.
+     *
+     * @retval `false`     Remote peer disconnected
+     * @retval `true`      Success
+     * @throw LogicError   Already started
+     * @throw SystemError  Thread couldn't be created
+     * @see   `stop()`
+     */
+    bool start();
+
+    /**
+     * Returns the socket address of the remote peer.
+     *
+     * @return Socket address of remote peer
+     */
+    SockAddr getRmtAddr() noexcept;
+
+    /**
+     * Stops this instance from serving its remote counterpart. Does the
+     * following:
+     *   - Stops the threads that are serving the remote peer
+     *   - Joins those threads
+     * *Must* be called in order for this instance to be destroyed
+     *
+     * @throw LogicError  Peer hasn't been started
+     * @see   `start()`
+     */
+    void stop();
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `false`  Instance is invalid
+     * @retval `true`   Instance is valid
+     */
+    operator bool() const;
+
+    size_t hash() const noexcept;
+
+    bool operator<(const Peer& rhs) const noexcept;
+
+    bool operator==(const Peer& rhs) const noexcept;
+
+    bool operator!=(const Peer& rhs) const noexcept;
+
+    String to_string(bool withName = false) const;
+
+    /**
+     * Notifies the remote peer.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool notify(const PubPath notice) const;
+    bool notify(const NackMode notice) const;
+    bool notify(const McastReport& notice) const;
+    bool notify(const Inventory& notice) const;
+    bool notify(const ProdIndex notice) const;
+    bool notify(const DataSegId& notice) const;
+
+    /**
+     * Requests data from the remote peer.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool request(const ProdIndex request) const;
+    bool request(const DataSegId& request) const;
+    bool request(const BlockId& request) const;
+
+    /**
+     * Sends data to the remote peer.
+     *
+     * @retval    `false`     Remote peer disconnected
+     * @retval    `true`      Success
+     */
+    bool send(const ProdInfo& prodInfo) const;
+    bool send(const DataSeg& dataSeg) const;
+    bool send(const CodedSeg& codedSeg) const;
+
+    bool rmtIsPubPath() const noexcept;
+
+    /**
+     * Indicates if the remote peer is in NACK-mode (i.e., it doesn't want
+     * notices of individual data-segments because it'll request the ones it's
+     * missing).
+     *
+     * @retval `true`   Remote peer is in NACK-mode
+     * @retval `false`  Remote peer wants all notices
+     */
+    bool rmtWantsNacks() const noexcept;
+
+    /**
+     * Indicates if the remote peer is known to have a product's information
+     * or a data-segment because it notified this instance about it or because
+     * it was exchanged with it.
+     *
+     * @retval `true`   The remote peer has it
+     * @retval `false`  The remote peer isn't known to have it
+     * @see `HaveSet`
+     */
+    bool rmtHas(const ProdIndex prodIndex) const;
+    bool rmtHas(const DataSegId& segId) const;
+};
+
+/**
+ * Listening peer server.
+ */
+class PeerSrvr
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs from the local address for the server.
+     *
+     * @param[in] node          P2P node
+     * @param[in] srvrAddr      Local Address for peer server
+     * @param[in] maxAccept     Maximum number of outstanding peer connections
+     * @param[in] numAcceptors  Number of listening sockets. If greater than
+     *                          one, then that many sockets listen on
+     *                          `srvrAddr` via SO_REUSEPORT and each is served
+     *                          by its own thread on its own CPU, which lets
+     *                          many simultaneous connections be accepted in
+     *                          parallel. Otherwise, a single socket is
+     *                          accepted by the caller of `accept()`.
+     */
+    PeerSrvr(P2pNode&        node,
+             const SockAddr& srvrAddr,
+             const unsigned  maxAccept = 8,
+             const unsigned  numAcceptors = 1);
+
+    /**
+     * Returns the next, accepted peer.
+     *
+     * @return Next peer
+     */
+    Peer accept();
+};
+
+} // namespace
+
+namespace std {
+    template<>
+    struct hash<hycast::Peer> {
+        size_t operator()(const hycast::Peer& peer) const noexcept {
+            return peer.hash();
+        }
+    };
+}
+
+#endif /* MAIN_PROTO_PEER_H_ */
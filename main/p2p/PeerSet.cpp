@@ -0,0 +1,500 @@
+/**
+ * This file implements a set of active peers whose remote counterparts can all
+ * be notified together.
+ *
+ *  @file:  PeerSet.cpp
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "Bookkeeper.h"
+#include "error.h"
+#include "HycastProto.h"
+#include "logging.h"
+#include "NoticeArray.h"
+#include "PeerSet.h"
+#include "StopToken.h"
+#include "ThreadException.h"
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hycast {
+
+/**
+ * Thread-safe set of active peers.
+ */
+class PeerSet::Impl
+{
+    /**
+     * A thread-safe class responsible for sending notifications in a
+     * notice-queue to a single peer.
+     */
+    class PeerEntry {
+        mutable Mutex    mutex;
+        mutable ThreadEx threadEx;
+        Peer             peer;
+        NoticeArray      noticeArray;
+        Inventory        inventory;   ///< Local inventory for remote peer
+        ArrayIndex       readIndex;
+        StopSource       stopSource;  ///< Stops the sending thread
+        Thread           thread;
+
+        /**
+         * Sets the inventory and returns the initial read-index. If the local
+         * node has an inventory, then it's sent to the remote peer instead of
+         * replaying the pending notices. The write-index is obtained first so
+         * that whatever was notified before it is in the inventory.
+         *
+         * @param[in] node  Local P2P node
+         * @return          Initial read-index
+         */
+        ArrayIndex initReadIndex(P2pNode& node) {
+            const auto writeIndex = noticeArray.getWriteIndex();
+            inventory = node.getInventory();
+            return inventory
+                    ? writeIndex
+                    : noticeArray.getOldestIndex();
+        }
+
+        void run(const bool pubPath, const bool nackMode) {
+            LOG_TRACE;
+            try {
+                /*
+                 * Starting the peer here, on a separate thread, means that it
+                 * won't block other peers if it was client-side constructed and
+                 * has yet to connect to the remote peer.
+                 */
+                // Starts reading messages from the remote peer
+                if (!peer.start())
+                    return; // `peer.stop()` was called
+                peer.notify(PubPath(pubPath));
+                if (nackMode)
+                    peer.notify(NackMode(true));
+                if (inventory) {
+                    peer.notify(inventory);
+                    inventory = Inventory{}; // No longer needed
+                }
+
+                const auto stopToken = stopSource.getToken();
+
+                for (auto index = readIndex;;) {
+                    // Returns early if a stop is requested
+                    if (!noticeArray.send(index, peer, stopToken))
+                        break; // Connection lost or stop requested
+                    /*
+                     * To avoid prematurely purging the current notice, the
+                     * read-index must be advanced *after* the notice has
+                     * been sent.
+                     */
+                    Guard guard(mutex);
+                    readIndex = index;
+                }
+            }
+            catch (const std::exception& ex) {
+                LOG_ERROR(ex);
+                threadEx.set(ex);
+            }
+        }
+
+    public:
+        PeerEntry(P2pNode&    node,
+                  Peer        peer,
+                  NoticeArray noticeArray,
+                  const bool  pubPath,
+                  const bool  nackMode)
+            : mutex()
+            , threadEx()
+            , peer(peer)
+            , noticeArray(noticeArray)
+            , inventory()
+            , readIndex(initReadIndex(node))
+            , stopSource()
+            , thread(&PeerEntry::run, this, pubPath, nackMode)
+        {}
+
+        PeerEntry(const PeerEntry& peerEntry) =delete;
+        PeerEntry& operator=(const PeerEntry& entry) =delete;
+
+        PeerEntry(PeerEntry&& peerEntry) =default;
+
+        ~PeerEntry() {
+            /*
+             * The thread is stopped cooperatively: the stop request wakes it
+             * if it's waiting for a notice, and stopping the peer shuts down
+             * its connection, which ends any write or connection attempt.
+             */
+            stopSource.requestStop();
+            peer.stop();
+            thread.join();
+        }
+
+        ArrayIndex getReadIndex() const {
+            Guard guard(mutex);
+            threadEx.throwIfSet();
+            return readIndex;
+        }
+    };
+
+    using PeerEntries = std::map<Peer, PeerEntry>;
+
+    /// Weight of a new multicast outcome in the moving-average loss-rate
+    static constexpr double ALPHA = 0.001;
+
+    mutable Mutex mutex;
+    P2pNode&      node;
+    // Placed before peer entries to ensure existence for `PeerEntry.run()`
+    NoticeArray   noticeArray;
+    PeerEntries   peerEntries;
+    const double  maxLoss;     ///< Loss-rate above which NACK-mode is left
+    double        mcastLoss;   ///< Moving-average multicast loss-rate
+    bool          nackMode;    ///< Are remote peers told NACK-mode?
+    SubBookkeeper bookkeeper;  ///< Decides which peer requests what
+
+    /**
+     * Purges notice-queue of notices that will not be read. A stalled peer
+     * can't make the notice-queue grow without bound because the queue erases
+     * its oldest notices when it's full.
+     */
+    void purge() {
+        const auto writeIndex = noticeArray.getWriteIndex();
+        // Guaranteed to be equal to or greater than oldest read-index:
+        auto       oldestIndex = writeIndex;
+
+        // Find oldest read-index
+        {
+            Guard guard(mutex); // No changes allowed to peer-set
+            for (const auto& peerEntry : peerEntries) {
+                const auto readIndex = peerEntry.second.getReadIndex();
+
+                if (readIndex < oldestIndex)
+                    oldestIndex = readIndex;
+            }
+        }
+
+        if (oldestIndex < writeIndex)
+            // Purge notice-queue of entries that will not be read
+            noticeArray.eraseTo(oldestIndex);
+    }
+
+    /**
+     * Has a peer make the requests for data-segments that the bookkeeper
+     * assigns to it. Only does something in swarming mode.
+     *
+     * @param[in] peer  Peer
+     */
+    void makeRequests(Peer peer) {
+        DataSegId segId;
+        while (bookkeeper.getRequest(peer, segId))
+            if (!peer.request(segId))
+                break; // Connection lost. `erase()` will reassign.
+    }
+
+public:
+    Impl(   P2pNode&               node,
+            const double           maxLoss,
+            const ArrayIndex::Type maxNotices,
+            const bool             swarm)
+        : mutex()
+        , node(node)
+        , noticeArray(node, maxNotices)
+        , peerEntries()
+        , maxLoss(maxLoss)
+        , mcastLoss(0)
+        , nackMode(maxLoss > 0)
+        , bookkeeper(8, swarm)
+    {
+        if (maxLoss < 0 || maxLoss >= 1)
+            throw INVALID_ARGUMENT("Invalid maximum loss-rate: " +
+                    std::to_string(maxLoss));
+    }
+
+    /**
+     * Adds a peer to this instance and starts it iff the peer is not already in
+     * the set.
+     *
+     * @param[in] peer           Peer to be added
+     * @param[in] pubPath        Is local peer path to publisher?
+     * @retval    `false`        Peer was not added because it already exists
+     * @retval    `true`         Peer was added
+     * @throw std::system_error  Couldn't create new thread
+     */
+    bool insert(Peer peer, const bool pubPath) {
+        Guard guard(mutex);
+        bool  added;
+
+        if (peerEntries.count(peer)) {
+            added = false;
+        }
+        else {
+            // NB: The following requires that `peer.hash()` works now
+            const auto  pair = peerEntries.emplace(std::piecewise_construct,
+                    std::forward_as_tuple(peer),
+                    std::forward_as_tuple(node, peer, noticeArray, pubPath,
+                            nackMode));
+
+            LOG_ASSERT(pair.second); // Because `peerEntries.count(peer) != 0`
+
+            bookkeeper.add(peer);
+            added = true;
+        }
+
+        return added;
+    }
+
+    bool erase(Peer peer) {
+        std::vector<Peer> others;
+        {
+            Guard guard(mutex);
+            if (peerEntries.erase(peer) == 0)
+                return false;
+            for (const auto& peerEntry : peerEntries)
+                others.push_back(peerEntry.first);
+        }
+
+        // Requests are made without the lock because they might block
+        bookkeeper.remove(peer);
+        for (auto& other : others)
+            makeRequests(other);
+        return true;
+    }
+
+    PeerEntries::size_type size() const {
+        Guard guard(mutex);
+        return peerEntries.size();
+    }
+
+    void notify(const PubPath notice) {
+        purge();
+        noticeArray.putPubPath(notice);
+    }
+
+    void notify(const Inventory& notice) {
+        purge();
+        noticeArray.putInventory(notice);
+    }
+
+    /**
+     * Sends a multicast reception report towards the publisher: to the first
+     * peer whose remote peer is a path to the publisher and that isn't the
+     * peer the report came from. Sending it to only one peer and limiting the
+     * number of hops ensures that reports can neither multiply nor circulate
+     * indefinitely.
+     *
+     * @param[in] notice  Multicast reception report
+     * @param[in] from    Peer the report came from. Invalid if it's the local
+     *                    node's.
+     * @retval `true`     Report was sent
+     * @retval `false`    Report wasn't sent
+     */
+    bool notify(const McastReport& notice, Peer from) {
+        if (notice.numHops >= McastReport::MAX_HOPS)
+            return false;
+
+        Peer upstream{};
+        {
+            Guard guard(mutex);
+            for (const auto& peerEntry : peerEntries) {
+                const auto& peer = peerEntry.first;
+                if (peer.rmtIsPubPath() && !(from && peer == from)) {
+                    upstream = peer;
+                    break;
+                }
+            }
+        }
+        if (!upstream)
+            return false;
+
+        auto report = notice;
+        ++report.numHops;
+        return upstream.notify(report); // Blocks, so mutex isn't locked
+    }
+
+    void notify(const ProdIndex notice) {
+        purge();
+        noticeArray.putProdIndex(notice);
+    }
+
+    void notify(const DataSegId& notice) {
+        purge();
+        noticeArray.put(notice);
+    }
+
+    bool shouldRequest(Peer peer, const ProdIndex notice) {
+        return bookkeeper.shouldRequest(peer, notice);
+    }
+
+    bool shouldRequest(Peer peer, const DataSegId& notice) {
+        return bookkeeper.shouldRequest(peer, notice);
+    }
+
+    void received(Peer peer, const ProdIndex prodIndex) {
+        bookkeeper.received(peer, prodIndex);
+    }
+
+    void received(Peer peer, const DataSegId& segId) {
+        bookkeeper.received(peer, segId);
+        makeRequests(peer);
+    }
+
+    /**
+     * Accumulates the outcome of the multicast of a data-segment. Switches
+     * the remote peers to full notices if the loss-rate exceeds the maximum
+     * and back to NACK-mode when it falls below half the maximum.
+     *
+     * @param[in] received  Was the data-segment received by multicast?
+     */
+    void mcastOutcome(const bool received) {
+        if (maxLoss <= 0)
+            return;
+
+        Guard guard(mutex);
+        mcastLoss += ALPHA*((received ? 0 : 1) - mcastLoss);
+
+        const bool wantNacks = nackMode
+                ? mcastLoss <= maxLoss
+                : mcastLoss < maxLoss/2;
+        if (wantNacks != nackMode) {
+            nackMode = wantNacks;
+            LOG_NOTE("Multicast loss-rate is %g. Switching to %s notices",
+                    mcastLoss, nackMode ? "NACK-mode" : "full");
+            noticeArray.putNackMode(nackMode);
+        }
+    }
+
+    bool isNackMode() const {
+        Guard guard(mutex);
+        return nackMode;
+    }
+
+    double getMcastLoss() const {
+        Guard guard(mutex);
+        return mcastLoss;
+    }
+
+    unsigned long getNumSuppressed() const noexcept {
+        return noticeArray.getNumSuppressed();
+    }
+
+    unsigned long getNumRedundant() const noexcept {
+        return noticeArray.getNumRedundant();
+    }
+
+    unsigned long getNumResyncs() const noexcept {
+        return noticeArray.getNumResyncs();
+    }
+
+    double getSuppressionRatio() const noexcept {
+        const double numSkipped = noticeArray.getNumSuppressed() +
+                noticeArray.getNumRedundant();
+        const double numTotal = numSkipped + noticeArray.getNumSent();
+        return numTotal ? numSkipped/numTotal : 0;
+    }
+};
+
+constexpr double PeerSet::Impl::ALPHA;
+
+/******************************************************************************/
+
+PeerSet::PeerSet(
+        P2pNode&               node,
+        const double           maxLoss,
+        const ArrayIndex::Type maxNotices,
+        const bool             swarm)
+    : pImpl{std::make_shared<Impl>(node, maxLoss, maxNotices, swarm)}
+{}
+
+bool PeerSet::insert(Peer peer, const bool pubPath) const {
+    return pImpl->insert(peer, pubPath);
+}
+
+bool PeerSet::erase(Peer peer) const {
+    return pImpl->erase(peer);
+}
+
+PeerSet::size_type PeerSet::size() const {
+    return pImpl->size();
+}
+
+void PeerSet::notify(const PubPath notice) const {
+    pImpl->notify(notice);
+}
+
+void PeerSet::notify(const Inventory& notice) const {
+    pImpl->notify(notice);
+}
+
+bool PeerSet::notify(const McastReport& notice, Peer from) const {
+    return pImpl->notify(notice, from);
+}
+
+void PeerSet::notify(const ProdIndex notice) const {
+    pImpl->notify(notice);
+}
+
+void PeerSet::notify(const DataSegId& notice) const {
+    pImpl->notify(notice);
+}
+
+bool PeerSet::shouldRequest(Peer peer, const ProdIndex notice) const {
+    return pImpl->shouldRequest(peer, notice);
+}
+
+bool PeerSet::shouldRequest(Peer peer, const DataSegId& notice) const {
+    return pImpl->shouldRequest(peer, notice);
+}
+
+void PeerSet::received(Peer peer, const ProdIndex prodIndex) const {
+    pImpl->received(peer, prodIndex);
+}
+
+void PeerSet::received(Peer peer, const DataSegId& segId) const {
+    pImpl->received(peer, segId);
+}
+
+void PeerSet::mcastOutcome(const bool received) const {
+    pImpl->mcastOutcome(received);
+}
+
+bool PeerSet::isNackMode() const {
+    return pImpl->isNackMode();
+}
+
+double PeerSet::getMcastLoss() const {
+    return pImpl->getMcastLoss();
+}
+
+unsigned long PeerSet::getNumSuppressed() const noexcept {
+    return pImpl->getNumSuppressed();
+}
+
+unsigned long PeerSet::getNumRedundant() const noexcept {
+    return pImpl->getNumRedundant();
+}
+
+unsigned long PeerSet::getNumResyncs() const noexcept {
+    return pImpl->getNumResyncs();
+}
+
+double PeerSet::getSuppressionRatio() const noexcept {
+    return pImpl->getSuppressionRatio();
+}
+
+} // namespace
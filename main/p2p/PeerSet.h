@@ -0,0 +1,257 @@
+/**
+ * This file declares a set of peers.
+ *
+ *  @file: PeerSet.h
+ * @author: Steven R. Emmerson <emmerson@ucar.edu>
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_PROTO_PEERSET_H_
+#define MAIN_PROTO_PEERSET_H_
+
+#include "NoticeArray.h"
+#include "Peer.h"
+
+#include <memory>
+
+namespace hycast {
+
+class PeerSet
+{
+public:
+    class                 Impl;
+
+protected:
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    using size_type = size_t;
+
+    /**
+     * Constructs.
+     *
+     * NACK-mode: While the multicast is healthy, a subscriber's remote peers
+     * needn't notify it about every data-segment because it'll have almost
+     * all of them. If `maxLoss` is positive, then the remote peers are told
+     * to only send product notices and the node is expected to request
+     * (i.e., negatively acknowledge) the few data-segments that it's missing
+     * from a peer that notified it about the product. The remote peers are
+     * switched back to full notices when the multicast loss-rate exceeds
+     * `maxLoss`.
+     *
+     * The number of pending notices is bounded. A remote peer that falls
+     * further behind than that is resynchronized with a notice for every
+     * recent product rather than being sent every notice it missed.
+     *
+     * Swarming: A subscriber decides which peer requests what by calling
+     * `shouldRequest()` when a notice arrives and `received()` when data
+     * arrives. If `swarm` is true, then the requests for data-segments are
+     * striped across every peer that has them in proportion to the peers'
+     * throughput, and this instance makes the deferred requests itself.
+     *
+     * @param[in] node             Associated P2P node
+     * @param[in] maxLoss          Maximum multicast loss-rate for NACK-mode.
+     *                             0 means NACK-mode is never used.
+     * @param[in] maxNotices       Maximum number of pending notices
+     * @param[in] swarm            Stripe data-segment requests across peers?
+     * @throws    InvalidArgument  `maxLoss < 0 || maxLoss >= 1`
+     * @throws    InvalidArgument  `maxNotices == 0`
+     * @see `mcastOutcome()`
+     * @see `SubBookkeeper`
+     */
+    PeerSet(P2pNode&               node,
+            const double           maxLoss = 0,
+            const ArrayIndex::Type maxNotices = NoticeArray::MAX_NOTICES,
+            const bool             swarm = false);
+
+    /**
+     * Adds a peer. If the peer is already in the set, then nothing is done;
+     * otherwise, the peer is added and starts receiving from its associated
+     * remote peer and becomes ready to notify its remote peer.
+     *
+     * @param[in] peer     Peer to try adding
+     * @param[in] pubPath  Is the local peer a path to the publisher?
+     * @retval    `false`  Peer was already in the set. Nothing was done.
+     * @retval    `true`   Peer was not in the set. Peer was added and started.
+     * @see Peer::start()
+     */
+    bool insert(Peer peer, const bool pubPath = false) const;
+
+    /**
+     * Removes a peer. In swarming mode, the peer's outstanding requests for
+     * data-segments are made by the remaining peers that have them.
+     *
+     * @param[in] peer     Peer to remove
+     * @retval    `false`  Peer wasn't in the set
+     * @retval    `true`   Peer was removed
+     */
+    bool erase(Peer peer) const;
+
+    size_type size() const;
+
+    void notify(const PubPath notice) const;
+
+    /**
+     * Notifies the remote peers of the local node's inventory so that they
+     * can reconcile what they have with it. Should be called periodically.
+     * A newly-added peer is sent the inventory returned by
+     * `P2pNode::getInventory()`.
+     *
+     * @param[in] notice  Inventory of the local node
+     */
+    void notify(const Inventory& notice) const;
+
+    /**
+     * Sends a multicast reception report towards the publisher (i.e., to a
+     * peer whose remote peer is a path to the publisher). Used both for the
+     * local node's reports and for forwarding those of remote peers. A report
+     * is forwarded at most `McastReport::MAX_HOPS` times.
+     *
+     * @param[in] notice   Multicast reception report
+     * @param[in] from     Peer the report came from, which won't be sent it.
+     *                     Default is the local node.
+     * @retval    `true`   Report was sent
+     * @retval    `false`  Report wasn't sent because no peer is a path to the
+     *                     publisher, its hop limit was reached, or the
+     *                     connection was lost
+     * @threadsafety       Safe
+     * @see `McastMonitor`
+     */
+    bool notify(const McastReport& notice, Peer from = Peer{}) const;
+
+    void notify(const ProdIndex notice) const;
+
+    void notify(const DataSegId& notice) const;
+
+    /**
+     * Indicates if a peer should request information on a product that its
+     * remote peer has. Should be called by the node's `recvNotice()`.
+     *
+     * @param[in] peer        Peer
+     * @param[in] notice      Product index
+     * @retval    `true`      The peer should request it
+     * @retval    `false`     The peer shouldn't request it
+     * @throws    LogicError  Peer isn't in the set
+     * @threadsafety          Safe
+     * @see `SubBookkeeper::shouldRequest()`
+     */
+    bool shouldRequest(Peer peer, const ProdIndex notice) const;
+
+    /**
+     * Indicates if a peer should request a data-segment that its remote peer
+     * has. Should be called by the node's `recvNotice()`. In swarming mode, a
+     * request that shouldn't be made now might be made later by this
+     * instance.
+     *
+     * @param[in] peer        Peer
+     * @param[in] notice      Data-segment identifier
+     * @retval    `true`      The peer should request it
+     * @retval    `false`     The peer shouldn't request it
+     * @throws    LogicError  Peer isn't in the set
+     * @threadsafety          Safe
+     * @see `SubBookkeeper::shouldRequest()`
+     */
+    bool shouldRequest(Peer peer, const DataSegId& notice) const;
+
+    /**
+     * Processes a peer having received product information. Should be called
+     * by the node's `recvData()`.
+     *
+     * @param[in] peer        Peer
+     * @param[in] prodIndex   Product index
+     * @throws    LogicError  Peer isn't in the set or the information wasn't
+     *                        requested
+     * @threadsafety          Safe
+     */
+    void received(Peer peer, const ProdIndex prodIndex) const;
+
+    /**
+     * Processes a peer having received a data-segment. Should be called by
+     * the node's `recvData()`. In swarming mode, the peer then requests the
+     * next data-segments that are assigned to it.
+     *
+     * @param[in] peer        Peer
+     * @param[in] segId       Data-segment identifier
+     * @throws    LogicError  Peer isn't in the set or, if not swarming, the
+     *                        data-segment wasn't requested
+     * @threadsafety          Safe
+     */
+    void received(Peer peer, const DataSegId& segId) const;
+
+    /**
+     * Accumulates the outcome of the multicast of a data-segment for the
+     * purpose of NACK-mode. Does nothing if NACK-mode isn't enabled.
+     *
+     * @param[in] received  Was the data-segment received by multicast?
+     * @threadsafety        Safe
+     * @see `McastMonitor`
+     */
+    void mcastOutcome(const bool received) const;
+
+    /**
+     * Indicates if the remote peers have been told NACK-mode.
+     *
+     * @retval `true`   Yes
+     * @retval `false`  No
+     */
+    bool isNackMode() const;
+
+    /**
+     * Returns the moving-average multicast loss-rate.
+     *
+     * @return  Moving-average multicast loss-rate
+     */
+    double getMcastLoss() const;
+
+    /**
+     * Returns the number of data-segment notices that weren't sent to remote
+     * peers because they were in NACK-mode.
+     *
+     * @return  Number of suppressed data-segment notices
+     */
+    unsigned long getNumSuppressed() const noexcept;
+
+    /**
+     * Returns the number of product and data-segment notices that weren't
+     * sent to remote peers because they were known to have the product or
+     * data-segment.
+     *
+     * @return  Number of redundant notices
+     * @see `Peer::rmtHas()`
+     */
+    unsigned long getNumRedundant() const noexcept;
+
+    /**
+     * Returns the number of times that a remote peer was resynchronized
+     * because it fell too far behind.
+     *
+     * @return  Number of resynchronizations
+     */
+    unsigned long getNumResyncs() const noexcept;
+
+    /**
+     * Returns the fraction of product and data-segment notices that weren't
+     * sent to remote peers, whether because of NACK-mode or because they
+     * were redundant.
+     *
+     * @return  Suppression ratio in [0, 1]
+     */
+    double getSuppressionRatio() const noexcept;
+};
+
+} // namespace
+
+#endif /* MAIN_PROTO_PEERSET_H_ */
@@ -0,0 +1,558 @@
+/**
+ * Random linear network coding (RLNC) of data-segments for P2P repair.
+ *
+ *        File: Rlnc.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "error.h"
+#include "Rlnc.h"
+
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HYCAST_X86 1
+#endif
+
+namespace hycast {
+
+/**
+ * Logarithm and exponential tables. 3 generates the multiplicative group.
+ */
+struct Gf256Tables
+{
+    uint8_t log[256];
+    uint8_t exp[510]; ///< Doubled to avoid a modulo operation
+
+    Gf256Tables()
+    {
+        unsigned x = 1;
+        for (unsigned i = 0; i < 255; ++i) {
+            exp[i] = exp[i + 255] = x;
+            log[x] = i;
+            x ^= x << 1; // Multiply by 3
+            if (x & 0x100)
+                x ^= 0x11B;
+        }
+        log[0] = 0; // Unused
+    }
+};
+
+static const Gf256Tables& tables()
+{
+    static const Gf256Tables tables;
+    return tables;
+}
+
+uint8_t Gf256::mul(const uint8_t a, const uint8_t b) noexcept
+{
+    if (a == 0 || b == 0)
+        return 0;
+    const auto& t = tables();
+    return t.exp[t.log[a] + t.log[b]];
+}
+
+uint8_t Gf256::inv(const uint8_t a)
+{
+    if (a == 0)
+        throw INVALID_ARGUMENT("Zero has no inverse");
+    const auto& t = tables();
+    return t.exp[255 - t.log[a]];
+}
+
+/**
+ * Product tables of a multiplier for the low and high nibbles of a
+ * multiplicand. Their exclusive-or is the product.
+ */
+struct NibbleTables
+{
+    alignas(16) uint8_t lo[16];
+    alignas(16) uint8_t hi[16];
+
+    explicit NibbleTables(const uint8_t c) noexcept
+    {
+        for (unsigned x = 0; x < 16; ++x) {
+            lo[x] = Gf256::mul(c, x);
+            hi[x] = Gf256::mul(c, x << 4);
+        }
+    }
+};
+
+/// Bulk operation. `src == nullptr` means scale `dst` in place.
+using BulkOp = void (*)(uint8_t* dst, const uint8_t* src, uint8_t c,
+        size_t nbytes);
+
+static void bulkScalar(
+        uint8_t*       dst,
+        const uint8_t* src,
+        const uint8_t  c,
+        const size_t   nbytes)
+{
+    const NibbleTables t(c);
+
+    if (src) {
+        for (size_t i = 0; i < nbytes; ++i)
+            dst[i] ^= t.lo[src[i] & 0xF] ^ t.hi[src[i] >> 4];
+    }
+    else {
+        for (size_t i = 0; i < nbytes; ++i)
+            dst[i] = t.lo[dst[i] & 0xF] ^ t.hi[dst[i] >> 4];
+    }
+}
+
+#ifdef HYCAST_X86
+__attribute__((target("ssse3")))
+static void bulkSsse3(
+        uint8_t*       dst,
+        const uint8_t* src,
+        const uint8_t  c,
+        const size_t   nbytes)
+{
+    const NibbleTables t(c);
+    const __m128i      lo = _mm_load_si128(
+            reinterpret_cast<const __m128i*>(t.lo));
+    const __m128i      hi = _mm_load_si128(
+            reinterpret_cast<const __m128i*>(t.hi));
+    const __m128i      mask = _mm_set1_epi8(0x0F);
+    size_t             i = 0;
+
+    for (; i + 16 <= nbytes; i += 16) {
+        const auto d = reinterpret_cast<__m128i*>(dst + i);
+        const auto v = _mm_loadu_si128(src
+                ? reinterpret_cast<const __m128i*>(src + i)
+                : d);
+        const auto p = _mm_xor_si128(
+                _mm_shuffle_epi8(lo, _mm_and_si128(v, mask)),
+                _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(v, 4),
+                        mask)));
+        _mm_storeu_si128(d, src ? _mm_xor_si128(_mm_loadu_si128(d), p) : p);
+    }
+    bulkScalar(dst + i, src ? src + i : nullptr, c, nbytes - i);
+}
+
+__attribute__((target("avx2")))
+static void bulkAvx2(
+        uint8_t*       dst,
+        const uint8_t* src,
+        const uint8_t  c,
+        const size_t   nbytes)
+{
+    const NibbleTables t(c);
+    const __m256i      lo = _mm256_broadcastsi128_si256(_mm_load_si128(
+            reinterpret_cast<const __m128i*>(t.lo)));
+    const __m256i      hi = _mm256_broadcastsi128_si256(_mm_load_si128(
+            reinterpret_cast<const __m128i*>(t.hi)));
+    const __m256i      mask = _mm256_set1_epi8(0x0F);
+    size_t             i = 0;
+
+    for (; i + 32 <= nbytes; i += 32) {
+        const auto d = reinterpret_cast<__m256i*>(dst + i);
+        const auto v = _mm256_loadu_si256(src
+                ? reinterpret_cast<const __m256i*>(src + i)
+                : d);
+        const auto p = _mm256_xor_si256(
+                _mm256_shuffle_epi8(lo, _mm256_and_si256(v, mask)),
+                _mm256_shuffle_epi8(hi, _mm256_and_si256(
+                        _mm256_srli_epi64(v, 4), mask)));
+        _mm256_storeu_si256(d, src
+                ? _mm256_xor_si256(_mm256_loadu_si256(d), p)
+                : p);
+    }
+    bulkScalar(dst + i, src ? src + i : nullptr, c, nbytes - i);
+}
+#endif
+
+/// Bulk implementation chosen for the CPU
+struct Bulk
+{
+    BulkOp      op;
+    const char* name;
+
+    Bulk()
+        : op{bulkScalar}
+        , name{"scalar"}
+    {
+#ifdef HYCAST_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            op = bulkAvx2;
+            name = "avx2";
+        }
+        else if (__builtin_cpu_supports("ssse3")) {
+            op = bulkSsse3;
+            name = "ssse3";
+        }
+#endif
+    }
+};
+
+static const Bulk& bulk()
+{
+    static const Bulk bulk;
+    return bulk;
+}
+
+void Gf256::mulAdd(
+        void*         dst,
+        const void*   src,
+        const uint8_t c,
+        const size_t  nbytes) noexcept
+{
+    if (c == 0)
+        return;
+    if (c == 1) {
+        auto       d = static_cast<uint8_t*>(dst);
+        const auto s = static_cast<const uint8_t*>(src);
+        for (size_t i = 0; i < nbytes; ++i)
+            d[i] ^= s[i];
+        return;
+    }
+    bulk().op(static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src),
+            c, nbytes);
+}
+
+void Gf256::scale(
+        void*         buf,
+        const uint8_t c,
+        const size_t  nbytes) noexcept
+{
+    if (c == 1)
+        return;
+    if (c == 0) {
+        ::memset(buf, 0, nbytes);
+        return;
+    }
+    bulk().op(static_cast<uint8_t*>(buf), nullptr, c, nbytes);
+}
+
+const char* Gf256::getImpl() noexcept
+{
+    return bulk().name;
+}
+
+/******************************************************************************/
+
+/**
+ * Vets a block identifier.
+ *
+ * @param[in] blockId          Block identifier
+ * @param[in] prodSize         Size of product in bytes
+ * @throws    InvalidArgument  Block identifier is invalid
+ */
+static void vet(
+        const BlockId& blockId,
+        const ProdSize prodSize)
+{
+    if (blockId.offset >= prodSize || blockId.offset % BlockId::SIZE)
+        throw INVALID_ARGUMENT("Invalid block " + blockId.to_string() +
+                " for product of " + std::to_string(prodSize) + " bytes");
+}
+
+class CodedSeg::Impl
+{
+public:
+    BlockId  blockId;  ///< Block identifier
+    ProdSize prodSize; ///< Product size in bytes
+    uint8_t  coefs[BlockId::NUM_SEGS];
+    char     data[DataSeg::CANON_DATASEG_SIZE];
+
+    Impl(   const BlockId& blockId,
+            const ProdSize prodSize)
+        : blockId(blockId)
+        , prodSize(prodSize)
+    {
+        vet(blockId, prodSize);
+    }
+
+    Impl(   const BlockId& blockId,
+            const ProdSize prodSize,
+            const uint8_t* coefs,
+            const char*    data)
+        : Impl(blockId, prodSize)
+    {
+        ::memcpy(this->coefs, coefs, blockId.numSegs(prodSize));
+        ::memcpy(this->data, data, sizeof(this->data));
+    }
+
+    Impl(   const BlockId& blockId,
+            const ProdSize prodSize,
+            TcpSock&       sock)
+        : Impl(blockId, prodSize)
+    {
+        if (!sock.read(coefs, blockId.numSegs(prodSize)) ||
+                !sock.read(data, sizeof(data)))
+            throw EOF_ERROR("EOF encountered reading coded data-segment of "
+                    "block " + blockId.to_string());
+    }
+
+    String to_string(const bool withName) const {
+        String string;
+        if (withName)
+            string += "CodedSeg";
+        return string + "{blockId=" + blockId.to_string() + ", prodSize=" +
+                std::to_string(prodSize) + "}";
+    }
+};
+
+CodedSeg::CodedSeg()
+    : pImpl{}
+{}
+
+CodedSeg::CodedSeg(
+        const BlockId& blockId,
+        const ProdSize prodSize,
+        const uint8_t* coefs,
+        const char*    data)
+    : pImpl(std::make_shared<Impl>(blockId, prodSize, coefs, data))
+{}
+
+CodedSeg::CodedSeg(
+        const BlockId& blockId,
+        const ProdSize prodSize,
+        TcpSock&       sock)
+    : pImpl(std::make_shared<Impl>(blockId, prodSize, sock))
+{}
+
+CodedSeg::operator bool() const {
+    return static_cast<bool>(pImpl);
+}
+
+const BlockId& CodedSeg::blockId() const noexcept {
+    return pImpl->blockId;
+}
+
+ProdSize CodedSeg::prodSize() const noexcept {
+    return pImpl->prodSize;
+}
+
+const uint8_t* CodedSeg::coefs() const noexcept {
+    return pImpl->coefs;
+}
+
+const char* CodedSeg::data() const noexcept {
+    return pImpl->data;
+}
+
+String CodedSeg::to_string(const bool withName) const {
+    return pImpl->to_string(withName);
+}
+
+/******************************************************************************/
+
+class RlncEncoder::Impl
+{
+    mutable Mutex      mutex;
+    const BlockId      blockId;
+    const ProdSize     prodSize;
+    const char*        blockData;
+    const unsigned     numSegs;
+    std::minstd_rand   random;
+
+public:
+    Impl(   const BlockId& blockId,
+            const ProdSize prodSize,
+            const char*    blockData)
+        : mutex()
+        , blockId(blockId)
+        , prodSize(prodSize)
+        , blockData(blockData)
+        , numSegs((vet(blockId, prodSize), blockId.numSegs(prodSize)))
+        , random(std::random_device{}())
+    {}
+
+    CodedSeg encode()
+    {
+        uint8_t coefs[BlockId::NUM_SEGS];
+        char    data[DataSeg::CANON_DATASEG_SIZE] = {};
+
+        {
+            Guard guard{mutex};
+            bool  allZero = true;
+            while (allZero) {
+                for (unsigned i = 0; i < numSegs; ++i) {
+                    coefs[i] = random();
+                    allZero &= coefs[i] == 0;
+                }
+            }
+        }
+
+        for (unsigned i = 0; i < numSegs; ++i) {
+            const SegOffset offset = i * DataSeg::CANON_DATASEG_SIZE;
+            Gf256::mulAdd(data, blockData + offset, coefs[i],
+                    DataSeg::size(prodSize, blockId.offset + offset));
+        }
+
+        return CodedSeg(blockId, prodSize, coefs, data);
+    }
+};
+
+RlncEncoder::RlncEncoder(
+        const BlockId& blockId,
+        const ProdSize prodSize,
+        const char*    blockData)
+    : pImpl(std::make_shared<Impl>(blockId, prodSize, blockData))
+{}
+
+CodedSeg RlncEncoder::encode() const {
+    return pImpl->encode();
+}
+
+/******************************************************************************/
+
+class RlncDecoder::Impl
+{
+    static const size_t SEG_SIZE = DataSeg::CANON_DATASEG_SIZE;
+
+    const BlockId     blockId;
+    const ProdSize    prodSize;
+    const unsigned    numSegs;
+    unsigned          rank;
+    std::vector<uint8_t> coefs;    ///< Row-major. Reduced row echelon form.
+    std::vector<char> data;        ///< Row-major
+    std::vector<int>  pivotRow;    ///< Column -> row of its pivot or -1
+
+    uint8_t* rowCoefs(const unsigned row) {
+        return coefs.data() + row*numSegs;
+    }
+
+    char* rowData(const unsigned row) {
+        return data.data() + row*SEG_SIZE;
+    }
+
+public:
+    Impl(   const BlockId& blockId,
+            const ProdSize prodSize)
+        : blockId(blockId)
+        , prodSize(prodSize)
+        , numSegs((vet(blockId, prodSize), blockId.numSegs(prodSize)))
+        , rank(0)
+        , coefs(numSegs*numSegs)
+        , data(numSegs*SEG_SIZE)
+        , pivotRow(numSegs, -1)
+    {}
+
+    bool add(const CodedSeg& codedSeg)
+    {
+        if (!(codedSeg.blockId() == blockId) ||
+                codedSeg.prodSize() != prodSize)
+            throw INVALID_ARGUMENT("Coded data-segment " +
+                    codedSeg.to_string() + " isn't for block " +
+                    blockId.to_string());
+
+        if (rank == numSegs)
+            return false;
+
+        // Reduce the new row by the existing pivot rows
+        uint8_t* const newCoefs = rowCoefs(rank);
+        char* const    newData = rowData(rank);
+        ::memcpy(newCoefs, codedSeg.coefs(), numSegs);
+        ::memcpy(newData, codedSeg.data(), SEG_SIZE);
+
+        for (unsigned col = 0; col < numSegs; ++col) {
+            const auto factor = newCoefs[col];
+            if (factor && pivotRow[col] >= 0) {
+                Gf256::mulAdd(newCoefs, rowCoefs(pivotRow[col]), factor,
+                        numSegs);
+                Gf256::mulAdd(newData, rowData(pivotRow[col]), factor,
+                        SEG_SIZE);
+            }
+        }
+
+        unsigned pivot = 0;
+        while (pivot < numSegs && newCoefs[pivot] == 0)
+            ++pivot;
+        if (pivot == numSegs)
+            return false; // Not innovative
+
+        const auto inverse = Gf256::inv(newCoefs[pivot]);
+        Gf256::scale(newCoefs, inverse, numSegs);
+        Gf256::scale(newData, inverse, SEG_SIZE);
+
+        // Eliminate the pivot column from the other rows
+        for (unsigned row = 0; row < rank; ++row) {
+            const auto factor = rowCoefs(row)[pivot];
+            if (factor) {
+                Gf256::mulAdd(rowCoefs(row), newCoefs, factor, numSegs);
+                Gf256::mulAdd(rowData(row), newData, factor, SEG_SIZE);
+            }
+        }
+
+        pivotRow[pivot] = rank++;
+        return true;
+    }
+
+    unsigned getRank() const noexcept {
+        return rank;
+    }
+
+    unsigned getNumSegs() const noexcept {
+        return numSegs;
+    }
+
+    bool isDecoded() const noexcept {
+        return rank == numSegs;
+    }
+
+    DataSeg getDataSeg(const unsigned index)
+    {
+        if (index >= numSegs)
+            throw OUT_OF_RANGE("Index " + std::to_string(index) + " is "
+                    "greater than " + std::to_string(numSegs - 1));
+        if (!isDecoded())
+            throw LOGIC_ERROR("Block " + blockId.to_string() + " isn't "
+                    "decoded");
+
+        const DataSegId segId(blockId.prodIndex,
+                blockId.offset + index*DataSeg::CANON_DATASEG_SIZE);
+        return DataSeg(segId, prodSize, rowData(pivotRow[index]));
+    }
+};
+
+RlncDecoder::RlncDecoder(
+        const BlockId& blockId,
+        const ProdSize prodSize)
+    : pImpl(std::make_shared<Impl>(blockId, prodSize))
+{}
+
+bool RlncDecoder::add(const CodedSeg& codedSeg) const {
+    return pImpl->add(codedSeg);
+}
+
+unsigned RlncDecoder::getRank() const noexcept {
+    return pImpl->getRank();
+}
+
+unsigned RlncDecoder::getNumSegs() const noexcept {
+    return pImpl->getNumSegs();
+}
+
+bool RlncDecoder::isDecoded() const noexcept {
+    return pImpl->isDecoded();
+}
+
+DataSeg RlncDecoder::getDataSeg(const unsigned index) const {
+    return pImpl->getDataSeg(index);
+}
+
+} // namespace
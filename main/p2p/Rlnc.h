@@ -0,0 +1,199 @@
+/**
+ * Random linear network coding (RLNC) of data-segments for P2P repair.
+ *
+ *        File: Rlnc.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_P2P_RLNC_H_
+#define MAIN_P2P_RLNC_H_
+
+#include "HycastProto.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Arithmetic in GF(2^8) with the reducing polynomial x^8 + x^4 + x^3 + x + 1.
+ * The bulk operations use AVX2 or SSSE3 if the CPU supports them.
+ */
+class Gf256
+{
+public:
+    /**
+     * Returns the product of two elements.
+     *
+     * @param[in] a  Multiplicand
+     * @param[in] b  Multiplier
+     * @return       Product
+     */
+    static uint8_t mul(uint8_t a, uint8_t b) noexcept;
+
+    /**
+     * Returns the multiplicative inverse of an element.
+     *
+     * @param[in] a                Element
+     * @return                     Inverse
+     * @throws    InvalidArgument  `a == 0`
+     */
+    static uint8_t inv(uint8_t a);
+
+    /**
+     * Adds a multiple of one vector to another: `dst[i] ^= c*src[i]`.
+     *
+     * @param[in,out] dst     Destination vector
+     * @param[in]     src     Source vector
+     * @param[in]     c       Multiplier
+     * @param[in]     nbytes  Number of elements
+     */
+    static void mulAdd(
+            void*        dst,
+            const void*  src,
+            uint8_t      c,
+            size_t       nbytes) noexcept;
+
+    /**
+     * Multiplies a vector by a scalar: `buf[i] = c*buf[i]`.
+     *
+     * @param[in,out] buf     Vector
+     * @param[in]     c       Multiplier
+     * @param[in]     nbytes  Number of elements
+     */
+    static void scale(
+            void*        buf,
+            uint8_t      c,
+            size_t       nbytes) noexcept;
+
+    /**
+     * Returns the name of the bulk implementation: "avx2", "ssse3", or
+     * "scalar".
+     *
+     * @return Name of bulk implementation
+     */
+    static const char* getImpl() noexcept;
+};
+
+/**
+ * Encodes the data-segments of a block into coded data-segments. Every coded
+ * data-segment has random coefficients, so the coded data-segments of
+ * independent encoders (i.e., of different peers) are very likely to be
+ * linearly independent.
+ */
+class RlncEncoder
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs.
+     *
+     * @param[in] blockId          Block identifier
+     * @param[in] prodSize         Size of product in bytes
+     * @param[in] blockData        Start of the block's data (not the
+     *                             product's). Must remain valid for the
+     *                             lifetime of this instance.
+     * @throws    InvalidArgument  `blockId` isn't valid for `prodSize`
+     */
+    RlncEncoder(
+            const BlockId& blockId,
+            const ProdSize prodSize,
+            const char*    blockData);
+
+    /**
+     * Returns a new coded data-segment.
+     *
+     * @return        Coded data-segment
+     * @threadsafety  Safe
+     */
+    CodedSeg encode() const;
+};
+
+/**
+ * Decodes a block from any sufficient set of coded data-segments by
+ * incremental Gauss-Jordan elimination.
+ */
+class RlncDecoder
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Constructs.
+     *
+     * @param[in] blockId          Block identifier
+     * @param[in] prodSize         Size of product in bytes
+     * @throws    InvalidArgument  `blockId` isn't valid for `prodSize`
+     */
+    RlncDecoder(
+            const BlockId& blockId,
+            const ProdSize prodSize);
+
+    /**
+     * Adds a coded data-segment.
+     *
+     * @param[in] codedSeg         Coded data-segment
+     * @retval    `true`           It was innovative (i.e., increased the rank)
+     * @retval    `false`          It wasn't
+     * @throws    InvalidArgument  It's for a different block
+     * @threadsafety               Compatible but unsafe
+     */
+    bool add(const CodedSeg& codedSeg) const;
+
+    /**
+     * Returns the number of linearly independent coded data-segments that
+     * have been added.
+     *
+     * @return  Rank of the decoding matrix
+     */
+    unsigned getRank() const noexcept;
+
+    /**
+     * Returns the number of data-segments in the block.
+     *
+     * @return  Number of data-segments in the block
+     */
+    unsigned getNumSegs() const noexcept;
+
+    /**
+     * Indicates if the block is decoded.
+     *
+     * @retval `true`   Yes
+     * @retval `false`  No
+     */
+    bool isDecoded() const noexcept;
+
+    /**
+     * Returns a decoded data-segment. The data references this instance and
+     * is valid only during its lifetime.
+     *
+     * @param[in] index         Origin-0 index of data-segment in block
+     * @return                  Data-segment
+     * @throws    OutOfRange    `index >= getNumSegs()`
+     * @throws    LogicError    Block isn't decoded
+     */
+    DataSeg getDataSeg(unsigned index) const;
+};
+
+} // namespace
+
+#endif /* MAIN_P2P_RLNC_H_ */
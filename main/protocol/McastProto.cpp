@@ -25,7 +25,17 @@
 #include "error.h"
 #include "hycast.h"
 #include "McastProto.h"
+#include "PacketRing.h"
 #include "protocol.h"
+#include "XdpRing.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 namespace hycast {
 
@@ -35,17 +45,58 @@ static MsgIdType prodInfoId = MsgId::PROD_INFO;
 static MsgIdType dataSegId = MsgId::DATA_SEG;
 
 class McastSndr::Impl {
-    UdpSock sock;
+    using Clock = std::chrono::steady_clock;
+
+    UdpSock             sock;
+    std::atomic<double> rate;     ///< Maximum rate in bytes/s. 0 => unlimited
+    Clock::time_point   nextTime; ///< Earliest time for next datagram
+
+    /**
+     * Blocks until a datagram may be sent without exceeding the rate.
+     *
+     * @param[in] nbytes   Size of the datagram in bytes
+     * @cancellationpoint  Yes
+     */
+    void pace(const size_t nbytes)
+    {
+        const double maxRate = rate;
+        if (maxRate <= 0)
+            return;
+
+        const auto now = Clock::now();
+        if (nextTime > now) {
+            std::this_thread::sleep_until(nextTime);
+        }
+        else {
+            nextTime = now; // No credit for idleness
+        }
+        nextTime += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(nbytes/maxRate));
+    }
 
 public:
     Impl(UdpSock& sock)
         : sock{sock}
+        , rate{0}
+        , nextTime{}
     {}
 
     Impl(UdpSock&& sock)
         : sock{sock}
+        , rate{0}
+        , nextTime{}
     {}
 
+    void setRate(const double rate) noexcept
+    {
+        this->rate = rate;
+    }
+
+    double getRate() const noexcept
+    {
+        return rate;
+    }
+
     void setMcastIface(const InetAddr& interface)
     {
         sock.setMcastIface(interface);
@@ -62,6 +113,7 @@ public:
             sock.addWrite(prodInfo.getProdIndex().getValue());
             sock.addWrite(prodInfo.getProdSize());
             sock.addWrite(name.data(), name.length());
+            pace(McastProto::PROD_INFO_HDR_LEN + name.length());
             sock.write();
         }
         catch (const std::exception& ex) {
@@ -70,11 +122,20 @@ public:
         }
     }
 
+    bool enableZeroCopy()
+    {
+        return sock.enableZeroCopy();
+    }
+
     /**
      * @param[in] seg           Data-segment
+     * @param[in] pin           Keeps the segment's data valid for a zero-copy
+     *                          write. The write is ordinary if this is empty.
      * @throws    RuntimeError  Couldn't multicast data-segment
      */
-    void multicast(const MemSeg& seg)
+    void multicast(
+            const MemSeg&       seg,
+            const UdpSock::Pin& pin = UdpSock::Pin{})
     {
         LOG_DEBUG("Multicasting data-segment " + seg.getSegId().to_string());
 
@@ -85,7 +146,13 @@ public:
             sock.addWrite(seg.getProdSize());
             sock.addWrite(seg.getSegOffset());
             sock.addWrite(seg.data(), seg.getSegSize());
-            sock.write();
+            pace(McastProto::DATA_SEG_HDR_LEN + seg.getSegSize());
+            if (pin) {
+                sock.write(pin);
+            }
+            else {
+                sock.write();
+            }
         }
         catch (const std::exception& ex) {
             LOG_DEBUG("Exception thrown: %s", ex.what());
@@ -119,100 +186,176 @@ void McastSndr::multicast(const MemSeg& seg)
     pImpl->multicast(seg);
 }
 
+void McastSndr::setRate(const double rate) const
+{
+    pImpl->setRate(rate);
+}
+
+double McastSndr::getRate() const noexcept
+{
+    return pImpl->getRate();
+}
+
+bool McastSndr::enableZeroCopy() const
+{
+    return pImpl->enableZeroCopy();
+}
+
+void McastSndr::multicast(
+        const MemSeg&       seg,
+        const UdpSock::Pin& pin)
+{
+    pImpl->multicast(seg, pin);
+}
+
 /******************************************************************************/
 
+/**
+ * Abstract multicast receiver. Decodes datagrams in place. The layout of a
+ * datagram is that written by `McastSndr`: every field is in network byte order
+ * and naturally aligned relative to the start of the datagram.
+ */
 class McastRcvr::Impl
 {
-    UdpSock          sock;
-    McastSub*    mcastSub;
-
-    void addCommon(
-            SegSize&         varSize,
-            ProdIndex::Type& prodIndex,
-            ProdSize&        prodSize)
+    static uint16_t get16(
+            const uint8_t* buf,
+            const size_t   offset)
     {
-        sock.addPeek(varSize);
-        sock.addPeek(prodIndex);
-        sock.addPeek(prodSize);
+        uint16_t value;
+        ::memcpy(&value, buf + offset, sizeof(value));
+        return ntohs(value);
     }
 
-    bool recvProdInfo()
+    static uint32_t get32(
+            const uint8_t* buf,
+            const size_t   offset)
     {
-        LOG_DEBUG("Receiving product-information on socket %s",
-                sock.to_string().data());
+        uint32_t value;
+        ::memcpy(&value, buf + offset, sizeof(value));
+        return ntohl(value);
+    }
 
-        SegSize         nameLen;
-        ProdIndex::Type prodIndex;
-        ProdSize        prodSize;
-        addCommon(nameLen, prodIndex, prodSize);
-        if (!sock.peek())
-            return false;
+    void recvProdInfo(
+            const uint8_t* buf,
+            const size_t   nbytes)
+    {
+        const SegSize nameLen = get16(buf, 2);
+        if (McastProto::PROD_INFO_HDR_LEN + nameLen > nbytes) {
+            LOG_DEBUG("Ignoring truncated product-information datagram");
+            return;
+        }
 
-        char buf[nameLen];
-        sock.addPeek(buf, nameLen);
-        if (!sock.peek())
-            return false;
+        mcastSub->hereIsMcast(ProdInfo{get32(buf, 4), get32(buf, 8),
+            std::string(reinterpret_cast<const char*>(buf) +
+                    McastProto::PROD_INFO_HDR_LEN, nameLen)});
+    }
 
-        sock.discard();
+    void recvDataSeg(
+            const uint8_t* buf,
+            const size_t   nbytes)
+    {
+        if (nbytes < McastProto::DATA_SEG_HDR_LEN) {
+            LOG_DEBUG("Ignoring truncated data-segment datagram");
+            return;
+        }
 
-        mcastSub->hereIsMcast(ProdInfo{prodIndex, prodSize,
-            std::string(buf, nameLen)});
+        const SegSize segSize = get16(buf, 2);
+        if (McastProto::DATA_SEG_HDR_LEN + segSize > nbytes) {
+            LOG_DEBUG("Ignoring truncated data-segment datagram");
+            return;
+        }
 
-        return true;
+        MemSeg memSeg{SegInfo{SegId{get32(buf, 4), get32(buf, 12)},
+                get32(buf, 8), segSize}, buf + McastProto::DATA_SEG_HDR_LEN};
+        mcastSub->hereIsMcast(memSeg);
     }
 
-    bool recvDataSeg()
-    {
-        LOG_DEBUG("Receiving data-segment on socket %s",
-                sock.to_string().data());
+protected:
+    McastSub* mcastSub;
 
-        SegSize         segSize;
-        ProdIndex::Type prodIndex;
-        ProdSize        prodSize;
-        ProdSize        segOffset;
-        addCommon(segSize, prodIndex, prodSize);
-        sock.addPeek(segOffset);
-        if (!sock.peek())
-            return false;
+    Impl(McastSub& mcastSub)
+        : mcastSub{&mcastSub}
+    {}
 
-        UdpSeg udpSeg{SegInfo{SegId{prodIndex, segOffset}, prodSize, segSize},
-                sock};
-        mcastSub->hereIsMcast(udpSeg);
-        sock.discard();
+    /**
+     * Decodes a datagram and passes the result to the subscriber. Unknown and
+     * malformed datagrams are ignored.
+     *
+     * @param[in] buf     Datagram
+     * @param[in] nbytes  Size of datagram in bytes
+     */
+    void dispatch(
+            const uint8_t* buf,
+            const size_t   nbytes)
+    {
+        if (nbytes < McastProto::PROD_INFO_HDR_LEN)
+            return;
 
-        return true;
+        const MsgIdType msgId = get16(buf, 0);
+        if (msgId == MsgId::PROD_INFO) {
+            recvProdInfo(buf, nbytes);
+        }
+        else if (msgId == MsgId::DATA_SEG) {
+            recvDataSeg(buf, nbytes);
+        }
     }
 
 public:
-    Impl(   const SrcMcastAddrs& srcMcastInfo,
-            McastSub&            mcastSub)
-        : sock{srcMcastInfo.grpAddr, srcMcastInfo.srcAddr}
-        , mcastSub{&mcastSub}
+    virtual ~Impl() noexcept
     {}
 
     /**
      * Returns on EOF.
      */
-    void operator()()
+    virtual void operator()() =0;
+
+    /**
+     * Causes `operator()()` to return.
+     */
+    virtual void halt() =0;
+
+    virtual uint64_t getNumDrops() const =0;
+};
+
+/**
+ * Multicast receiver that uses a UDP socket. Kernel coalescing of datagrams
+ * (UDP GRO) is used if available, so one system call can return many
+ * datagrams.
+ */
+class McastRcvr::SockImpl final : public McastRcvr::Impl
+{
+    UdpSock              sock;
+    std::vector<uint8_t> buf; ///< Receive buffer
+
+public:
+    SockImpl(
+            const SrcMcastAddrs& srcMcastInfo,
+            McastSub&            mcastSub)
+        : Impl(mcastSub)
+        , sock{srcMcastInfo.grpAddr, srcMcastInfo.srcAddr}
+        , buf()
+    {
+        if (sock.enableGro()) {
+            buf.resize(UINT16_MAX); // Maximum size of a coalesced run
+        }
+        else {
+            LOG_DEBUG("UDP GRO is unavailable");
+            buf.resize(UdpSock::MAX_PAYLOAD);
+        }
+    }
+
+    void operator()() override
     {
         try {
-            for (;;) {
-                MsgIdType msgId;
-                sock.addPeek(msgId);
-                if (!sock.peek())
-                    break; // EOF or `sock.halt()` called
-
-                if (msgId == MsgId::PROD_INFO) {
-                    if (!recvProdInfo())
-                        break;
-                }
-                else if (msgId == MsgId::DATA_SEG) {
-                    if (!recvDataSeg())
-                        break;
-                }
-
-                sock.discard();
-            } // Indefinite loop
+            size_t segSize;
+            size_t nbytes;
+
+            while ((nbytes = sock.read(buf.data(), buf.size(), segSize))) {
+                // Split a coalesced run into its datagrams
+                for (size_t offset = 0; offset < nbytes; offset += segSize)
+                    dispatch(buf.data() + offset,
+                            std::min(segSize, nbytes - offset));
+            }
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(
@@ -221,22 +364,103 @@ public:
     }
 
     /**
-     * Causes `operator()()` to return.
-     *
      * @throws    SystemError      `::shutdown()` failure
      */
-    void halt()
+    void halt() override
     {
         sock.shutdown();
     }
+
+    uint64_t getNumDrops() const override
+    {
+        return 0;
+    }
+};
+
+/**
+ * Multicast receiver that decodes datagrams in place in a receive ring (e.g.,
+ * `PacketRing`, `XdpRing`).
+ *
+ * @tparam Ring  Type of receive ring
+ */
+template<class Ring>
+class McastRcvr::RingImpl final : public McastRcvr::Impl
+{
+    Ring ring;
+
+public:
+    RingImpl(
+            McastSub&   mcastSub,
+            const Ring& ring)
+        : Impl(mcastSub)
+        , ring(ring)
+    {}
+
+    void operator()() override
+    {
+        try {
+            const void* data;
+            size_t      nbytes;
+
+            while (ring.next(data, nbytes))
+                dispatch(static_cast<const uint8_t*>(data), nbytes);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(
+                    RUNTIME_ERROR("Multicast reception failure"));
+        }
+    }
+
+    void halt() override
+    {
+        ring.halt();
+    }
+
+    uint64_t getNumDrops() const override
+    {
+        return ring.getStats().drops;
+    }
 };
 
 McastRcvr::McastRcvr(
         const SrcMcastAddrs& srcMcastInfo,
         McastSub&            mcastSub)
-    : pImpl{new Impl(srcMcastInfo, mcastSub)}
+    : pImpl{new SockImpl(srcMcastInfo, mcastSub)}
 {}
 
+McastRcvr::McastRcvr(
+        const SrcMcastAddrs& srcMcastInfo,
+        McastSub&            mcastSub,
+        const std::string&   ifaceName,
+        const bool           useXdp)
+    : pImpl{}
+{
+    if (useXdp) {
+        try {
+            const unsigned numQueues = XdpRing::getNumRxQueues(ifaceName);
+            if (numQueues > 1)
+                throw RUNTIME_ERROR("Interface " + ifaceName + " has " +
+                        std::to_string(numQueues) + " receive queues, but "
+                        "AF_XDP would only receive from the first");
+
+            pImpl.reset(new RingImpl<XdpRing>(mcastSub,
+                    XdpRing(srcMcastInfo.grpAddr, srcMcastInfo.srcAddr,
+                            ifaceName)));
+            LOG_INFO("Receiving multicast via AF_XDP on interface %s",
+                    ifaceName.data());
+            return;
+        }
+        catch (const std::exception& ex) {
+            log_info(ex);
+            LOG_INFO("AF_XDP is unavailable. Using packet ring.");
+        }
+    }
+
+    pImpl.reset(new RingImpl<PacketRing>(mcastSub,
+            PacketRing(srcMcastInfo.grpAddr, srcMcastInfo.srcAddr,
+                    ifaceName)));
+}
+
 void McastRcvr::operator()()
 {
     pImpl->operator()();
@@ -247,4 +471,9 @@ void McastRcvr::halt()
     pImpl->halt();
 }
 
+uint64_t McastRcvr::getNumDrops() const
+{
+    return pImpl->getNumDrops();
+}
+
 } // namespace
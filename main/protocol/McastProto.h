@@ -27,7 +27,9 @@
 #include "Socket.h"
 #include "hycast.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 namespace hycast {
 
@@ -50,6 +52,19 @@ class McastProto
 public:
     /// Maximum size of a data-segment in bytes
     static const int MAX_SEGSIZE = UdpSock::MAX_PAYLOAD - 12;
+    /**
+     * Size in bytes of a product-information datagram without the product's
+     * name: message ID, name length, product index, and product size
+     */
+    static const size_t PROD_INFO_HDR_LEN = 2*sizeof(uint16_t) +
+            2*sizeof(uint32_t);
+    /**
+     * Size in bytes of a data-segment datagram without the segment's data:
+     * message ID, segment size, product index, product size, and segment
+     * offset
+     */
+    static const size_t DATA_SEG_HDR_LEN = 2*sizeof(uint16_t) +
+            3*sizeof(uint32_t);
 };
 
 /******************************************************************************/
@@ -108,6 +123,50 @@ public:
      * @cancellationpoint       Yes
      */
     void multicast(const MemSeg& seg);
+
+    /**
+     * Enables zero-copy multicasting of data-segments by
+     * `multicast(const MemSeg&, const UdpSock::Pin&)`.
+     *
+     * @retval    `true`       Success
+     * @retval    `false`      The kernel doesn't support zero-copy writing
+     * @throws    SystemError  System failure
+     * @see `UdpSock::enableZeroCopy()`
+     */
+    bool enableZeroCopy() const;
+
+    /**
+     * Sets the maximum multicast rate. Multicasting blocks as necessary to not
+     * exceed it. The default is no maximum.
+     *
+     * @param[in] rate  Maximum rate in bytes per second. 0 means no maximum.
+     * @threadsafety    Safe
+     * @see `McastRateCtl`
+     */
+    void setRate(const double rate) const;
+
+    /**
+     * Returns the maximum multicast rate.
+     *
+     * @return          Maximum rate in bytes per second. 0 means no maximum.
+     * @threadsafety    Safe
+     */
+    double getRate() const noexcept;
+
+    /**
+     * Multicasts a data-segment. If zero-copy multicasting is enabled, then
+     * the segment's data isn't copied by the kernel and `pin` is kept until
+     * the kernel is done with it.
+     *
+     * @param[in] seg           Data segment
+     * @param[in] pin           Keeps the segment's data valid
+     * @throws    SystemError   I/O failure
+     * @cancellationpoint       Yes
+     * @see `UdpSock::write(const UdpSock::Pin&)`
+     */
+    void multicast(
+            const MemSeg&       seg,
+            const UdpSock::Pin& pin);
 };
 
 /******************************************************************************/
@@ -123,7 +182,15 @@ public:
 
     virtual bool hereIsMcast(const ProdInfo& prodInfo) =0;
 
-    virtual bool hereIsMcast(UdpSeg& seg) =0;
+    /**
+     * Processes a multicast data-segment. The segment's data is only valid
+     * during this call.
+     *
+     * @param[in] seg      Data-segment
+     * @retval    `true`   Data-segment is new
+     * @retval    `false`  Data-segment is old
+     */
+    virtual bool hereIsMcast(DataSeg& seg) =0;
 };
 
 /******************************************************************************/
@@ -134,11 +201,14 @@ public:
 class McastRcvr
 {
     class                 Impl;
+    class                 SockImpl;
+    template<class Ring>
+    class                 RingImpl;
     std::shared_ptr<Impl> pImpl;
 
 public:
     /**
-     * Constructs.
+     * Constructs. Datagrams are received via a UDP socket.
      *
      * @param[in] srcMcastInfo  Source-specific multicast information
      * @param[in] mcastSub      Subscriber of multicast products
@@ -148,6 +218,29 @@ public:
             const SrcMcastAddrs& srcMcastInfo,
             McastSub&            mcastSub);
 
+    /**
+     * Constructs. Datagrams are received on the given interface and decoded in
+     * place, which avoids a system call and copy per datagram. A memory-mapped
+     * packet ring is used unless AF_XDP is requested. An AF_XDP socket, which
+     * also bypasses the kernel's network stack, only receives from the
+     * interface's first receive queue; so, it's used only if the interface has
+     * a single receive queue. Requires IPv4 and the `CAP_NET_RAW` capability
+     * (plus `CAP_NET_ADMIN` for AF_XDP).
+     *
+     * @param[in] srcMcastInfo  Source-specific multicast information
+     * @param[in] mcastSub      Subscriber of multicast products
+     * @param[in] ifaceName     Name of the receiving interface (e.g., "eth0")
+     * @param[in] useXdp        Whether to try AF_XDP first
+     * @throws    SystemError   System failure (e.g., lack of `CAP_NET_RAW`)
+     * @see `XdpRing`
+     * @see `PacketRing`
+     */
+    McastRcvr(
+            const SrcMcastAddrs& srcMcastInfo,
+            McastSub&            mcastSub,
+            const std::string&   ifaceName,
+            const bool           useXdp = false);
+
     /**
      * Executes the multicast receiver. Calls this instance's observer. Returns
      * on EOF.
@@ -165,6 +258,15 @@ public:
      * @cancellationpoint    No
      */
     void halt();
+
+    /**
+     * Returns the number of datagrams dropped by the kernel because they
+     * weren't read fast enough. Always zero for a socket-based receiver.
+     *
+     * @return               Number of dropped datagrams
+     * @throws SystemError   System failure
+     */
+    uint64_t getNumDrops() const;
 };
 
 } // namespace
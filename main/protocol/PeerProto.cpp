@@ -73,6 +73,8 @@ protected:
     static const MsgIdType     DATA_SEG = MsgId::DATA_SEG;
     static const MsgIdType     PATH_TO_SRC = MsgId::PATH_TO_PUB;
     static const MsgIdType     NO_PATH_TO_SRC = MsgId::NO_PATH_TO_PUB;
+    static const MsgIdType     MCAST_REPORT = MsgId::MCAST_REPORT;
+    static const uint32_t      PPM = 1000000; ///< Denominator of loss-rate
 
     void init()
     {
@@ -164,6 +166,23 @@ protected:
         }
     }
 
+    bool recvReport()
+    {
+        uint32_t lossPpm;
+        uint64_t rcvRate;
+
+        // The following perform network translation
+        if (!srvrSock.read(lossPpm) || !srvrSock.read(rcvRate))
+            return false;
+
+        const double lossRate = static_cast<double>(lossPpm)/PPM;
+        LOG_DEBUG("Received multicast report: lossRate=%g, rcvRate=%g",
+                lossRate, static_cast<double>(rcvRate));
+        sendPeer.recvReport(lossRate, rcvRate);
+
+        return true;
+    }
+
     /**
      * Returns on EOF.
      */
@@ -186,6 +205,10 @@ protected:
                     if (!recvSegReq())
                         break;
                 }
+                else if (msgId == MCAST_REPORT) {
+                    if (!recvReport())
+                        break;
+                }
                 else {
                     throw RUNTIME_ERROR("Invalid message ID: " +
                             std::to_string(msgId));
@@ -521,8 +544,25 @@ public:
      * @cancellationpoint    Yes
      */
     virtual void request(SegId segId) =0;
+
+    /**
+     * Sends a summary of the local node's reception of the multicast to the
+     * remote peer.
+     *
+     * @param[in] lossRate   Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate    Receive-rate in bytes per second
+     * @cancellationpoint    Yes
+     */
+    virtual void report(
+            double lossRate,
+            double rcvRate) =0;
 };
 
+void SendPeer::recvReport(
+        const double,
+        const double) {
+}
+
 PeerProto::operator bool() const {
     return pImpl.operator bool();
 }
@@ -575,6 +615,12 @@ void PeerProto::request(const SegId segId) const {
     pImpl->request(segId);
 }
 
+void PeerProto::report(
+        const double lossRate,
+        const double rcvRate) const {
+    pImpl->report(lossRate, rcvRate);
+}
+
 void PeerProto::gotPath() const {
     pImpl->gotPath();
 }
@@ -666,6 +712,13 @@ public:
     {
         throw LOGIC_ERROR("Invalid action for a publisher");
     }
+
+    void report(
+            const double lossRate,
+            const double rcvRate)
+    {
+        throw LOGIC_ERROR("Invalid action for a publisher");
+    }
 };
 
 PeerProto::PeerProto(
@@ -683,6 +736,7 @@ class SubPeerProto final : public PeerProto::Impl
 {
 protected:
     TcpSock     clntSock;       ///< Requesting and receiving chunks
+    Mutex       clntMutex;      ///< Serializes writing to `clntSock`
     RecvPeer&   recvPeer;       ///< Receiving peer
     std::thread rcvNoteThread;  ///< Receiving and processing notices
     std::thread rcvChunkThread; ///< Receiving and processing chunks
@@ -970,6 +1024,7 @@ public:
                 //recvPeer.asSendPeer())
                 *reinterpret_cast<SendPeer*>(&recvPeer))
         , clntSock{}
+        , clntMutex{}
         , recvPeer(recvPeer)
         , rcvNoteThread{}
         , rcvChunkThread{}
@@ -1008,6 +1063,7 @@ public:
                 //recvPeer.asSendPeer())
                 *reinterpret_cast<SendPeer*>(&recvPeer))
         , clntSock{}
+        , clntMutex{}
         , recvPeer(recvPeer)
         , rcvNoteThread{}
         , rcvChunkThread{}
@@ -1080,13 +1136,32 @@ public:
 
     void request(const ProdIndex prodIndex)
     {
+        Guard guard{clntMutex};
         send(PROD_INFO_REQUEST, prodIndex, clntSock);
     }
 
     void request(const SegId segId)
     {
+        Guard guard{clntMutex};
         send(DATA_SEG_REQUEST, segId, clntSock);
     }
+
+    /**
+     * Sends a multicast report on the requesting socket because that's the
+     * one the remote peer reads for requests.
+     */
+    void report(
+            const double lossRate,
+            const double rcvRate)
+    {
+        LOG_DEBUG("Sending multicast report: lossRate=%g, rcvRate=%g",
+                lossRate, rcvRate);
+        Guard guard{clntMutex};
+        // The following perform network translation
+        clntSock.write(MCAST_REPORT);
+        clntSock.write(static_cast<uint32_t>(lossRate*PPM + 0.5));
+        clntSock.write(static_cast<uint64_t>(rcvRate + 0.5));
+    }
 };
 
 PeerProto::PeerProto(
@@ -56,6 +56,18 @@ public:
      * @param[in] segId  Identifier of data-segment
      */
     virtual void sendMe(const SegId& segId) =0;
+
+    /**
+     * Handles a summary of the remote subscriber's reception of the multicast.
+     * The publisher uses it to adapt its multicast rate. This default does
+     * nothing.
+     *
+     * @param[in] lossRate  Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate   Receive-rate in bytes per second
+     */
+    virtual void recvReport(
+            const double lossRate,
+            const double rcvRate);
 };
 
 /**
@@ -312,6 +324,19 @@ public:
      * @cancellationpoint     Yes
      */
     void request(SegId segId) const;
+
+    /**
+     * Sends a summary of the local node's reception of the multicast to the
+     * remote peer.
+     *
+     * @param[in] lossRate    Loss-rate of data-segments in [0, 1]
+     * @param[in] rcvRate     Receive-rate in bytes per second
+     * @throws    LogicError  This instance is a publisher
+     * @cancellationpoint     Yes
+     */
+    void report(
+            double lossRate,
+            double rcvRate) const;
 };
 
 } // namespace
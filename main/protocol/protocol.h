@@ -35,7 +35,8 @@ typedef enum {
     PROD_INFO,
     DATA_SEG,
     PATH_TO_PUB,
-    NO_PATH_TO_PUB
+    NO_PATH_TO_PUB,
+    MCAST_REPORT
 } MsgId;
 
 } // namespace
@@ -0,0 +1,257 @@
+/**
+ * Group-commit of completed product-files to stable storage.
+ *
+ *        File: GroupSync.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "GroupSync.h"
+
+#include "error.h"
+#include "logging.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace hycast {
+
+class GroupSync::Impl
+{
+    using Mutex     = std::mutex;
+    using Guard     = std::lock_guard<Mutex>;
+    using Lock      = std::unique_lock<Mutex>;
+    using Cond      = std::condition_variable;
+    using Thread    = std::thread;
+    using Clock     = std::chrono::steady_clock;
+    using Pathnames = std::vector<std::string>;
+
+    mutable Mutex         mutex;
+    Cond                  cond;
+    const int             rootFd;
+    const StoragePolicy   policy;
+    const Clock::duration groupDelay;
+    Pathnames             pending;  ///< Files of the next group
+    Clock::time_point     deadline; ///< When the next group is due
+    unsigned              flushers; ///< Number of threads in `flush()`
+    bool                  syncing;  ///< A group is being synchronized?
+    bool                  done;     ///< Background thread should exit?
+    uint64_t              numFiles;
+    uint64_t              numGroups;
+    Thread                thread;
+
+    /**
+     * Synchronizes a group of files with stable storage. Failures are logged
+     * because the files' data is still in the page cache and the receiving
+     * threads can't do anything about it.
+     *
+     * @param[in] group  Pathnames of the files
+     * @return           Number of files that were synchronized. Excludes
+     *                   files that no longer exist.
+     */
+    size_t sync(const Pathnames& group) const {
+        std::vector<std::pair<int, const std::string*>> files; // Open files
+        files.reserve(group.size());
+
+        // Start writeback of the whole group before waiting on any of it
+        for (const auto& pathname : group) {
+            const int fd = ::openat(rootFd, pathname.data(), O_RDONLY);
+            if (fd == -1) {
+                if (errno != ENOENT)
+                    LOG_WARN("Couldn't open product-file \"%s\": %s",
+                            pathname.data(), ::strerror(errno));
+                continue;
+            }
+            if (::sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE))
+                LOG_WARN("sync_file_range() failure on \"%s\": %s",
+                        pathname.data(), ::strerror(errno));
+            files.push_back(std::make_pair(fd, &pathname));
+        }
+
+        for (const auto& file : files) {
+            if (policy.sync == StoragePolicy::Sync::DATASYNC &&
+                    ::fdatasync(file.first))
+                LOG_ERROR("fdatasync() failure on \"%s\": %s",
+                        file.second->data(), ::strerror(errno));
+            ::close(file.first);
+        }
+
+        return files.size();
+    }
+
+    /**
+     * Indicates if the next group should be synchronized now.
+     *
+     * @pre            Mutex is locked
+     * @retval `true`  It should
+     * @retval `false` It shouldn't
+     * @post           Mutex is locked
+     */
+    bool isReady() const noexcept {
+        return pending.size() >= policy.groupSize || flushers || done ||
+                Clock::now() >= deadline;
+    }
+
+    /**
+     * Synchronizes groups of files. Executes on the background thread. Doesn't
+     * return until `done` is set and every added file has been synchronized.
+     */
+    void run() {
+        Lock lock{mutex};
+
+        for (;;) {
+            if (pending.empty()) {
+                if (done)
+                    break;
+                cond.wait(lock);
+                continue;
+            }
+            if (!isReady()) {
+                cond.wait_until(lock, deadline);
+                continue;
+            }
+
+            Pathnames group{};
+            group.swap(pending);
+            syncing = true;
+            lock.unlock();
+
+            const auto count = sync(group);
+
+            lock.lock();
+            syncing = false;
+            numFiles += count;
+            ++numGroups;
+            cond.notify_all();
+        }
+    }
+
+public:
+    Impl(   const int            rootFd,
+            const StoragePolicy& policy)
+        : mutex()
+        , cond()
+        , rootFd(rootFd)
+        , policy(policy)
+        , groupDelay(std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(policy.groupDelay)))
+        , pending()
+        , deadline()
+        , flushers(0)
+        , syncing(false)
+        , done(false)
+        , numFiles(0)
+        , numGroups(0)
+        , thread()
+    {
+        if (policy.sync == StoragePolicy::Sync::NONE)
+            throw INVALID_ARGUMENT("Synchronization is disabled");
+        if (policy.groupSize == 0)
+            throw INVALID_ARGUMENT("Group size is zero");
+
+        pending.reserve(policy.groupSize);
+
+        try {
+            thread = Thread(&Impl::run, this);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(
+                    RUNTIME_ERROR("Couldn't create synchronization thread"));
+        }
+    }
+
+    /**
+     * Destroys. Doesn't return until every added file has been synchronized.
+     */
+    ~Impl() noexcept {
+        {
+            Guard guard{mutex};
+            done = true;
+            cond.notify_all();
+        }
+        thread.join();
+    }
+
+    void add(const std::string& pathname) {
+        Guard guard{mutex};
+
+        if (pending.empty())
+            deadline = Clock::now() + groupDelay;
+        pending.push_back(pathname);
+        cond.notify_all();
+    }
+
+    void flush() {
+        Lock lock{mutex};
+
+        ++flushers;
+        cond.notify_all();
+        while (!pending.empty() || syncing)
+            cond.wait(lock);
+        --flushers;
+    }
+
+    uint64_t getNumFiles() const {
+        Guard guard{mutex};
+        return numFiles;
+    }
+
+    uint64_t getNumGroups() const {
+        Guard guard{mutex};
+        return numGroups;
+    }
+};
+
+/******************************************************************************/
+
+GroupSync::GroupSync(
+        const int            rootFd,
+        const StoragePolicy& policy)
+    : pImpl{std::make_shared<Impl>(rootFd, policy)}
+{}
+
+GroupSync::operator bool() const noexcept {
+    return static_cast<bool>(pImpl);
+}
+
+void GroupSync::add(const std::string& pathname) const {
+    pImpl->add(pathname);
+}
+
+void GroupSync::flush() const {
+    pImpl->flush();
+}
+
+uint64_t GroupSync::getNumFiles() const {
+    return pImpl->getNumFiles();
+}
+
+uint64_t GroupSync::getNumGroups() const {
+    return pImpl->getNumGroups();
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+/**
+ * Group-commit of completed product-files to stable storage.
+ *
+ *        File: GroupSync.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_REPOSITORY_GROUPSYNC_H_
+#define MAIN_REPOSITORY_GROUPSYNC_H_
+
+#include "ProdFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hycast {
+
+/**
+ * Thread-safe synchronizer of completed product-files with stable storage. A
+ * background thread synchronizes the files in groups: writeback of every file
+ * in a group is started before any of them is waited on, so the device sees
+ * the group's writes together and the receiving threads never wait on it. A
+ * group is synchronized when it has `StoragePolicy::groupSize` files or its
+ * first file has waited `StoragePolicy::groupDelay` seconds.
+ *
+ * Files are referenced by pathname, so a file needn't stay open until it's
+ * synchronized. A file that's deleted before then is skipped.
+ */
+class GroupSync final
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /**
+     * Default constructs. The resulting instance will test false and must not
+     * be used.
+     */
+    GroupSync() =default;
+
+    /**
+     * Constructs. Starts the background thread.
+     *
+     * @param[in] rootFd           File descriptor open on the root directory
+     *                             of the repository. Must remain open for the
+     *                             lifetime of this instance.
+     * @param[in] policy           Durability policy
+     * @throws    InvalidArgument  `policy.sync == StoragePolicy::Sync::NONE`
+     *                             or `policy.groupSize == 0`
+     * @throws    RuntimeError     Couldn't create background thread
+     */
+    GroupSync(
+            const int            rootFd,
+            const StoragePolicy& policy);
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Adds a completed product-file to be synchronized.
+     *
+     * @param[in] pathname  Pathname of the file relative to the root
+     *                      directory
+     * @threadsafety        Safe
+     */
+    void add(const std::string& pathname) const;
+
+    /**
+     * Synchronizes every added product-file now. Doesn't return until they've
+     * been synchronized.
+     *
+     * @threadsafety  Safe
+     */
+    void flush() const;
+
+    /**
+     * Returns the number of product-files that have been synchronized.
+     *
+     * @return        Number of synchronized files
+     * @threadsafety  Safe
+     */
+    uint64_t getNumFiles() const;
+
+    /**
+     * Returns the number of groups that have been synchronized.
+     *
+     * @return        Number of synchronized groups
+     * @threadsafety  Safe
+     */
+    uint64_t getNumGroups() const;
+};
+
+} // namespace
+
+#endif /* MAIN_REPOSITORY_GROUPSYNC_H_ */
@@ -28,8 +28,13 @@
 #include "FileUtil.h"
 #include "Thread.h"
 
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
 #include <fcntl.h>
+#include <linux/fs.h>
 #include <mutex>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -70,6 +75,8 @@ protected:
     int               fd;
     const SegSize     segSize;
     const SegSize     lastSegSize;
+    unsigned          pins;         ///< Number of outstanding pins
+    bool              closePending; ///< Close when last pin is released?
 
     /**
      * Opens an existing file.
@@ -151,6 +158,8 @@ protected:
         , lastSegSize{static_cast<SegSize>(segSize
                 ? (prodSize%segSize ? prodSize%segSize : segSize)
                 : 0)}
+        , pins{0}
+        , closePending{false}
     {
         if (prodSize && segSize == 0)
             throw INVALID_ARGUMENT("Zero segment-size specified for "
@@ -170,6 +179,8 @@ protected:
             const int mode) {
         const bool wasClosed = fd < 0;
 
+        closePending = false;
+
         if (wasClosed) {
             fd = open(rootFd, pathname, mode);
             if (fd == -1)
@@ -258,7 +269,37 @@ public:
 
     void close() {
         Guard guard(mutex);
-        disableAccess();
+        if (pins) {
+            closePending = true;
+        }
+        else {
+            disableAccess();
+        }
+    }
+
+    /**
+     * Keeps the data of the underlying file accessible until the returned
+     * object and all its copies are destroyed, even if `close()` is called.
+     *
+     * @param[in] impl  This instance
+     * @return          Pin of the file's data
+     */
+    static std::shared_ptr<const void> pin(const std::shared_ptr<Impl>& impl) {
+        {
+            Guard guard(impl->mutex);
+            ++impl->pins;
+        }
+        return std::shared_ptr<const void>(impl->data, [impl](const void*) {
+            impl->unpin();
+        });
+    }
+
+    void unpin() noexcept {
+        Guard guard(mutex);
+        if (--pins == 0 && closePending) {
+            closePending = false;
+            disableAccess();
+        }
     }
 
     /**
@@ -321,6 +362,10 @@ void ProdFile::close() const {
     return pImpl->close();
 }
 
+std::shared_ptr<const void> ProdFile::pin() const {
+    return Impl::pin(pImpl);
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -383,25 +428,143 @@ bool SndProdFile::exists(ProdSize offset) const {
  */
 class RcvProdFile::Impl final : public ProdFile::Impl
 {
+    using Word = uint64_t;
+
+    /// Number of bits in a bitmap word
+    static const unsigned WORD_BITS = 64;
+
     ProdIndex         prodIndex;  ///< Product index
-    std::vector<bool> haveSegs;   ///< Bitmap of set data-segments
+    std::vector<Word> haveSegs;   ///< Bitmap of set data-segments. Bits
+                                  ///< beyond the last segment are set.
     ProdSize          segCount;   ///< Number of set data-segments
     bool              pathIsName; ///< File pathname is product name?
 
+    /**
+     * Returns the bitmap of a product. Bits beyond the last data-segment are
+     * set so that scans stop there.
+     *
+     * @param[in] numSegs  Number of data-segments
+     * @return             Bitmap with no data-segments set
+     */
+    static std::vector<Word> makeBitmap(const ProdSize numSegs) {
+        std::vector<Word> bitmap((numSegs + WORD_BITS - 1) / WORD_BITS, 0);
+        if (numSegs % WORD_BITS)
+            bitmap.back() = ~static_cast<Word>(0) << (numSegs % WORD_BITS);
+        return bitmap;
+    }
+
+    inline bool isSet(const ProdSize iSeg) const noexcept {
+        return (haveSegs[iSeg/WORD_BITS] >> (iSeg%WORD_BITS)) & 1;
+    }
+
+    inline void set(const ProdSize iSeg) noexcept {
+        haveSegs[iSeg/WORD_BITS] |= static_cast<Word>(1) << (iSeg%WORD_BITS);
+    }
+
+    /**
+     * Returns the index of the first data-segment at or after a given one
+     * whose bit has a given value. Whole words that can't contain such a bit
+     * are skipped.
+     *
+     * @pre                State is locked
+     * @param[in] iSeg     Index of data-segment at which to start
+     * @param[in] value    Bit value to find
+     * @return             Index of the data-segment. Will be `numSegs` if
+     *                     none.
+     */
+    ProdSize find(const ProdSize iSeg, const bool value) const noexcept {
+        const Word flip = value ? 0 : ~static_cast<Word>(0);
+        size_t     iWord = iSeg / WORD_BITS;
+
+        if (iWord >= haveSegs.size())
+            return numSegs;
+
+        // Bits of the first word before `iSeg` are ignored
+        Word bits = (haveSegs[iWord] ^ flip) &
+                (~static_cast<Word>(0) << (iSeg % WORD_BITS));
+
+        while (bits == 0) {
+            if (++iWord == haveSegs.size())
+                return numSegs;
+            bits = haveSegs[iWord] ^ flip;
+        }
+
+        const ProdSize i = iWord*WORD_BITS + __builtin_ctzll(bits);
+        return i < numSegs ? i : numSegs;
+    }
+
+    /**
+     * Sets the extent-size hint of an empty file so that the file-system
+     * allocates its blocks in extents of that size. A file-system that doesn't
+     * support the hint is ignored because the hint is advisory.
+     *
+     * @param[in] fd          File descriptor open on empty file
+     * @param[in] extentSize  Extent size in bytes
+     */
+    static void setExtentSize(
+            const int    fd,
+            const size_t extentSize) noexcept
+    {
+#ifdef FS_IOC_FSSETXATTR
+        struct fsxattr attr;
+
+        if (::ioctl(fd, FS_IOC_FSGETXATTR, &attr) == 0) {
+            attr.fsx_xflags |= FS_XFLAG_EXTSIZE;
+            attr.fsx_extsize = extentSize;
+            if (::ioctl(fd, FS_IOC_FSSETXATTR, &attr) == 0)
+                return;
+        }
+        LOG_DEBUG("Extent-size hint not set: %s", ::strerror(errno));
+#endif
+    }
+
+    /**
+     * Sets the size of a new file.
+     *
+     * @param[in] fd            File descriptor open on empty file
+     * @param[in] pathname      Pathname of file
+     * @param[in] prodSize      Size of file in bytes
+     * @param[in] alloc         When the file's blocks are allocated. The
+     *                          blocks are allocated as data arrives if the
+     *                          file-system or kernel doesn't support
+     *                          preallocation.
+     * @throws    SYSTEM_ERROR  `ftruncate()` or `fallocate()` failure
+     */
+    static void setSize(
+            const int                  fd,
+            const std::string&         pathname,
+            const ProdSize             prodSize,
+            const StoragePolicy::Alloc alloc)
+    {
+        if (alloc == StoragePolicy::Alloc::PREALLOC && prodSize) {
+            if (::fallocate(fd, 0, 0, prodSize) == 0)
+                return;
+            if (errno != EOPNOTSUPP && errno != ENOSYS)
+                throw SYSTEM_ERROR("fallocate() failure on \"" + pathname +
+                        "\"");
+        }
+
+        if (::ftruncate(fd, prodSize))
+            throw SYSTEM_ERROR("ftruncate() failure on \"" + pathname + "\"");
+    }
+
     /**
      * Creates a file from product-information. The file will have the given
      * size and be zero-filled.
      *
      * @param[in] rootFd        File descriptor open on root directory
-     * @param[in] prodInfo      Product-information
-     * @param[in] segSize       Size of canonical segment in bytes
+     * @param[in] pathname      Pathname of file
+     * @param[in] prodSize      Size of file in bytes
+     * @param[in] policy        Layout policy
      * @return                  File descriptor on open file
-     * @throws    SYSTEM_ERROR  `open()` or `ftruncate()` failure
+     * @throws    SYSTEM_ERROR  `open()`, `ftruncate()`, or `fallocate()`
+     *                          failure
      */
     static int create(
-            const int          rootFd,
-            const std::string& pathname,
-            const ProdSize&    prodSize)
+            const int            rootFd,
+            const std::string&   pathname,
+            const ProdSize&      prodSize,
+            const StoragePolicy& policy)
     {
         ensureDir(rootFd, dirPath(pathname), 0700);
 
@@ -411,14 +574,14 @@ class RcvProdFile::Impl final : public ProdFile::Impl
             throw SYSTEM_ERROR("Couldn't create file \"" + pathname + "\"");
 
         try {
-            if (::ftruncate(fd, prodSize))
-                throw SYSTEM_ERROR("ftruncate() failure on \"" + pathname +
-                        "\"");
+            if (policy.extentSize)
+                setExtentSize(fd, policy.extentSize);
+            setSize(fd, pathname, prodSize, policy.alloc);
             return fd;
         } // `fd` is open
         catch (...) {
             ::close(fd);
-            ::unlink(pathname.data());
+            ::unlinkat(rootFd, pathname.data(), 0);
             throw;
         }
     }
@@ -447,20 +610,23 @@ public:
      * @param[in] prodIndex        Product index
      * @param[in] prodSize         Product size in bytes
      * @param[in] segSize          Canonical segment size in bytes
+     * @param[in] policy           Layout policy
      * @throws    InvalidArgument  `prodSize != 0 && segSize == 0`
-     * @throws    SystemError      `open()` or `ftruncate()` failure
+     * @throws    SystemError      `open()`, `ftruncate()`, or `fallocate()`
+     *                             failure
      */
-    Impl(   const int       rootFd,
-            const ProdIndex prodIndex,
-            const ProdSize  prodSize,
-            const SegSize   segSize)
+    Impl(   const int            rootFd,
+            const ProdIndex      prodIndex,
+            const ProdSize       prodSize,
+            const SegSize        segSize,
+            const StoragePolicy& policy)
         : ProdFile::Impl{prodIndex.to_string(), prodSize, segSize}
         , prodIndex(prodIndex)
-        , haveSegs(numSegs, false)
+        , haveSegs(makeBitmap(numSegs))
         , segCount{0}
         , pathIsName(false)
     {
-        fd = create(rootFd, pathname, prodSize);
+        fd = create(rootFd, pathname, prodSize, policy);
         ensureAccess(rootFd, O_RDWR);
     }
 
@@ -472,7 +638,21 @@ public:
     bool exists(const ProdSize offset) const {
         vet(offset);
         Guard guard(mutex);
-        return haveSegs[segIndex(offset)];
+        return isSet(segIndex(offset));
+    }
+
+    SegRanges getMissing(const size_t maxRanges) const {
+        SegRanges ranges{};
+        Guard     guard(mutex);
+
+        for (ProdSize iSeg = find(0, false);
+                iSeg < numSegs && ranges.size() < maxRanges; ) {
+            const auto end = find(iSeg, true);
+            ranges.push_back(SegRange{iSeg*segSize, end - iSeg});
+            iSeg = find(end, false);
+        }
+
+        return ranges;
     }
 
     /**
@@ -563,13 +743,13 @@ public:
         {
             Guard guard(mutex);
 
-            wasSaved = !haveSegs[iSeg];
+            wasSaved = !isSet(iSeg);
 
             if (!wasSaved) {
                 LOG_WARN("Duplicate data segment: " + seg.to_string());
             }
             else {
-                haveSegs[iSeg] = true;
+                set(iSeg);
             }
         }
 
@@ -601,11 +781,13 @@ public:
 RcvProdFile::RcvProdFile() noexcept =default;
 
 RcvProdFile::RcvProdFile(
-        const int       rootFd,
-        const ProdIndex prodIndex,
-        const ProdSize  prodSize,
-        const SegSize   segSize)
-    : ProdFile(std::make_shared<Impl>(rootFd, prodIndex, prodSize, segSize)) {
+        const int            rootFd,
+        const ProdIndex      prodIndex,
+        const ProdSize       prodSize,
+        const SegSize        segSize,
+        const StoragePolicy& policy)
+    : ProdFile(std::make_shared<Impl>(rootFd, prodIndex, prodSize, segSize,
+            policy)) {
 }
 
 void RcvProdFile::open(const int rootFd) const {
@@ -621,6 +803,10 @@ bool RcvProdFile::isComplete() const {
     return static_cast<Impl*>(pImpl.get())->isComplete();
 }
 
+SegRanges RcvProdFile::getMissing(const size_t maxRanges) const {
+    return static_cast<Impl*>(pImpl.get())->getMissing(maxRanges);
+}
+
 bool
 RcvProdFile::save(
         const int       rootFd,
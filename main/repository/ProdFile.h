@@ -25,10 +25,67 @@
 
 #include "hycast.h"
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace hycast {
 
+/**
+ * Range of contiguous data-segments.
+ */
+struct SegRange
+{
+    ProdSize offset; ///< Offset of first data-segment in bytes
+    ProdSize count;  ///< Number of data-segments
+
+    bool operator==(const SegRange& rhs) const noexcept {
+        return offset == rhs.offset && count == rhs.count;
+    }
+};
+
+using SegRanges = std::vector<SegRange>;
+
+/**
+ * Layout and durability policy of a receiver's product-files.
+ */
+struct StoragePolicy
+{
+    /// When the blocks of a product-file are allocated
+    enum class Alloc {
+        SPARSE,  ///< As data-segments arrive (`ftruncate()`)
+        PREALLOC ///< When the file is created (`fallocate()`)
+    };
+
+    /// How a completed product-file is synchronized with stable storage
+    enum class Sync {
+        NONE,      ///< It isn't: the kernel writes it back eventually
+        WRITEBACK, ///< Writeback is started (`sync_file_range()`). Not durable.
+        DATASYNC   ///< Writeback is completed (`fdatasync()`). Durable.
+    };
+
+    Alloc    alloc;      ///< When blocks are allocated
+    size_t   extentSize; ///< Extent-size hint in bytes or 0 for none. Only
+                         ///< some file-systems (e.g., XFS) honor it.
+    Sync     sync;       ///< How completed files are synchronized
+    unsigned groupSize;  ///< Number of completed files synchronized together
+    double   groupDelay; ///< Maximum time, in seconds, that a completed file
+                         ///< waits for its group to fill
+
+    StoragePolicy(
+            const Alloc    alloc = Alloc::SPARSE,
+            const size_t   extentSize = 0,
+            const Sync     sync = Sync::NONE,
+            const unsigned groupSize = 16,
+            const double   groupDelay = 1.0)
+        : alloc(alloc)
+        , extentSize(extentSize)
+        , sync(sync)
+        , groupSize(groupSize)
+        , groupDelay(groupDelay)
+    {}
+};
+
 /**
  * Abstract product-file.
  */
@@ -89,10 +146,23 @@ public:
     virtual void open(const int rootFd) const =0;
 
     /**
-     * Disables access to the underlying file.
+     * Disables access to the underlying file. Deferred while the file's data
+     * is pinned.
      */
     void close() const;
 
+    /**
+     * Pins the data of the underlying file. The data stays accessible until
+     * the returned object and all its copies are destroyed, even if `close()`
+     * is called in the meantime. Used by zero-copy multicasting, where the
+     * kernel references the data after the write returns.
+     *
+     * @return             Pin of the file's data
+     * @threadsafety       Safe
+     * @cancellationpoint  No
+     */
+    std::shared_ptr<const void> pin() const;
+
     /**
      * Indicates if the file contains a particular data-segment.
      *
@@ -176,14 +246,17 @@ public:
      * @param[in] prodIndex        Product index
      * @param[in] prodSize         Product size in bytes
      * @param[in] segSize          Size of canonical data-segment in bytes
+     * @param[in] policy           Layout policy. `policy.sync` is ignored.
      * @throws    InvalidArgument  `prodSize != 0 && segSize == 0`
-     * @throws    SystemError      `open()` or `ftruncate()` failure
+     * @throws    SystemError      `open()`, `ftruncate()`, or `fallocate()`
+     *                             failure
      */
     RcvProdFile(
-            const int       rootFd,
-            const ProdIndex prodIndex,
-            const ProdSize  prodSize,
-            const SegSize   segSize);
+            const int            rootFd,
+            const ProdIndex      prodIndex,
+            const ProdSize       prodSize,
+            const SegSize        segSize,
+            const StoragePolicy& policy = StoragePolicy{});
 
     /**
      * Enables access to the underlying file.
@@ -213,6 +286,19 @@ public:
      */
     bool isComplete() const;
 
+    /**
+     * Returns the ranges of data-segments that are missing. The bitmap of
+     * saved data-segments is scanned a word at a time, so the query is fast
+     * even for large products.
+     *
+     * @param[in] maxRanges  Maximum number of ranges to return
+     * @return               Ranges of missing data-segments in order of
+     *                       increasing offset. Will be empty if the product
+     *                       has all its data-segments.
+     * @threadsafety         Safe
+     */
+    SegRanges getMissing(const size_t maxRanges = SIZE_MAX) const;
+
     /**
      * Saves product information.
      *
@@ -0,0 +1,236 @@
+/**
+ * Compact, thread-safe table of product metadata.
+ *
+ *        File: ProdTable.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "ProdTable.h"
+
+#include "error.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace hycast {
+
+class ProdTable::Impl
+{
+    using Mutex = std::mutex;
+    using Guard = std::lock_guard<Mutex>;
+
+    /// Fixed-size record of a product
+    struct Record {
+        /// Name offset of an empty record
+        static const uint64_t NONE = ~static_cast<uint64_t>(0);
+
+        uint64_t nameOff; ///< Offset of product name in arena
+        uint32_t nameLen; ///< Length of product name in bytes
+        ProdSize size;    ///< Size of product in bytes
+
+        Record()
+            : nameOff(NONE)
+            , nameLen(0)
+            , size(0)
+        {}
+
+        inline bool exists() const noexcept {
+            return nameOff != NONE;
+        }
+    };
+
+    /// Arena size below which it's not compacted
+    static const size_t MIN_ARENA = 65536;
+
+    mutable Mutex         mutex;
+    const ProdIndex::Type maxProds;
+    std::deque<Record>    records;   ///< Window of records
+    ProdIndex::Type       first;     ///< Product-index of first record
+    std::string           arena;     ///< Product names, back-to-back
+    size_t                liveBytes; ///< Bytes of names in the window
+    size_t                numProds;  ///< Number of products in the window
+
+    /**
+     * Returns the record of a product.
+     *
+     * @pre                  Mutex is locked
+     * @param[in] prodIndex  Product index
+     * @return               Record. Will be `nullptr` if the product isn't in
+     *                       the table.
+     * @post                 Mutex is locked
+     */
+    const Record* find(const ProdIndex prodIndex) const {
+        // Unsigned arithmetic handles wrap-around and indexes before `first`
+        const ProdIndex::Type i = prodIndex.getValue() - first;
+        return (i < records.size() && records[i].exists())
+                ? &records[i]
+                : nullptr;
+    }
+
+    /**
+     * Removes the first record.
+     *
+     * @pre   Mutex is locked
+     * @pre   `!records.empty()`
+     * @post  Mutex is locked
+     */
+    void popFront() {
+        const auto& record = records.front();
+        if (record.exists()) {
+            liveBytes -= record.nameLen;
+            --numProds;
+        }
+        records.pop_front();
+        ++first;
+    }
+
+    /**
+     * Removes the names of forgotten products from the arena.
+     *
+     * @pre   Mutex is locked
+     * @post  Mutex is locked
+     */
+    void compact() {
+        std::string names;
+        names.reserve(liveBytes);
+
+        for (auto& record : records) {
+            if (record.exists()) {
+                const auto nameOff = names.size();
+                names.append(arena, record.nameOff, record.nameLen);
+                record.nameOff = nameOff;
+            }
+        }
+
+        arena.swap(names);
+    }
+
+public:
+    Impl(const ProdIndex::Type maxProds)
+        : mutex()
+        , maxProds(maxProds)
+        , records()
+        , first(0)
+        , arena()
+        , liveBytes(0)
+        , numProds(0)
+    {
+        if (maxProds == 0)
+            throw INVALID_ARGUMENT("Maximum number of products is zero");
+    }
+
+    bool add(const ProdInfo& prodInfo) {
+        if (!prodInfo)
+            throw INVALID_ARGUMENT("Product information is invalid");
+
+        const auto      index = prodInfo.getProdIndex().getValue();
+        const auto&     name = prodInfo.getProdName();
+        Guard           guard{mutex};
+
+        if (records.empty())
+            first = index;
+
+        ProdIndex::Type i = index - first;
+        if (static_cast<int32_t>(i) < 0)
+            return false; // Before the window
+
+        if (i >= records.size() + maxProds) {
+            // Far beyond the window: start anew
+            records.clear();
+            liveBytes = numProds = 0;
+            first = index;
+            i = 0;
+        }
+        for (; i >= maxProds; --i)
+            popFront();
+        if (i >= records.size())
+            records.resize(i + 1);
+
+        auto& record = records[i];
+        if (record.exists())
+            return false;
+
+        record.nameOff = arena.size();
+        record.nameLen = name.size();
+        record.size = prodInfo.getProdSize();
+        arena.append(name);
+        liveBytes += name.size();
+        ++numProds;
+
+        if (arena.size() > MIN_ARENA && arena.size() > 2*liveBytes)
+            compact();
+
+        return true;
+    }
+
+    ProdInfo get(const ProdIndex prodIndex) const {
+        Guard       guard{mutex};
+        const auto* record = find(prodIndex);
+
+        return record
+                ? ProdInfo(prodIndex, record->size,
+                        arena.substr(record->nameOff, record->nameLen))
+                : ProdInfo{};
+    }
+
+    bool contains(const ProdIndex prodIndex) const {
+        Guard guard{mutex};
+        return find(prodIndex) != nullptr;
+    }
+
+    size_t size() const {
+        Guard guard{mutex};
+        return numProds;
+    }
+
+    size_t getNameBytes() const {
+        Guard guard{mutex};
+        return arena.size();
+    }
+};
+
+/******************************************************************************/
+
+ProdTable::ProdTable(const ProdIndex::Type maxProds)
+    : pImpl{std::make_shared<Impl>(maxProds)}
+{}
+
+bool ProdTable::add(const ProdInfo& prodInfo) const {
+    return pImpl->add(prodInfo);
+}
+
+ProdInfo ProdTable::get(const ProdIndex prodIndex) const {
+    return pImpl->get(prodIndex);
+}
+
+bool ProdTable::contains(const ProdIndex prodIndex) const {
+    return pImpl->contains(prodIndex);
+}
+
+size_t ProdTable::size() const {
+    return pImpl->size();
+}
+
+size_t ProdTable::getNameBytes() const {
+    return pImpl->getNameBytes();
+}
+
+} // namespace
@@ -0,0 +1,111 @@
+/**
+ * Compact, thread-safe table of product metadata.
+ *
+ *        File: ProdTable.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_REPOSITORY_PRODTABLE_H_
+#define MAIN_REPOSITORY_PRODTABLE_H_
+
+#include "hycast.h"
+
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe table of the metadata of the most recent products. It's indexed
+ * directly by product-index. Records have a fixed size and are contiguous and
+ * product names are stored back-to-back in a single arena, so the table
+ * itself doesn't hold a heap object per product. Product information is only
+ * created when it's requested.
+ *
+ * The table doesn't replace a repository's product-files: an open or
+ * remembered product-file still has its own pathname. What the table saves is
+ * retaining a product-information object per product and accessing a
+ * product-file to answer a lookup.
+ *
+ * The table covers a sliding window of product-indexes. Adding a product
+ * beyond the end of the window advances the window and forgets the oldest
+ * products. A product before the window isn't added.
+ */
+class ProdTable
+{
+    class                 Impl;
+    std::shared_ptr<Impl> pImpl;
+
+public:
+    /// Default maximum number of products
+    static const ProdIndex::Type MAX_PRODS = 100000;
+
+    /**
+     * Constructs.
+     *
+     * @param[in] maxProds         Maximum number of products
+     * @throws    InvalidArgument  `maxProds == 0`
+     */
+    explicit ProdTable(const ProdIndex::Type maxProds = MAX_PRODS);
+
+    /**
+     * Adds product information.
+     *
+     * @param[in] prodInfo         Product information
+     * @retval    `true`           Added
+     * @retval    `false`          Not added because it already exists or it's
+     *                             before the window
+     * @throws    InvalidArgument  `!prodInfo`
+     */
+    bool add(const ProdInfo& prodInfo) const;
+
+    /**
+     * Returns product information.
+     *
+     * @param[in] prodIndex  Product index
+     * @return               Product information. Will test false if it isn't
+     *                       in the table.
+     */
+    ProdInfo get(const ProdIndex prodIndex) const;
+
+    /**
+     * Indicates if product information is in the table.
+     *
+     * @param[in] prodIndex  Product index
+     * @retval    `true`     It is
+     * @retval    `false`    It isn't
+     */
+    bool contains(const ProdIndex prodIndex) const;
+
+    /**
+     * Returns the number of products in the table.
+     *
+     * @return  Number of products
+     */
+    size_t size() const;
+
+    /**
+     * Returns the number of bytes used by product names.
+     *
+     * @return  Number of bytes in the name arena
+     */
+    size_t getNameBytes() const;
+};
+
+} // namespace
+
+#endif /* MAIN_REPOSITORY_PRODTABLE_H_ */
@@ -26,15 +26,19 @@
 
 #include "error.h"
 #include "FileUtil.h"
+#include "GroupSync.h"
 #include "hycast.h"
 #include "ProdFile.h"
+#include "ProdTable.h"
 #include "Thread.h"
 #include "Watcher.h"
+#include "WindowMap.h"
 
 #include "LinkedMap.cpp"
 
 #include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <errno.h>
 #include <fcntl.h>
 #include <functional>
@@ -150,7 +154,11 @@ class Repository::Impl
 protected:
     /**
      * A product-index to product-file hash table that also identifies the
-     * least-recently-used product-file.
+     * least-recently-used product-file. The table is direct-indexed by
+     * product-index, so finding a recent product is one array access. The
+     * entries form an intrusive, doubly-linked list and are pooled, so moving
+     * an entry to the tail of the list only relinks pointers and neither
+     * allocates nor rehashes.
      *
      * @tparam PF  Type of product-file
      */
@@ -158,30 +166,99 @@ protected:
     class LinkedProdMap final
     {
         /**
-         * A hash table entry for a product-file that also forms a linked-list.
+         * An entry for a product-file that also forms a linked-list.
          */
         struct Entry final
         {
-            PF          prodFile; ///< Receiving product-file
-            ProdIndex   prev;     ///< Previous entry (towards the head)
-            ProdIndex   next;     ///< Subsequent entry (towards the tail)
+            PF        prodFile;  ///< Product-file
+            ProdIndex prodIndex; ///< Product-index
+            Entry*    prev;      ///< Previous entry (towards the head)
+            Entry*    next;      ///< Subsequent entry (towards the tail).
+                                 ///< Next free entry if in the free-list.
 
             Entry()
                 : prodFile()
-                , prev()
-                , next()
-            {}
-
-            Entry(PF& prodFile, const ProdIndex prev)
-                : prodFile(prodFile)
-                , prev(prev)
-                , next()
+                , prodIndex()
+                , prev(nullptr)
+                , next(nullptr)
             {}
         };
 
-        std::unordered_map<ProdIndex, Entry> map;
-        ProdIndex                            head; ///< Head of list
-        ProdIndex                            tail; ///< Tail of list
+        WindowMap<Entry*, ProdIndex::Type>    map;
+        std::deque<Entry>                     pool;     ///< Stable storage
+        Entry*                                freeList; ///< Unused entries
+        Entry*                                head;     ///< Head of list
+        Entry*                                tail;     ///< Tail of list
+
+        /**
+         * Removes an entry from the list.
+         *
+         * @param[in] entry  Entry to be removed
+         */
+        void unlink(Entry* entry) noexcept
+        {
+            if (entry->prev) {
+                entry->prev->next = entry->next;
+            }
+            else {
+                head = entry->next;
+            }
+
+            if (entry->next) {
+                entry->next->prev = entry->prev;
+            }
+            else {
+                tail = entry->prev;
+            }
+        }
+
+        /**
+         * Adds an entry to the tail-end of the list.
+         *
+         * @param[in] entry  Entry to be added
+         */
+        void linkTail(Entry* entry) noexcept
+        {
+            entry->prev = tail;
+            entry->next = nullptr;
+
+            if (tail) {
+                tail->next = entry;
+            }
+            else {
+                head = entry;
+            }
+            tail = entry;
+        }
+
+        /**
+         * Returns an unused entry.
+         *
+         * @return  Unused entry
+         */
+        Entry* allocate()
+        {
+            if (freeList == nullptr) {
+                pool.emplace_back();
+                return &pool.back();
+            }
+
+            auto entry = freeList;
+            freeList = entry->next;
+            return entry;
+        }
+
+        /**
+         * Returns an entry to the free-list.
+         *
+         * @param[in] entry  Entry that's no longer used
+         */
+        void deallocate(Entry* entry) noexcept
+        {
+            entry->prodFile = PF{};
+            entry->next = freeList;
+            freeList = entry;
+        }
 
     public:
         /**
@@ -189,8 +266,10 @@ protected:
          */
         LinkedProdMap()
             : map()
-            , head()
-            , tail()
+            , pool()
+            , freeList(nullptr)
+            , head(nullptr)
+            , tail(nullptr)
         {}
 
         /**
@@ -199,11 +278,16 @@ protected:
          * @param[in] initSize  Initial size
          */
         LinkedProdMap(const size_t initSize)
-            : map(initSize)
-            , head()
-            , tail()
+            : map(2*initSize)
+            , pool()
+            , freeList(nullptr)
+            , head(nullptr)
+            , tail(nullptr)
         {}
 
+        LinkedProdMap(const LinkedProdMap& that) =delete;
+        LinkedProdMap& operator=(const LinkedProdMap& rhs) =delete;
+
         /**
          * Returns the number of entries.
          *
@@ -228,20 +312,21 @@ protected:
             if (!prodIndex)
                 throw INVALID_ARGUMENT("Product-index is invalid");
 
-            Entry                      entry(prodFile, tail);
-            std::pair<ProdIndex,Entry> elt(prodIndex, entry);
-            auto                       pair = map.insert(elt);
-
+            auto pair = map.insert(prodIndex.getValue(), nullptr);
             if (!pair.second)
                 throw LOGIC_ERROR("Entry already exists");
 
-            if (tail) {
-                map[tail].next = prodIndex;
+            try {
+                auto entry = allocate();
+                entry->prodFile = prodFile;
+                entry->prodIndex = prodIndex;
+                linkTail(entry);
+                *pair.first = entry;
             }
-            else {
-                head = prodIndex;
+            catch (const std::exception& ex) {
+                map.erase(prodIndex.getValue());
+                throw;
             }
-            tail = prodIndex;
         }
 
         /**
@@ -254,30 +339,17 @@ protected:
          */
         PF remove(const ProdIndex prodIndex)
         {
-            auto iter = map.find(prodIndex);
+            auto ptr = map.find(prodIndex.getValue());
 
-            if (iter == map.end())
+            if (ptr == nullptr)
                 throw INVALID_ARGUMENT("No such entry");
 
-            Entry& entry = iter->second;
-
-            if (entry.prev) {
-                map[entry.prev].next = entry.next;
-            }
-            else {
-                head = entry.next;
-            }
-
-            if (entry.next) {
-                map[entry.next].prev = entry.prev;
-            }
-            else {
-                tail = entry.prev;
-            }
-
-            auto prodFile = entry.prodFile;;
+            auto entry = *ptr;
+            auto prodFile = entry->prodFile;
 
-            map.erase(iter);
+            map.erase(prodIndex.getValue());
+            unlink(entry);
+            deallocate(entry);
 
             return prodFile;
         }
@@ -292,16 +364,20 @@ protected:
          */
         PF find(const ProdIndex prodIndex)
         {
-            auto      iter = map.find(prodIndex);
+            auto ptr = map.find(prodIndex.getValue());
 
-            if (iter == map.end()) {
+            if (ptr == nullptr) {
                 static const PF prodFile{};
                 return prodFile;
             }
 
-            auto prodFile = remove(prodIndex);
-            add(prodIndex, prodFile);
-            return prodFile;
+            auto entry = *ptr;
+            if (entry != tail) {
+                unlink(entry);
+                linkTail(entry);
+            }
+
+            return entry->prodFile;
         }
 
         /**
@@ -312,7 +388,7 @@ protected:
          */
         ProdIndex getHead()
         {
-            return head;
+            return head ? head->prodIndex : ProdIndex{};
         }
     };
 
@@ -361,11 +437,8 @@ protected:
     static void ensureRoom(
             LinkedProdMap<PF>& map,
             const size_t       maxOpenFiles) {
-        while (map.size() >= maxOpenFiles) {
-            const auto prodIndex = map.getHead();
-            map.find(prodIndex).close();
-            map.remove(prodIndex);
-        }
+        while (map.size() >= maxOpenFiles)
+            map.remove(map.getHead()).close();
     }
 
     static std::string getIndexPath(const ProdIndex prodIndex)
@@ -532,6 +605,7 @@ class PubRepo::Impl final : public Repository::Impl
     Watcher                    watcher;   ///< Watches filename hierarchy
     std::queue<ProdIndex>      prodQueue; ///< Queue of products to be sent
     ProdIndex                  prodIndex; ///< Next product-index
+    ProdTable                  prodTable; ///< Metadata of recent products
 
     ProdIndex getNextIndex()
     {
@@ -609,6 +683,7 @@ public:
         , watcher(this->rootPathname) // Absolute pathname
         , prodQueue()
         , prodIndex()
+        , prodTable()
     {}
 
     /**
@@ -651,25 +726,29 @@ public:
      * product-entry is created and added to the set of active product-entries.
      * for each new non-directory file in the repository's hierarchy:
      *
-     * @return              Index of next product to publish
-     * @throws SystemError  System failure
-     * @threadsafety        Compatible but unsafe
+     * @param[in] stopToken    Token that stops waiting
+     * @return                 Index of next product to publish. Will test
+     *                         false if a stop was requested.
+     * @throws    SystemError  System failure
+     * @threadsafety           Compatible but unsafe
      */
-    ProdInfo getNextProd()
+    ProdInfo getNextProd(const StopToken& stopToken)
     {
+        Watcher::WatchEvent event;
+        if (!watcher.getEvent(event, stopToken))
+            return ProdInfo{};
+
         ProdInfo   prodInfo{};
         const auto prodIndex = getNextIndex();
 
         try {
-            Watcher::WatchEvent event;
-            watcher.getEvent(event);
-
             const auto prodName = event.pathname.substr(rootPrefixLen);
 
             SndProdFile prodFile(rootFd, prodName, segSize);
             addProdFile(prodIndex, prodFile);
 
             prodInfo = ProdInfo(prodIndex, prodFile.getProdSize(), prodName);
+            prodTable.add(prodInfo);
         }
         catch (const std::exception& ex) {
             std::throw_with_nested(RUNTIME_ERROR("Couldn't get product-file "
@@ -679,6 +758,11 @@ public:
         return prodInfo;
     }
 
+    ProdInfo getNextProd() override
+    {
+        return getNextProd(StopToken{});
+    }
+
     /**
      * Returns the product-information corresponding to a product-index.
      *
@@ -688,18 +772,39 @@ public:
      */
     ProdInfo getProdInfo(const ProdIndex prodIndex)
     {
+        // The table obviates opening the product-file
+        auto prodInfo = prodTable.get(prodIndex);
+        if (prodInfo)
+            return prodInfo;
+
         Guard      guard{mutex};
         const auto prodFile = getProdFile(prodIndex);
 
-        if (!prodFile) {
-            static const ProdInfo prodInfo{};
-            return prodInfo;
-        }
+        if (!prodFile)
+            return prodInfo; // Tests false
 
+        // The file's pathname is relative to the root directory: the name
         return ProdInfo(prodIndex, prodFile.getProdSize(),
                 prodFile.getPathname());
     }
 
+    /**
+     * Pins the data of a product.
+     *
+     * @param[in] prodIndex  Product index
+     * @return               Pin of product's data. Will test false if no such
+     *                       product exists.
+     */
+    std::shared_ptr<const void> pin(const ProdIndex prodIndex)
+    {
+        Guard      guard{mutex};
+        const auto prodFile = getProdFile(prodIndex);
+
+        return prodFile
+                ? prodFile.pin()
+                : std::shared_ptr<const void>{};
+    }
+
     /**
      * Returns the in-memory data-segment that corresponds to a segment
      * identifier.
@@ -742,13 +847,21 @@ void PubRepo::link(
 }
 
 ProdInfo PubRepo::getNextProd() const {
-    return static_cast<Impl*>(pImpl.get())->getNextProd();
+    return static_cast<Impl*>(pImpl.get())->getNextProd(StopToken{});
+}
+
+ProdInfo PubRepo::getNextProd(const StopToken& stopToken) const {
+    return static_cast<Impl*>(pImpl.get())->getNextProd(stopToken);
 }
 
 ProdInfo PubRepo::getProdInfo(const ProdIndex prodIndex) const {
     return static_cast<Impl*>(pImpl.get())->getProdInfo(prodIndex);
 }
 
+std::shared_ptr<const void> PubRepo::pin(const ProdIndex prodIndex) const {
+    return static_cast<Impl*>(pImpl.get())->pin(prodIndex);
+}
+
 MemSeg PubRepo::getMemSeg(const SegId& segId) const {
     return static_cast<Impl*>(pImpl.get())->getMemSeg(segId);
 }
@@ -761,9 +874,12 @@ MemSeg PubRepo::getMemSeg(const SegId& segId) const {
  */
 class SubRepo::Impl final : public Repository::Impl
 {
-    std::queue<ProdInfo>       completeProds; ///< Queue of completed products
+    std::queue<ProdIndex>      completeProds; ///< Queue of completed products
     LinkedProdMap<RcvProdFile> prodFiles;
     LinkedProdMap<RcvProdFile> openFiles;
+    ProdTable                  prodTable;     ///< Metadata of recent products
+    const StoragePolicy        policy;        ///< Layout and durability policy
+    GroupSync                  groupSync;     ///< Synchronizes completed files
 
     void makeRoom()
     {
@@ -837,7 +953,8 @@ class SubRepo::Impl final : public Repository::Impl
         if (!prodFile) {
             LOG_DEBUG("Creating product " + prodIndex.to_string());
 
-            prodFile = RcvProdFile(rootFd, prodIndex, prodSize, segSize);
+            prodFile = RcvProdFile(rootFd, prodIndex, prodSize, segSize,
+                    policy);
             addProdFile(prodIndex, prodFile);
         }
 
@@ -846,27 +963,39 @@ class SubRepo::Impl final : public Repository::Impl
 
     /**
      * Finishes processing a completely-received data-product by adding the
-     * product to the completed-product queue
+     * product to the completed-product queue and, if synchronization is
+     * enabled, scheduling its file for synchronization with stable storage.
      *
-     * @pre                 State is locked
-     * @pre                 Product-file is complete
-     * @param[in] prodFile  File containing the data-product
+     * @pre                  State is unlocked
+     * @pre                  Product-file is complete
+     * @param[in] prodIndex  Index of the data-product
+     * @param[in] prodFile   Product-file of the data-product
      */
-    void finish(const RcvProdFile& prodFile) {
-        const auto prodInfo = prodFile.getProdInfo();
-        Guard      guard(mutex);
+    void finish(
+            const ProdIndex    prodIndex,
+            const RcvProdFile& prodFile) {
+        if (groupSync)
+            groupSync.add(prodFile.getPathname());
+
+        Guard guard(mutex);
 
-        completeProds.push(prodInfo);
+        completeProds.push(prodIndex);
         cond.notify_all();
     }
 
 public:
-    Impl(   const std::string& rootPathname,
-            const SegSize      segSize,
-            const size_t       maxOpenFiles)
+    Impl(   const std::string&   rootPathname,
+            const SegSize        segSize,
+            const size_t         maxOpenFiles,
+            const StoragePolicy& policy)
         : Repository::Impl{rootPathname, segSize, maxOpenFiles}
         , prodFiles() // TODO: Add existing files
         , openFiles(maxOpenFiles)
+        , prodTable()
+        , policy(policy)
+        , groupSync(policy.sync == StoragePolicy::Sync::NONE
+                ? GroupSync{}
+                : GroupSync{rootFd, policy})
     {}
 
     /**
@@ -888,8 +1017,11 @@ public:
                 prodInfo.getProdSize());
         const bool wasSaved = prodFile.save(rootFd, prodInfo);
 
-        if (wasSaved && prodFile.isComplete())
-            finish(prodFile);
+        if (wasSaved) {
+            prodTable.add(prodInfo);
+            if (prodFile.isComplete())
+                finish(prodInfo.getProdIndex(), prodFile);
+        }
 
         return wasSaved;
     }
@@ -911,7 +1043,7 @@ public:
         const auto wasSaved = prodFile.save(dataSeg);
 
         if (wasSaved && prodFile.isComplete())
-            finish(prodFile);
+            finish(dataSeg.getProdIndex(), prodFile);
 
         return wasSaved;
     }
@@ -929,9 +1061,17 @@ public:
         while(completeProds.empty())
             cond.wait(lock);
 
-        auto prodInfo = completeProds.front();
+        const auto prodIndex = completeProds.front();
         completeProds.pop();
 
+        auto prodInfo = prodTable.get(prodIndex);
+        if (!prodInfo) {
+            // Forgotten by the table
+            auto prodFile = getProdFile(prodIndex);
+            if (prodFile)
+                prodInfo = prodFile.getProdInfo();
+        }
+
         return prodInfo;
     }
 
@@ -945,13 +1085,16 @@ public:
      */
     ProdInfo getProdInfo(const ProdIndex prodIndex)
     {
+        // The table obviates opening the product-file
+        auto prodInfo = prodTable.get(prodIndex);
+        if (prodInfo)
+            return prodInfo;
+
         Guard                 guard{mutex};
         auto                  prodFile = getProdFile(prodIndex);
 
-        if (!prodFile) {
-            static const ProdInfo prodInfo{};
-            return prodInfo;
-        }
+        if (!prodFile)
+            return prodInfo; // Tests false
 
         return prodFile.getProdInfo();
     }
@@ -989,6 +1132,9 @@ public:
      */
     bool exists(const ProdIndex prodIndex)
     {
+        if (prodTable.contains(prodIndex))
+            return true;
+
         Guard       guard{mutex};
         RcvProdFile prodFile = getProdFile(prodIndex);
 
@@ -1009,16 +1155,39 @@ public:
 
         return prodFile && prodFile.exists(segId.getOffset());
     }
+
+    /**
+     * Returns the ranges of data-segments of a product that are missing.
+     *
+     * @param[in] prodIndex  Product index
+     * @param[in] maxRanges  Maximum number of ranges to return
+     * @return               Ranges of missing data-segments. Will be empty if
+     *                       the product is complete or unknown.
+     */
+    SegRanges getMissing(
+            const ProdIndex prodIndex,
+            const size_t    maxRanges)
+    {
+        RcvProdFile prodFile;
+        {
+            Guard guard{mutex};
+            prodFile = getProdFile(prodIndex);
+        }
+
+        // The product-file is thread-safe
+        return prodFile ? prodFile.getMissing(maxRanges) : SegRanges{};
+    }
 };
 
 /******************************************************************************/
 SubRepo::SubRepo() =default;
 
 SubRepo::SubRepo(
-        const std::string& rootPathname,
-        const SegSize      segSize,
-        const size_t       maxOpenFiles)
-    : Repository{new Impl(rootPathname, segSize, maxOpenFiles)} {
+        const std::string&   rootPathname,
+        const SegSize        segSize,
+        const size_t         maxOpenFiles,
+        const StoragePolicy& policy)
+    : Repository{new Impl(rootPathname, segSize, maxOpenFiles, policy)} {
 }
 
 bool SubRepo::save(const ProdInfo& prodInfo) const {
@@ -1049,4 +1218,10 @@ bool SubRepo::exists(const SegId& segId) const {
     return static_cast<Impl*>(pImpl.get())->exists(segId);
 }
 
+SegRanges SubRepo::getMissing(
+        const ProdIndex prodIndex,
+        const size_t    maxRanges) const {
+    return static_cast<Impl*>(pImpl.get())->getMissing(prodIndex, maxRanges);
+}
+
 } // namespace
@@ -25,6 +25,7 @@
 
 #include "ProdFile.h"
 #include "hycast.h"
+#include "StopToken.h"
 
 #include <memory>
 #include <string>
@@ -176,7 +177,20 @@ public:
     ProdInfo getNextProd() const;
 
     /**
-     * Returns information on a product.
+     * Returns information on the next product to publish. Blocks until one is
+     * ready or a stop is requested.
+     *
+     * @param[in] stopToken  Token that stops waiting
+     * @return               Information on the next product to publish. Will
+     *                       test false if a stop was requested.
+     */
+    ProdInfo getNextProd(const StopToken& stopToken) const;
+
+    /**
+     * Returns information on a product. The product's name is the pathname of
+     * its file relative to the root directory of the repository, just as in
+     * the information returned by `getNextProd()`. Recent products are looked
+     * up in a table, so their files aren't accessed.
      *
      * @param[in] prodIndex  Index of product
      * @return               Information on product. Will test false if no such
@@ -188,6 +202,20 @@ public:
      */
     ProdInfo getProdInfo(ProdIndex prodIndex) const override;
 
+    /**
+     * Pins the data of a product. The data stays accessible until the returned
+     * object and all its copies are destroyed, even if the product's file is
+     * closed in the meantime.
+     *
+     * @param[in] prodIndex  Index of product
+     * @return               Pin of product's data. Will test false if no such
+     *                       product exists.
+     * @threadsafety         Safe
+     * @cancellationpoint    No
+     * @see `ProdFile::pin()`
+     */
+    std::shared_ptr<const void> pin(ProdIndex prodIndex) const;
+
     /**
      * Returns a data-segment
      *
@@ -225,10 +253,12 @@ public:
      * @param[in] segSize       Size of canonical data-segment in bytes
      * @param[in] maxOpenFiles  Maximum number of files to have open
      *                          simultaneously
+     * @param[in] policy        Layout and durability policy of product-files
      */
-    SubRepo(const std::string& rootPathname = getDefRootPathname(),
-            SegSize            segSize = getDefSegSize(),
-            size_t             maxOpenFiles = getDefMaxOpenFiles());
+    SubRepo(const std::string&   rootPathname = getDefRootPathname(),
+            SegSize              segSize = getDefSegSize(),
+            size_t               maxOpenFiles = getDefMaxOpenFiles(),
+            const StoragePolicy& policy = StoragePolicy{});
 
     /**
      * Saves product-information in the corresponding product-file.
@@ -306,6 +336,22 @@ public:
      * @retval    `true`     Data-segment does exist
      */
     bool exists(const SegId& segId) const;
+
+    /**
+     * Returns the ranges of data-segments of a product that are missing. The
+     * result is suitable for requesting the data-segments in batches.
+     *
+     * @param[in] prodIndex  Product index
+     * @param[in] maxRanges  Maximum number of ranges to return
+     * @return               Ranges of missing data-segments in order of
+     *                       increasing offset. Will be empty if the product is
+     *                       complete or unknown.
+     * @threadsafety         Safe
+     * @see `exists(ProdIndex)`
+     */
+    SegRanges getMissing(
+            const ProdIndex prodIndex,
+            const size_t    maxRanges = SIZE_MAX) const;
 };
 
 } // namespace
@@ -23,13 +23,16 @@
 #include "config.h"
 
 #include "error.h"
+#include "logging.h"
 #include "Watcher.h"
 
 #include <cstring>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <queue>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -45,6 +48,7 @@ class Watcher::Impl final
 
     std::string rootDir;  ///< Root directory of watched hierarchy
     int         fd ;      ///< inotify(7) file-descriptor
+    int         stopFd;   ///< eventfd(2) that's written to stop waiting
     PathMap     dirPaths; ///< Pathnames of watched directories
     WdMap       wds;      ///< inotify(7) watch descriptors
     PathQueue   regFiles; ///< Queue of pre-existing but new regular files
@@ -169,18 +173,36 @@ class Watcher::Impl final
     }
 
     /**
-     * Blocks.
+     * Blocks until events can be read or a stop is requested.
      *
-     * @throws SystemError  Couldn't read inotify(7) file-descriptor
+     * @param[in] stopToken    Token that stops waiting
+     * @retval    `true`       Events were read
+     * @retval    `false`      A stop was requested
+     * @throws    SystemError  Couldn't read inotify(7) file-descriptor
      */
-    void readEvents() {
-        ssize_t nbytes = ::read(fd, eventBuf.buf, sizeof(eventBuf)); // Blocks
+    bool readEvents(const StopToken& stopToken) {
+        StopCallback  stopCallback{stopToken, [this] {
+            const uint64_t one = 1;
+            if (::write(stopFd, &one, sizeof(one)) == -1)
+                LOG_ERROR("Couldn't write to eventfd(2)");
+        }};
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+
+        while (::poll(fds, 2, -1) == -1) // Blocks
+            if (errno != EINTR)
+                throw SYSTEM_ERROR("Couldn't poll inotify(7) file-descriptor");
+
+        if (stopToken.stopRequested())
+            return false;
+
+        ssize_t nbytes = ::read(fd, eventBuf.buf, sizeof(eventBuf));
 
         if (nbytes == -1)
             throw SYSTEM_ERROR("Couldn't read inotify(7) file-descriptor");
 
         nextEvent = eventBuf.buf;
         endEvent = eventBuf.buf + nbytes;
+        return true;
     }
 
     /**
@@ -227,11 +249,13 @@ public:
      * @throws    SystemError  `inotify_init()` failure
      * @throws    SystemError  Couldn't set `inotify_init(2)` file-descriptor to
      *                         close-on-exec
+     * @throws    SystemError  `eventfd()` failure
      * @throws    SystemError  Couldn't open directory
      */
     Impl(const std::string& rootDir)
         : rootDir(rootDir)
         , fd(::inotify_init())
+        , stopFd(-1)
         , dirPaths()
         , wds()
         , regFiles()
@@ -245,19 +269,28 @@ public:
             throw SYSTEM_ERROR("Couldn't set inotify(7) file-descriptor to "
                     "close-on-exec");
 
+        stopFd = ::eventfd(0, EFD_CLOEXEC);
+        if (stopFd == -1)
+            throw SYSTEM_ERROR("eventfd() failure");
+
         watch(rootDir);
     }
 
     ~Impl() noexcept
     {
+        (void)::close(stopFd);
         (void)::close(fd);
     }
 
     /**
      * Returns a watched-for event.  Reads the `inotify(7)` file-descriptor.
-     * Recurses into new directories. Follows symbolic links. Blocks.
+     * Recurses into new directories. Follows symbolic links. Blocks until an
+     * event occurs or a stop is requested.
      *
      * @param[out] watchEvent  The watched-for event
+     * @param[in]  stopToken   Token that stops waiting
+     * @retval     `true`      `watchEvent` is set
+     * @retval     `false`     A stop was requested
      * @threadsafety           Compatible but unsafe
      *
      * @threadsafety Unsafe
@@ -265,15 +298,19 @@ public:
      * @throws       RuntimeError  A watched file-system was unmounted
      * @throws       RuntimeError  The inotify(7) event-queue overflowed
      */
-    void getEvent(WatchEvent& watchEvent)
+    bool getEvent(
+            WatchEvent&      watchEvent,
+            const StopToken& stopToken)
     {
         while (regFiles.empty()) {
-            readEvents(); // Blocks
+            if (!readEvents(stopToken)) // Blocks
+                return false;
             processEvents();
         }
 
         watchEvent.pathname = regFiles.front();
         regFiles.pop();
+        return true;
     }
 };
 
@@ -283,9 +320,11 @@ Watcher::Watcher(const std::string& rootDir)
     : pImpl{new Impl(rootDir)}
 {}
 
-void Watcher::getEvent(WatchEvent& watchEvent)
+bool Watcher::getEvent(
+        WatchEvent&      watchEvent,
+        const StopToken& stopToken)
 {
-    pImpl->getEvent(watchEvent);
+    return pImpl->getEvent(watchEvent, stopToken);
 }
 
 } // namespace
@@ -23,6 +23,8 @@
 #ifndef MAIN_REPOSITORY_WATCHER_H_
 #define MAIN_REPOSITORY_WATCHER_H_
 
+#include "StopToken.h"
+
 #include <memory>
 #include <string>
 
@@ -54,12 +56,18 @@ public:
     Watcher(const std::string& rootDir);
 
     /**
-     * Returns a watched-for event.
+     * Returns a watched-for event. Blocks until one occurs or a stop is
+     * requested.
      *
      * @param[out] watchEvent  The watched-for event
+     * @param[in]  stopToken   Token that stops waiting
+     * @retval     `true`      `watchEvent` is set
+     * @retval     `false`     A stop was requested. `watchEvent` is unset.
      * @threadsafety           Compatible but unsafe
      */
-    void getEvent(WatchEvent& event);
+    bool getEvent(
+            WatchEvent&      event,
+            const StopToken& stopToken = StopToken{});
 };
 
 } // namespace
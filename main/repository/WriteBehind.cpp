@@ -0,0 +1,331 @@
+/**
+ * Bounded, in-memory stage between the reception of data-segments and their
+ * storage in a repository.
+ *
+ *        File: WriteBehind.cpp
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "WriteBehind.h"
+
+#include "error.h"
+#include "logging.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hycast {
+
+/// Repository of a handle on a write-behind stage
+struct WriteBehind::Sink
+{
+    SubRepo     repo;
+    const Saved saved;
+    size_t      depth; ///< Number of queued segments. Guarded by the stage.
+
+    Sink(   SubRepo&     repo,
+            const Saved& saved)
+        : repo(repo)
+        , saved(saved)
+        , depth(0)
+    {}
+};
+
+class WriteBehind::Impl
+{
+    using Mutex     = std::mutex;
+    using Guard     = std::lock_guard<Mutex>;
+    using Lock      = std::unique_lock<Mutex>;
+    using Cond      = std::condition_variable;
+    using Thread    = std::thread;
+    using Clock     = std::chrono::steady_clock;
+    using ExceptPtr = std::exception_ptr;
+    using SinkPtr   = std::shared_ptr<Sink>;
+
+    /// Metadata of a queued data-segment. Its data is in the data pool.
+    struct Slot
+    {
+        SinkPtr  sink;
+        SegId    segId;
+        ProdSize prodSize;
+        SegSize  segSize;
+    };
+
+    mutable Mutex           mutex;
+    Cond                    notEmpty;   ///< Signaled when a segment is queued
+    Cond                    drained;    ///< Signaled when a segment is removed
+    const Policy            policy;
+    const SegSize           slotSize;   ///< Size of a slot in bytes
+    std::vector<Slot>       slots;      ///< Ring of queued segments
+    std::unique_ptr<char[]> data;       ///< Data of slots, back-to-back
+    size_t                  head;       ///< Index of oldest queued segment
+    bool                    overflowed; ///< Overflow policy applies?
+    bool                    done;       ///< Writer should exit when drained?
+    ExceptPtr               exPtr;      ///< Exception thrown by writer
+    Metrics                 metrics;
+    Thread                  writer;
+
+    /**
+     * Returns the data of a slot.
+     *
+     * @param[in] i  Index of slot
+     * @return       Data of the slot
+     */
+    inline char* slotData(const size_t i) const noexcept {
+        return data.get() + i*slotSize;
+    }
+
+    /**
+     * Throws the exception thrown by the writer thread, if any.
+     *
+     * @pre    Mutex is locked
+     * @throws Exception thrown by the writer thread
+     * @post   Mutex is locked
+     */
+    void throwIfException() const {
+        if (exPtr)
+            std::rethrow_exception(exPtr);
+    }
+
+    /**
+     * Saves queued data-segments in the repository. Executes on the writer
+     * thread. Doesn't return until `done` is set and the queue is empty or an
+     * exception is thrown.
+     */
+    void run() {
+        try {
+            Lock lock{mutex};
+
+            for (;;) {
+                while (metrics.depth == 0 && !done)
+                    notEmpty.wait(lock);
+                if (metrics.depth == 0)
+                    break;
+
+                /*
+                 * The head slot isn't reused until it's released below, so its
+                 * data can be read without the mutex locked.
+                 */
+                Slot slot{};
+                std::swap(slot, slots[head]); // Don't keep the sink alive
+                lock.unlock();
+
+                MemSeg     memSeg{SegInfo{slot.segId, slot.prodSize,
+                        slot.segSize}, slotData(head)};
+                const bool wasSaved = slot.sink->repo.save(memSeg);
+                slot.sink->saved(slot.segId, wasSaved);
+
+                lock.lock();
+                wasSaved ? ++metrics.numSaved : ++metrics.numDups;
+                head = (head + 1) % slots.size();
+                --metrics.depth;
+                --slot.sink->depth;
+                if (overflowed && metrics.depth <= policy.lowWater) {
+                    overflowed = false;
+                    LOG_NOTE("Write-behind stage recovered: {dropped: %lu, "
+                            "blocked: %g s}",
+                            static_cast<unsigned long>(metrics.numDropped),
+                            metrics.blockedSecs);
+                }
+                drained.notify_all();
+            }
+        }
+        catch (const std::exception& ex) {
+            LOG_DEBUG("Exception thrown: %s", ex.what());
+            Guard guard{mutex};
+            exPtr = std::current_exception();
+            drained.notify_all();
+        }
+    }
+
+public:
+    Impl(   const SegSize slotSize,
+            const Policy& policy)
+        : mutex()
+        , notEmpty()
+        , drained()
+        , policy(policy)
+        , slotSize(slotSize)
+        , slots()
+        , data()
+        , head(0)
+        , overflowed(false)
+        , done(false)
+        , exPtr()
+        , metrics()
+        , writer()
+    {
+        if (policy.highWater == 0)
+            throw INVALID_ARGUMENT("High watermark is zero");
+        if (policy.lowWater >= policy.highWater)
+            throw INVALID_ARGUMENT("Low watermark isn't less than high "
+                    "watermark");
+
+        slots.resize(policy.highWater);
+        data.reset(new char[policy.highWater*slotSize]);
+
+        try {
+            writer = Thread(&Impl::run, this);
+        }
+        catch (const std::exception& ex) {
+            std::throw_with_nested(
+                    RUNTIME_ERROR("Couldn't create writer thread"));
+        }
+    }
+
+    /**
+     * Destroys. Doesn't return until the writer thread has saved every queued
+     * data-segment.
+     */
+    ~Impl() noexcept {
+        {
+            Guard guard{mutex};
+            done = true;
+            notEmpty.notify_all();
+        }
+        writer.join();
+    }
+
+    bool save(
+            const SinkPtr& sink,
+            DataSeg&       dataSeg) {
+        const auto segSize = dataSeg.getSegSize();
+
+        if (segSize > slotSize) {
+            {
+                Guard guard{mutex};
+                throwIfException();
+                ++metrics.numDirect;
+            }
+            sink->saved(dataSeg.getSegId(), sink->repo.save(dataSeg));
+            return true;
+        }
+
+        Lock lock{mutex};
+        throwIfException();
+
+        if (!overflowed && metrics.depth >= policy.highWater) {
+            overflowed = true;
+            ++metrics.numOverflows;
+            LOG_NOTE("Write-behind stage overflowed: {depth: %lu}",
+                    static_cast<unsigned long>(metrics.depth));
+        }
+
+        if (overflowed) {
+            if (policy.overflow == Overflow::DROP) {
+                ++metrics.numDropped;
+                return false;
+            }
+
+            const auto start = Clock::now();
+            while (overflowed && !exPtr)
+                drained.wait(lock);
+            metrics.blockedSecs += std::chrono::duration<double>(
+                    Clock::now() - start).count();
+            throwIfException();
+        }
+
+        const auto tail = (head + metrics.depth) % slots.size();
+        slots[tail] = Slot{sink, dataSeg.getSegId(), dataSeg.getProdSize(),
+                segSize};
+        dataSeg.getData(slotData(tail));
+
+        ++sink->depth;
+        if (++metrics.depth > metrics.maxDepth)
+            metrics.maxDepth = metrics.depth;
+        ++metrics.numQueued;
+        notEmpty.notify_one();
+
+        return true;
+    }
+
+    /**
+     * Blocks until the data-segments of a sink, or every data-segment, have
+     * been processed.
+     *
+     * @param[in] sink  Sink or `nullptr` for every data-segment
+     * @throws          Exception thrown by the writer thread
+     */
+    void flush(const Sink* sink) {
+        Lock lock{mutex};
+
+        while ((sink ? sink->depth : metrics.depth) && !exPtr)
+            drained.wait(lock);
+        throwIfException();
+    }
+
+    Metrics getMetrics() const {
+        Guard guard{mutex};
+        return metrics;
+    }
+};
+
+/******************************************************************************/
+
+WriteBehind::WriteBehind(
+        std::shared_ptr<Impl> pImpl,
+        std::shared_ptr<Sink> sink)
+    : pImpl(pImpl)
+    , sink(sink)
+{}
+
+WriteBehind::WriteBehind(
+        SubRepo&      repo,
+        const Saved&  saved,
+        const Policy& policy)
+    : WriteBehind(WriteBehind(repo.getSegSize(), policy).attach(repo, saved))
+{}
+
+WriteBehind::WriteBehind(
+        const SegSize slotSize,
+        const Policy& policy)
+    : pImpl{std::make_shared<Impl>(slotSize, policy)}
+    , sink{}
+{}
+
+WriteBehind WriteBehind::attach(
+        SubRepo&     repo,
+        const Saved& saved) const {
+    return WriteBehind{pImpl, std::make_shared<Sink>(repo, saved)};
+}
+
+WriteBehind::operator bool() const noexcept {
+    return static_cast<bool>(pImpl);
+}
+
+bool WriteBehind::save(DataSeg& dataSeg) const {
+    if (!sink)
+        throw LOGIC_ERROR("Write-behind stage has no repository");
+    return pImpl->save(sink, dataSeg);
+}
+
+void WriteBehind::flush() const {
+    pImpl->flush(sink.get());
+}
+
+WriteBehind::Metrics WriteBehind::getMetrics() const {
+    return pImpl->getMetrics();
+}
+
+} // namespace
@@ -0,0 +1,209 @@
+/**
+ * Bounded, in-memory stage between the reception of data-segments and their
+ * storage in a repository.
+ *
+ *        File: WriteBehind.h
+ *  Created on: Oct 19, 2026
+ *      Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MAIN_REPOSITORY_WRITEBEHIND_H_
+#define MAIN_REPOSITORY_WRITEBEHIND_H_
+
+#include "Repository.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace hycast {
+
+/**
+ * Thread-safe, bounded write-behind stage for a subscriber's repository. A
+ * receiving thread copies data-segments into a fixed pool of slots and returns
+ * immediately; a separate writer thread saves them in the repository. A
+ * storage stall (e.g., writeback or a journal commit) therefore stalls the
+ * writer thread rather than the receiving thread, and the socket continues to
+ * be drained.
+ *
+ * When the number of queued segments reaches the high watermark, the stage
+ * overflows and the overflow policy applies until the number drains to the low
+ * watermark. A dropped segment isn't in the repository and will, consequently,
+ * be repaired over the P2P network.
+ */
+class WriteBehind final
+{
+    class                 Impl;
+    struct                Sink;
+    std::shared_ptr<Impl> pImpl;
+    std::shared_ptr<Sink> sink; ///< Repository of this handle. May be empty.
+
+    WriteBehind(
+            std::shared_ptr<Impl> pImpl,
+            std::shared_ptr<Sink> sink);
+
+public:
+    /// What to do with a data-segment when the stage overflows
+    enum class Overflow {
+        DROP,  ///< Discard the segment
+        BLOCK  ///< Block the receiving thread
+    };
+
+    /// Policy of the stage
+    struct Policy
+    {
+        size_t   highWater; ///< Number of queued segments at which overflow
+                            ///< starts. Also the number of slots.
+        size_t   lowWater;  ///< Number of queued segments at which overflow
+                            ///< ends
+        Overflow overflow;  ///< Overflow policy
+
+        Policy( const size_t   highWater = 4096,
+                const size_t   lowWater = 3072,
+                const Overflow overflow = Overflow::DROP)
+            : highWater(highWater)
+            , lowWater(lowWater)
+            , overflow(overflow)
+        {}
+    };
+
+    /// Metrics of the stage
+    struct Metrics
+    {
+        size_t   depth;        ///< Number of queued segments
+        size_t   maxDepth;     ///< Maximum number of queued segments
+        uint64_t numQueued;    ///< Number of segments queued
+        uint64_t numSaved;     ///< Number of segments saved in the repository
+        uint64_t numDups;      ///< Number of segments already in the repository
+        uint64_t numDropped;   ///< Number of segments dropped by overflow
+        uint64_t numDirect;    ///< Number of oversized segments saved directly
+        uint64_t numOverflows; ///< Number of times the stage overflowed
+        double   blockedSecs;  ///< Time the receiving thread was blocked
+    };
+
+    /**
+     * Function that's called by the writer thread after it has processed a
+     * data-segment.
+     *
+     * @param[in] segId   Segment identifier
+     * @param[in] saved   Whether the segment was saved (i.e., it wasn't
+     *                    already in the repository)
+     */
+    using Saved = std::function<void(const SegId& segId, bool saved)>;
+
+    /**
+     * Default constructs. The resulting instance will test false and must not
+     * be used.
+     */
+    WriteBehind() =default;
+
+    /**
+     * Constructs. Starts the writer thread. Slots have the size of the
+     * repository's canonical data-segment.
+     *
+     * @param[in] repo             Repository
+     * @param[in] saved            Function to call after a segment has been
+     *                             processed by the writer thread
+     * @param[in] policy           Policy of the stage
+     * @throws    InvalidArgument  `policy.highWater == 0` or
+     *                             `policy.lowWater >= policy.highWater`
+     * @throws    RuntimeError     Couldn't create writer thread
+     */
+    WriteBehind(
+            SubRepo&      repo,
+            const Saved&  saved,
+            const Policy& policy = Policy{});
+
+    /**
+     * Constructs a stage that can be shared by the repositories of several
+     * subscribers (e.g., one per feed) so that they share one writer thread
+     * and one pool of slots. Starts the writer thread. Data-segments are
+     * queued via the handles returned by `attach()`.
+     *
+     * @param[in] slotSize         Size of a slot in bytes
+     * @param[in] policy           Policy of the stage
+     * @throws    InvalidArgument  `policy.highWater == 0` or
+     *                             `policy.lowWater >= policy.highWater`
+     * @throws    RuntimeError     Couldn't create writer thread
+     * @see `attach()`
+     */
+    WriteBehind(
+            SegSize       slotSize,
+            const Policy& policy = Policy{});
+
+    /**
+     * Returns a handle that queues data-segments for a repository on this
+     * stage. The handle shares the writer thread, slots, metrics, and any
+     * exception thrown by the writer thread with every other handle of this
+     * stage. Segments that were queued via the handle are processed even if
+     * it's destroyed, so call `flush()` on it before destroying whatever
+     * `saved` references.
+     *
+     * @param[in] repo   Repository
+     * @param[in] saved  Function to call after a segment of the handle has
+     *                   been processed by the writer thread
+     * @return           Handle on this stage for the repository
+     * @threadsafety     Safe
+     */
+    WriteBehind attach(
+            SubRepo&     repo,
+            const Saved& saved) const;
+
+    /**
+     * Indicates if this instance is valid (i.e., wasn't default constructed).
+     *
+     * @retval `true`   Instance is valid
+     * @retval `false`  Instance is not valid
+     */
+    operator bool() const noexcept;
+
+    /**
+     * Queues a data-segment to be saved. Copies the segment's data. A segment
+     * that's larger than a slot is saved directly.
+     *
+     * @param[in] dataSeg     Data-segment
+     * @retval    `true`      Segment was queued or saved
+     * @retval    `false`     Segment was dropped by overflow
+     * @throws    LogicError  This instance has no repository (i.e., it was
+     *                        constructed by `WriteBehind(SegSize, Policy)`)
+     * @throws                Exception thrown by the writer thread
+     * @threadsafety          Safe
+     */
+    bool save(DataSeg& dataSeg) const;
+
+    /**
+     * Blocks until every data-segment queued via this handle has been
+     * processed by the writer thread. For an instance without a repository,
+     * blocks until the whole stage is empty.
+     *
+     * @throws        Exception thrown by the writer thread
+     * @threadsafety  Safe
+     */
+    void flush() const;
+
+    /**
+     * Returns the metrics of this instance.
+     *
+     * @return        Metrics
+     * @threadsafety  Safe
+     */
+    Metrics getMetrics() const;
+};
+
+} // namespace
+
+#endif /* MAIN_REPOSITORY_WRITEBEHIND_H_ */
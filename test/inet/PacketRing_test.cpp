@@ -0,0 +1,184 @@
+/**
+ * This file tests class `PacketRing`.
+ *
+ *       File: PacketRing_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "PacketRing.h"
+#include "Socket.h"
+
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing class `PacketRing`
+class PacketRingTest : public ::testing::Test
+{
+protected:
+    hycast::SockAddr grpAddr;  // Multicast group address
+    hycast::InetAddr ifAddr;   // Interface address
+    hycast::SockAddr otherGrp; // Another multicast group
+    hycast::UdpSock  sndSock;  // Sending socket
+
+    PacketRingTest()
+        : grpAddr("232.1.1.1:3880")
+        , ifAddr("127.0.0.1")
+        , otherGrp("232.1.1.2:3880")
+        , sndSock(grpAddr)
+    {
+        sndSock.setMcastIface(ifAddr);
+    }
+
+    /**
+     * Returns a ring on the loopback interface or an invalid ring if the
+     * process lacks the necessary capability. The source address is that of
+     * the sending socket, which the kernel chose when the socket was connected.
+     */
+    std::shared_ptr<hycast::PacketRing> createRing(
+            const unsigned numBlocks = 4)
+    {
+        try {
+            return std::make_shared<hycast::PacketRing>(grpAddr,
+                    sndSock.getLclAddr().getInetAddr(), "lo", 1U << 16,
+                    numBlocks);
+        }
+        catch (const std::system_error& ex) {
+            if (ex.code().value() != EPERM)
+                throw;
+            return std::shared_ptr<hycast::PacketRing>();
+        }
+    }
+};
+
+// Tests construction
+TEST_F(PacketRingTest, Construction)
+{
+    auto ring = createRing();
+    if (!ring)
+        GTEST_SKIP();
+    auto stats = ring->getStats();
+    EXPECT_EQ(0, stats.drops);
+}
+
+// Tests halting
+TEST_F(PacketRingTest, Halt)
+{
+    auto ring = createRing();
+    if (!ring)
+        GTEST_SKIP();
+
+    std::thread thread([&ring]{
+        const void* data;
+        size_t      nbytes;
+        EXPECT_FALSE(ring->next(data, nbytes));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ring->halt();
+    thread.join();
+}
+
+// Tests reception of datagrams. Datagrams to another group are filtered out.
+TEST_F(PacketRingTest, Reception)
+{
+    auto ring = createRing();
+    if (!ring)
+        GTEST_SKIP();
+
+    hycast::UdpSock otherSock(otherGrp);
+    otherSock.setMcastIface(ifAddr);
+
+    const int numDgrams = 100;
+    for (uint32_t i = 0; i < numDgrams; ++i) {
+        otherSock.addWrite(i);
+        otherSock.write();
+        sndSock.addWrite(i);
+        sndSock.write();
+    }
+
+    for (uint32_t i = 0; i < numDgrams; ++i) {
+        const void* data;
+        size_t      nbytes;
+        ASSERT_TRUE(ring->next(data, nbytes));
+        ASSERT_EQ(sizeof(uint32_t), nbytes);
+        uint32_t value;
+        ::memcpy(&value, data, sizeof(value));
+        EXPECT_EQ(i, ntohl(value));
+    }
+
+    auto stats = ring->getStats();
+    EXPECT_EQ(0, stats.drops);
+}
+
+// Tests receiving a burst of full-sized datagrams
+TEST_F(PacketRingTest, Burst)
+{
+    auto ring = createRing(64);
+    if (!ring)
+        GTEST_SKIP();
+
+    const uint32_t numDgrams = 100000;
+    char           payload[hycast::UdpSock::MAX_PAYLOAD] = {};
+
+    std::thread sender([&]{
+        for (uint32_t i = 0; i < numDgrams; ++i) {
+            const uint32_t value = htonl(i);
+            ::memcpy(payload, &value, sizeof(value));
+            sndSock.addWrite(payload, sizeof(payload));
+            sndSock.write();
+        }
+    });
+
+    uint32_t numRcvd = 0;
+    int64_t  prevSeq = -1;
+    for (;;) {
+        const void* data;
+        size_t      nbytes;
+        ASSERT_TRUE(ring->next(data, nbytes));
+        ASSERT_EQ(sizeof(payload), nbytes);
+
+        // Datagrams are received in order and without duplication
+        uint32_t value;
+        ::memcpy(&value, data, sizeof(value));
+        const int64_t seq = ntohl(value);
+        ASSERT_LT(prevSeq, seq);
+        prevSeq = seq;
+
+        auto stats = ring->getStats();
+        if (++numRcvd + stats.drops == numDgrams)
+            break;
+    }
+    sender.join();
+
+    // Every datagram is accounted for and few, if any, were dropped
+    auto stats = ring->getStats();
+    EXPECT_EQ(numDgrams, numRcvd + stats.drops);
+    EXPECT_LE(stats.drops, numDgrams/10);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
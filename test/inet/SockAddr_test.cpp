@@ -19,15 +19,25 @@
  * limitations under the License.
  */
 
+#include "error.h"
 #include "SockAddr.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
 #include <gtest/gtest.h>
+#include <mutex>
+#include <netdb.h>
 #include <netinet/in.h>
 #include <stdexcept>
 #include <string>
 #include <string.h>
 #include <sys/socket.h>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace {
 
@@ -174,6 +184,181 @@ TEST_F(SockAddrTest, LessThanOperator) {
     EXPECT_FALSE(sockAddrIn6 < sockAddrIn6_1);
 }
 
+// Tests copying, equality, and hashing
+TEST_F(SockAddrTest, CopyAndHash) {
+    hycast::SockAddr copy = sockAddrIn_1;
+    EXPECT_TRUE(copy == sockAddrIn_1);
+    EXPECT_EQ(sockAddrIn_1.hash(), copy.hash());
+    EXPECT_EQ(std::hash<hycast::SockAddr>()(sockAddrIn_1),
+            std::hash<hycast::SockAddr>()(copy));
+    EXPECT_FALSE(sockAddrIn_1 == sockAddrIn_2);
+    EXPECT_NE(sockAddrIn_1.hash(), sockAddrIn_2.hash());
+
+    copy = sockAddrIn6_1;
+    EXPECT_TRUE(copy == sockAddrIn6_1);
+    EXPECT_EQ(sockAddrIn6_1.hash(), copy.hash());
+    EXPECT_FALSE(sockAddrIn6_1 == sockAddrIn_1);
+
+    copy = sockAddrName_1;
+    EXPECT_TRUE(copy == sockAddrName_1);
+    EXPECT_TRUE(copy == hycast::SockAddr(NAME_HOST1, PORT1));
+    EXPECT_EQ(sockAddrName_1.hash(),
+            hycast::SockAddr(NAME_HOST1, PORT1).hash());
+    EXPECT_FALSE(sockAddrName_1 == sockAddrName_2);
+}
+
+// Tests the performance of socket addresses as hash-table keys
+TEST_F(SockAddrTest, MapKey) {
+    // Copying is a memory copy, so it never allocates
+    EXPECT_TRUE(std::is_trivially_copyable<hycast::InetAddr>::value);
+    EXPECT_TRUE(std::is_trivially_copyable<hycast::SockAddr>::value);
+
+    const int                     numAddrs = 1000;
+    const int                     numLookups = 100000;
+    std::vector<hycast::SockAddr> addrs;
+
+    for (int i = 0; i < numAddrs; ++i)
+        addrs.push_back(hycast::SockAddr(htonl(0x0A000000 + i),
+                static_cast<in_port_t>(38800 + i%3)));
+
+    std::unordered_map<hycast::SockAddr, int> map;
+    for (int i = 0; i < numAddrs; ++i)
+        map[addrs[i]] = i;
+    ASSERT_EQ(numAddrs, map.size());
+
+    // Addresses that differ in a few low-order bits are spread over the buckets
+    size_t maxBucketSize = 0;
+    for (size_t i = 0; i < map.bucket_count(); ++i)
+        maxBucketSize = std::max(maxBucketSize, map.bucket_size(i));
+    EXPECT_LE(maxBucketSize, 8);
+
+    long sum = 0;
+    for (int i = 0; i < numLookups; ++i) {
+        const hycast::SockAddr key = addrs[i%numAddrs]; // Copy as in practice
+        sum += map.at(key);
+    }
+    EXPECT_EQ(static_cast<long>(numLookups/numAddrs)*
+            (numAddrs*(numAddrs-1)/2), sum);
+}
+
+// Tests cached resolution of hostnames
+TEST_F(SockAddrTest, NameResolution) {
+    typedef std::chrono::steady_clock Clock;
+
+    const hycast::SockAddr  localhost("localhost", PORT1);
+    struct sockaddr_storage storage;
+
+    localhost.get_sockaddr(storage);
+    EXPECT_TRUE(storage.ss_family == AF_INET || storage.ss_family == AF_INET6);
+    EXPECT_EQ(PORT1, hycast::SockAddr(storage).getPort());
+
+    // Failures are cached, too
+    const hycast::SockAddr bogus("no.such.host.invalid", PORT1);
+    EXPECT_THROW(bogus.get_sockaddr(storage), std::exception);
+    EXPECT_THROW(bogus.get_sockaddr(storage), std::exception);
+
+    // A cached resolution is much cheaper than calling the resolver
+    const int numResolutions = 1000;
+    auto      start = Clock::now();
+    for (int i = 0; i < numResolutions; ++i) {
+        struct addrinfo  hints = {};
+        struct addrinfo* list;
+        hints.ai_family = AF_UNSPEC;
+        ASSERT_EQ(0, ::getaddrinfo("localhost", nullptr, &hints, &list));
+        ::freeaddrinfo(list);
+    }
+    const auto uncached = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < numResolutions; ++i)
+        localhost.get_sockaddr(storage);
+    const auto cached = Clock::now() - start;
+
+    EXPECT_LT(5*cached, uncached);
+}
+
+// Tests waiting for a resolution without blocking
+TEST_F(SockAddrTest, WhenResolved) {
+    std::mutex              mutex;
+    std::condition_variable cond;
+    int                     numCalls = 0;
+    std::exception_ptr      error{};
+    const auto              resolved = [&](std::exception_ptr ptr) {
+        std::lock_guard<std::mutex> guard{mutex};
+        error = ptr;
+        ++numCalls;
+        cond.notify_all();
+    };
+    const auto              waitFor = [&](const int count) {
+        std::unique_lock<std::mutex> lock{mutex};
+        return cond.wait_for(lock, std::chrono::seconds(10),
+                [&]{return numCalls >= count;});
+    };
+
+    // An IP address is resolved immediately
+    hycast::SockAddr("127.0.0.1", PORT1).whenResolved(resolved);
+    EXPECT_EQ(1, numCalls);
+    EXPECT_FALSE(error);
+
+    // A hostname is resolved by the resolver pool
+    hycast::SockAddr("unresolvable.host.invalid", PORT1).whenResolved(resolved);
+    ASSERT_TRUE(waitFor(2));
+    EXPECT_TRUE(error);
+
+    // After which getting the socket address doesn't block
+    const hycast::SockAddr localhost("localhost", PORT1);
+    localhost.whenResolved(resolved);
+    ASSERT_TRUE(waitFor(3));
+    EXPECT_FALSE(error);
+    struct sockaddr_storage storage;
+    localhost.get_sockaddr(storage);
+    EXPECT_EQ(PORT1, hycast::SockAddr(storage).getPort());
+
+    EXPECT_THROW(hycast::SockAddr().whenResolved(resolved),
+            hycast::LogicError);
+}
+
+// Tests getting a socket address without blocking
+TEST_F(SockAddrTest, PeekSockaddr) {
+    struct sockaddr_storage storage;
+
+    // An IP address never blocks
+    EXPECT_TRUE(hycast::SockAddr("127.0.0.1", PORT1).peek_sockaddr(storage));
+    EXPECT_EQ(PORT1, hycast::SockAddr(storage).getPort());
+
+    // A hostname is available once it's been resolved
+    const hycast::SockAddr localhost("localhost", PORT1);
+    localhost.prefetch();
+    const auto timeout = std::chrono::steady_clock::now() +
+            std::chrono::seconds(10);
+    bool       peeked;
+    while (!(peeked = localhost.peek_sockaddr(storage)) &&
+            std::chrono::steady_clock::now() < timeout)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_TRUE(peeked);
+    EXPECT_EQ(PORT1, hycast::SockAddr(storage).getPort());
+
+    // A failed resolution is reported
+    const hycast::SockAddr invalid("unresolvable.host.invalid", PORT1);
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    done = false;
+    invalid.whenResolved([&](std::exception_ptr) {
+        std::lock_guard<std::mutex> guard{mutex};
+        done = true;
+        cond.notify_all();
+    });
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(10),
+                [&]{return done;}));
+    }
+    EXPECT_THROW(invalid.peek_sockaddr(storage), std::exception);
+
+    EXPECT_THROW(hycast::SockAddr().peek_sockaddr(storage),
+            hycast::LogicError);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
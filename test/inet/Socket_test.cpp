@@ -26,10 +26,14 @@
 #include "Socket.h"
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <mutex>
 #include <signal.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 namespace {
 
@@ -220,6 +224,23 @@ TEST_F(SocketTest, ShutdownClientSocket)
     srvrThread.join();
 }
 
+// Tests connecting to a hostname, which the resolver pool resolves
+TEST_F(SocketTest, ConnectToHostname)
+{
+    hycast::TcpSrvrSock lstnSock;
+    hycast::TcpSock     srvrSock;
+
+    startServer(lstnSock, srvrSock);
+    waitForState(LISTENING);
+
+    hycast::TcpClntSock clntSock(hycast::SockAddr("localhost", 38800));
+    EXPECT_EQ(true, clntSock.write(true));
+    waitForState(READ_SOMETHING);
+
+    clntSock.shutdown();
+    srvrThread.join();
+}
+
 // Tests round-trip scalar exchange
 TEST_F(SocketTest, ScalarExchange)
 {
@@ -264,6 +285,133 @@ TEST_F(SocketTest, VectorExchange)
     srvrThread.join();
 }
 
+// Tests reading whole multicast datagrams with UDP GRO enabled if possible
+TEST_F(SocketTest, UdpRead)
+{
+    hycast::SockAddr grpAddr("232.1.1.1:38801");
+    hycast::UdpSock  sndSock(grpAddr);
+    hycast::UdpSock  rcvSock(grpAddr, sndSock.getLclAddr().getInetAddr());
+    const bool       gro = rcvSock.enableGro(); // Reading must work either way
+
+    uint32_t numDgrams = 10;
+    for (uint32_t i = 0; i < numDgrams; ++i) {
+        sndSock.addWrite(i);
+        sndSock.addWrite(i);
+        sndSock.write();
+    }
+
+    if (gro) {
+        /*
+         * Have the kernel deliver a coalesced run by sending it as a single
+         * UDP GSO buffer from the same source
+         */
+        const int sd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_NE(-1, sd);
+        sndSock.getLclAddr().clone(0).bind(sd);
+        grpAddr.connect(sd);
+        const int segSize = 2*sizeof(uint32_t);
+        ASSERT_EQ(0, ::setsockopt(sd, IPPROTO_UDP, 103, &segSize,
+                sizeof(segSize))); // UDP_SEGMENT
+
+        uint32_t values[2*10];
+        for (int i = 0; i < 10; ++i)
+            values[2*i] = values[2*i+1] = htonl(numDgrams++);
+        ASSERT_EQ(sizeof(values), ::write(sd, values, sizeof(values)));
+        ::close(sd);
+    }
+
+    uint32_t next = 0;
+    bool     coalesced = false;
+    while (next < numDgrams) {
+        uint8_t buf[UINT16_MAX];
+        size_t  segSize;
+        size_t  nbytes = rcvSock.read(buf, sizeof(buf), segSize);
+        ASSERT_EQ(0, nbytes % (2*sizeof(uint32_t)));
+        ASSERT_EQ(2*sizeof(uint32_t), segSize);
+        coalesced |= nbytes > segSize;
+
+        for (size_t offset = 0; offset < nbytes; offset += segSize) {
+            uint32_t values[2];
+            ::memcpy(values, buf + offset, sizeof(values));
+            EXPECT_EQ(next, ntohl(values[0]));
+            EXPECT_EQ(next++, ntohl(values[1]));
+        }
+    }
+    EXPECT_EQ(gro, coalesced);
+
+    rcvSock.shutdown();
+    size_t segSize;
+    EXPECT_EQ(0, rcvSock.read(&segSize, sizeof(segSize), segSize));
+}
+
+// Tests zero-copy writing and the release of pins upon completion
+TEST_F(SocketTest, ZeroCopyWrite)
+{
+    hycast::SockAddr grpAddr("232.1.1.1:38802");
+    hycast::UdpSock  sndSock(grpAddr);
+    hycast::UdpSock  rcvSock(grpAddr, sndSock.getLclAddr().getInetAddr());
+
+    if (!sndSock.enableZeroCopy())
+        GTEST_SKIP() << "Zero-copy writing is unsupported";
+
+    char                 data[1000];
+    bool                 released = false;
+    hycast::UdpSock::Pin pin(data, [&released](const void*) {
+        released = true;
+    });
+    const uint32_t       numDgrams = 20; // Fits in receive buffer
+
+    for (uint32_t i = 0; i < numDgrams; ++i) {
+        ::memset(data, i, sizeof(data));
+        sndSock.addWrite(i);
+        sndSock.addWrite(data, sizeof(data));
+        sndSock.write(pin); // Loopback copies, so `data` may be reused
+    }
+    pin.reset();
+    sndSock.flush();
+    EXPECT_EQ(0, sndSock.getNumPinned());
+    EXPECT_TRUE(released);
+
+    /*
+     * Multicast loopback may drop or reorder datagrams, so they're read on a
+     * separate thread for a limited time and only what arrives is checked
+     */
+    std::vector<bool>       rcvd(numDgrams, false);
+    uint32_t                numRcvd = 0;
+    std::mutex              mutex;
+    std::condition_variable cond;
+    std::thread             reader([&] {
+        uint8_t buf[sizeof(uint32_t) + sizeof(data)];
+        size_t  segSize;
+        size_t  nbytes;
+        while ((nbytes = rcvSock.read(buf, sizeof(buf), segSize)) != 0) {
+            uint32_t value;
+            ASSERT_EQ(sizeof(buf), nbytes);
+            ::memcpy(&value, buf, sizeof(value));
+            value = ntohl(value);
+            ASSERT_GT(numDgrams, value);
+            uint8_t expect[sizeof(data)];
+            ::memset(expect, value, sizeof(expect));
+            EXPECT_EQ(0, ::memcmp(expect, buf + sizeof(value),
+                    sizeof(expect)));
+
+            std::lock_guard<std::mutex> guard{mutex};
+            EXPECT_FALSE(rcvd[value]); // No duplicates
+            rcvd[value] = true;
+            ++numRcvd;
+            cond.notify_one();
+        }
+    });
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        cond.wait_for(lock, std::chrono::seconds(1),
+                [&] { return numRcvd == numDgrams; });
+    }
+    rcvSock.shutdown(); // Causes `read()` to return 0
+    reader.join();
+    EXPECT_GT(numRcvd, 0u);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -29,13 +29,33 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <mutex>
+#include <new>
 #include <pthread.h>
 #include <random>
+#include <string>
 #include <stdexcept>
 #include <stdio.h>
+#include <stdlib.h>
 #include <thread>
 #include <unistd.h>
 
+/// Number of heap allocations by the current thread
+static thread_local unsigned long numAllocs = 0;
+
+void* operator new(const size_t size)
+{
+    ++numAllocs;
+    void* const ptr = ::malloc(size ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* const ptr) noexcept
+{
+    ::free(ptr);
+}
+
 namespace {
 
 // The fixture for testing class Future.
@@ -242,6 +262,145 @@ TEST_F(FutureTest, IntFutureException)
     thread.join();
 }
 
+/******************************************************************************/
+
+// Tests a continuation of an int future
+TEST_F(FutureTest, IntFutureContinuation)
+{
+    hycast::Future<int> future{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto next = future.then([](int result) {return result == 1;});
+    EXPECT_FALSE(next.hasCompleted());
+    future.setResult(1);
+    EXPECT_TRUE(next.hasCompleted());
+    EXPECT_TRUE(next.getResult());
+
+    // The task is already done
+    bool called{false};
+    future.then([&called](int result) {called = true;}).getResult();
+    EXPECT_TRUE(called);
+}
+
+// Tests a chain of continuations with a result that isn't a built-in type
+TEST_F(FutureTest, StringContinuation)
+{
+    hycast::Future<int> future{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto next = future.then([](int result) {return std::to_string(result);})
+            .then([](std::string str) {return str + str;});
+    future.setResult(1);
+    EXPECT_EQ(std::string("11"), next.getResult());
+
+    // Several continuations of one future
+    int sum{0};
+    hycast::Future<int> future2{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto next1 = future2.then([&sum](int result) {sum += result;});
+    auto next2 = future2.then([&sum](int result) {sum += 2*result;});
+    future2.setResult(1);
+    EXPECT_TRUE(next1.hasCompleted());
+    EXPECT_TRUE(next2.hasCompleted());
+    EXPECT_EQ(3, sum);
+}
+
+// Tests a continuation of a void future on another thread
+TEST_F(FutureTest, DispatchedContinuation)
+{
+    hycast::Future<void> future{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    std::thread          thread{};
+    const auto           dispatch = [&thread](hycast::BasicFuture::Callback
+            callback) {
+        thread = std::thread(callback);
+    };
+    auto next = future.then([]{return 2;}, dispatch);
+    future.setResult();
+    EXPECT_EQ(2, next.getResult());
+    thread.join();
+}
+
+// Tests propagation of an exception and cancellation to a continuation
+TEST_F(FutureTest, ContinuationFailure)
+{
+    hycast::Future<int> future1{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    bool called{false};
+    auto next1 = future1.then([&called](int result) {called = true;});
+    future1.setException(std::make_exception_ptr(std::out_of_range("test")));
+    EXPECT_THROW(next1.getResult(), std::out_of_range);
+    EXPECT_FALSE(called);
+
+    hycast::Future<int> future2{[&future2](bool mayInterrupt) {
+        future2.setCanceled();
+    }};
+    auto next2 = future2.then([&called](int result) {called = true;});
+    next2.cancel();
+    EXPECT_TRUE(future2.wasCanceled());
+    EXPECT_TRUE(next2.wasCanceled());
+    EXPECT_FALSE(called);
+
+    hycast::Future<void> future3{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto next3 = future3.then([]{throw std::out_of_range("test");});
+    future3.setResult();
+    EXPECT_THROW(next3.getResult(), std::out_of_range);
+}
+
+// Tests that futures and their continuations don't allocate from the heap
+// once the pool of shared states has free blocks
+TEST_F(FutureTest, NoHeapAllocation)
+{
+    const auto useFutures = [this] {
+        hycast::Future<int>  future{[this](bool mayInterrupt){
+                stop(mayInterrupt);}};
+        auto                 next = future.then([](int result) {
+                return result + 1;});
+        hycast::Future<void> future2{[this](bool mayInterrupt){
+                stop(mayInterrupt);}};
+        auto                 next2 = future2.then([]{return 2;});
+        future.setResult(1);
+        future2.setResult();
+        return next.getResult() + next2.getResult();
+    };
+
+    EXPECT_EQ(4, useFutures()); // Fills the pool
+    const auto before = numAllocs;
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(4, useFutures());
+    EXPECT_EQ(before, numAllocs);
+}
+
+// Tests waiting for all futures
+TEST_F(FutureTest, WhenAll)
+{
+    EXPECT_TRUE(hycast::whenAll({}).hasCompleted());
+
+    hycast::Future<void> future1{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    hycast::Future<int>  future2{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto all = hycast::whenAll({future1, future2});
+    future2.setResult(1);
+    EXPECT_FALSE(all.hasCompleted());
+    future1.setResult();
+    EXPECT_NO_THROW(all.getResult());
+
+    hycast::Future<int>  future3{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    hycast::Future<int>  future4{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    all = hycast::whenAll({future3, future4});
+    future3.setException(std::make_exception_ptr(std::out_of_range("test")));
+    future4.setResult(1);
+    EXPECT_THROW(all.getResult(), std::out_of_range);
+}
+
+// Tests waiting for any future
+TEST_F(FutureTest, WhenAny)
+{
+    EXPECT_THROW(hycast::whenAny({}), hycast::InvalidArgument);
+
+    hycast::Future<void> future1{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    hycast::Future<int>  future2{[this](bool mayInterrupt){stop(mayInterrupt);}};
+    auto any = hycast::whenAny({future1, future2});
+    EXPECT_FALSE(any.hasCompleted());
+    auto thread = std::thread([&future2]{usleep(100000); future2.setResult(1);});
+    EXPECT_EQ(1, any.getResult());
+    future1.setResult();
+    EXPECT_EQ(1, any.getResult());
+    thread.join();
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,100 @@
+/**
+ * This file tests cooperative cancellation of threads.
+ *
+ *       File: StopToken_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "StopToken.h"
+
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+/// The fixture for testing cooperative cancellation
+class StopTokenTest : public ::testing::Test
+{
+};
+
+// Tests default construction
+TEST_F(StopTokenTest, DefaultConstruction)
+{
+    hycast::StopToken token{};
+    EXPECT_FALSE(token.stopRequested());
+
+    bool called = false;
+    hycast::StopCallback callback{token, [&called]{called = true;}};
+    EXPECT_FALSE(called);
+}
+
+// Tests requesting a stop
+TEST_F(StopTokenTest, RequestStop)
+{
+    hycast::StopSource source{};
+    auto               token = source.getToken();
+    int                count = 0;
+
+    EXPECT_FALSE(token.stopRequested());
+    {
+        hycast::StopCallback callback1{token, [&count]{++count;}};
+        {
+            hycast::StopCallback callback2{token, [&count]{count += 10;}};
+        } // Deregistered
+        EXPECT_TRUE(source.requestStop());
+        EXPECT_FALSE(source.requestStop());
+    }
+    EXPECT_TRUE(token.stopRequested());
+    EXPECT_TRUE(source.stopRequested());
+    EXPECT_EQ(1, count);
+
+    // Already stopped
+    hycast::StopCallback callback{token, [&count]{++count;}};
+    EXPECT_EQ(2, count);
+}
+
+// Tests waking a thread that's waiting on a condition variable
+TEST_F(StopTokenTest, WakeWaiter)
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    hycast::StopSource      source{};
+    std::thread             thread([&] {
+        const auto           token = source.getToken();
+        hycast::StopCallback callback{token, [&] {
+            std::lock_guard<std::mutex> guard{mutex};
+            cond.notify_all();
+        }};
+        std::unique_lock<std::mutex> lock{mutex};
+        while (!token.stopRequested())
+            cond.wait(lock);
+    });
+
+    source.requestStop();
+    thread.join();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+/**
+ * This file tests class `WindowMap`.
+ *
+ *       File: WindowMap_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "WindowMap.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+/// The fixture for testing class `WindowMap`
+class WindowMapTest : public ::testing::Test
+{
+protected:
+    using Map = hycast::WindowMap<std::string>;
+};
+
+// Tests inserting, finding and erasing
+TEST_F(WindowMapTest, InsertFindErase)
+{
+    Map map{4};
+
+    EXPECT_EQ(0, map.size());
+    EXPECT_EQ(nullptr, map.find(1));
+
+    auto pair = map.insert(1, "1");
+    EXPECT_TRUE(pair.second);
+    EXPECT_EQ("1", *pair.first);
+
+    pair = map.insert(1, "one");
+    EXPECT_FALSE(pair.second);
+    EXPECT_EQ("1", *pair.first);
+
+    ASSERT_NE(nullptr, map.find(1));
+    EXPECT_EQ("1", *map.find(1));
+    EXPECT_EQ(1, map.size());
+
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_FALSE(map.erase(1));
+    EXPECT_EQ(nullptr, map.find(1));
+    EXPECT_EQ(0, map.size());
+}
+
+// Tests stragglers
+TEST_F(WindowMapTest, Stragglers)
+{
+    Map map{4};
+
+    for (uint32_t key = 0; key < 10; ++key)
+        EXPECT_TRUE(map.insert(key, std::to_string(key)).second);
+
+    // Keys 0 through 5 contended for slots with newer keys
+    EXPECT_EQ(10, map.size());
+    EXPECT_EQ(6, map.overflowSize());
+    for (uint32_t key = 0; key < 10; ++key) {
+        ASSERT_NE(nullptr, map.find(key));
+        EXPECT_EQ(std::to_string(key), *map.find(key));
+    }
+
+    // An old key that arrives late goes into the overflow map
+    EXPECT_TRUE(map.erase(2));
+    EXPECT_TRUE(map.insert(2, "2").second);
+    EXPECT_EQ(6, map.overflowSize());
+    EXPECT_EQ("10", *map.insert(10, "10").first);
+    EXPECT_EQ("2", *map.find(2));
+}
+
+// Tests wrap-around of keys
+TEST_F(WindowMapTest, WrapAround)
+{
+    hycast::WindowMap<int, uint8_t> map{4};
+
+    EXPECT_TRUE(map.insert(254, 254).second);
+    EXPECT_TRUE(map.insert(2, 2).second); // Same slot. Newer.
+    EXPECT_EQ(1, map.overflowSize());
+    EXPECT_EQ(254, *map.find(254));
+    EXPECT_EQ(2, *map.find(2));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
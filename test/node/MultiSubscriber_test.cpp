@@ -0,0 +1,113 @@
+/**
+ * This file tests class `MultiSubscriber`
+ *
+ *       File: MultiSubscriber_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FileUtil.h"
+#include "logging.h"
+#include "MultiSubscriber.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using Feed = hycast::MultiSubscriber::Feed;
+
+/// The fixture for testing class `MultiSubscriber`
+class MultiSubscriberTest : public ::testing::Test
+{
+protected:
+    const std::string     repoRoot;
+    const hycast::SegSize segSize;
+
+    MultiSubscriberTest()
+        : repoRoot("/tmp/MultiSubscriber_test")
+        , segSize{1000}
+    {}
+
+    ~MultiSubscriberTest()
+    {
+        hycast::rmDirTree(repoRoot);
+    }
+
+    static Feed feed(
+            const std::string& name,
+            const in_port_t    port) {
+        return Feed{name,
+                hycast::SrcMcastAddrs{hycast::SockAddr{"232.1.1.1", port},
+                        hycast::InetAddr{"127.0.0.1"}},
+                hycast::P2pInfo{hycast::SockAddr{"127.0.0.1", port}, 0, 3},
+                hycast::ServerPool{}};
+    }
+};
+
+// Tests invalid construction
+TEST_F(MultiSubscriberTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::MultiSubscriber("", segSize),
+            hycast::InvalidArgument);
+    EXPECT_THROW(hycast::MultiSubscriber(repoRoot, segSize, 0),
+            hycast::InvalidArgument);
+    EXPECT_THROW(hycast::MultiSubscriber(repoRoot, segSize, 10,
+            hycast::WriteBehind::Policy(2, 2)), hycast::InvalidArgument);
+}
+
+// Tests adding feeds
+TEST_F(MultiSubscriberTest, Add)
+{
+    hycast::MultiSubscriber multiSub{repoRoot, segSize};
+
+    EXPECT_EQ(0, multiSub.size());
+    multiSub.add(feed("a", 38800)).add(feed("b", 38801));
+    EXPECT_EQ(2, multiSub.size());
+}
+
+// Tests adding invalid feeds
+TEST_F(MultiSubscriberTest, InvalidAdd)
+{
+    hycast::MultiSubscriber multiSub{repoRoot, segSize};
+
+    EXPECT_THROW(multiSub.add(feed("", 38800)), hycast::InvalidArgument);
+    EXPECT_THROW(multiSub.add(feed(".", 38800)), hycast::InvalidArgument);
+    EXPECT_THROW(multiSub.add(feed("..", 38800)), hycast::InvalidArgument);
+    EXPECT_THROW(multiSub.add(feed("a/b", 38800)), hycast::InvalidArgument);
+
+    multiSub.add(feed("a", 38800));
+    EXPECT_THROW(multiSub.add(feed("a", 38801)), hycast::InvalidArgument);
+    EXPECT_EQ(1, multiSub.size());
+}
+
+// Tests executing without feeds
+TEST_F(MultiSubscriberTest, NoFeeds)
+{
+    hycast::MultiSubscriber multiSub{repoRoot, segSize};
+
+    EXPECT_THROW(multiSub(), hycast::LogicError);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+/**
+ * This file tests class `NackAggregator`
+ *
+ *       File: NackAggregator_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "NackAggregator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Action = hycast::NackAggregator::Action;
+
+/// The fixture for testing class `NackAggregator`
+class NackAggregatorTest : public ::testing::Test
+{
+protected:
+    static const unsigned NUM_PEERS = 20;
+    hycast::ProdIndex     prodIndex;
+    hycast::SegId         segId;
+
+    NackAggregatorTest()
+        : prodIndex{1}
+        , segId{prodIndex, 0}
+    {}
+};
+
+// Tests invalid construction
+TEST_F(NackAggregatorTest, InvalidConstruction)
+{
+    EXPECT_FALSE(hycast::NackAggregator());
+    EXPECT_THROW(hycast::NackAggregator(0), hycast::InvalidArgument);
+    EXPECT_THROW(hycast::NackAggregator(1.1), hycast::InvalidArgument);
+    EXPECT_THROW(hycast::NackAggregator(0.5, 0), hycast::InvalidArgument);
+    EXPECT_THROW(hycast::NackAggregator(0.5, 1, 1), hycast::InvalidArgument);
+}
+
+// Tests a segment that few peers request
+TEST_F(NackAggregatorTest, FewRequests)
+{
+    hycast::NackAggregator aggregator(0.25, 0.05);
+
+    for (unsigned i = 0; i < NUM_PEERS/4; ++i)
+        EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(0, aggregator.getNumRemcast());
+
+    // The requesters' re-requests are answered after the window
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    for (unsigned i = 0; i < NUM_PEERS/4; ++i)
+        EXPECT_EQ(Action::UNICAST, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(NUM_PEERS/4, aggregator.getNumDeferred());
+}
+
+// Tests a segment that many peers request
+TEST_F(NackAggregatorTest, ManyRequests)
+{
+    hycast::NackAggregator aggregator(0.25);
+
+    for (unsigned i = 0; i < NUM_PEERS/4; ++i)
+        EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(Action::REMULTICAST, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+
+    // Other segments are unaffected
+    const hycast::SegId otherId{prodIndex, 1000};
+    EXPECT_EQ(Action::DEFER, aggregator.add(otherId, NUM_PEERS));
+
+    EXPECT_EQ(1, aggregator.getNumRemcast());
+    EXPECT_EQ(NUM_PEERS/4 + 2, aggregator.getNumDeferred());
+}
+
+// Tests that a re-request after a re-multicast is answered
+TEST_F(NackAggregatorTest, LostRemcast)
+{
+    hycast::NackAggregator aggregator(0.25, 0.05);
+
+    for (unsigned i = 0; i <= NUM_PEERS/4; ++i)
+        aggregator.add(segId, NUM_PEERS);
+    EXPECT_EQ(1, aggregator.getNumRemcast());
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(Action::UNICAST, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(1, aggregator.getNumRemcast());
+}
+
+// Tests forgetting a segment after the retention time
+TEST_F(NackAggregatorTest, Retention)
+{
+    hycast::NackAggregator aggregator(0.25, 0.02, 0.05);
+
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(Action::UNICAST, aggregator.add(segId, NUM_PEERS));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+}
+
+// Tests answering collected requests when their window closes
+TEST_F(NackAggregatorTest, Closed)
+{
+    std::mutex                 mutex;
+    std::condition_variable    cond;
+    std::vector<hycast::SegId> closed;
+    hycast::NackAggregator     aggregator(0.25, 0.05,
+            hycast::NackAggregator::RETENTION,
+            [&](const hycast::SegId& segId) {
+                std::lock_guard<std::mutex> guard{mutex};
+                closed.push_back(segId);
+                cond.notify_all();
+            });
+
+    const hycast::SegId otherId{prodIndex, 1000};
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(Action::DEFER, aggregator.add(segId, NUM_PEERS));
+    EXPECT_EQ(Action::DEFER, aggregator.add(otherId, NUM_PEERS));
+
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        EXPECT_TRUE(cond.wait_for(lock, std::chrono::seconds(1),
+                [&] { return closed.size() == 2; }));
+    }
+
+    // Each window closes once, in the order in which they opened
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    std::lock_guard<std::mutex> guard{mutex};
+    ASSERT_EQ(2, closed.size());
+    EXPECT_EQ(segId, closed[0]);
+    EXPECT_EQ(otherId, closed[1]);
+}
+
+// Tests the publisher's upstream data-segments under correlated loss
+TEST_F(NackAggregatorTest, CorrelatedLoss)
+{
+    const unsigned         numSegs = 100;  // Lost by every peer
+    hycast::NackAggregator aggregator(0.25);
+    unsigned long          numSent = 0;
+
+    for (hycast::ProdSize offset = 0; offset < numSegs; ++offset) {
+        const hycast::SegId lostId{prodIndex, offset};
+        for (unsigned peer = 0; peer < NUM_PEERS; ++peer)
+            if (aggregator.add(lostId, NUM_PEERS) != Action::DEFER)
+                ++numSent;
+    }
+
+    // Each segment is sent once instead of once per peer
+    EXPECT_EQ(numSegs, aggregator.getNumRemcast());
+    EXPECT_EQ(numSegs, numSent);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
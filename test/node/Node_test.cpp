@@ -26,6 +26,7 @@
 #include "hycast.h"
 #include "Node.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <fcntl.h>
 #include <gtest/gtest.h>
@@ -36,10 +37,61 @@
 
 namespace {
 
+/// Manager of a subscriber-peer that only reports on its multicast reception
+class ReportingPeerMgr final : public hycast::XcvrPeerMgr
+{
+public:
+    hycast::ProdInfo getProdInfo(
+            const hycast::SockAddr&,
+            const hycast::ProdIndex) override {
+        return hycast::ProdInfo{};
+    }
+    hycast::MemSeg getMemSeg(
+            const hycast::SockAddr&,
+            const hycast::SegId&) override {
+        return hycast::MemSeg{};
+    }
+    void pathToPub(const hycast::SockAddr&) override {
+    }
+    void noPathToPub(const hycast::SockAddr&) override {
+    }
+    bool shouldRequest(
+            const hycast::SockAddr&,
+            const hycast::ProdIndex) override {
+        return false;
+    }
+    bool shouldRequest(
+            const hycast::SockAddr&,
+            const hycast::SegId&) override {
+        return false;
+    }
+    bool hereIs(
+            const hycast::SockAddr&,
+            const hycast::ProdInfo&) override {
+        return false;
+    }
+    bool hereIs(
+            const hycast::SockAddr&,
+            hycast::TcpSeg&) override {
+        return false;
+    }
+};
+
 /// The fixture for testing class `Node`
 class NodeTest : public ::testing::Test
 {
 protected:
+    /**
+     * Removes a directory tree so that the repositories start empty.
+     *
+     * @param[in] dir  Pathname of the root of the tree
+     * @return         The pathname
+     */
+    static std::string rmTree(const std::string& dir) {
+        hycast::rmDirTree(dir);
+        return dir;
+    }
+
     std::mutex                mutex;
     std::condition_variable   cond;
     char                      memData[1000];
@@ -78,11 +130,11 @@ protected:
         , prodIndex{1}
         , prodSize{5000}
         , prodName{"foo/bar/product.dat"}
-        , testRoot("/tmp/Node_test")
+        , testRoot(rmTree("/tmp/Node_test"))
         , pubRepoRoot(testRoot + "/pub")
         , subRepoRoot(testRoot + "/sub")
-        , pubRepo() // Can't initialize because `rmDirTree(testRoot)`
-        , subRepo() // Can't initialize because `rmDirTree(testRoot)`
+        , pubRepo(pubRepoRoot, segSize)
+        , subRepo(subRepoRoot, segSize)
         , filePath(testRoot + "/" + prodName)
         , prodInfo{prodIndex, prodSize, prodName}
         , segId(prodIndex, 0)
@@ -103,10 +155,7 @@ protected:
         , p2pSrvrPool{std::set<hycast::SockAddr>{pubSockAddr}}
         , numPeers{0}
     {
-        hycast::rmDirTree(testRoot);
         ::memset(memData, 0xbd, segSize);
-        pubRepo = hycast::PubRepo(pubRepoRoot, segSize);
-        subRepo = hycast::SubRepo(subRepoRoot, segSize);
     }
 
     virtual ~NodeTest() {
@@ -213,6 +262,43 @@ TEST_F(NodeTest, Sending)
     }
 }
 
+// Tests that a subscriber's reception report changes the multicast rate
+TEST_F(NodeTest, RateCtl)
+{
+    const double      maxRate = 1e8;
+    hycast::P2pInfo   p2pInfo{.sockAddr=hycast::SockAddr("127.0.0.1:38810"),
+            .listenSize=listenSize, .maxPeers=maxPeers};
+    hycast::Publisher publisher(p2pInfo, grpSockAddr, pubRepo);
+
+    publisher.setRateCtl(maxRate/100, maxRate);
+    EXPECT_EQ(maxRate, publisher.getRate());
+
+    std::thread pubThread(&NodeTest::runNode, std::ref(publisher));
+
+    // Connect to the publisher as a subscriber
+    ReportingPeerMgr peerMgr{};
+    hycast::Peer     peer(p2pInfo.sockAddr,
+            hycast::NodeType::NO_PATH_TO_PUBLISHER, peerMgr);
+    std::thread      peerThread(&hycast::Peer::operator(), peer);
+
+    /*
+     * Report heavy loss in two reporting intervals. The second report ends the
+     * first interval, which halves the rate.
+     */
+    peer.report(0.5, maxRate/4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    peer.report(0.5, maxRate/4);
+
+    for (int i = 0; i < 100 && publisher.getRate() == maxRate; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(maxRate/2, publisher.getRate());
+
+    peer.halt();
+    peerThread.join();
+    publisher.halt();
+    pubThread.join();
+}
+
 }  // namespace
 
 static void myTerminate()
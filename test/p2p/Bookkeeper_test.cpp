@@ -6,6 +6,7 @@
 
 #include <condition_variable>
 #include <gtest/gtest.h>
+#include <list>
 #include <mutex>
 #include <thread>
 
@@ -124,6 +125,66 @@ TEST_F(BookkeeperTest, ShouldRequest)
     EXPECT_TRUE(bookkeeper.shouldRequest(peer2, segId));
 }
 
+// Tests striping requests across peers and stealing a stalled peer's requests
+TEST_F(BookkeeperTest, Swarming)
+{
+    hycast::SubBookkeeper bookkeeper{8, true};
+    const int             numSegs = 100;
+    std::list<DataSegId>  requests1;
+    std::list<DataSegId>  requests2;
+
+    bookkeeper.add(peer1);
+    bookkeeper.add(peer2);
+
+    for (int i = 0; i < numSegs; ++i) {
+        DataSegId segId(prodIndex, i*hycast::DataSeg::CANON_DATASEG_SIZE);
+        if (bookkeeper.shouldRequest(peer1, segId))
+            requests1.push_back(segId);
+        if (bookkeeper.shouldRequest(peer2, segId))
+            requests2.push_back(segId);
+    }
+    EXPECT_LT(0, requests1.size());
+    EXPECT_LT(0, requests2.size());
+    EXPECT_GT(numSegs, requests1.size() + requests2.size()); // Windows
+
+    // Only the second peer responds
+    int numRecvd = 0;
+    while (!requests2.empty()) {
+        bookkeeper.received(peer2, requests2.front());
+        requests2.pop_front();
+        ++numRecvd;
+
+        DataSegId segId;
+        while (bookkeeper.getRequest(peer2, segId))
+            requests2.push_back(segId);
+    }
+    EXPECT_EQ(numSegs, numRecvd); // Including stolen requests
+
+    // Late arrival of a stolen request
+    bookkeeper.received(peer1, requests1.front());
+    DataSegId segId;
+    EXPECT_FALSE(bookkeeper.getRequest(peer1, segId));
+}
+
+// Tests reassignment of a removed peer's requests in swarming mode
+TEST_F(BookkeeperTest, SwarmingRemoval)
+{
+    hycast::SubBookkeeper bookkeeper{8, true};
+
+    bookkeeper.add(peer1);
+    bookkeeper.add(peer2);
+
+    EXPECT_TRUE(bookkeeper.shouldRequest(peer1, segId));
+    EXPECT_FALSE(bookkeeper.shouldRequest(peer2, segId));
+    EXPECT_THROW(bookkeeper.shouldRequest(peer2, segId), LogicError);
+
+    EXPECT_TRUE(bookkeeper.remove(peer1));
+    DataSegId reqSegId;
+    ASSERT_TRUE(bookkeeper.getRequest(peer2, reqSegId));
+    EXPECT_EQ(segId, reqSegId);
+    EXPECT_FALSE(bookkeeper.getRequest(peer2, reqSegId));
+}
+
 #if 0
 // Tests data exchange
 TEST_F(BookkeeperTest, DataExchange)
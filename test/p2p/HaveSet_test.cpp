@@ -0,0 +1,156 @@
+/**
+ * This file tests class `HaveSet`.
+ *
+ *       File: HaveSet_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "HaveSet.h"
+#include "logging.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing class `HaveSet`
+class HaveSetTest : public ::testing::Test
+{
+protected:
+    static const SegSize SEG_SIZE = DataSeg::CANON_DATASEG_SIZE;
+    ProdIndex            prodIndex;
+
+    HaveSetTest()
+        : prodIndex{1}
+    {}
+};
+
+// Tests invalid construction
+TEST_F(HaveSetTest, InvalidConstruction)
+{
+    EXPECT_THROW(HaveSet(0), InvalidArgument);
+    EXPECT_THROW(HaveSet(1, 0), InvalidArgument);
+}
+
+// Tests product information
+TEST_F(HaveSetTest, ProdInfo)
+{
+    HaveSet haveSet{};
+
+    EXPECT_FALSE(haveSet.has(prodIndex));
+    haveSet.add(DataSegId(prodIndex, 0));
+    EXPECT_FALSE(haveSet.has(prodIndex)); // Segment isn't product information
+    haveSet.add(prodIndex);
+    EXPECT_TRUE(haveSet.has(prodIndex));
+    EXPECT_EQ(1, haveSet.size());
+}
+
+// Tests data-segments
+TEST_F(HaveSetTest, DataSegs)
+{
+    HaveSet haveSet{};
+
+    for (SegOffset i = 0; i < 200; i += 3)
+        haveSet.add(DataSegId(prodIndex, i*SEG_SIZE));
+
+    for (SegOffset i = 0; i < 300; ++i)
+        ASSERT_EQ(i < 200 && i % 3 == 0,
+                haveSet.has(DataSegId(prodIndex, i*SEG_SIZE)));
+
+    EXPECT_FALSE(haveSet.has(DataSegId(ProdIndex(2), 0)));
+}
+
+// Tests ignoring data-segments beyond the maximum number per product
+TEST_F(HaveSetTest, OutOfRange)
+{
+    HaveSet haveSet{2, 128};
+
+    haveSet.add(DataSegId(prodIndex, 127*SEG_SIZE));
+    EXPECT_TRUE(haveSet.has(DataSegId(prodIndex, 127*SEG_SIZE)));
+
+    haveSet.add(DataSegId(prodIndex, 128*SEG_SIZE));
+    EXPECT_FALSE(haveSet.has(DataSegId(prodIndex, 128*SEG_SIZE)));
+
+    // A bogus notice neither allocates a bitmap nor evicts a product
+    haveSet.add(DataSegId(ProdIndex(2), UINT32_MAX));
+    EXPECT_EQ(1, haveSet.size());
+
+    Inventory inventory{};
+    inventory.partial.push_back(Inventory::PartialProd{3, false,
+            std::vector<uint64_t>(4, ~uint64_t(0))});
+    haveSet.add(inventory);
+    EXPECT_TRUE(haveSet.has(DataSegId(ProdIndex(3), 127*SEG_SIZE)));
+    EXPECT_FALSE(haveSet.has(DataSegId(ProdIndex(3), 128*SEG_SIZE)));
+}
+
+// Tests eviction of the oldest product
+TEST_F(HaveSetTest, Eviction)
+{
+    HaveSet haveSet{2};
+
+    haveSet.add(ProdIndex(1));
+    haveSet.add(DataSegId(ProdIndex(2), 0));
+    haveSet.add(DataSegId(ProdIndex(1), SEG_SIZE)); // Doesn't refresh
+    haveSet.add(ProdIndex(3));
+
+    EXPECT_EQ(2, haveSet.size());
+    EXPECT_FALSE(haveSet.has(ProdIndex(1)));
+    EXPECT_FALSE(haveSet.has(DataSegId(ProdIndex(1), SEG_SIZE)));
+    EXPECT_TRUE(haveSet.has(DataSegId(ProdIndex(2), 0)));
+    EXPECT_TRUE(haveSet.has(ProdIndex(3)));
+}
+
+// Tests adding an inventory
+TEST_F(HaveSetTest, Inventory)
+{
+    HaveSet   haveSet{};
+    Inventory inventory{};
+
+    inventory.addComplete(ProdIndex(1));
+    inventory.addComplete(ProdIndex(2));
+    inventory.addComplete(ProdIndex(4));
+    EXPECT_EQ(2, inventory.complete.size());
+
+    inventory.add(ProdIndex(5));
+    inventory.add(DataSegId(ProdIndex(5), 2*SEG_SIZE));
+    inventory.add(DataSegId(ProdIndex(6), 0));
+    EXPECT_EQ(2, inventory.partial.size());
+
+    haveSet.add(inventory);
+
+    for (ProdIndex::Type i = 1; i <= 4; ++i) {
+        EXPECT_EQ(i != 3, haveSet.has(ProdIndex(i)));
+        EXPECT_EQ(i != 3, haveSet.has(DataSegId(ProdIndex(i), 9*SEG_SIZE)));
+    }
+    EXPECT_TRUE(haveSet.has(ProdIndex(5)));
+    EXPECT_FALSE(haveSet.has(DataSegId(ProdIndex(5), SEG_SIZE)));
+    EXPECT_TRUE(haveSet.has(DataSegId(ProdIndex(5), 2*SEG_SIZE)));
+    EXPECT_FALSE(haveSet.has(ProdIndex(6)));
+    EXPECT_TRUE(haveSet.has(DataSegId(ProdIndex(6), 0)));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,273 @@
+/**
+ * This file tests class `McastMonitor`.
+ *
+ *       File: McastMonitor_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "McastMonitor.h"
+#include "McastRateCtl.h"
+#include "P2pNode.h"
+#include "PeerSet.h"
+
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing class `McastMonitor`
+class McastMonitorTest : public ::testing::Test, public P2pNode,
+        public McastRcvr
+{
+protected:
+    static const SegSize  SEG_SIZE = DataSeg::CANON_DATASEG_SIZE;
+    static const int      NUM_SEGS = 10; ///< Data-segments per product
+    static const ProdSize PROD_SIZE = NUM_SEGS*SEG_SIZE;
+    static constexpr double MAX_RATE = 1e8; ///< Maximum multicast rate
+    char                    memData[SEG_SIZE];
+    int                     numProdInfos; ///< Number forwarded
+    int                     numDataSegs;  ///< Number forwarded
+    SockAddr                pubAddr;
+    std::mutex              mutex;
+    std::condition_variable cond;
+    McastRateCtl            rateCtl;      ///< Publisher's rate controller
+    int                     numReports;   ///< Number received by publisher
+
+    McastMonitorTest()
+        : memData{}
+        , numProdInfos(0)
+        , numDataSegs(0)
+        , pubAddr{"localhost:38800"}
+        , mutex()
+        , cond()
+        , rateCtl(MAX_RATE/100, MAX_RATE, 0.01, 0.01)
+        , numReports(0)
+    {}
+
+    /**
+     * Connects a subscriber's peer-set to a publisher's peer-set. Returns
+     * when the subscriber's peer knows that its remote peer is a path to the
+     * publisher.
+     *
+     * @param[in] pubPeerSet  Publisher's peer-set
+     * @param[in] subPeerSet  Subscriber's peer-set
+     * @return                Subscriber's peer
+     */
+    Peer connect(
+            PeerSet& pubPeerSet,
+            PeerSet& subPeerSet) {
+        PeerSrvr    peerSrvr{*this, pubAddr};
+        std::thread srvrThread([&] {
+            pubPeerSet.insert(peerSrvr.accept(), true);
+        });
+
+        Peer subPeer{*this, pubAddr};
+        subPeerSet.insert(subPeer);
+        srvrThread.join();
+
+        for (int i = 0; !subPeer.rmtIsPubPath() && i < 1000; ++i)
+            ::usleep(1000);
+        return subPeer;
+    }
+
+    /**
+     * Multicasts a data-segment.
+     *
+     * @param[in] monitor    Multicast monitor
+     * @param[in] prodIndex  Index of product
+     * @param[in] segNum     Origin-0 index of data-segment in product
+     * @param[in] prodSize   Size of product in bytes
+     */
+    void mcast(
+            McastMonitor&   monitor,
+            const ProdIndex prodIndex,
+            const int       segNum,
+            const ProdSize  prodSize = PROD_SIZE) {
+        monitor.recvMcast(DataSeg{DataSegId(prodIndex, segNum*SEG_SIZE),
+                prodSize, memData});
+    }
+
+public:
+    // Multicast receiver
+    void recvMcast(const ProdInfo prodInfo) override {
+        ++numProdInfos;
+    }
+    void recvMcast(const DataSeg dataSeg) override {
+        ++numDataSegs;
+    }
+
+    // P2P node. Only the publisher receives reports.
+    void recvNotice(const McastReport notice, Peer peer) override {
+        rateCtl.report(notice.lossRate(), notice.rcvRate);
+        std::lock_guard<std::mutex> guard{mutex};
+        ++numReports;
+        cond.notify_all();
+    }
+    void recvNotice(const PubPath notice, Peer peer) override {}
+    bool recvNotice(const ProdIndex notice, Peer peer) override {
+        return false;
+    }
+    bool recvNotice(const DataSegId notice, Peer peer) override {
+        return false;
+    }
+    ProdInfo recvRequest(const ProdIndex request, Peer peer) override {
+        return ProdInfo{};
+    }
+    DataSeg recvRequest(const DataSegId request, Peer peer) override {
+        return DataSeg{};
+    }
+    void recvData(const ProdInfo data, Peer peer) override {}
+    void recvData(const DataSeg data, Peer peer) override {}
+};
+
+const int McastMonitorTest::NUM_SEGS;
+constexpr double McastMonitorTest::MAX_RATE;
+
+// Tests default construction
+TEST_F(McastMonitorTest, DefaultConstruction)
+{
+    McastMonitor monitor{};
+    EXPECT_FALSE(monitor);
+}
+
+// Tests reception without loss
+TEST_F(McastMonitorTest, NoLoss)
+{
+    PeerSet      peerSet{*this, 0.1};
+    McastMonitor monitor{*this, peerSet};
+    ASSERT_TRUE(monitor);
+
+    for (ProdIndex::Type i = 1; i <= 3; ++i) {
+        monitor.recvMcast(ProdInfo{i, "product", PROD_SIZE});
+        for (int j = 0; j < NUM_SEGS; ++j)
+            mcast(monitor, i, j);
+    }
+
+    EXPECT_EQ(3, numProdInfos);
+    EXPECT_EQ(3*NUM_SEGS, numDataSegs);
+    EXPECT_EQ(3*NUM_SEGS, monitor.getNumRcvd());
+    EXPECT_EQ(0, monitor.getNumLost());
+    EXPECT_EQ(0, peerSet.getMcastLoss());
+    EXPECT_TRUE(peerSet.isNackMode());
+}
+
+// Tests detection of lost data-segments
+TEST_F(McastMonitorTest, Gaps)
+{
+    PeerSet      peerSet{*this, 0.1};
+    McastMonitor monitor{*this, peerSet};
+
+    mcast(monitor, 1, 0);
+    mcast(monitor, 1, 2); // Segment 1 lost
+    mcast(monitor, 1, 3);
+    mcast(monitor, 2, 0); // Segments 4 through 9 of product 1 lost
+    mcast(monitor, 1, 1); // Late: forwarded but not counted
+    mcast(monitor, 2, 9); // Segments 1 through 8 lost
+
+    EXPECT_EQ(6, numDataSegs);
+    EXPECT_EQ(5, monitor.getNumRcvd());
+    EXPECT_EQ(1 + 6 + 8, monitor.getNumLost());
+    EXPECT_LT(0, peerSet.getMcastLoss());
+}
+
+// Tests that a lossy multicast switches the remote peers to full notices
+TEST_F(McastMonitorTest, LossEndsNackMode)
+{
+    PeerSet      peerSet{*this, 0.1};
+    McastMonitor monitor{*this, peerSet};
+
+    ASSERT_TRUE(peerSet.isNackMode());
+    for (ProdIndex::Type i = 1; i <= 100; ++i)
+        for (int j = 0; j < NUM_SEGS; j += 2)
+            mcast(monitor, i, j); // Every other segment is lost
+
+    EXPECT_EQ(100*NUM_SEGS/2, monitor.getNumRcvd());
+    EXPECT_EQ(100*NUM_SEGS/2 - 1, monitor.getNumLost()); // Last isn't known
+    EXPECT_LT(0.1, peerSet.getMcastLoss());
+    EXPECT_FALSE(peerSet.isNackMode());
+}
+
+// Tests invalid construction
+TEST_F(McastMonitorTest, InvalidConstruction)
+{
+    PeerSet peerSet{*this};
+    EXPECT_THROW(McastMonitor(*this, peerSet, 0), InvalidArgument);
+}
+
+// Tests the limits on forwarding a report
+TEST_F(McastMonitorTest, Forwarding)
+{
+    PeerSet pubPeerSet{*this};
+    PeerSet subPeerSet{*this};
+    auto    subPeer = connect(pubPeerSet, subPeerSet);
+    ASSERT_TRUE(subPeer.rmtIsPubPath());
+
+    McastReport report{0.5, 1e6};
+    EXPECT_FALSE(subPeerSet.notify(report, subPeer)); // Not back to source
+    report.numHops = McastReport::MAX_HOPS;
+    EXPECT_FALSE(subPeerSet.notify(report));
+    report.numHops = McastReport::MAX_HOPS - 1;
+    EXPECT_TRUE(subPeerSet.notify(report));
+
+    std::unique_lock<std::mutex> lock{mutex};
+    while (numReports == 0)
+        cond.wait(lock);
+    EXPECT_EQ(1, numReports);
+}
+
+// Tests that a subscriber's reports lower the publisher's multicast rate
+TEST_F(McastMonitorTest, ReportsDriveRateCtl)
+{
+    PeerSet pubPeerSet{*this};
+    PeerSet subPeerSet{*this, 0.1};
+    auto    subPeer = connect(pubPeerSet, subPeerSet);
+    ASSERT_TRUE(subPeer.rmtIsPubPath());
+
+    McastMonitor monitor{*this, subPeerSet, 0.005};
+    for (ProdIndex::Type i = 1; i <= 20; ++i) {
+        for (int j = 0; j < NUM_SEGS; j += 2)
+            mcast(monitor, i, j); // Every other segment is lost
+        ::usleep(2000);
+    }
+    const auto numSent = monitor.getNumReports();
+    EXPECT_LT(1, numSent);
+
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        while (numReports < numSent)
+            cond.wait(lock);
+    }
+    rateCtl.endInterval();
+
+    // A 50% loss-rate is way above the maximum
+    EXPECT_GT(MAX_RATE/2, rateCtl.getRate());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
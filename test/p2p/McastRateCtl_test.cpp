@@ -0,0 +1,140 @@
+/**
+ * This file tests class `McastRateCtl`
+ *
+ *       File: McastRateCtl_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "McastRateCtl.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// The fixture for testing class `McastRateCtl`
+class McastRateCtlTest : public ::testing::Test
+{
+protected:
+    const double minRate;
+    const double maxRate;
+    const double maxLoss;
+    const double interval; ///< Long enough that only `endInterval()` ends one
+
+    McastRateCtlTest()
+        : minRate{1e6}
+        , maxRate{100e6}
+        , maxLoss{0.01}
+        , interval{3600}
+    {}
+};
+
+// Tests invalid construction
+TEST_F(McastRateCtlTest, InvalidConstruction)
+{
+    EXPECT_FALSE(hycast::McastRateCtl());
+    EXPECT_THROW(hycast::McastRateCtl(0, maxRate), hycast::InvalidArgument);
+    EXPECT_THROW(hycast::McastRateCtl(maxRate, minRate),
+            hycast::InvalidArgument);
+    EXPECT_THROW(hycast::McastRateCtl(minRate, maxRate, 1),
+            hycast::InvalidArgument);
+    EXPECT_THROW(hycast::McastRateCtl(minRate, maxRate, maxLoss, 0),
+            hycast::InvalidArgument);
+}
+
+// Tests that no reports means no change
+TEST_F(McastRateCtlTest, NoReports)
+{
+    hycast::McastRateCtl rateCtl(minRate, maxRate, maxLoss, interval);
+    EXPECT_EQ(maxRate, rateCtl.getRate());
+    EXPECT_FALSE(rateCtl.endInterval());
+    EXPECT_EQ(maxRate, rateCtl.getRate());
+}
+
+// Tests tracking of the worst receiver
+TEST_F(McastRateCtlTest, WorstReceiver)
+{
+    hycast::McastRateCtl rateCtl(minRate, maxRate, maxLoss, interval);
+
+    // One receiver is behind a 60 MB/s link
+    for (int i = 0; i < 50; ++i) {
+        const auto rate = rateCtl.getRate();
+        const auto lossRate = rate > 60e6 ? 1 - 60e6/rate : 0;
+        rateCtl.report(0, rate);
+        rateCtl.report(lossRate, rate*(1 - lossRate));
+        rateCtl.endInterval();
+    }
+    EXPECT_NEAR(60e6, rateCtl.getRate(), 3e6);
+
+    // No one loses much: the rate probes upward to the maximum
+    for (int i = 0; i < 100; ++i) {
+        rateCtl.report(maxLoss/2, rateCtl.getRate());
+        rateCtl.endInterval();
+    }
+    EXPECT_EQ(maxRate, rateCtl.getRate());
+}
+
+// Tests the limits
+TEST_F(McastRateCtlTest, Limits)
+{
+    hycast::McastRateCtl rateCtl(minRate, maxRate, maxLoss, interval);
+
+    // A receive-rate of nearly zero halves the rate at most
+    rateCtl.report(0.5, 1);
+    EXPECT_TRUE(rateCtl.endInterval());
+    EXPECT_EQ(maxRate/2, rateCtl.getRate());
+
+    for (int i = 0; i < 100; ++i) {
+        rateCtl.report(0.5, 1);
+        rateCtl.endInterval();
+    }
+    EXPECT_EQ(minRate, rateCtl.getRate());
+}
+
+// Tests the trade-off between multicast rate and repair load
+TEST_F(McastRateCtlTest, RepairLoad)
+{
+    hycast::McastRateCtl rateCtl(minRate, maxRate, maxLoss, interval);
+    const double         linkRate = 50e6;  // Slowest link in the tree
+    double               sent = 0;         // Multicast bytes
+    double               repaired = 0;     // P2P repair bytes
+
+    // Everything above the link's capacity is lost and must be repaired
+    for (int i = 0; i < 1000; ++i) {
+        const auto rate = rateCtl.getRate();
+        const auto lossRate = rate > linkRate ? 1 - linkRate/rate : 0;
+        sent += rate;
+        repaired += rate*lossRate;
+        rateCtl.report(lossRate, rate*(1 - lossRate));
+        rateCtl.endInterval();
+    }
+
+    // Repair costs about the maximum loss-rate and the link stays busy
+    EXPECT_GT(2*maxLoss, repaired/sent);
+    EXPECT_LT(0.8*linkRate, sent/1000);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
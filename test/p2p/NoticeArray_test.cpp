@@ -0,0 +1,233 @@
+/**
+ * This file tests class `NoticeArray`.
+ *
+ *       File: NoticeArray_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "NoticeArray.h"
+
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing class `NoticeArray`
+class NoticeArrayTest : public ::testing::Test, public hycast::P2pNode
+{
+protected:
+    static const SegSize    SEG_SIZE = DataSeg::CANON_DATASEG_SIZE;
+    SockAddr                pubAddr;
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    listening;
+    std::set<ProdIndex>     prodNotices;  ///< Received product notices
+    int                     segNoticeCount;
+
+    NoticeArrayTest()
+        : pubAddr{"localhost:38802"}
+        , mutex{}
+        , cond{}
+        , listening{false}
+        , prodNotices{}
+        , segNoticeCount{0}
+    {}
+
+    /**
+     * Adds, to a notice array, a product notice followed by notices of some
+     * of its data-segments.
+     */
+    void put(NoticeArray& noticeArray, const ProdIndex prodIndex,
+            const int numSegs) {
+        noticeArray.putProdIndex(prodIndex);
+        for (int i = 0; i < numSegs; ++i)
+            noticeArray.put(DataSegId(prodIndex, i*SEG_SIZE));
+    }
+
+public:
+    void startPubPeer(Peer& pubPeer)
+    {
+        PeerSrvr peerSrvr{*this, pubAddr};
+        {
+            std::lock_guard<decltype(mutex)> guard{mutex};
+            listening = true;
+            cond.notify_all();
+        }
+
+        pubPeer = peerSrvr.accept();
+        ASSERT_TRUE(pubPeer);
+        ASSERT_TRUE(pubPeer.start());
+    }
+
+    void waitUntilListening()
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while (!listening)
+            cond.wait(lock);
+    }
+
+    void waitForProdNotices(const size_t count)
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while (prodNotices.size() < count)
+            cond.wait(lock);
+    }
+
+    void recvNotice(const PubPath notice, Peer peer) override {
+    }
+
+    // Subscriber-side. Nothing is requested.
+    bool recvNotice(const ProdIndex notice, Peer peer) override {
+        std::lock_guard<decltype(mutex)> guard{mutex};
+        prodNotices.insert(notice);
+        cond.notify_all();
+        return false;
+    }
+
+    // Subscriber-side. Nothing is requested.
+    bool recvNotice(const DataSegId notice, Peer peer) override {
+        std::lock_guard<decltype(mutex)> guard{mutex};
+        ++segNoticeCount;
+        return false;
+    }
+
+    ProdInfo recvRequest(const ProdIndex request, Peer peer) override {
+        ADD_FAILURE();
+        return ProdInfo{};
+    }
+
+    DataSeg recvRequest(const DataSegId request, Peer peer) override {
+        ADD_FAILURE();
+        return DataSeg{};
+    }
+
+    void recvData(const ProdInfo data, Peer peer) override {
+        ADD_FAILURE();
+    }
+
+    void recvData(const DataSeg data, Peer peer) override {
+        ADD_FAILURE();
+    }
+};
+
+// Tests invalid construction
+TEST_F(NoticeArrayTest, InvalidConstruction)
+{
+    EXPECT_THROW(NoticeArray(*this, 0), InvalidArgument);
+}
+
+// Tests that the array is bounded
+TEST_F(NoticeArrayTest, Bounded)
+{
+    NoticeArray noticeArray{*this, 3};
+
+    put(noticeArray, ProdIndex(1), 9);
+    EXPECT_EQ(10, noticeArray.getWriteIndex());
+    EXPECT_EQ(7, noticeArray.getOldestIndex());
+
+    // Erasing to before the oldest notice does nothing
+    noticeArray.eraseTo(5);
+    EXPECT_EQ(7, noticeArray.getOldestIndex());
+
+    noticeArray.eraseTo(9);
+    EXPECT_EQ(9, noticeArray.getOldestIndex());
+}
+
+// Tests resynchronization of a peer that fell too far behind
+TEST_F(NoticeArrayTest, Resync)
+{
+    Peer        pubPeer{};
+    std::thread srvrThread(&NoticeArrayTest::startPubPeer, this,
+            std::ref(pubPeer));
+
+    try {
+        waitUntilListening();
+
+        Peer subPeer(*this, pubAddr);
+        ASSERT_TRUE(subPeer.start());
+        srvrThread.join();
+
+        NoticeArray noticeArray{*this, 4};
+        put(noticeArray, ProdIndex(1), 3); // Indexes 0-3
+        put(noticeArray, ProdIndex(2), 3); // Indexes 4-7
+        ASSERT_EQ(4, noticeArray.getOldestIndex());
+
+        // The notices of the first product were erased
+        ArrayIndex index{0};
+        ASSERT_TRUE(noticeArray.send(index, pubPeer));
+        EXPECT_EQ(4, index);
+        EXPECT_EQ(1ul, noticeArray.getNumResyncs());
+        waitForProdNotices(2);
+        EXPECT_EQ(1, prodNotices.count(ProdIndex(1)));
+        EXPECT_EQ(1, prodNotices.count(ProdIndex(2)));
+
+        // Sending continues normally
+        ASSERT_TRUE(noticeArray.send(index, pubPeer));
+        EXPECT_EQ(5, index);
+        EXPECT_EQ(1ul, noticeArray.getNumResyncs());
+
+        subPeer.stop();
+        pubPeer.stop();
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        ADD_FAILURE();
+        pubPeer.stop();
+        if (srvrThread.joinable())
+            srvrThread.join();
+    }
+}
+
+// Tests stopping a peer that's waiting for a notice
+TEST_F(NoticeArrayTest, Stop)
+{
+    NoticeArray noticeArray{*this};
+    StopSource  stopSource{};
+    Peer        peer{};
+    ArrayIndex  index{noticeArray.getWriteIndex()};
+    bool        sent = true;
+    std::thread thread([&] {
+        sent = noticeArray.send(index, peer, stopSource.getToken());
+    });
+
+    ::usleep(100000);
+    EXPECT_TRUE(stopSource.requestStop());
+    thread.join();
+    EXPECT_FALSE(sent);
+    EXPECT_EQ(0, index);
+
+    // A stopped peer doesn't wait
+    EXPECT_FALSE(noticeArray.send(index, peer, stopSource.getToken()));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
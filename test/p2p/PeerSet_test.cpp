@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace {
 
@@ -46,12 +47,16 @@ protected:
     char                    memData[hycast::DataSeg::CANON_DATASEG_SIZE];
     hycast::DataSeg         dataSeg;
     int                     pubPathNoticeCount;
+    int                     nackModeNoticeCount;
     int                     prodInfoNoticeCount;
     int                     dataSegNoticeCount;
     int                     prodInfoRequestCount;
     int                     dataSegRequestCount;
     int                     prodInfoCount;
     int                     dataSegCount;
+    int                     inventoryCount;
+    hycast::Inventory       inventory;
+    hycast::Peer            dataSegPeer;  ///< Peer that last received segment
 
     static const int        NUM_SUBSCRIBERS = 4;
 
@@ -68,12 +73,16 @@ protected:
         , memData{}
         , dataSeg{segId, prodSize, memData}
         , pubPathNoticeCount(0)
+        , nackModeNoticeCount(0)
         , prodInfoNoticeCount(0)
         , dataSegNoticeCount(0)
         , prodInfoRequestCount(0)
         , dataSegRequestCount(0)
         , prodInfoCount(0)
         , dataSegCount(0)
+        , inventoryCount(0)
+        , inventory()
+        , dataSegPeer()
     {
         ::memset(memData, 0xbd, segSize);
     }
@@ -92,6 +101,36 @@ public:
             cond.wait(lock);
     }
 
+    void waitForBits(const State bits)
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while ((state & bits) != bits)
+            cond.wait(lock);
+    }
+
+    void waitForNackModeNotices(const int count)
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while (nackModeNoticeCount < count)
+            cond.wait(lock);
+    }
+
+    void waitForInventories(const int count)
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while (inventoryCount < count)
+            cond.wait(lock);
+    }
+
+    /// Returns the peer that received the last data-segment
+    hycast::Peer waitForDataSegs(const int count)
+    {
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        while (dataSegCount < count)
+            cond.wait(lock);
+        return dataSegPeer;
+    }
+
     // Publisher-side
     bool isPublisher() const override {
         LOG_TRACE;
@@ -113,6 +152,31 @@ public:
         ++pubPathNoticeCount;
     }
 
+    // Publisher-side
+    void recvNotice(const hycast::NackMode notice, Peer peer) override
+    {
+        LOG_TRACE;
+        std::lock_guard<std::mutex> guard{mutex};
+        ++nackModeNoticeCount;
+        cond.notify_all();
+    }
+
+    // Both sides
+    hycast::Inventory getInventory() const override
+    {
+        return inventory;
+    }
+
+    // Both sides
+    void recvNotice(const hycast::Inventory& notice, Peer peer) override
+    {
+        LOG_TRACE;
+        EXPECT_TRUE(notice.isComplete(prodIndex));
+        std::lock_guard<std::mutex> guard{mutex};
+        ++inventoryCount;
+        cond.notify_all();
+    }
+
     // Subscriber-side
     bool recvNotice(const hycast::ProdIndex notice, Peer peer)
             override
@@ -187,8 +251,10 @@ public:
         ASSERT_EQ(segSize, actualDataSeg.size());
         EXPECT_EQ(0, ::memcmp(dataSeg.data(), actualDataSeg.data(), segSize));
         std::lock_guard<std::mutex> guard{mutex};
+        dataSegPeer = peer;
         if (++dataSegCount == NUM_SUBSCRIBERS)
             orState(SEG_RCVD);
+        cond.notify_all();
     }
 
     void offline(hycast::Peer peer) {
@@ -260,6 +326,205 @@ TEST_F(PeerSetTest, DataExchange)
     }
 }
 
+// Tests suppression of notices that the remote peers don't need
+TEST_F(PeerSetTest, RedundantNotices)
+{
+    try {
+        hycast::PeerSet pubPeerSet{*this};
+        std::thread     srvrThread{&PeerSetTest::startPublisher, this,
+                std::ref(pubPeerSet)};
+
+        waitForState(LISTENING);
+
+        hycast::PeerSet subPeerSet{*this};
+        for (int i = 0; i < NUM_SUBSCRIBERS; ++i) {
+            hycast::Peer subPeer{*this, pubAddr};
+            ASSERT_TRUE(subPeerSet.insert(subPeer));
+        }
+
+        ASSERT_TRUE(srvrThread.joinable());
+        srvrThread.join();
+
+        pubPeerSet.notify(prodIndex);
+        pubPeerSet.notify(segId);
+        waitForState(DONE);
+        EXPECT_EQ(0, pubPeerSet.getSuppressionRatio());
+
+        // The subscribers have what was sent to them
+        pubPeerSet.notify(prodIndex);
+        pubPeerSet.notify(segId);
+        for (int i = 0; i < 1000 &&
+                pubPeerSet.getNumRedundant() < 2*NUM_SUBSCRIBERS; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(static_cast<unsigned long>(2*NUM_SUBSCRIBERS),
+                pubPeerSet.getNumRedundant());
+        EXPECT_EQ(0.5, pubPeerSet.getSuppressionRatio());
+        EXPECT_EQ(+NUM_SUBSCRIBERS, prodInfoNoticeCount);
+        EXPECT_EQ(+NUM_SUBSCRIBERS, dataSegNoticeCount);
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        ADD_FAILURE();
+    }
+}
+
+// Tests the exchange of inventories
+TEST_F(PeerSetTest, Inventory)
+{
+    try {
+        // Both sides already have the product
+        inventory.addComplete(prodIndex);
+
+        hycast::PeerSet pubPeerSet{*this};
+        pubPeerSet.notify(prodIndex); // Won't be replayed
+
+        std::thread     srvrThread{&PeerSetTest::startPublisher, this,
+                std::ref(pubPeerSet)};
+
+        waitForState(LISTENING);
+
+        hycast::PeerSet subPeerSet{*this};
+        for (int i = 0; i < NUM_SUBSCRIBERS; ++i) {
+            hycast::Peer subPeer{*this, pubAddr};
+            ASSERT_TRUE(subPeerSet.insert(subPeer));
+        }
+
+        ASSERT_TRUE(srvrThread.joinable());
+        srvrThread.join();
+        waitForInventories(2*NUM_SUBSCRIBERS); // Both directions
+
+        // The subscribers are known to have the product
+        pubPeerSet.notify(segId);
+        for (int i = 0; i < 1000 &&
+                pubPeerSet.getNumRedundant() < NUM_SUBSCRIBERS; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(static_cast<unsigned long>(NUM_SUBSCRIBERS),
+                pubPeerSet.getNumRedundant());
+        EXPECT_EQ(0ul, pubPeerSet.getNumResyncs());
+        EXPECT_EQ(0, prodInfoNoticeCount);
+        EXPECT_EQ(0, dataSegNoticeCount);
+
+        // Periodic inventory
+        pubPeerSet.notify(inventory);
+        waitForInventories(3*NUM_SUBSCRIBERS);
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        ADD_FAILURE();
+    }
+}
+
+// Tests NACK-mode
+TEST_F(PeerSetTest, NackMode)
+{
+    EXPECT_THROW(hycast::PeerSet(*this, -0.1), hycast::InvalidArgument);
+    EXPECT_THROW(hycast::PeerSet(*this, 1), hycast::InvalidArgument);
+
+    try {
+        hycast::PeerSet pubPeerSet{*this};
+        std::thread     srvrThread{&PeerSetTest::startPublisher, this,
+                std::ref(pubPeerSet)};
+
+        waitForState(LISTENING);
+
+        // The subscribers are receiving the multicast well
+        hycast::PeerSet subPeerSet{*this, 0.1};
+        EXPECT_TRUE(subPeerSet.isNackMode());
+        for (int i = 0; i < NUM_SUBSCRIBERS; ++i) {
+            hycast::Peer subPeer{*this, pubAddr};
+            ASSERT_TRUE(subPeerSet.insert(subPeer));
+        }
+
+        ASSERT_TRUE(srvrThread.joinable());
+        srvrThread.join();
+        waitForNackModeNotices(NUM_SUBSCRIBERS);
+
+        // Only the product notice is sent
+        pubPeerSet.notify(prodIndex);
+        pubPeerSet.notify(segId);
+        waitForBits(static_cast<State>(PROD_REQUEST_RCVD | PROD_INFO_RCVD));
+        for (int i = 0; i < 1000 &&
+                pubPeerSet.getNumSuppressed() < NUM_SUBSCRIBERS; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(static_cast<unsigned long>(NUM_SUBSCRIBERS),
+                pubPeerSet.getNumSuppressed());
+        EXPECT_EQ(0, dataSegNoticeCount);
+
+        // The multicast becomes lossy
+        for (int i = 0; i < 1000 && subPeerSet.isNackMode(); ++i)
+            subPeerSet.mcastOutcome(false);
+        EXPECT_FALSE(subPeerSet.isNackMode());
+        EXPECT_LT(0.1, subPeerSet.getMcastLoss());
+        waitForNackModeNotices(2*NUM_SUBSCRIBERS);
+
+        // The data-segment notice is sent and the segment requested
+        pubPeerSet.notify(segId);
+        waitForState(DONE);
+        EXPECT_EQ(static_cast<unsigned long>(NUM_SUBSCRIBERS),
+                pubPeerSet.getNumSuppressed());
+
+        // The multicast recovers
+        for (int i = 0; i < 10000 && !subPeerSet.isNackMode(); ++i)
+            subPeerSet.mcastOutcome(true);
+        EXPECT_TRUE(subPeerSet.isNackMode());
+        EXPECT_GT(0.05, subPeerSet.getMcastLoss());
+        waitForNackModeNotices(3*NUM_SUBSCRIBERS);
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        ADD_FAILURE();
+    }
+}
+
+// Tests swarming, including the reassignment of a removed peer's request
+TEST_F(PeerSetTest, Swarming)
+{
+    try {
+        hycast::PeerSet pubPeerSet{*this};
+        std::thread     srvrThread{&PeerSetTest::startPublisher, this,
+                std::ref(pubPeerSet)};
+
+        waitForState(LISTENING);
+
+        hycast::PeerSet           subPeerSet{*this, 0,
+                hycast::NoticeArray::MAX_NOTICES, true};
+        std::vector<hycast::Peer> subPeers;
+        for (int i = 0; i < NUM_SUBSCRIBERS; ++i) {
+            subPeers.push_back(hycast::Peer{*this, pubAddr});
+            ASSERT_TRUE(subPeerSet.insert(subPeers.back()));
+        }
+
+        ASSERT_TRUE(srvrThread.joinable());
+        srvrThread.join();
+
+        // Every remote peer has the data-segment, but only one peer should
+        // request it
+        hycast::Peer requester{};
+        int          numRequesters = 0;
+        for (auto& subPeer : subPeers) {
+            if (subPeerSet.shouldRequest(subPeer, segId)) {
+                requester = subPeer;
+                ++numRequesters;
+            }
+        }
+        EXPECT_EQ(1, numRequesters);
+        ASSERT_TRUE(requester);
+
+        /*
+         * The requesting peer leaves, so another peer makes the request. An
+         * idle peer might duplicate it because it's the tail of the product.
+         */
+        ASSERT_TRUE(subPeerSet.erase(requester));
+        const auto dataPeer = waitForDataSegs(1);
+        EXPECT_NE(requester, dataPeer);
+        subPeerSet.received(dataPeer, segId);
+    }
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        ADD_FAILURE();
+    }
+}
+
 }  // namespace
 
 static void myTerminate()
@@ -5,15 +5,51 @@
 #include "Peer.h"
 
 #include <condition_variable>
+#include <dirent.h>
 #include <gtest/gtest.h>
 #include <mutex>
+#include <set>
 #include <signal.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 namespace {
 
 using namespace hycast;
 
+/// Returns the number of open file descriptors of this process
+static int numOpenFds()
+{
+    DIR* const dir = ::opendir("/proc/self/fd");
+    int        num = 0;
+
+    if (dir) {
+        while (::readdir(dir))
+            ++num;
+        ::closedir(dir);
+    }
+    return num;
+}
+
+/**
+ * Waits for the number of open file descriptors to return to a given value.
+ * Sockets are released asynchronously by the threads that accepted them.
+ *
+ * @param[in] numFds  Expected number of open file descriptors
+ * @return            Actual number of open file descriptors
+ */
+static int waitForFds(const int numFds)
+{
+    int num = numOpenFds();
+
+    for (int i = 0; num != numFds && i < 100; ++i) {
+        ::usleep(10000);
+        num = numOpenFds();
+    }
+    return num;
+}
+
 /// The fixture for testing class `Peer`
 class PeerTest : public ::testing::Test, public hycast::P2pNode
 {
@@ -27,6 +63,7 @@ protected:
         SEG_REQUEST_RCVD  = 0x20,
         PROD_INFO_RCVD    = 0x40,
         SEG_RCVD          = 0x80,
+        UNAVAIL_RCVD      = 0x100,
         DONE = LISTENING |
                PROD_NOTICE_RCVD |
                SEG_NOTICE_RCVD |
@@ -44,6 +81,7 @@ protected:
     hycast::SegSize         segSize;
     hycast::ProdInfo        prodInfo;
     hycast::DataSegId       segId;
+    hycast::DataSegId       unavailId; ///< ID of segment publisher lacks
     char                    memData[hycast::DataSeg::CANON_DATASEG_SIZE];
     hycast::DataSeg         dataSeg;
 
@@ -57,6 +95,7 @@ protected:
         , segSize{sizeof(memData)}
         , prodInfo{prodIndex, "product", prodSize}
         , segId(prodIndex, sizeof(memData)) // Second data-segment
+        , unavailId(prodIndex, 2*sizeof(memData)) // Third data-segment
         , memData{}
         , dataSeg{segId, prodSize, memData}
     {
@@ -137,11 +176,21 @@ public:
                                 Peer peer) override
     {
         LOG_TRACE;
-        EXPECT_EQ(segId, request);
         orState(SEG_REQUEST_RCVD);
+        if (request == unavailId)
+            return hycast::DataSeg{};
+        EXPECT_EQ(segId, request);
         return dataSeg;
     }
 
+    // Subscriber-side
+    void recvUnavail(const hycast::DataSegId actualSegId, Peer peer) override
+    {
+        LOG_TRACE;
+        EXPECT_EQ(unavailId, actualSegId);
+        orState(UNAVAIL_RCVD);
+    }
+
     // Subscriber-side
     void recvData(const hycast::ProdInfo data, Peer peer) override
     {
@@ -306,6 +355,38 @@ TEST_F(PeerTest, DataExchange)
     }
 }
 
+// Tests a request for a data-segment that the remote peer doesn't have
+TEST_F(PeerTest, UnavailableSegment)
+{
+    hycast::Peer pubPeer{};
+    std::thread srvrThread(&PeerTest::startPubPeer, this, std::ref(pubPeer));
+
+    try {
+        waitForState(LISTENING);
+
+        hycast::Peer subPeer(*this, pubAddr);
+        ASSERT_TRUE(subPeer);
+        ASSERT_TRUE(subPeer.start());
+
+        ASSERT_TRUE(srvrThread.joinable());
+        srvrThread.join();
+
+        // As in NACK-mode, the request isn't preceded by a notice
+        ASSERT_TRUE(subPeer.request(unavailId));
+
+        waitForState(static_cast<State>(LISTENING | SEG_REQUEST_RCVD |
+                UNAVAIL_RCVD));
+        subPeer.stop();
+        pubPeer.stop();
+    } // `srvrThread` created
+    catch (const std::exception& ex) {
+        LOG_ERROR(ex);
+        pubPeer.stop();
+        if (srvrThread.joinable())
+            srvrThread.join();
+    }
+}
+
 // Tests broken connection
 TEST_F(PeerTest, BrokenConnection)
 {
@@ -355,6 +436,74 @@ TEST_F(PeerTest, BrokenConnection)
     }
 }
 
+// Tests repeated joins of a subscribing peer to a publishing peer
+TEST_F(PeerTest, RepeatedJoins)
+{
+    const int        numJoins = 100;
+    hycast::PeerSrvr peerSrvr{*this, pubAddr};
+    const int        numFds = numOpenFds();
+    int              numJoined = 0;
+
+    for (int i = 0; i < numJoins; ++i) {
+        hycast::Peer subPeer(*this, pubAddr);
+        ASSERT_TRUE(subPeer.start());
+        hycast::Peer pubPeer = peerSrvr.accept();
+        ASSERT_TRUE(pubPeer);
+        ASSERT_TRUE(pubPeer.start());
+        ++numJoined;
+
+        subPeer.stop();
+        pubPeer.stop();
+    }
+
+    EXPECT_EQ(numJoins, numJoined);
+    EXPECT_EQ(numFds, waitForFds(numFds)); // No sockets were leaked
+}
+
+// Tests simultaneous joins with one and with several accepting threads
+TEST_F(PeerTest, MultiAcceptor)
+{
+    const int numPeers = 64;
+
+    for (unsigned numAcceptors : {1, 4}) {
+        hycast::PeerSrvr   peerSrvr{*this, pubAddr, numPeers, numAcceptors};
+        const int          numFds = numOpenFds();
+        {
+            std::vector<hycast::Peer> subPeers;
+            for (int i = 0; i < numPeers; ++i)
+                subPeers.push_back(hycast::Peer(*this, pubAddr));
+
+            std::vector<std::thread> threads;
+            for (auto& subPeer : subPeers)
+                threads.push_back(std::thread([&subPeer]{
+                    EXPECT_TRUE(subPeer.start());}));
+
+            std::vector<hycast::Peer> pubPeers;
+            for (int i = 0; i < numPeers; ++i) {
+                pubPeers.push_back(peerSrvr.accept());
+                ASSERT_TRUE(pubPeers.back());
+            }
+
+            for (auto& thread : threads)
+                thread.join();
+
+            // Each peer's sockets were assembled correctly
+            std::set<hycast::SockAddr> rmtAddrs;
+            for (auto& pubPeer : pubPeers) {
+                ASSERT_TRUE(pubPeer.start());
+                rmtAddrs.insert(pubPeer.getRmtAddr());
+            }
+            EXPECT_EQ(numPeers, rmtAddrs.size());
+
+            for (auto& subPeer : subPeers)
+                subPeer.stop();
+            for (auto& pubPeer : pubPeers)
+                pubPeer.stop();
+        }
+        EXPECT_EQ(numFds, waitForFds(numFds)); // No sockets were leaked
+    }
+}
+
 }  // namespace
 
 static void myTerminate()
@@ -0,0 +1,341 @@
+/**
+ * This file tests random linear network coding.
+ *
+ *       File: Rlnc_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "logging.h"
+#include "Rlnc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing random linear network coding
+class RlncTest : public ::testing::Test
+{
+protected:
+    static const unsigned NUM_PEERS = 4;   ///< Number of peers with product
+    static const unsigned NUM_TRIALS = 200;
+    ProdIndex             prodIndex;
+    ProdSize              prodSize;        ///< 2.5 blocks
+    std::vector<char>     prodData;
+    std::minstd_rand      random;
+
+    RlncTest()
+        : prodIndex{1}
+        , prodSize{BlockId::SIZE*5/2}
+        , prodData(prodSize)
+        , random{1}
+    {
+        for (auto& byte : prodData)
+            byte = random();
+    }
+
+    /**
+     * Returns the number of packets that the peers send until the subscriber
+     * has every data-segment of a block when each peer independently sends
+     * the segments in its own random order (i.e., no coordination).
+     */
+    unsigned uncoordinatedSegs(
+            const unsigned numSegs,
+            const double   lossRate)
+    {
+        std::bernoulli_distribution        lost{lossRate};
+        std::vector<std::vector<unsigned>> orders(NUM_PEERS);
+        std::vector<bool>                  have(numSegs, false);
+        unsigned                           numHave = 0;
+        unsigned                           numSent = 0;
+
+        for (auto& order : orders) {
+            for (unsigned i = 0; i < numSegs; ++i)
+                order.push_back(i);
+            std::shuffle(order.begin(), order.end(), random);
+        }
+
+        for (unsigned i = 0; numHave < numSegs; i = (i + 1) % numSegs) {
+            for (auto& order : orders) {
+                ++numSent;
+                if (!lost(random) && !have[order[i]]) {
+                    have[order[i]] = true;
+                    if (++numHave == numSegs)
+                        break;
+                }
+            }
+        }
+
+        return numSent;
+    }
+
+    /**
+     * Returns the number of packets that the peers send until the subscriber
+     * can decode a block when each peer independently sends coded segments.
+     */
+    unsigned uncoordinatedCoded(
+            const BlockId& blockId,
+            const double   lossRate)
+    {
+        std::bernoulli_distribution lost{lossRate};
+        std::vector<RlncEncoder>    encoders;
+        RlncDecoder                 decoder(blockId, prodSize);
+        unsigned                    numSent = 0;
+
+        for (unsigned i = 0; i < NUM_PEERS; ++i)
+            encoders.push_back(RlncEncoder(blockId, prodSize,
+                    prodData.data() + blockId.offset));
+
+        while (!decoder.isDecoded()) {
+            for (auto& encoder : encoders) {
+                ++numSent;
+                auto codedSeg = encoder.encode();
+                if (!lost(random) && decoder.add(codedSeg) &&
+                        decoder.isDecoded())
+                    break;
+            }
+        }
+
+        return numSent;
+    }
+
+    /**
+     * Returns the number of request rounds until the subscriber has every
+     * data-segment of a block when each missing segment is requested from a
+     * peer and lost responses are re-requested in the next round.
+     */
+    unsigned requestedSegs(
+            const unsigned numSegs,
+            const double   lossRate,
+            unsigned&      numSent)
+    {
+        std::bernoulli_distribution lost{lossRate};
+        unsigned                    numMissing = numSegs;
+        unsigned                    numRounds = 0;
+
+        for (; numMissing; ++numRounds) {
+            const auto numRequests = numMissing;
+            for (unsigned i = 0; i < numRequests; ++i) {
+                ++numSent;
+                if (!lost(random))
+                    --numMissing;
+            }
+        }
+
+        return numRounds;
+    }
+
+    /**
+     * Returns the number of request rounds until the subscriber can decode a
+     * block when it requests as many coded segments as its rank deficit.
+     */
+    unsigned requestedCoded(
+            const BlockId& blockId,
+            const double   lossRate,
+            unsigned&      numSent)
+    {
+        std::bernoulli_distribution lost{lossRate};
+        RlncEncoder                 encoder(blockId, prodSize,
+                prodData.data() + blockId.offset);
+        RlncDecoder                 decoder(blockId, prodSize);
+        unsigned                    numRounds = 0;
+
+        for (; !decoder.isDecoded(); ++numRounds) {
+            const auto numRequests = decoder.getNumSegs() - decoder.getRank();
+            for (unsigned i = 0; i < numRequests; ++i) {
+                ++numSent;
+                auto codedSeg = encoder.encode();
+                if (!lost(random))
+                    decoder.add(codedSeg);
+            }
+        }
+
+        return numRounds;
+    }
+};
+
+// Tests GF(2^8) arithmetic
+TEST_F(RlncTest, Gf256Arithmetic)
+{
+    EXPECT_EQ(0xC1, Gf256::mul(0x57, 0x83)); // FIPS-197, section 4.2
+    EXPECT_EQ(0x01, Gf256::mul(0x53, 0xCA));
+    EXPECT_EQ(0, Gf256::mul(0, 0x53));
+
+    for (unsigned a = 1; a < 256; ++a) {
+        EXPECT_EQ(1, Gf256::mul(a, Gf256::inv(a)));
+        for (unsigned b = 0; b < 256; ++b)
+            ASSERT_EQ(Gf256::mul(a, b), Gf256::mul(b, a));
+    }
+
+    EXPECT_THROW(Gf256::inv(0), InvalidArgument);
+}
+
+// Tests the bulk operations against the scalar product
+TEST_F(RlncTest, BulkOperations)
+{
+    LOG_NOTE("Bulk implementation is %s", Gf256::getImpl());
+
+    const size_t         nbytes = 1001; // Exercises the scalar tail
+    std::vector<uint8_t> src(nbytes);
+    std::vector<uint8_t> dst(nbytes);
+    std::vector<uint8_t> expect(nbytes);
+
+    for (unsigned c = 0; c < 256; ++c) {
+        for (size_t i = 0; i < nbytes; ++i) {
+            src[i] = random();
+            dst[i] = random();
+            expect[i] = dst[i] ^ Gf256::mul(c, src[i]);
+        }
+        Gf256::mulAdd(dst.data(), src.data(), c, nbytes);
+        ASSERT_EQ(expect, dst);
+
+        for (size_t i = 0; i < nbytes; ++i)
+            expect[i] = Gf256::mul(c, dst[i]);
+        Gf256::scale(dst.data(), c, nbytes);
+        ASSERT_EQ(expect, dst);
+    }
+}
+
+// Tests invalid blocks
+TEST_F(RlncTest, InvalidBlock)
+{
+    EXPECT_THROW(RlncDecoder(BlockId(prodIndex, 1), prodSize),
+            InvalidArgument);
+    EXPECT_THROW(RlncDecoder(BlockId(prodIndex, 3*BlockId::SIZE), prodSize),
+            InvalidArgument);
+}
+
+// Tests decoding every block of a product from one peer
+TEST_F(RlncTest, RoundTrip)
+{
+    for (ProdSize offset = 0; offset < prodSize; offset += BlockId::SIZE) {
+        const BlockId blockId(prodIndex, offset);
+        RlncEncoder   encoder(blockId, prodSize, prodData.data() + offset);
+        RlncDecoder   decoder(blockId, prodSize);
+        unsigned      numAdded = 0;
+
+        EXPECT_EQ(blockId.numSegs(prodSize), decoder.getNumSegs());
+        EXPECT_THROW(decoder.getDataSeg(0), LogicError);
+
+        while (!decoder.isDecoded()) {
+            decoder.add(encoder.encode());
+            ASSERT_GT(decoder.getNumSegs() + 5, ++numAdded);
+        }
+        EXPECT_FALSE(decoder.add(encoder.encode()));
+
+        for (unsigned i = 0; i < decoder.getNumSegs(); ++i) {
+            auto dataSeg = decoder.getDataSeg(i);
+            const auto segOffset = offset + i*DataSeg::CANON_DATASEG_SIZE;
+            ASSERT_EQ(segOffset, dataSeg.segId().offset);
+            ASSERT_EQ(0, ::memcmp(prodData.data() + segOffset, dataSeg.data(),
+                    dataSeg.size()));
+        }
+        EXPECT_THROW(decoder.getDataSeg(decoder.getNumSegs()), OutOfRange);
+    }
+}
+
+// Tests decoding a block from the coded segments of several peers
+TEST_F(RlncTest, SeveralPeers)
+{
+    const BlockId            blockId(prodIndex, 0);
+    std::vector<RlncEncoder> encoders;
+    RlncDecoder              decoder(blockId, prodSize);
+
+    for (unsigned i = 0; i < NUM_PEERS; ++i)
+        encoders.push_back(RlncEncoder(blockId, prodSize, prodData.data()));
+
+    for (unsigned i = 0; !decoder.isDecoded(); ++i)
+        decoder.add(encoders[i % NUM_PEERS].encode());
+
+    for (unsigned i = 0; i < decoder.getNumSegs(); ++i) {
+        auto dataSeg = decoder.getDataSeg(i);
+        ASSERT_EQ(0, ::memcmp(prodData.data() + dataSeg.segId().offset,
+                dataSeg.data(), dataSeg.size()));
+    }
+
+    // A coded segment of a different block
+    const BlockId otherId(prodIndex, BlockId::SIZE);
+    RlncEncoder   other(otherId, prodSize, prodData.data() + otherId.offset);
+    EXPECT_THROW(decoder.add(other.encode()), InvalidArgument);
+}
+
+// Compares repair by coded segments with repair by plain data-segments
+TEST_F(RlncTest, Repair)
+{
+    const BlockId  blockId(prodIndex, 0);
+    const unsigned numSegs = blockId.numSegs(prodSize);
+
+    for (const double lossRate : {0.0, 0.1, 0.3}) {
+        unsigned long plainSent = 0;
+        unsigned long codedSent = 0;
+        unsigned long plainSentReq = 0;
+        unsigned long codedSentReq = 0;
+        unsigned long plainRounds = 0;
+        unsigned long codedRounds = 0;
+
+        for (unsigned trial = 0; trial < NUM_TRIALS; ++trial) {
+            unsigned sent = 0;
+            plainSent += uncoordinatedSegs(numSegs, lossRate);
+            codedSent += uncoordinatedCoded(blockId, lossRate);
+            plainRounds += requestedSegs(numSegs, lossRate, sent);
+            plainSentReq += sent;
+            sent = 0;
+            codedRounds += requestedCoded(blockId, lossRate, sent);
+            codedSentReq += sent;
+        }
+
+        // Coding eliminates the duplicates of uncoordinated peers: on
+        // average, a block takes little more than its segments, each of which
+        // might be lost, plus one packet from each peer
+        EXPECT_LT(codedSent, plainSent);
+        EXPECT_GT(NUM_TRIALS*((numSegs + 1)/(1 - lossRate) + NUM_PEERS),
+                codedSent);
+
+        // When segments are requested, coding costs at most one more packet
+        // and one more round per block on average
+        EXPECT_GE(plainSentReq + NUM_TRIALS, codedSentReq);
+        EXPECT_GE(plainRounds + NUM_TRIALS, codedRounds);
+    }
+
+    // Decoding rarely needs more coded segments than there are data-segments
+    RlncEncoder encoder(blockId, prodSize, prodData.data());
+    unsigned    numAdded = 0;
+    for (unsigned i = 0; i < NUM_TRIALS/10; ++i) {
+        RlncDecoder decoder(blockId, prodSize);
+        while (!decoder.isDecoded()) {
+            decoder.add(encoder.encode());
+            ++numAdded;
+        }
+    }
+    EXPECT_GE((NUM_TRIALS/10)*(numSegs + 1), numAdded);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  hycast::log_setName(::basename(argv[0]));
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
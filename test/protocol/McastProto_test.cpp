@@ -81,7 +81,7 @@ public:
         return true;
     }
 
-    bool hereIsMcast(hycast::UdpSeg& seg)
+    bool hereIsMcast(hycast::DataSeg& seg)
     {
         const hycast::SegSize size = seg.getSegInfo().getSegSize();
         EXPECT_EQ(segSize, size);
@@ -52,6 +52,7 @@ protected:
         SEG_REQUEST_RCVD = 0x80,
         PROD_INFO_RCVD = 0x100,
         SEG_RCVD = 0x200,
+        REPORT_RCVD = 0x400,
     } State;
     State                   state;
     std::mutex              mutex;
@@ -65,6 +66,8 @@ protected:
     hycast::SegInfo         segInfo;
     char*                   memData;
     hycast::MemSeg          memSeg;
+    const double            lossRate;
+    const double            rcvRate;
     hycast::PeerProto       pubProto;
 
     PeerProtoTest()
@@ -84,6 +87,8 @@ protected:
         , segInfo(segId, prodSize, segSize)
         , memData{new char[segSize]}
         , memSeg{segInfo, memData}
+        , lossRate{0.25}
+        , rcvRate{1e6}
         , pubProto{}
     {
         ::memset(memData, 0xbd, segSize);
@@ -148,6 +153,15 @@ public:
         orState(SEG_REQUEST_RCVD);
     }
 
+    void recvReport(
+            const double actualLoss,
+            const double actualRate)
+    {
+        EXPECT_EQ(lossRate, actualLoss);
+        EXPECT_EQ(rcvRate, actualRate);
+        orState(REPORT_RCVD);
+    }
+
     void hereIs(const hycast::ProdInfo& actual)
     {
         EXPECT_EQ(prodInfo, actual);
@@ -229,6 +243,11 @@ TEST_F(PeerProtoTest, Exchange)
             pubProto.send(memSeg);
             waitForBit(SEG_RCVD);
 
+            subProto.report(lossRate, rcvRate);
+            waitForBit(REPORT_RCVD);
+            EXPECT_THROW(pubProto.report(lossRate, rcvRate),
+                    hycast::LogicError);
+
             subProto.halt();
             subThread.join();
             pubThread.join();
@@ -0,0 +1,130 @@
+/**
+ * This file tests class `GroupSync`.
+ *
+ *       File: GroupSync_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "GroupSync.h"
+
+#include "error.h"
+#include "FileUtil.h"
+
+#include <cassert>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing class `GroupSync`
+class GroupSyncTest : public ::testing::Test
+{
+protected:
+    const std::string rootPath;
+    int               rootFd;
+
+    GroupSyncTest()
+        : rootPath("/tmp/GroupSync_test")
+        , rootFd(-1)
+    {
+        rmDirTree(rootPath);
+        ensureDir(rootPath, 0777);
+        rootFd = ::open(rootPath.data(), O_RDONLY);
+        assert(rootFd != -1);
+    }
+
+    ~GroupSyncTest() noexcept {
+        if (rootFd >= 0)
+            ::close(rootFd);
+        rmDirTree(rootPath);
+    }
+
+    void createFile(const std::string& pathname) {
+        const int fd = ::openat(rootFd, pathname.data(),
+                O_WRONLY|O_CREAT|O_EXCL, 0600);
+        ASSERT_NE(-1, fd);
+        ASSERT_EQ(1, ::write(fd, "x", 1));
+        ::close(fd);
+    }
+};
+
+// Tests invalid construction
+TEST_F(GroupSyncTest, InvalidConstruction)
+{
+    EXPECT_THROW(GroupSync(rootFd, StoragePolicy{}), InvalidArgument);
+    EXPECT_THROW(GroupSync(rootFd, StoragePolicy{StoragePolicy::Alloc::SPARSE,
+            0, StoragePolicy::Sync::DATASYNC, 0}), InvalidArgument);
+}
+
+// Tests synchronizing a full group
+TEST_F(GroupSyncTest, FullGroup)
+{
+    GroupSync groupSync{rootFd, StoragePolicy{StoragePolicy::Alloc::SPARSE,
+            0, StoragePolicy::Sync::DATASYNC, 2, 3600}};
+
+    createFile("a");
+    createFile("b");
+    groupSync.add("a");
+    groupSync.add("b");
+
+    for (int i = 0; groupSync.getNumGroups() == 0 && i < 100; ++i)
+        ::usleep(10000);
+    EXPECT_EQ(1, groupSync.getNumGroups());
+    EXPECT_EQ(2, groupSync.getNumFiles());
+}
+
+// Tests synchronizing a partial group
+TEST_F(GroupSyncTest, PartialGroup)
+{
+    GroupSync groupSync{rootFd, StoragePolicy{StoragePolicy::Alloc::SPARSE,
+            0, StoragePolicy::Sync::WRITEBACK, 16, 0.05}};
+
+    createFile("a");
+    groupSync.add("a");
+
+    for (int i = 0; groupSync.getNumGroups() == 0 && i < 100; ++i)
+        ::usleep(10000);
+    EXPECT_EQ(1, groupSync.getNumGroups());
+    EXPECT_EQ(1, groupSync.getNumFiles());
+}
+
+// Tests flushing, including a file that was deleted
+TEST_F(GroupSyncTest, Flush)
+{
+    GroupSync groupSync{rootFd, StoragePolicy{StoragePolicy::Alloc::SPARSE,
+            0, StoragePolicy::Sync::DATASYNC, 16, 3600}};
+
+    createFile("a");
+    groupSync.add("a");
+    groupSync.add("deleted");
+    groupSync.flush();
+
+    EXPECT_EQ(1, groupSync.getNumGroups());
+    EXPECT_EQ(1, groupSync.getNumFiles()); // The deleted file is skipped
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
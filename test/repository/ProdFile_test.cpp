@@ -25,13 +25,20 @@
 
 #include "error.h"
 #include "FileUtil.h"
+#include "GroupSync.h"
 #include "hycast.h"
 
+#include <algorithm>
 #include <cassert>
 #include <fcntl.h>
 #include <gtest/gtest.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <random>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <vector>
 
 namespace {
 
@@ -84,6 +91,27 @@ protected:
         hycast::rmDirTree(rootPath);
         //hycast::rmDirTree(rootPath);
     }
+
+    /**
+     * Returns the number of extents of a file.
+     *
+     * @param[in] pathname  Pathname of file relative to root directory
+     * @return              Number of extents. Will be -1 if unknown.
+     */
+    int numExtents(const std::string& pathname)
+    {
+        const int fd = ::openat(rootFd, pathname.data(), O_RDONLY);
+        if (fd == -1)
+            return -1;
+
+        struct fiemap fiemap = {};
+        fiemap.fm_length = FIEMAP_MAX_OFFSET;
+        fiemap.fm_flags = FIEMAP_FLAG_SYNC; // So delayed allocation is done
+        const int status = ::ioctl(fd, FS_IOC_FIEMAP, &fiemap);
+        ::close(fd);
+
+        return status ? -1 : fiemap.fm_mapped_extents;
+    }
 };
 
 // Tests a zero-size SndProdFile
@@ -180,6 +208,151 @@ TEST_F(ProdFileTest, RcvProdFile)
     }
 }
 
+// Tests the missing data-segments of a RcvProdFile
+TEST_F(ProdFileTest, MissingSegments)
+{
+    const hycast::ProdSize numSegs = 200; // More than 3 bitmap words
+    hycast::ProdSize       prodSize{static_cast<hycast::ProdSize>(
+            numSegs*segSize - 1)};
+    hycast::RcvProdFile    prodFile(rootFd, prodIndex, prodSize, segSize);
+
+    auto ranges = prodFile.getMissing();
+    ASSERT_EQ(1, ranges.size());
+    EXPECT_EQ((hycast::SegRange{0, numSegs}), ranges[0]);
+
+    // Save every data-segment except 1, 63-64 and the last one
+    for (hycast::ProdSize i = 0; i < numSegs; ++i) {
+        if (i == 1 || i == 63 || i == 64 || i == numSegs - 1)
+            continue;
+        hycast::SegId   segId(prodIndex, i*segSize);
+        hycast::SegInfo segInfo(segId, prodSize, prodFile.getSegSize(i*segSize));
+        hycast::MemSeg  memSeg{segInfo, memData};
+        ASSERT_TRUE(prodFile.save(memSeg));
+    }
+
+    ranges = prodFile.getMissing();
+    ASSERT_EQ(3, ranges.size());
+    EXPECT_EQ((hycast::SegRange{1*segSize, 1}), ranges[0]);
+    EXPECT_EQ((hycast::SegRange{63*segSize, 2}), ranges[1]);
+    EXPECT_EQ((hycast::SegRange{(numSegs-1)*segSize, 1}), ranges[2]);
+
+    ranges = prodFile.getMissing(2);
+    EXPECT_EQ(2, ranges.size());
+}
+
+// Tests the allocation policy of a RcvProdFile
+TEST_F(ProdFileTest, Allocation)
+{
+    struct stat statBuf;
+
+    hycast::RcvProdFile sparse(rootFd, prodIndex, prodSize, segSize);
+    ASSERT_EQ(0, ::fstatat(rootFd, sparse.getPathname().data(), &statBuf, 0));
+    EXPECT_EQ(prodSize, statBuf.st_size);
+    EXPECT_EQ(0, statBuf.st_blocks);
+
+    const hycast::StoragePolicy policy{hycast::StoragePolicy::Alloc::PREALLOC,
+            1048576};
+    hycast::RcvProdFile prealloc(rootFd, hycast::ProdIndex{2}, prodSize,
+            segSize, policy);
+    ASSERT_EQ(0, ::fstatat(rootFd, prealloc.getPathname().data(), &statBuf,
+            0));
+    EXPECT_EQ(prodSize, statBuf.st_size);
+    EXPECT_LE(prodSize, 512*statBuf.st_blocks); // If supported by file-system
+
+    // Preallocated blocks read as zeros
+    EXPECT_TRUE(prealloc.save(memSeg));
+    const auto data = static_cast<const char*>(prealloc.getData(0));
+    EXPECT_EQ(0, ::memcmp(memData, data, segSize));
+}
+
+// Tests receiving interleaved products under each storage policy
+TEST_F(ProdFileTest, StoragePolicies)
+{
+    using Policy = hycast::StoragePolicy;
+
+    static const int              NUM_PRODS = 16;
+    static const hycast::ProdSize PROD_SIZE = 2000000;
+    const hycast::ProdSize        numSegs = PROD_SIZE / segSize;
+    const struct {
+        const char* name;
+        Policy      policy;
+    } configs[] = {
+        {"sparse",                  Policy{}},
+        {"sparse+datasync",         Policy{Policy::Alloc::SPARSE, 0,
+                Policy::Sync::DATASYNC, 4, 0.1}},
+        {"prealloc",                Policy{Policy::Alloc::PREALLOC}},
+        {"prealloc+extsize",        Policy{Policy::Alloc::PREALLOC, 1048576}},
+        {"prealloc+writeback",      Policy{Policy::Alloc::PREALLOC, 0,
+                Policy::Sync::WRITEBACK, 4, 0.1}},
+        {"prealloc+datasync",       Policy{Policy::Alloc::PREALLOC, 0,
+                Policy::Sync::DATASYNC, 4, 0.1}}
+    };
+
+    // Segments of concurrently-received products arrive interleaved
+    std::vector<std::pair<int, hycast::ProdSize>> order;
+    for (int iProd = 0; iProd < NUM_PRODS; ++iProd)
+        for (hycast::ProdSize iSeg = 0; iSeg < numSegs; ++iSeg)
+            order.push_back(std::make_pair(iProd, iSeg));
+    std::shuffle(order.begin(), order.end(), std::mt19937{});
+
+    hycast::ProdIndex::Type index = 1;
+    long                    sparseExtents = -1;
+    for (const auto& config : configs) {
+        SCOPED_TRACE(config.name);
+        hycast::GroupSync groupSync{};
+        if (config.policy.sync != Policy::Sync::NONE)
+            groupSync = hycast::GroupSync(rootFd, config.policy);
+
+        std::vector<hycast::RcvProdFile> prodFiles;
+        std::vector<hycast::ProdSize>    counts(NUM_PRODS, 0);
+        for (int iProd = 0; iProd < NUM_PRODS; ++iProd)
+            prodFiles.push_back(hycast::RcvProdFile(rootFd,
+                    hycast::ProdIndex{index + iProd}, PROD_SIZE, segSize,
+                    config.policy));
+
+        for (const auto& pair : order) {
+            auto&                  prodFile = prodFiles[pair.first];
+            const hycast::ProdSize offset = pair.second*segSize;
+            hycast::SegInfo        segInfo(hycast::SegId(
+                    hycast::ProdIndex{index + pair.first}, offset), PROD_SIZE,
+                    segSize);
+            hycast::MemSeg         memSeg{segInfo, memData};
+            ASSERT_TRUE(prodFile.save(memSeg));
+            if (++counts[pair.first] == numSegs && groupSync)
+                groupSync.add(prodFile.getPathname());
+        }
+        for (const auto& prodFile : prodFiles)
+            EXPECT_TRUE(prodFile.getMissing().empty());
+
+        // Every completed file was synchronized, several at a time
+        if (groupSync) {
+            groupSync.flush();
+            EXPECT_EQ(NUM_PRODS, groupSync.getNumFiles());
+            EXPECT_LT(0, groupSync.getNumGroups());
+            EXPECT_GT(NUM_PRODS, groupSync.getNumGroups());
+        }
+
+        // Preallocation doesn't fragment files more than sparse allocation
+        long extents = 0;
+        for (const auto& prodFile : prodFiles) {
+            const int num = numExtents(prodFile.getPathname());
+            if (num < 0) {
+                extents = -1; // Unknown
+                break;
+            }
+            extents += num;
+        }
+        if (config.policy.alloc == Policy::Alloc::SPARSE) {
+            sparseExtents = extents;
+        }
+        else if (extents >= 0 && sparseExtents >= 0) {
+            EXPECT_GE(sparseExtents, extents);
+        }
+
+        index += NUM_PRODS;
+    }
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
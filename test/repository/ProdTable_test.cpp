@@ -0,0 +1,96 @@
+/**
+ * This file tests class `ProdTable`.
+ *
+ *       File: ProdTable_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "ProdTable.h"
+
+#include "error.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/// The fixture for testing class `ProdTable`
+class ProdTableTest : public ::testing::Test
+{
+protected:
+    static hycast::ProdInfo prodInfo(const hycast::ProdIndex::Type index)
+    {
+        return hycast::ProdInfo(index, 1000 + index,
+                "product/" + std::to_string(index));
+    }
+};
+
+// Tests invalid construction
+TEST_F(ProdTableTest, InvalidConstruction)
+{
+    EXPECT_THROW(hycast::ProdTable(0), hycast::InvalidArgument);
+}
+
+// Tests adding and getting
+TEST_F(ProdTableTest, AddAndGet)
+{
+    hycast::ProdTable prodTable{};
+
+    EXPECT_FALSE(prodTable.get(1));
+    EXPECT_TRUE(prodTable.add(prodInfo(3)));
+    EXPECT_TRUE(prodTable.add(prodInfo(5)));
+    EXPECT_FALSE(prodTable.add(prodInfo(5)));  // Duplicate
+    EXPECT_FALSE(prodTable.add(prodInfo(2)));  // Before window
+    EXPECT_TRUE(prodTable.add(prodInfo(4)));   // Out of order
+
+    EXPECT_EQ(3, prodTable.size());
+    for (hycast::ProdIndex::Type i = 3; i <= 5; ++i) {
+        EXPECT_TRUE(prodTable.contains(i));
+        EXPECT_TRUE(prodInfo(i) == prodTable.get(i));
+    }
+    EXPECT_FALSE(prodTable.contains(6));
+}
+
+// Tests the sliding window
+TEST_F(ProdTableTest, Window)
+{
+    hycast::ProdTable prodTable{10};
+
+    for (hycast::ProdIndex::Type i = 1; i <= 100000; ++i)
+        ASSERT_TRUE(prodTable.add(prodInfo(i)));
+
+    EXPECT_EQ(10, prodTable.size());
+    EXPECT_FALSE(prodTable.contains(99990));
+    EXPECT_TRUE(prodInfo(99991) == prodTable.get(99991));
+    EXPECT_TRUE(prodInfo(100000) == prodTable.get(100000));
+
+    // The names of forgotten products don't accumulate
+    EXPECT_GT(200000, prodTable.getNameBytes());
+
+    // Far beyond the window
+    EXPECT_TRUE(prodTable.add(prodInfo(1000000)));
+    EXPECT_EQ(1, prodTable.size());
+    EXPECT_TRUE(prodInfo(1000000) == prodTable.get(1000000));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
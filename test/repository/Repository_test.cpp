@@ -153,6 +153,8 @@ TEST_F(RepositoryTest, CreatProdForSending)
     try {
         auto prodInfo = repo.getNextProd();
         ASSERT_TRUE(RepositoryTest::prodInfo == prodInfo);
+        // Same name as the product-file's pathname relative to the root
+        EXPECT_EQ(prodInfo, repo.getProdInfo(prodInfo.getProdIndex()));
         auto memSeg = repo.getMemSeg(RepositoryTest::segId);
         ASSERT_EQ(RepositoryTest::memSeg, memSeg);
     }
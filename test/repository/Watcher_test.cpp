@@ -31,6 +31,7 @@
 #include <gtest/gtest.h>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
 namespace {
 
@@ -146,6 +147,23 @@ TEST_F(WatcherTest, AddHardLink)
     thread.join();
 }
 
+// Tests stopping a wait for an event
+TEST_F(WatcherTest, Stop)
+{
+    hycast::Watcher    watcher(rootDir);
+    hycast::StopSource stopSource{};
+    bool               gotEvent = true;
+    auto               thread = std::thread([&] {
+        struct hycast::Watcher::WatchEvent watchEvent;
+        gotEvent = watcher.getEvent(watchEvent, stopSource.getToken());
+    });
+
+    ::usleep(100000);
+    stopSource.requestStop();
+    thread.join();
+    EXPECT_FALSE(gotEvent);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -0,0 +1,248 @@
+/**
+ * This file tests class `WriteBehind`.
+ *
+ *       File: WriteBehind_test.cpp
+ * Created On: Oct 19, 2026
+ *     Author: Steven R. Emmerson
+ *
+ *    Copyright 2021 University Corporation for Atmospheric Research
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "error.h"
+#include "FileUtil.h"
+#include "WriteBehind.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using namespace hycast;
+
+/// The fixture for testing class `WriteBehind`
+class WriteBehindTest : public ::testing::Test
+{
+protected:
+    static const SegSize    SEG_SIZE = 1000;
+    static const int        NUM_SEGS = 10;
+    static const ProdSize   PROD_SIZE = NUM_SEGS*SEG_SIZE;
+    const std::string       rootDir;
+    SubRepo                 repo;
+    char                    memData[SEG_SIZE];
+    std::mutex              mutex;
+    std::condition_variable cond;
+    bool                    stalled; ///< Simulated storage stall
+    std::set<ProdSize>      offsets; ///< Offsets of saved segments
+    int                     numDups;
+
+    static std::string freshDir(const std::string& dir) {
+        rmDirTree(dir);
+        return dir;
+    }
+
+    WriteBehindTest()
+        : rootDir(freshDir("/tmp/WriteBehind_test"))
+        , repo(rootDir, SEG_SIZE)
+        , memData{}
+        , mutex()
+        , cond()
+        , stalled(false)
+        , offsets()
+        , numDups(0)
+    {
+        ::memset(memData, 0xbd, sizeof(memData));
+    }
+
+    ~WriteBehindTest() {
+        rmDirTree(rootDir);
+    }
+
+    MemSeg memSeg(const ProdSize i) {
+        return MemSeg{SegInfo{SegId{ProdIndex{1}, i*SEG_SIZE}, PROD_SIZE,
+                SEG_SIZE}, memData};
+    }
+
+    WriteBehind::Saved saved() {
+        return [this](const SegId& segId, const bool wasSaved) {
+            std::unique_lock<std::mutex> lock{mutex};
+            while (stalled)
+                cond.wait(lock);
+            if (wasSaved) {
+                offsets.insert(segId.getOffset());
+            }
+            else {
+                ++numDups;
+            }
+        };
+    }
+
+    void setStalled(const bool value) {
+        std::lock_guard<std::mutex> guard{mutex};
+        stalled = value;
+        cond.notify_all();
+    }
+};
+
+const int WriteBehindTest::NUM_SEGS;
+
+// Tests invalid construction
+TEST_F(WriteBehindTest, InvalidConstruction)
+{
+    EXPECT_THROW(WriteBehind(repo, saved(), WriteBehind::Policy(0, 0)),
+            InvalidArgument);
+    EXPECT_THROW(WriteBehind(repo, saved(), WriteBehind::Policy(2, 2)),
+            InvalidArgument);
+}
+
+// Tests saving data-segments
+TEST_F(WriteBehindTest, Save)
+{
+    WriteBehind writeBehind{repo, saved(),
+            WriteBehind::Policy(2*NUM_SEGS, NUM_SEGS)};
+
+    for (int i = 0; i < NUM_SEGS; ++i) {
+        auto seg = memSeg(i);
+        EXPECT_TRUE(writeBehind.save(seg));
+    }
+    auto dup = memSeg(0);
+    EXPECT_TRUE(writeBehind.save(dup));
+    writeBehind.flush();
+
+    EXPECT_EQ(NUM_SEGS, offsets.size());
+    EXPECT_EQ(1, numDups);
+    for (ProdSize i = 0; i < NUM_SEGS; ++i) {
+        const auto seg = repo.getMemSeg(SegId{ProdIndex{1}, i*SEG_SIZE});
+        ASSERT_TRUE(seg);
+        EXPECT_EQ(0, ::memcmp(memData, seg.data(), SEG_SIZE));
+    }
+
+    const auto metrics = writeBehind.getMetrics();
+    EXPECT_EQ(0, metrics.depth);
+    EXPECT_EQ(NUM_SEGS + 1, metrics.numQueued);
+    EXPECT_EQ(NUM_SEGS, metrics.numSaved);
+    EXPECT_EQ(1, metrics.numDups);
+    EXPECT_EQ(0, metrics.numDropped);
+}
+
+// Tests dropping data-segments when the stage overflows
+TEST_F(WriteBehindTest, Drop)
+{
+    WriteBehind writeBehind{repo, saved(), WriteBehind::Policy(4, 1)};
+
+    setStalled(true);
+    for (int i = 0; i < NUM_SEGS; ++i) {
+        auto seg = memSeg(i);
+        writeBehind.save(seg);
+    }
+    auto metrics = writeBehind.getMetrics();
+    EXPECT_EQ(4, metrics.depth);
+    EXPECT_EQ(4, metrics.maxDepth);
+    EXPECT_EQ(1, metrics.numOverflows);
+    EXPECT_EQ(NUM_SEGS - 4, metrics.numDropped);
+
+    setStalled(false);
+    writeBehind.flush();
+
+    // The stage recovered at the low watermark
+    auto seg = memSeg(NUM_SEGS - 1);
+    EXPECT_TRUE(writeBehind.save(seg));
+    writeBehind.flush();
+    EXPECT_EQ(5, offsets.size());
+    EXPECT_EQ(4*SEG_SIZE, repo.getMissing(ProdIndex{1}).front().offset);
+}
+
+// Tests blocking the receiving thread when the stage overflows
+TEST_F(WriteBehindTest, Block)
+{
+    WriteBehind writeBehind{repo, saved(),
+            WriteBehind::Policy(2, 1, WriteBehind::Overflow::BLOCK)};
+
+    setStalled(true);
+    std::thread thread([&] {
+        for (int i = 0; i < NUM_SEGS; ++i) {
+            auto seg = memSeg(i);
+            EXPECT_TRUE(writeBehind.save(seg));
+        }
+    });
+
+    ::usleep(100000);
+    auto metrics = writeBehind.getMetrics();
+    EXPECT_EQ(2, metrics.depth);
+    EXPECT_EQ(1, metrics.numOverflows);
+
+    setStalled(false);
+    thread.join();
+    writeBehind.flush();
+
+    EXPECT_EQ(NUM_SEGS, offsets.size());
+    EXPECT_TRUE(repo.getMissing(ProdIndex{1}).empty());
+    metrics = writeBehind.getMetrics();
+    EXPECT_EQ(0, metrics.numDropped);
+    EXPECT_LT(0, metrics.blockedSecs);
+}
+
+// Tests a stage that's shared by two repositories
+TEST_F(WriteBehindTest, Shared)
+{
+    const std::string  otherDir(freshDir("/tmp/WriteBehind_test2"));
+    SubRepo            otherRepo(otherDir, SEG_SIZE);
+    std::set<ProdSize> otherOffsets;
+    WriteBehind        stage{SEG_SIZE, WriteBehind::Policy(2*NUM_SEGS,
+            NUM_SEGS)};
+    auto               seg = memSeg(0);
+
+    EXPECT_THROW(stage.save(seg), LogicError);
+
+    auto handle = stage.attach(repo, saved());
+    auto otherHandle = stage.attach(otherRepo,
+            [&](const SegId& segId, const bool wasSaved) {
+                if (wasSaved)
+                    otherOffsets.insert(segId.getOffset());
+            });
+
+    for (int i = 0; i < NUM_SEGS; ++i) {
+        auto seg = memSeg(i);
+        EXPECT_TRUE(handle.save(seg));
+        if (i % 2 == 0)
+            EXPECT_TRUE(otherHandle.save(seg));
+    }
+    otherHandle.flush();
+    EXPECT_EQ(NUM_SEGS/2, otherOffsets.size());
+    stage.flush();
+
+    EXPECT_EQ(NUM_SEGS, offsets.size());
+    EXPECT_TRUE(repo.getMissing(ProdIndex{1}).empty());
+    EXPECT_EQ(NUM_SEGS/2, otherRepo.getMissing(ProdIndex{1}).size());
+
+    const auto metrics = stage.getMetrics();
+    EXPECT_EQ(0, metrics.depth);
+    EXPECT_EQ(NUM_SEGS + NUM_SEGS/2, metrics.numQueued);
+    EXPECT_EQ(NUM_SEGS + NUM_SEGS/2, metrics.numSaved);
+
+    rmDirTree(otherDir);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}